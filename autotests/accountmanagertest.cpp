@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "../src/abstractaccountmanager.h"
+
+#include <QTest>
+
+using namespace KMGraph2;
+
+/**
+ * Serves the accounts of a list, like KAccountsManager serves those of
+ * KAccounts, and is told about changes the way KAccountsManager is told by
+ * the signals of Accounts::Manager.
+ */
+class TestAccountManager : public AbstractAccountManager
+{
+public:
+    AccountPtr createAccount() override
+    {
+        const QString accountName = QStringLiteral("new%1@outlook.com").arg(backend.size());
+        backend << accountName;
+        accountChanged();
+        return account(accountName);
+    }
+
+    AccountPtr refreshAccount(const AccountPtr &account) override
+    {
+        return account;
+    }
+
+    void removeAccount(const QString &accountName) override
+    {
+        backend.removeAll(accountName);
+        accountChanged();
+    }
+
+    /** What Accounts::Manager::accountCreated, accountRemoved and accountUpdated trigger. */
+    void accountChanged()
+    {
+        invalidateAccounts();
+    }
+
+    QStringList backend;
+    int loads = 0;
+
+protected:
+    void loadAccounts() override
+    {
+        ++loads;
+        for (const auto &accountName : qAsConst(backend)) {
+            insertAccount(AccountPtr(new Account(accountName)));
+        }
+    }
+};
+
+class AccountManagerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testIndexCached();
+    void testCreated();
+    void testRemoved();
+    void testUpdated();
+};
+
+QTEST_GUILESS_MAIN(AccountManagerTest)
+
+void AccountManagerTest::testIndexCached()
+{
+    TestAccountManager manager;
+    manager.backend << QStringLiteral("foo@outlook.com") << QStringLiteral("bar@outlook.com");
+
+    QCOMPARE(manager.accounts(), QSet<QString>({ QStringLiteral("foo@outlook.com"), QStringLiteral("bar@outlook.com") }));
+    QCOMPARE(manager.account(QStringLiteral("foo@outlook.com"))->accountName(), QStringLiteral("foo@outlook.com"));
+    QVERIFY(manager.account(QStringLiteral("baz@outlook.com"))->accountName().isEmpty());
+    manager.accounts();
+    QCOMPARE(manager.loads, 1);
+
+    // Without a change signal, the backend is not read again.
+    manager.backend << QStringLiteral("baz@outlook.com");
+    QVERIFY(!manager.accounts().contains(QStringLiteral("baz@outlook.com")));
+    QCOMPARE(manager.loads, 1);
+}
+
+void AccountManagerTest::testCreated()
+{
+    TestAccountManager manager;
+    manager.backend << QStringLiteral("foo@outlook.com");
+    QCOMPARE(manager.accounts().size(), 1);
+
+    const AccountPtr account = manager.createAccount();
+    QCOMPARE(manager.loads, 2);
+    QVERIFY(manager.accounts().contains(account->accountName()));
+
+    // Created by another process, e.g. the KCM.
+    manager.backend << QStringLiteral("baz@outlook.com");
+    manager.accountChanged();
+    QCOMPARE(manager.account(QStringLiteral("baz@outlook.com"))->accountName(), QStringLiteral("baz@outlook.com"));
+    QCOMPARE(manager.accounts().size(), 3);
+    QCOMPARE(manager.loads, 3);
+}
+
+void AccountManagerTest::testRemoved()
+{
+    TestAccountManager manager;
+    manager.backend << QStringLiteral("foo@outlook.com") << QStringLiteral("bar@outlook.com");
+    QCOMPARE(manager.accounts().size(), 2);
+
+    manager.removeAccount(QStringLiteral("foo@outlook.com"));
+    QCOMPARE(manager.accounts(), QSet<QString>({ QStringLiteral("bar@outlook.com") }));
+    // Removed accounts are not served from the old index.
+    QVERIFY(manager.account(QStringLiteral("foo@outlook.com"))->accountName().isEmpty());
+}
+
+void AccountManagerTest::testUpdated()
+{
+    TestAccountManager manager;
+    manager.backend << QStringLiteral("foo@outlook.com");
+    QCOMPARE(manager.account(QStringLiteral("foo@outlook.com"))->accountName(), QStringLiteral("foo@outlook.com"));
+
+    // e.g. renamed, or its OneDrive service disabled.
+    manager.backend = QStringList({ QStringLiteral("renamed@outlook.com") });
+    manager.accountChanged();
+    QVERIFY(manager.account(QStringLiteral("foo@outlook.com"))->accountName().isEmpty());
+    QCOMPARE(manager.account(QStringLiteral("renamed@outlook.com"))->accountName(), QStringLiteral("renamed@outlook.com"));
+    QCOMPARE(manager.loads, 2);
+}
+
+#include "accountmanagertest.moc"
@@ -0,0 +1,363 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "mockdrive.h"
+#include "../src/backgrounduploader.h"
+#include "../src/graphrequest.h"
+#include "../src/onedrivehelper.h"
+#include "../src/uploadjournal.h"
+
+#include <QDir>
+#include <QLockFile>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+#include <QTest>
+
+using namespace KMGraph2;
+
+class BackgroundUploaderTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testJournal();
+    void testConflictName();
+    void testNewFile();
+    void testReplace();
+    void testConflict();
+    void testUploadSession();
+    void testFailure();
+    void testSafeSave();
+    void testUnfinishedSafeSave();
+    void testAbandonedSafeSave();
+    void testPartialGracePeriod();
+    void testCommitRebase();
+    void testClaim();
+
+private:
+    UploadJournal::Upload queue(const QString &path, const QByteArray &data, const QString &baseCTag = QString(),
+                                const QDateTime &queuedAt = QDateTime::currentDateTimeUtc());
+    QString cTag(const QString &path) const;
+
+    MockDrive m_drive;
+    AccountPtr m_account;
+    QTemporaryDir *m_dir = nullptr;
+    UploadJournal *m_journal = nullptr;
+};
+
+QTEST_GUILESS_MAIN(BackgroundUploaderTest)
+
+static const QString AccountPath = QStringLiteral("/foo@outlook.com");
+
+void BackgroundUploaderTest::initTestCase()
+{
+    QVERIFY(m_drive.start());
+    qputenv("ONEDRIVE_GRAPH_URL", m_drive.url().toString().toLatin1());
+    m_account = AccountPtr(new Account(QStringLiteral("foo@outlook.com"), QStringLiteral("secret-token")));
+}
+
+void BackgroundUploaderTest::init()
+{
+    MockDrive::Shape shape;
+    shape.depth = 1;
+    shape.folders = 1;
+    shape.files = 2;
+    shape.fileSize = 1024;
+    m_drive.generate(shape);
+    m_drive.resetCounters();
+
+    m_dir = new QTemporaryDir;
+    QVERIFY(m_dir->isValid());
+    m_journal = new UploadJournal(m_dir->filePath(QStringLiteral("journal")));
+}
+
+void BackgroundUploaderTest::cleanup()
+{
+    delete m_journal;
+    m_journal = nullptr;
+    delete m_dir;
+    m_dir = nullptr;
+}
+
+UploadJournal::Upload BackgroundUploaderTest::queue(const QString &path, const QByteArray &data, const QString &baseCTag,
+                                                    const QDateTime &queuedAt)
+{
+    QTemporaryFile file;
+    file.open();
+    file.write(data);
+    file.close();
+
+    UploadJournal::Upload upload;
+    upload.path = AccountPath + path;
+    upload.baseCTag = baseCTag;
+    upload.queuedAt = queuedAt;
+    m_journal->add(upload, file.fileName());
+    m_journal->upload(upload.path, &upload);
+    return upload;
+}
+
+QString BackgroundUploaderTest::cTag(const QString &path) const
+{
+    GraphRequest request(OneDriveHelper::networkAccessManager(), "GET", QStringLiteral("/items/%1").arg(m_drive.idForPath(path)));
+    request.setAccount(m_account);
+    request.exec();
+    return request.response().value(QStringLiteral("cTag")).toString();
+}
+
+void BackgroundUploaderTest::testJournal()
+{
+    QVERIFY(m_journal->isEmpty());
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    const auto first = queue(QStringLiteral("/folder0/a.txt"), "first", QStringLiteral("base"), now.addSecs(-2));
+    const auto other = queue(QStringLiteral("/b.txt"), "other", QString(), now.addSecs(-1));
+    QCOMPARE(first.size, qint64(5));
+    QCOMPARE(m_journal->uploads().size(), 2);
+    QCOMPARE(m_journal->uploads().first().path, first.path);
+    QCOMPARE(m_journal->uploadsIn(AccountPath + QStringLiteral("/folder0")).size(), 1);
+
+    // A newer put() replaces the pending one, which stays based on the same version.
+    const auto second = queue(QStringLiteral("/folder0/a.txt"), "second");
+    QVERIFY(second.queuedAt > first.queuedAt);
+    QCOMPARE(second.baseCTag, QStringLiteral("base"));
+    QVERIFY(!QFile::exists(m_journal->contentFile(first)));
+    QFile content(m_journal->contentFile(second));
+    QVERIFY(content.open(QIODevice::ReadOnly));
+    QCOMPARE(content.readAll(), QByteArray("second"));
+    QCOMPARE(m_journal->uploads().last().path, second.path);
+
+    // Done with the replaced upload: the newer one is kept.
+    m_journal->remove(first);
+    UploadJournal::Upload pending;
+    QVERIFY(m_journal->upload(first.path, &pending));
+    QCOMPARE(pending.queuedAt, second.queuedAt);
+
+    m_journal->remove(second);
+    m_journal->remove(other.path);
+    QVERIFY(m_journal->isEmpty());
+    QCOMPARE(QDir(m_journal->directory()).entryList(QDir::Files), QStringList());
+}
+
+void BackgroundUploaderTest::testConflictName()
+{
+    const QDateTime at = QDateTime(QDate(2018, 5, 4), QTime(13, 14, 15));
+    QCOMPARE(BackgroundUploader::conflictName(QStringLiteral("notes.txt"), at), QStringLiteral("notes (conflict 2018-05-04 131415).txt"));
+    QCOMPARE(BackgroundUploader::conflictName(QStringLiteral("Makefile"), at), QStringLiteral("Makefile (conflict 2018-05-04 131415)"));
+    QCOMPARE(BackgroundUploader::conflictName(QStringLiteral(".bashrc"), at), QStringLiteral(".bashrc (conflict 2018-05-04 131415)"));
+}
+
+void BackgroundUploaderTest::testNewFile()
+{
+    const auto upload = queue(QStringLiteral("/folder0/new file.txt"), "hello");
+
+    BackgroundUploader uploader(m_journal);
+    QCOMPARE(uploader.upload(upload, m_account), BackgroundUploader::Committed);
+    // The lookup, and the upload.
+    QCOMPARE(m_drive.requestCount(), 2);
+    QCOMPARE(m_drive.content(m_drive.idForPath(QStringLiteral("folder0/new file.txt"))), QByteArray("hello"));
+    QVERIFY(m_journal->isEmpty());
+}
+
+void BackgroundUploaderTest::testReplace()
+{
+    const QString id = m_drive.idForPath(QStringLiteral("folder0/file0.bin"));
+    const auto upload = queue(QStringLiteral("/folder0/file0.bin"), "replaced", cTag(QStringLiteral("folder0/file0.bin")));
+    m_drive.resetCounters();
+
+    BackgroundUploader uploader(m_journal);
+    QCOMPARE(uploader.upload(upload, m_account), BackgroundUploader::Committed);
+    QCOMPARE(m_drive.requestCount(), 2);
+    // Same item, new content.
+    QCOMPARE(m_drive.idForPath(QStringLiteral("folder0/file0.bin")), id);
+    QCOMPARE(m_drive.content(id), QByteArray("replaced"));
+    QVERIFY(m_journal->isEmpty());
+}
+
+void BackgroundUploaderTest::testConflict()
+{
+    const QString id = m_drive.idForPath(QStringLiteral("folder0/file0.bin"));
+    const QByteArray server = m_drive.content(id);
+    const auto upload = queue(QStringLiteral("/folder0/file0.bin"), "local", QStringLiteral("\"c:{stale},0\""));
+
+    BackgroundUploader uploader(m_journal);
+    QCOMPARE(uploader.upload(upload, m_account), BackgroundUploader::Conflict);
+    QCOMPARE(m_drive.content(id), server);
+
+    const QString conflictName = BackgroundUploader::conflictName(QStringLiteral("file0.bin"), upload.queuedAt);
+    QCOMPARE(uploader.conflictPath(), AccountPath + QStringLiteral("/folder0/") + conflictName);
+    QCOMPARE(m_drive.content(m_drive.idForPath(QStringLiteral("folder0/") + conflictName)), QByteArray("local"));
+    QVERIFY(m_journal->isEmpty());
+
+    // Without a base version, only a file created by someone else after the put() conflicts.
+    const auto created = queue(QStringLiteral("/folder0/file1.bin"), "local", QString(), QDateTime::currentDateTimeUtc().addSecs(-60));
+    QCOMPARE(uploader.upload(created, m_account), BackgroundUploader::Conflict);
+    const auto overwrite = queue(QStringLiteral("/folder0/file1.bin"), "local");
+    QCOMPARE(uploader.upload(overwrite, m_account), BackgroundUploader::Committed);
+    QCOMPARE(m_drive.content(m_drive.idForPath(QStringLiteral("folder0/file1.bin"))), QByteArray("local"));
+}
+
+void BackgroundUploaderTest::testUploadSession()
+{
+    const qint64 size = BackgroundUploader::ChunkSize + 1024;
+    QByteArray data(int(size), 'x');
+    data[0] = 'a';
+    data[int(size) - 1] = 'z';
+    const auto upload = queue(QStringLiteral("/large.bin"), data);
+
+    BackgroundUploader uploader(m_journal);
+    QCOMPARE(uploader.upload(upload, m_account), BackgroundUploader::Committed);
+    // The lookup, the session, and two chunks.
+    QCOMPARE(m_drive.requestCount("POST"), 1);
+    QCOMPARE(m_drive.requestCount("PUT"), 2);
+    QCOMPARE(m_drive.content(m_drive.idForPath(QStringLiteral("large.bin"))), data);
+}
+
+void BackgroundUploaderTest::testFailure()
+{
+    // The folder does not exist.
+    const auto upload = queue(QStringLiteral("/missing/file.txt"), "lost");
+
+    BackgroundUploader uploader(m_journal);
+    QCOMPARE(uploader.upload(upload, m_account), BackgroundUploader::Failed);
+    QCOMPARE(uploader.statusCode(), 404);
+
+    UploadJournal::Upload pending;
+    QVERIFY(m_journal->upload(upload.path, &pending));
+    QCOMPARE(pending.attempts, 1);
+    QVERIFY(pending.nextAttempt > QDateTime::currentDateTimeUtc());
+    QVERIFY(!pending.lastError.isEmpty());
+}
+
+void BackgroundUploaderTest::testSafeSave()
+{
+    const QString id = m_drive.idForPath(QStringLiteral("folder0/file0.bin"));
+    const QString target = AccountPath + QStringLiteral("/folder0/file0.bin");
+
+    // The worker holds the partial file back, defers the deletion of the
+    // original, and moves the partial file over it on rename.
+    auto partial = queue(QStringLiteral("/folder0/file0.bin.part"), "saved");
+    partial.deletedTarget = target;
+    m_journal->update(partial);
+    QVERIFY(m_journal->rename(partial, target, cTag(QStringLiteral("folder0/file0.bin"))));
+
+    UploadJournal::Upload pending;
+    QVERIFY(!m_journal->upload(partial.path, &pending));
+    UploadJournal::Upload upload;
+    QVERIFY(m_journal->upload(target, &upload));
+    QVERIFY(upload.deletedTarget.isEmpty());
+    QCOMPARE(upload.size, qint64(5));
+
+    m_drive.resetCounters();
+    BackgroundUploader uploader(m_journal);
+    QCOMPARE(uploader.upload(upload, m_account), BackgroundUploader::Committed);
+    // A lookup and a single upload: nothing created, deleted or renamed.
+    QCOMPARE(m_drive.requestCount(), 2);
+    QCOMPARE(m_drive.requestCount("PUT"), 1);
+    QCOMPARE(m_drive.idForPath(QStringLiteral("folder0/file0.bin")), id);
+    QCOMPARE(m_drive.content(id), QByteArray("saved"));
+    QVERIFY(m_drive.idForPath(QStringLiteral("folder0/file0.bin.part")).isEmpty());
+    QVERIFY(m_journal->isEmpty());
+}
+
+void BackgroundUploaderTest::testUnfinishedSafeSave()
+{
+    // The rename never came: the steps are replayed as they were requested.
+    auto partial = queue(QStringLiteral("/folder0/file0.bin.part"), "saved");
+    partial.deletedTarget = AccountPath + QStringLiteral("/folder0/file0.bin");
+    m_journal->update(partial);
+
+    BackgroundUploader uploader(m_journal);
+    QCOMPARE(uploader.upload(partial, m_account), BackgroundUploader::Committed);
+    QCOMPARE(m_drive.requestCount("DELETE"), 1);
+    QVERIFY(m_drive.idForPath(QStringLiteral("folder0/file0.bin")).isEmpty());
+    QCOMPARE(m_drive.content(m_drive.idForPath(QStringLiteral("folder0/file0.bin.part"))), QByteArray("saved"));
+}
+
+void BackgroundUploaderTest::testAbandonedSafeSave()
+{
+    // The partial file was dropped before its rename: the deletion of the
+    // original is done by the worker, gone or not.
+    BackgroundUploader uploader(m_journal);
+    uploader.deleteTarget(AccountPath + QStringLiteral("/folder0/file0.bin"), m_account);
+    QVERIFY(m_drive.idForPath(QStringLiteral("folder0/file0.bin")).isEmpty());
+    uploader.deleteTarget(AccountPath + QStringLiteral("/folder0/file0.bin"), m_account);
+    QCOMPARE(m_drive.requestCount("DELETE"), 2);
+}
+
+void BackgroundUploaderTest::testPartialGracePeriod()
+{
+    // The agent leaves a fresh partial file to the worker, which renames it.
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    const auto partial = queue(QStringLiteral("/folder0/file0.bin.part"), "saved", QString(), now);
+    QVERIFY(UploadJournal::readyAt(partial) > now);
+    const auto old = queue(QStringLiteral("/folder0/file1.bin.part"), "saved", QString(), now.addSecs(-3600));
+    QVERIFY(UploadJournal::readyAt(old) <= now);
+
+    const auto upload = queue(QStringLiteral("/folder0/file0.bin"), "saved", QString(), now);
+    QVERIFY(!UploadJournal::readyAt(upload).isValid());
+    auto failed = upload;
+    failed.nextAttempt = now.addSecs(30);
+    QCOMPARE(UploadJournal::readyAt(failed), failed.nextAttempt);
+}
+
+void BackgroundUploaderTest::testCommitRebase()
+{
+    const QString path = QStringLiteral("folder0/file0.bin");
+    const auto first = queue(QLatin1Char('/') + path, "first", cTag(path));
+    BackgroundUploader uploader(m_journal);
+    QCOMPARE(uploader.upload(first, m_account), BackgroundUploader::Committed);
+
+    // A put() queued while the first upload was being sent.
+    const auto second = queue(QLatin1Char('/') + path, "second", QString(), first.queuedAt.addSecs(1));
+    m_journal->commit(first, cTag(path));
+    UploadJournal::Upload pending;
+    QVERIFY(m_journal->upload(second.path, &pending));
+    QCOMPARE(pending.queuedAt, second.queuedAt);
+    QCOMPARE(pending.baseCTag, cTag(path));
+
+    // Based on the committed version, not on the one it replaced.
+    QCOMPARE(uploader.upload(pending, m_account), BackgroundUploader::Committed);
+    QCOMPARE(m_drive.content(m_drive.idForPath(path)), QByteArray("second"));
+}
+
+void BackgroundUploaderTest::testClaim()
+{
+    const auto upload = queue(QStringLiteral("/folder0/new file.txt"), "hello");
+
+    // Another process is sending it.
+    QLockFile lock(m_journal->lockFile(upload.path));
+    QVERIFY(lock.tryLock(0));
+    BackgroundUploader uploader(m_journal);
+    QCOMPARE(uploader.upload(upload, m_account), BackgroundUploader::Busy);
+    QCOMPARE(m_drive.requestCount(), 0);
+    lock.unlock();
+
+    QCOMPARE(uploader.upload(upload, m_account), BackgroundUploader::Committed);
+    QVERIFY(m_journal->isEmpty());
+
+    // Committed by whoever claimed it first, nothing left to send.
+    m_drive.resetCounters();
+    QCOMPARE(uploader.upload(upload, m_account), BackgroundUploader::Committed);
+    QCOMPARE(m_drive.requestCount(), 0);
+}
+
+#include "backgrounduploadertest.moc"
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "mockgraphserver.h"
+#include "../src/graphbatch.h"
+#include "../src/graphrequest.h"
+
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QTest>
+
+using namespace KMGraph2;
+
+static const int ItemsCount = 500;
+// Simulated round trip to the Graph servers.
+static const int Latency = 5;
+
+class BatchBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testBatchResponses();
+    void testRetries();
+
+    void benchmarkDelete_data();
+    void benchmarkDelete();
+
+private:
+    MockGraphServer m_server;
+    QNetworkAccessManager m_network;
+    AccountPtr m_account;
+};
+
+QTEST_GUILESS_MAIN(BatchBenchmark)
+
+void BatchBenchmark::initTestCase()
+{
+    QVERIFY(m_server.start());
+    qputenv("ONEDRIVE_GRAPH_URL", m_server.url().toString().toLatin1());
+    m_account = AccountPtr(new Account(QStringLiteral("foo@outlook.com"), QStringLiteral("token")));
+}
+
+void BatchBenchmark::init()
+{
+    m_server.setLatency(0);
+    m_server.resetCounters();
+}
+
+void BatchBenchmark::testBatchResponses()
+{
+    GraphBatch batch(&m_network, m_account);
+    for (int i = 0; i < 45; ++i) {
+        QCOMPARE(batch.add("DELETE", QStringLiteral("/items/item%1").arg(i)), i);
+    }
+    QCOMPARE(batch.add("POST", QStringLiteral("/items/unsupported")), 45);
+
+    QVERIFY(batch.exec());
+    QCOMPARE(batch.requestCount(), 3);
+    QCOMPARE(m_server.requestCount(), 3);
+
+    const auto responses = batch.responses();
+    QCOMPARE(responses.size(), 46);
+    for (int i = 0; i < 45; ++i) {
+        QCOMPARE(responses.at(i).status, 204);
+    }
+    QCOMPARE(responses.at(45).status, 501);
+}
+
+void BatchBenchmark::testRetries()
+{
+    // Throttled requests are sent again by themselves, after their Retry-After.
+    GraphBatch throttled(&m_network, m_account);
+    for (int i = 0; i < 5; ++i) {
+        throttled.add("DELETE", QStringLiteral("/items/item%1").arg(i));
+    }
+    m_server.rejectNext(2, 429, 0);
+    QVERIFY(throttled.exec());
+    QCOMPARE(m_server.requestCount(), 2);
+    for (const auto &response : throttled.responses()) {
+        QCOMPARE(response.status, 204);
+    }
+
+    // The requests rejected for an expired token are left for the next exec().
+    m_server.resetCounters();
+    GraphBatch unauthorized(&m_network, m_account);
+    for (int i = 0; i < 5; ++i) {
+        unauthorized.add("DELETE", QStringLiteral("/items/item%1").arg(i));
+    }
+    m_server.rejectNext(2, 401);
+    QVERIFY(!unauthorized.exec());
+    QCOMPARE(unauthorized.statusCode(), 401);
+    int unanswered = 0;
+    for (const auto &response : unauthorized.responses()) {
+        unanswered += response.status == 0 ? 1 : 0;
+    }
+    QCOMPARE(unanswered, 2);
+    QVERIFY(unauthorized.exec());
+    QCOMPARE(m_server.requestCount(), 2);
+    for (const auto &response : unauthorized.responses()) {
+        QCOMPARE(response.status, 204);
+    }
+}
+
+void BatchBenchmark::benchmarkDelete_data()
+{
+    QTest::addColumn<bool>("batched");
+
+    QTest::newRow("one request per item") << false;
+    QTest::newRow("batched") << true;
+}
+
+void BatchBenchmark::benchmarkDelete()
+{
+    QFETCH(bool, batched);
+
+    m_server.setLatency(Latency);
+
+    QElapsedTimer timer;
+    timer.start();
+    if (batched) {
+        GraphBatch batch(&m_network, m_account);
+        for (int i = 0; i < ItemsCount; ++i) {
+            batch.add("DELETE", QStringLiteral("/items/item%1").arg(i));
+        }
+        QVERIFY(batch.exec());
+    } else {
+        for (int i = 0; i < ItemsCount; ++i) {
+            GraphRequest request(&m_network, "DELETE", QStringLiteral("/items/item%1").arg(i));
+            request.setAccount(m_account);
+            QVERIFY(request.exec());
+        }
+    }
+    const qint64 elapsed = timer.elapsed();
+
+    qInfo() << ItemsCount << "deletes:" << m_server.requestCount() << "requests in" << elapsed << "ms";
+    QCOMPARE(m_server.requestCount(), batched ? ItemsCount / GraphBatch::MaxRequests : ItemsCount);
+}
+
+#include "batchbenchmark.moc"
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "../src/credentialsstore.h"
+
+#include <KJob>
+
+#include <QElapsedTimer>
+#include <QTest>
+#include <QTimer>
+
+using namespace KMGraph2;
+
+// Simulated round trip to signond.
+static const int CredentialsLatency = 20;
+static const int AccountsCount = 5;
+
+class StubCredentialsJob : public KJob
+{
+    Q_OBJECT
+
+public:
+    explicit StubCredentialsJob(quint32 id)
+        : m_id(id)
+    {}
+
+    void start() override
+    {
+        QTimer::singleShot(CredentialsLatency, this, [this]() {
+            emitResult();
+        });
+    }
+
+    QVariantMap credentialsData() const
+    {
+        return {
+            {QStringLiteral("AccessToken"), QStringLiteral("access-%1").arg(m_id)},
+            {QStringLiteral("RefreshToken"), QStringLiteral("refresh-%1").arg(m_id)}
+        };
+    }
+
+private:
+    quint32 m_id;
+};
+
+class StubCredentialsStore : public CredentialsStore
+{
+public:
+    int jobsCount = 0;
+
+protected:
+    KJob *createJob(quint32 id) override
+    {
+        ++jobsCount;
+        return new StubCredentialsJob(id);
+    }
+
+    QVariantMap credentialsData(KJob *job) const override
+    {
+        return static_cast<StubCredentialsJob*>(job)->credentialsData();
+    }
+};
+
+class CredentialsBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testLazyLoad();
+    void testParallelLoad();
+
+    void benchmarkStartupEager();
+    void benchmarkStartupLazy();
+    void benchmarkLoadAllParallel();
+
+private:
+    static QList<AccountPtr> registerAccounts(StubCredentialsStore &store);
+    static QList<quint32> allIds();
+};
+
+QTEST_GUILESS_MAIN(CredentialsBenchmark)
+
+QList<AccountPtr> CredentialsBenchmark::registerAccounts(StubCredentialsStore &store)
+{
+    QList<AccountPtr> accounts;
+    for (quint32 id = 0; id < AccountsCount; ++id) {
+        const auto account = AccountPtr(new Account(QStringLiteral("account%1@outlook.com").arg(id)));
+        store.addAccount(id, account);
+        accounts << account;
+    }
+
+    return accounts;
+}
+
+QList<quint32> CredentialsBenchmark::allIds()
+{
+    QList<quint32> ids;
+    for (quint32 id = 0; id < AccountsCount; ++id) {
+        ids << id;
+    }
+
+    return ids;
+}
+
+void CredentialsBenchmark::testLazyLoad()
+{
+    StubCredentialsStore store;
+    const auto accounts = registerAccounts(store);
+    QCOMPARE(store.jobsCount, 0);
+
+    store.load({2});
+    QCOMPARE(store.jobsCount, 1);
+    QVERIFY(store.isLoaded(2));
+    QVERIFY(!store.isLoaded(1));
+    QCOMPARE(accounts.at(2)->accessToken(), QStringLiteral("access-2"));
+    QCOMPARE(accounts.at(2)->refreshToken(), QStringLiteral("refresh-2"));
+    QVERIFY(accounts.at(1)->accessToken().isEmpty());
+
+    // Already loaded, no new job.
+    store.load({2});
+    QCOMPARE(store.jobsCount, 1);
+}
+
+void CredentialsBenchmark::testParallelLoad()
+{
+    StubCredentialsStore store;
+    const auto accounts = registerAccounts(store);
+
+    QElapsedTimer timer;
+    timer.start();
+    store.load(allIds());
+    const auto elapsed = timer.elapsed();
+
+    QCOMPARE(store.jobsCount, AccountsCount);
+    for (quint32 id = 0; id < AccountsCount; ++id) {
+        QVERIFY(store.isLoaded(id));
+        QCOMPARE(accounts.at(id)->accessToken(), QStringLiteral("access-%1").arg(id));
+    }
+
+    // All the jobs ran concurrently, so we waited for roughly one round trip.
+    QVERIFY(elapsed < CredentialsLatency * AccountsCount);
+}
+
+void CredentialsBenchmark::benchmarkStartupEager()
+{
+    // What the worker used to do in its constructor.
+    QBENCHMARK {
+        StubCredentialsStore store;
+        registerAccounts(store);
+        for (const auto id : allIds()) {
+            store.load({id});
+        }
+    }
+}
+
+void CredentialsBenchmark::benchmarkStartupLazy()
+{
+    QBENCHMARK {
+        StubCredentialsStore store;
+        registerAccounts(store);
+    }
+}
+
+void CredentialsBenchmark::benchmarkLoadAllParallel()
+{
+    QBENCHMARK {
+        StubCredentialsStore store;
+        registerAccounts(store);
+        store.load(allIds());
+    }
+}
+
+#include "credentialsbenchmark.moc"
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "mockdrive.h"
+#include "../src/crossaccounttransfer.h"
+
+#include <QTest>
+
+using namespace KMGraph2;
+
+class CrossAccountTransferTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testTransfer_data();
+    void testTransfer();
+    void testAlreadyExists();
+    void testUnauthorized_data();
+    void testUnauthorized();
+
+private:
+    QUrl downloadUrl(const QString &id) const;
+
+    MockDrive m_drive;
+    AccountPtr m_account;
+};
+
+QTEST_GUILESS_MAIN(CrossAccountTransferTest)
+
+void CrossAccountTransferTest::initTestCase()
+{
+    QVERIFY(m_drive.start());
+    qputenv("ONEDRIVE_GRAPH_URL", m_drive.url().toString().toLatin1());
+    m_account = AccountPtr(new Account(QStringLiteral("foo@outlook.com"), QStringLiteral("secret-token")));
+}
+
+void CrossAccountTransferTest::init()
+{
+    MockDrive::Shape shape;
+    shape.depth = 0;
+    shape.files = 1;
+    shape.fileSize = 1024 * 1024;
+    m_drive.generate(shape);
+}
+
+QUrl CrossAccountTransferTest::downloadUrl(const QString &id) const
+{
+    return QUrl(m_drive.url().toString() + QStringLiteral("/download/") + id);
+}
+
+void CrossAccountTransferTest::testTransfer_data()
+{
+    QTest::addColumn<QString>("name");
+    QTest::addColumn<qint64>("size");
+
+    QTest::newRow("plain") << QStringLiteral("copy.bin") << qint64(1024 * 1024);
+    // Neither a fragment nor a query once in the URL.
+    QTest::newRow("reserved characters") << QStringLiteral("a#b?.txt") << qint64(1024 * 1024);
+    QTest::newRow("percent sign") << QStringLiteral("100% done.txt") << qint64(1024 * 1024);
+    QTest::newRow("empty") << QStringLiteral("a#b?.txt") << qint64(0);
+}
+
+void CrossAccountTransferTest::testTransfer()
+{
+    QFETCH(QString, name);
+    QFETCH(qint64, size);
+
+    const QString sourceId = m_drive.fileIds().first();
+    CrossAccountTransfer transfer(downloadUrl(sourceId), size, m_account, m_drive.rootId(), name, false);
+    QVERIFY2(transfer.exec(), qPrintable(transfer.errorString()));
+    QCOMPARE(m_drive.idForPath(name), transfer.createdId());
+    QCOMPARE(m_drive.content(transfer.createdId()), m_drive.content(sourceId).left(int(size)));
+}
+
+void CrossAccountTransferTest::testAlreadyExists()
+{
+    const QString sourceId = m_drive.fileIds().first();
+    CrossAccountTransfer first(downloadUrl(sourceId), 1024 * 1024, m_account, m_drive.rootId(), QStringLiteral("a#b?.txt"), false);
+    QVERIFY(first.exec());
+    CrossAccountTransfer second(downloadUrl(sourceId), 1024 * 1024, m_account, m_drive.rootId(), QStringLiteral("a#b?.txt"), false);
+    QVERIFY(!second.exec());
+    QCOMPARE(second.error(), CrossAccountTransfer::AlreadyExists);
+
+    CrossAccountTransfer replacing(downloadUrl(sourceId), 1024 * 1024, m_account, m_drive.rootId(), QStringLiteral("a#b?.txt"), true);
+    QVERIFY2(replacing.exec(), qPrintable(replacing.errorString()));
+    QCOMPARE(m_drive.idForPath(QStringLiteral("a#b?.txt")), replacing.createdId());
+}
+
+void CrossAccountTransferTest::testUnauthorized_data()
+{
+    QTest::addColumn<qint64>("size");
+
+    QTest::newRow("upload session") << qint64(1024 * 1024);
+    QTest::newRow("empty") << qint64(0);
+}
+
+void CrossAccountTransferTest::testUnauthorized()
+{
+    QFETCH(qint64, size);
+
+    // Rejected before anything was streamed, so that the worker can start
+    // again with a fresh token.
+    const QString sourceId = m_drive.fileIds().first();
+    m_drive.rejectNext(1, 401);
+    CrossAccountTransfer rejected(downloadUrl(sourceId), size, m_account, m_drive.rootId(), QStringLiteral("copy.bin"), false);
+    QVERIFY(!rejected.exec());
+    QCOMPARE(rejected.error(), CrossAccountTransfer::AuthError);
+    QVERIFY(m_drive.idForPath(QStringLiteral("copy.bin")).isEmpty());
+
+    CrossAccountTransfer retried(downloadUrl(sourceId), size, m_account, m_drive.rootId(), QStringLiteral("copy.bin"), false);
+    QVERIFY2(retried.exec(), qPrintable(retried.errorString()));
+    QCOMPARE(m_drive.idForPath(QStringLiteral("copy.bin")), retried.createdId());
+}
+
+#include "crossaccounttransfertest.moc"
@@ -0,0 +1,597 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "mockdrive.h"
+#include "../src/crossaccounttransfer.h"
+#include "../src/drivenavigator.h"
+#include "../src/filedownloader.h"
+#include "../src/graphbatch.h"
+#include "../src/graphrequest.h"
+#include "../src/metrics.h"
+#include "../src/onedrivehelper.h"
+#include "../src/requestscheduler.h"
+#include "../src/subtreelisting.h"
+#include "../src/uploadsession.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QNetworkAccessManager>
+#include <QTemporaryFile>
+#include <QTest>
+#include <QTimer>
+
+#include <KIO/CopyJob>
+#include <KIO/DeleteJob>
+#include <KIO/ListJob>
+#include <KIO/StatJob>
+#include <KIO/StoredTransferJob>
+
+#include <cstdio>
+#include <functional>
+
+using namespace KMGraph2;
+
+// Simulated link to the Graph servers.
+static const int Latency = 5;
+static const qint64 Bandwidth = 50 * 1024 * 1024;
+// Number of items for the operations on single files.
+static const int Samples = 40;
+// A tree of 11110 folders below the root, for the recursive listings.
+static const int SubtreeDepth = 4;
+static const int SubtreeFolders = 10;
+static const int SubtreeLatency = 1;
+// A large download or upload sharing a slower link with the stats of another worker.
+static const qint64 TransferSize = 96 * 1024 * 1024;
+static const qint64 TransferBandwidth = 64 * 1024 * 1024;
+static const int StatInterval = 20;
+
+/**
+ * Measures the latency, throughput and request count of the drive operations
+ * against a synthetic MockDrive, and reports them as JSON on the standard
+ * output, or in the file named by ONEDRIVE_BENCHMARK_REPORT.
+ *
+ * The account credentials of the worker cannot be pointed to the mock, so
+ * the operations are run through the helpers the worker sends its own
+ * requests with, e.g. DriveNavigator or FileDownloader, and named after what
+ * they measure: they leave out the caches and the command logic of the worker.
+ * When ONEDRIVE_BENCHMARK_URL names a writable folder, e.g.
+ * onedrive:/foo@outlook.com/benchmark, the same operations are also run
+ * through real KIO jobs against it, and reported under "kio".
+ */
+class DriveBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+
+    void benchmarkListDir();
+    void benchmarkListRecursive();
+    void benchmarkStat();
+    void benchmarkStatDuringGet();
+    void benchmarkStatDuringPut();
+    void benchmarkGet();
+    void benchmarkPut();
+    void benchmarkCopy();
+    void benchmarkCopyAcrossAccounts();
+    void benchmarkDel();
+
+    void benchmarkKioJobs();
+
+private:
+    QJsonObject report(const Metrics::Histogram &latencies, qint64 elapsed, qint64 bytes, int requests) const;
+    void measureStatDuringGet(const QString &name, RequestScheduler::Priority priority);
+    void measureStatDuringPut(const QString &name, RequestScheduler::Priority priority);
+    /**
+     * Runs @p transfer while another worker stats a file, and reports the
+     * latencies of the stats.
+     */
+    void measureStatDuring(const QString &name, RequestScheduler::Priority priority, const std::function<bool()> &transfer);
+
+    MockDrive m_drive;
+    MockDrive::Shape m_shape;
+    QNetworkAccessManager m_network;
+    AccountPtr m_account;
+    QStringList m_uploadedIds;
+    QJsonObject m_operations;
+    QJsonObject m_kioOperations;
+};
+
+QTEST_GUILESS_MAIN(DriveBenchmark)
+
+void DriveBenchmark::initTestCase()
+{
+    QVERIFY(m_drive.start());
+    qputenv("ONEDRIVE_GRAPH_URL", m_drive.url().toString().toLatin1());
+    m_account = AccountPtr(new Account(QStringLiteral("foo@outlook.com"), QStringLiteral("token")));
+
+    m_shape.depth = 3;
+    m_shape.folders = 4;
+    m_shape.files = 8;
+    m_shape.fileSize = 256 * 1024;
+    m_drive.generate(m_shape);
+    m_drive.setLatency(Latency);
+    m_drive.setBandwidth(Bandwidth);
+}
+
+void DriveBenchmark::cleanupTestCase()
+{
+    QJsonObject server;
+    server.insert(QStringLiteral("latencyMs"), Latency);
+    server.insert(QStringLiteral("bandwidthBytesPerSecond"), double(Bandwidth));
+
+    QJsonObject drive;
+    drive.insert(QStringLiteral("depth"), m_shape.depth);
+    drive.insert(QStringLiteral("folders"), m_drive.folderIds().size());
+    drive.insert(QStringLiteral("files"), m_drive.fileIds().size());
+    drive.insert(QStringLiteral("fileSize"), double(m_shape.fileSize));
+
+    QJsonObject json;
+    json.insert(QStringLiteral("server"), server);
+    json.insert(QStringLiteral("drive"), drive);
+    json.insert(QStringLiteral("operations"), m_operations);
+    if (!m_kioOperations.isEmpty()) {
+        json.insert(QStringLiteral("kio"), m_kioOperations);
+    }
+
+    const QByteArray text = QJsonDocument(json).toJson();
+    const QString fileName = QString::fromLocal8Bit(qgetenv("ONEDRIVE_BENCHMARK_REPORT"));
+    if (fileName.isEmpty()) {
+        fprintf(stdout, "%s", text.constData());
+        return;
+    }
+
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(text);
+}
+
+void DriveBenchmark::init()
+{
+    m_drive.resetCounters();
+}
+
+QJsonObject DriveBenchmark::report(const Metrics::Histogram &latencies, qint64 elapsed, qint64 bytes, int requests) const
+{
+    QJsonObject json;
+    json.insert(QStringLiteral("count"), double(latencies.count()));
+    json.insert(QStringLiteral("totalMs"), double(elapsed));
+    json.insert(QStringLiteral("meanMs"), latencies.count() ? latencies.sum() / 1000.0 / latencies.count() : 0.0);
+    json.insert(QStringLiteral("p50Ms"), latencies.percentile(50) / 1000.0);
+    json.insert(QStringLiteral("p99Ms"), latencies.percentile(99) / 1000.0);
+    if (requests >= 0) {
+        json.insert(QStringLiteral("requests"), requests);
+    }
+    if (bytes > 0) {
+        json.insert(QStringLiteral("bytes"), double(bytes));
+        json.insert(QStringLiteral("throughputMiBps"), elapsed > 0 ? bytes * 1000.0 / elapsed / (1024 * 1024) : 0.0);
+    }
+    return json;
+}
+
+void DriveBenchmark::benchmarkListDir()
+{
+    Metrics::Histogram latencies;
+    QElapsedTimer total;
+    total.start();
+    for (const auto &folderId : m_drive.folderIds()) {
+        QElapsedTimer timer;
+        timer.start();
+        int listed = 0;
+        QVERIFY(DriveNavigator(m_account).children(folderId, [&listed](const QJsonObject &) {
+            ++listed;
+        }));
+        latencies.record(timer.nsecsElapsed() / 1000);
+        QVERIFY(listed > 0);
+    }
+
+    m_operations.insert(QStringLiteral("listChildren"), report(latencies, total.elapsed(), 0, m_drive.requestCount()));
+}
+
+void DriveBenchmark::benchmarkListRecursive()
+{
+    // The drive is replaced for the time of this benchmark.
+    MockDrive::Shape shape;
+    shape.depth = SubtreeDepth;
+    shape.folders = SubtreeFolders;
+    shape.files = 1;
+    shape.fileSize = 1024;
+    m_drive.generate(shape);
+    m_drive.setLatency(SubtreeLatency);
+    const int items = m_drive.folderIds().size() + m_drive.fileIds().size() - 1;
+
+    const auto fetchAll = [this](const QString &path, const std::function<void(const QJsonObject &)> &onItem) {
+        QUrl next;
+        do {
+            GraphRequest request(&m_network, "GET", path);
+            request.setAccount(m_account);
+            if (next.isValid()) {
+                request.setUrl(next);
+            }
+            if (!request.exec()) {
+                return false;
+            }
+            const auto values = request.response().value(QStringLiteral("value")).toArray();
+            for (const auto &value : values) {
+                onItem(value.toObject());
+            }
+            next = QUrl(request.response().value(QStringLiteral("@odata.nextLink")).toString());
+        } while (next.isValid());
+        return true;
+    };
+
+    // Before: what KIO::listRecursive() costs, one listing per folder.
+    {
+        Metrics::Histogram latencies;
+        QElapsedTimer total;
+        total.start();
+        int listed = 0;
+        QStringList folders = {m_drive.rootId()};
+        while (!folders.isEmpty()) {
+            const QString folderId = folders.takeFirst();
+            QElapsedTimer timer;
+            timer.start();
+            QVERIFY(fetchAll(QStringLiteral("/items/%1/children").arg(folderId), [&](const QJsonObject &item) {
+                ++listed;
+                if (item.contains(QStringLiteral("folder"))) {
+                    folders << item.value(QStringLiteral("id")).toString();
+                }
+            }));
+            latencies.record(timer.nsecsElapsed() / 1000);
+        }
+        QCOMPARE(listed, items);
+        QJsonObject json = report(latencies, total.elapsed(), 0, m_drive.requestCount());
+        json.insert(QStringLiteral("folders"), m_drive.folderIds().size());
+        json.insert(QStringLiteral("latencyMs"), SubtreeLatency);
+        m_operations.insert(QStringLiteral("listRecursivePerFolder"), json);
+    }
+
+    // After: the change feed of the root, enumerated from scratch.
+    m_drive.resetCounters();
+    {
+        Metrics::Histogram latencies;
+        QElapsedTimer total;
+        total.start();
+        SubtreeListing listing((QString()));
+        int listed = 0;
+        QVERIFY(fetchAll(QStringLiteral("/root/delta"), [&](const QJsonObject &item) {
+            listed += listing.add(item).size();
+        }));
+        latencies.record(total.nsecsElapsed() / 1000);
+        QCOMPARE(listed, items);
+        QCOMPARE(listing.pendingCount(), 0);
+        QJsonObject json = report(latencies, total.elapsed(), 0, m_drive.requestCount());
+        json.insert(QStringLiteral("folders"), m_drive.folderIds().size());
+        json.insert(QStringLiteral("latencyMs"), SubtreeLatency);
+        m_operations.insert(QStringLiteral("listRecursiveDelta"), json);
+    }
+
+    m_drive.generate(m_shape);
+    m_drive.setLatency(Latency);
+}
+
+void DriveBenchmark::benchmarkStat()
+{
+    Metrics::Histogram latencies;
+    QElapsedTimer total;
+    total.start();
+    // What stat() sends for a file of a known folder: the lookup of its
+    // name, then the fetch of the item.
+    const QStringList folderIds = m_drive.folderIds();
+    for (int i = 0; i < Samples; ++i) {
+        const QString folderId = folderIds.at(i / m_shape.files);
+        QElapsedTimer timer;
+        timer.start();
+        DriveNavigator navigator(m_account);
+        QJsonObject child;
+        QVERIFY(navigator.child(folderId, QStringLiteral("file%1.bin").arg(i % m_shape.files), DriveNavigator::AnyItem, &child));
+        const QString fileId = child.value(QStringLiteral("id")).toString();
+        QJsonObject item;
+        QVERIFY(navigator.item(fileId, &item));
+        latencies.record(timer.nsecsElapsed() / 1000);
+        QCOMPARE(item.value(QStringLiteral("id")).toString(), fileId);
+    }
+
+    m_operations.insert(QStringLiteral("resolveAndFetchItem"), report(latencies, total.elapsed(), 0, m_drive.requestCount()));
+}
+
+void DriveBenchmark::benchmarkStatDuringGet()
+{
+    // The drive is replaced for the time of this benchmark.
+    MockDrive::Shape shape;
+    shape.depth = 0;
+    shape.files = 1;
+    shape.fileSize = TransferSize;
+    m_drive.generate(shape);
+    m_drive.setBandwidth(TransferBandwidth);
+    m_drive.setSharedLink(true);
+
+    // Before: the download runs as it would without any scheduling.
+    measureStatDuringGet(QStringLiteral("statDuringGetUnscheduled"), RequestScheduler::Interactive);
+    // After: as a foreground transfer, which gives way to the stats.
+    if (!QTest::currentTestFailed()) {
+        measureStatDuringGet(QStringLiteral("statDuringGetScheduled"), RequestScheduler::Transfer);
+    }
+
+    m_drive.setSharedLink(false);
+    m_drive.setBandwidth(Bandwidth);
+    m_drive.generate(m_shape);
+}
+
+void DriveBenchmark::benchmarkStatDuringPut()
+{
+    MockDrive::Shape shape;
+    shape.depth = 0;
+    shape.files = 1;
+    shape.fileSize = 1024;
+    m_drive.generate(shape);
+    m_drive.setBandwidth(TransferBandwidth);
+    m_drive.setSharedLink(true);
+
+    measureStatDuringPut(QStringLiteral("statDuringPutUnscheduled"), RequestScheduler::Interactive);
+    if (!QTest::currentTestFailed()) {
+        measureStatDuringPut(QStringLiteral("statDuringPutScheduled"), RequestScheduler::Transfer);
+    }
+
+    m_drive.setSharedLink(false);
+    m_drive.setBandwidth(Bandwidth);
+    m_drive.generate(m_shape);
+}
+
+void DriveBenchmark::measureStatDuringGet(const QString &name, RequestScheduler::Priority priority)
+{
+    m_drive.resetCounters();
+    const QString fileId = m_drive.fileIds().first();
+    GraphRequest request(&m_network, "GET", QStringLiteral("/items/%1").arg(fileId));
+    request.setAccount(m_account);
+    QVERIFY(request.exec());
+    const QUrl downloadUrl(request.response().value(QStringLiteral("@microsoft.graph.downloadUrl")).toString());
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    measureStatDuring(name, priority, [&]() {
+        FileDownloader downloader(downloadUrl, &file, 0, TransferSize);
+        if (!downloader.exec()) {
+            qWarning() << downloader.errorString();
+            return false;
+        }
+        return file.size() == TransferSize;
+    });
+}
+
+void DriveBenchmark::measureStatDuringPut(const QString &name, RequestScheduler::Priority priority)
+{
+    m_drive.resetCounters();
+    QByteArray data(int(TransferSize), 'x');
+    QBuffer buffer(&data);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    // As put() and copy() from a local file send large files.
+    measureStatDuring(name, priority, [&]() {
+        UploadSession session(m_account, QStringLiteral("/items/%1:/%2.bin:").arg(m_drive.rootId(), name));
+        if (!session.exec(&buffer, data.size())) {
+            qWarning() << session.errorString();
+            return false;
+        }
+        return session.item().value(QStringLiteral("size")).toVariant().toLongLong() == TransferSize;
+    });
+}
+
+void DriveBenchmark::measureStatDuring(const QString &name, RequestScheduler::Priority priority, const std::function<bool()> &transfer)
+{
+    const QString fileId = m_drive.fileIds().first();
+
+    // What another worker browsing the drive meanwhile would send.
+    Metrics::Histogram latencies;
+    bool statting = false;
+    QTimer statTimer;
+    statTimer.setInterval(StatInterval);
+    connect(&statTimer, &QTimer::timeout, this, [&]() {
+        if (statting) {
+            return;
+        }
+        statting = true;
+        RequestScheduler::Scope scope(RequestScheduler::Interactive);
+        QElapsedTimer timer;
+        timer.start();
+        GraphRequest stat(&m_network, "GET", QStringLiteral("/items/%1").arg(fileId));
+        stat.setAccount(m_account);
+        if (stat.exec()) {
+            latencies.record(timer.nsecsElapsed() / 1000);
+        }
+        statting = false;
+    });
+
+    RequestScheduler::Scope scope(priority);
+    QElapsedTimer total;
+    total.start();
+    statTimer.start();
+    const bool transferred = transfer();
+    statTimer.stop();
+    QVERIFY(transferred);
+    QVERIFY(latencies.count() > 0);
+
+    QJsonObject json = report(latencies, total.elapsed(), TransferSize, m_drive.requestCount());
+    json.insert(QStringLiteral("bandwidthBytesPerSecond"), double(TransferBandwidth));
+    m_operations.insert(name, json);
+}
+
+void DriveBenchmark::benchmarkGet()
+{
+    Metrics::Histogram latencies;
+    qint64 bytes = 0;
+    QElapsedTimer total;
+    total.start();
+    for (const auto &fileId : m_drive.fileIds().mid(0, Samples)) {
+        QElapsedTimer timer;
+        timer.start();
+        QJsonObject item;
+        QVERIFY(DriveNavigator(m_account).item(fileId, &item));
+        const QUrl downloadUrl(item.value(QStringLiteral("@microsoft.graph.downloadUrl")).toString());
+        const qint64 size = item.value(QStringLiteral("size")).toVariant().toLongLong();
+
+        QTemporaryFile file;
+        QVERIFY(file.open());
+        FileDownloader downloader(downloadUrl, &file, 0, size);
+        QVERIFY2(downloader.exec(), qPrintable(downloader.errorString()));
+        latencies.record(timer.nsecsElapsed() / 1000);
+        QCOMPARE(file.size(), size);
+        bytes += size;
+    }
+
+    m_operations.insert(QStringLiteral("fetchAndDownload"), report(latencies, total.elapsed(), bytes, m_drive.requestCount()));
+}
+
+void DriveBenchmark::benchmarkPut()
+{
+    const QByteArray data(int(m_shape.fileSize), 'x');
+
+    Metrics::Histogram latencies;
+    QElapsedTimer total;
+    total.start();
+    for (int i = 0; i < Samples; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        GraphRequest request(&m_network, "PUT", QStringLiteral("/items/%1:/upload%2.bin:/content").arg(m_drive.rootId()).arg(i));
+        request.setAccount(m_account);
+        request.setContent(data);
+        QVERIFY2(request.exec(), qPrintable(request.errorString()));
+        QCOMPARE(request.statusCode(), 201);
+        latencies.record(timer.nsecsElapsed() / 1000);
+        m_uploadedIds << request.response().value(QStringLiteral("id")).toString();
+    }
+
+    m_operations.insert(QStringLiteral("simpleUpload"), report(latencies, total.elapsed(), qint64(Samples) * data.size(), m_drive.requestCount()));
+}
+
+void DriveBenchmark::benchmarkCopy()
+{
+    // The requests of FileCopyJob: the copy, then its monitor.
+    const QStringList fileIds = m_drive.fileIds().mid(0, 8);
+    Metrics::Histogram latencies;
+    QElapsedTimer total;
+    total.start();
+    for (int i = 0; i < fileIds.size(); ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        QJsonObject parentReference;
+        parentReference.insert(QStringLiteral("id"), m_drive.rootId());
+        QJsonObject body;
+        body.insert(QStringLiteral("parentReference"), parentReference);
+        body.insert(QStringLiteral("name"), QStringLiteral("copy%1.bin").arg(i));
+        GraphRequest copy(&m_network, "POST", QStringLiteral("/items/%1/copy").arg(fileIds.at(i)), body);
+        copy.setAccount(m_account);
+        QVERIFY2(copy.exec(), qPrintable(copy.errorString()));
+        QCOMPARE(copy.statusCode(), 202);
+
+        GraphRequest monitor(&m_network, "GET", QString());
+        monitor.setAccount(m_account);
+        monitor.setUrl(copy.location());
+        QVERIFY2(monitor.exec(), qPrintable(monitor.errorString()));
+        latencies.record(timer.nsecsElapsed() / 1000);
+        QCOMPARE(monitor.response().value(QStringLiteral("status")).toString(), QStringLiteral("completed"));
+        QCOMPARE(m_drive.content(monitor.response().value(QStringLiteral("resourceId")).toString()), m_drive.content(fileIds.at(i)));
+    }
+
+    m_operations.insert(QStringLiteral("fileCopy"), report(latencies, total.elapsed(), 0, m_drive.requestCount()));
+}
+
+void DriveBenchmark::benchmarkCopyAcrossAccounts()
+{
+    Metrics::Histogram latencies;
+    qint64 bytes = 0;
+    QElapsedTimer total;
+    total.start();
+    const QStringList fileIds = m_drive.fileIds().mid(0, 8);
+    for (int i = 0; i < fileIds.size(); ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        const QUrl downloadUrl(m_drive.url().toString() + QStringLiteral("/download/") + fileIds.at(i));
+        CrossAccountTransfer transfer(downloadUrl, m_shape.fileSize, m_account, m_drive.rootId(),
+                                      QStringLiteral("transfer%1.bin").arg(i), false);
+        QVERIFY2(transfer.exec(), qPrintable(transfer.errorString()));
+        latencies.record(timer.nsecsElapsed() / 1000);
+        QCOMPARE(m_drive.content(transfer.createdId()), m_drive.content(fileIds.at(i)));
+        bytes += m_shape.fileSize;
+    }
+
+    m_operations.insert(QStringLiteral("copyAcrossAccounts"), report(latencies, total.elapsed(), bytes, m_drive.requestCount()));
+}
+
+void DriveBenchmark::benchmarkDel()
+{
+    QVERIFY(!m_uploadedIds.isEmpty());
+
+    // The deletions queued by consecutive del() calls, sent by batches of
+    // GraphBatch::MaxRequests. The latency is the one of each batch.
+    Metrics::Histogram latencies;
+    QElapsedTimer total;
+    total.start();
+    for (int i = 0; i < m_uploadedIds.size(); i += GraphBatch::MaxRequests) {
+        QElapsedTimer timer;
+        timer.start();
+        GraphBatch batch(&m_network, m_account);
+        for (const auto &id : m_uploadedIds.mid(i, GraphBatch::MaxRequests)) {
+            batch.add("DELETE", QStringLiteral("/items/%1").arg(id));
+        }
+        QVERIFY2(batch.exec(), qPrintable(batch.errorString()));
+        latencies.record(timer.nsecsElapsed() / 1000);
+        for (const auto &response : batch.responses()) {
+            QCOMPARE(response.status, 204);
+        }
+    }
+
+    m_operations.insert(QStringLiteral("queuedDeletes"), report(latencies, total.elapsed(), 0, m_drive.requestCount()));
+}
+
+void DriveBenchmark::benchmarkKioJobs()
+{
+    const QUrl base(QString::fromLocal8Bit(qgetenv("ONEDRIVE_BENCHMARK_URL")));
+    if (base.isEmpty()) {
+        QSKIP("Set ONEDRIVE_BENCHMARK_URL to run KIO jobs against a real drive");
+    }
+
+    const QUrl fileUrl(base.toString() + QStringLiteral("/kio-benchmark.bin"));
+    const QUrl copyUrl(base.toString() + QStringLiteral("/kio-benchmark-copy.bin"));
+    const QByteArray data(int(m_shape.fileSize), 'x');
+
+    const auto run = [this](const QString &name, KJob *job, qint64 bytes) {
+        QElapsedTimer timer;
+        timer.start();
+        const bool ok = job->exec();
+        Metrics::Histogram latencies;
+        latencies.record(timer.nsecsElapsed() / 1000);
+        m_kioOperations.insert(name, report(latencies, timer.elapsed(), bytes, -1));
+        return ok;
+    };
+
+    QVERIFY(run(QStringLiteral("listDir"), KIO::listDir(base, KIO::HideProgressInfo), 0));
+    QVERIFY(run(QStringLiteral("put"), KIO::storedPut(data, fileUrl, -1, KIO::Overwrite | KIO::HideProgressInfo), data.size()));
+    QVERIFY(run(QStringLiteral("stat"), KIO::stat(fileUrl, KIO::HideProgressInfo), 0));
+    QVERIFY(run(QStringLiteral("get"), KIO::storedGet(fileUrl, KIO::NoReload, KIO::HideProgressInfo), data.size()));
+    QVERIFY(run(QStringLiteral("copy"), KIO::copy(fileUrl, copyUrl, KIO::Overwrite | KIO::HideProgressInfo), 0));
+    QVERIFY(run(QStringLiteral("del"), KIO::del(QList<QUrl>() << fileUrl << copyUrl, KIO::HideProgressInfo), 0));
+}
+
+#include "drivebenchmark.moc"
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "mockdrive.h"
+#include "../src/filedownloader.h"
+
+#include <QTemporaryFile>
+#include <QTest>
+
+class FileDownloaderTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testDownload();
+    void testResume();
+    void testExpiredUrl();
+
+private:
+    QUrl downloadUrl(const QString &id) const;
+
+    MockDrive m_drive;
+};
+
+QTEST_GUILESS_MAIN(FileDownloaderTest)
+
+void FileDownloaderTest::initTestCase()
+{
+    QVERIFY(m_drive.start());
+    MockDrive::Shape shape;
+    shape.depth = 0;
+    shape.files = 1;
+    shape.fileSize = 3 * 1024 * 1024;
+    m_drive.generate(shape);
+}
+
+QUrl FileDownloaderTest::downloadUrl(const QString &id) const
+{
+    return QUrl(m_drive.url().toString() + QStringLiteral("/download/") + id);
+}
+
+void FileDownloaderTest::testDownload()
+{
+    const QString id = m_drive.fileIds().first();
+    QTemporaryFile file;
+    QVERIFY(file.open());
+
+    FileDownloader downloader(downloadUrl(id), &file, 0, 3 * 1024 * 1024);
+    QVERIFY2(downloader.exec(), qPrintable(downloader.errorString()));
+    QCOMPARE(downloader.statusCode(), 0);
+    file.seek(0);
+    QCOMPARE(file.readAll(), m_drive.content(id));
+}
+
+void FileDownloaderTest::testResume()
+{
+    const QString id = m_drive.fileIds().first();
+    const QByteArray content = m_drive.content(id);
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(content.left(1024));
+
+    FileDownloader downloader(downloadUrl(id), &file, 1024, content.size());
+    QVERIFY2(downloader.exec(), qPrintable(downloader.errorString()));
+    file.seek(0);
+    QCOMPARE(file.readAll(), content);
+}
+
+void FileDownloaderTest::testExpiredUrl()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+
+    // The caller tells an expired URL apart, to ask for a new one.
+    m_drive.rejectNext(1, 403);
+    FileDownloader downloader(downloadUrl(m_drive.fileIds().first()), &file, 0, 3 * 1024 * 1024);
+    QVERIFY(!downloader.exec());
+    QCOMPARE(downloader.statusCode(), 403);
+    QVERIFY(!downloader.errorString().isEmpty());
+}
+
+#include "filedownloadertest.moc"
@@ -0,0 +1,349 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "mockdrive.h"
+#include "../src/crossaccounttransfer.h"
+#include "../src/drivenavigator.h"
+#include "../src/filedownloader.h"
+#include "../src/fixturenetworkaccessmanager.h"
+#include "../src/graphbatch.h"
+#include "../src/graphrequest.h"
+#include "../src/onedrivehelper.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+#include <QTest>
+
+using namespace KMGraph2;
+
+// Replays take this long per request, plus their size at this bandwidth.
+static const int SyntheticLatency = 100;
+static const qint64 SyntheticBandwidth = 1024 * 1024;
+
+/**
+ * Records common workflows against a MockDrive through ONEDRIVE_FIXTURE_RECORD,
+ * replays the recordings offline, and fails when a workflow sends more
+ * requests, or waits more synthetic time, than in fixtures/baseline.json.
+ *
+ * The workflows send their requests the way the worker does: through
+ * DriveNavigator to resolve, list and stat paths, FileDownloader to get files,
+ * GraphRequest to create folders and files, CrossAccountTransfer for copies
+ * and GraphBatch for queued deletions. A
+ * replay that sends a request missing from the recording fails too. Update
+ * the baseline when a change of the request count is intended.
+ */
+class FixtureRegressionTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanup();
+
+    void testScrubbedTarget();
+    void testRecordAndReplay();
+
+    void testWorkflow_data();
+    void testWorkflow();
+
+private:
+    void runWorkflow(const QString &name);
+    void browse();
+    void open();
+    void crossAccountCopy();
+    void create();
+    void queuedDeletes();
+    void download(const QJsonObject &item);
+
+    MockDrive m_drive;
+    AccountPtr m_account;
+    QJsonObject m_baseline;
+    /** The items the workflows work on, looked up before anything changes. */
+    QHash<QString, QString> m_ids;
+};
+
+QTEST_GUILESS_MAIN(FixtureRegressionTest)
+
+void FixtureRegressionTest::initTestCase()
+{
+    QVERIFY(m_drive.start());
+    qputenv("ONEDRIVE_GRAPH_URL", m_drive.url().toString().toLatin1());
+    m_account = AccountPtr(new Account(QStringLiteral("foo@outlook.com"), QStringLiteral("secret-token")));
+
+    MockDrive::Shape shape;
+    shape.depth = 1;
+    shape.folders = 2;
+    shape.files = 3;
+    shape.fileSize = 1024;
+    m_drive.generate(shape);
+    for (const QString &path : {QStringLiteral("folder0"), QStringLiteral("folder0/file0.bin"),
+                                QStringLiteral("folder1/file1.bin"), QStringLiteral("folder1/file2.bin")}) {
+        m_ids.insert(path, m_drive.idForPath(path));
+        QVERIFY(!m_ids.value(path).isEmpty());
+    }
+
+    QFile baseline(QFINDTESTDATA("fixtures/baseline.json"));
+    QVERIFY(baseline.open(QIODevice::ReadOnly));
+    m_baseline = QJsonDocument::fromJson(baseline.readAll()).object();
+    QVERIFY(!m_baseline.isEmpty());
+}
+
+void FixtureRegressionTest::cleanup()
+{
+    OneDriveHelper::setNetworkAccessManager(nullptr);
+}
+
+void FixtureRegressionTest::testScrubbedTarget()
+{
+    QCOMPARE(FixtureNetworkAccessManager::scrubbedTarget(QUrl(QStringLiteral("https://public.bn.files.1drv.com/y4mX/a.txt?tempauth=abc&download=1"))),
+             QStringLiteral("/y4mX/a.txt?tempauth=scrubbed&download=1"));
+    QCOMPARE(FixtureNetworkAccessManager::scrubbedTarget(QUrl(QStringLiteral("https://graph.microsoft.com/v1.0/me/drive/items/1?access_token=abc"))),
+             QStringLiteral("/v1.0/me/drive/items/1?access_token=scrubbed"));
+    QCOMPARE(FixtureNetworkAccessManager::scrubbedTarget(QUrl(QStringLiteral("https://graph.microsoft.com/v1.0/me/drive/items/1"))),
+             QStringLiteral("/v1.0/me/drive/items/1"));
+}
+
+void FixtureRegressionTest::testRecordAndReplay()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(QStringLiteral("children.json"));
+    const QString path = QStringLiteral("/items/%1/children").arg(m_drive.rootId());
+
+    QJsonObject recorded;
+    {
+        FixtureNetworkAccessManager recorder(FixtureNetworkAccessManager::Record, fileName);
+        GraphRequest request(&recorder, "GET", path);
+        request.setAccount(m_account);
+        QVERIFY(request.exec());
+        recorded = request.response();
+        QCOMPARE(recorder.requestCount(), 1);
+    }
+
+    QFile fixture(fileName);
+    QVERIFY(fixture.open(QIODevice::ReadOnly));
+    const QByteArray data = fixture.readAll();
+    QVERIFY(!data.contains("secret-token"));
+    QVERIFY(!data.contains("Authorization"));
+
+    FixtureNetworkAccessManager player(FixtureNetworkAccessManager::Replay, fileName);
+    QVERIFY(player.isValid());
+    player.setTiming(FixtureNetworkAccessManager::SyntheticTiming, false);
+    player.setSyntheticTiming(100, 0);
+
+    GraphRequest request(&player, "GET", path);
+    request.setAccount(m_account);
+    QVERIFY(request.exec());
+    QCOMPARE(request.response().value(QStringLiteral("value")).toArray().size(),
+             recorded.value(QStringLiteral("value")).toArray().size());
+    QCOMPARE(player.simulatedLatency(), qint64(100));
+    QCOMPARE(player.unusedCount(), 0);
+
+    // The exchange was used up.
+    QVERIFY(!request.exec());
+    QCOMPARE(request.statusCode(), 404);
+    QCOMPARE(player.unmatchedCount(), 1);
+}
+
+void FixtureRegressionTest::testWorkflow_data()
+{
+    QTest::addColumn<QString>("name");
+
+    // In this order: the later ones change the drive.
+    QTest::newRow("browse") << QStringLiteral("browse");
+    QTest::newRow("open") << QStringLiteral("open");
+    QTest::newRow("crossaccount") << QStringLiteral("crossaccount");
+    QTest::newRow("create") << QStringLiteral("create");
+    QTest::newRow("deletes") << QStringLiteral("deletes");
+}
+
+void FixtureRegressionTest::testWorkflow()
+{
+    QFETCH(QString, name);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(name + QStringLiteral(".json"));
+
+    // Recorded the way the worker records, through its shared manager.
+    qputenv("ONEDRIVE_FIXTURE_RECORD", QFile::encodeName(fileName));
+    OneDriveHelper::setNetworkAccessManager(nullptr);
+    auto recorder = qobject_cast<FixtureNetworkAccessManager *>(OneDriveHelper::networkAccessManager());
+    qunsetenv("ONEDRIVE_FIXTURE_RECORD");
+    QVERIFY(recorder);
+    QCOMPARE(recorder->mode(), FixtureNetworkAccessManager::Record);
+    runWorkflow(name);
+    const int recordedCount = recorder->requestCount();
+    delete recorder;
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    FixtureNetworkAccessManager player(FixtureNetworkAccessManager::Replay, fileName);
+    QVERIFY(player.isValid());
+    player.setTiming(FixtureNetworkAccessManager::SyntheticTiming, false);
+    player.setSyntheticTiming(SyntheticLatency, SyntheticBandwidth);
+    OneDriveHelper::setNetworkAccessManager(&player);
+    runWorkflow(name);
+    if (QTest::currentTestFailed()) {
+        return;
+    }
+
+    const auto baseline = m_baseline.value(name).toObject();
+    qDebug() << name << "sent" << player.requestCount() << "requests, simulated latency" << player.simulatedLatency() << "ms";
+    QCOMPARE(player.unmatchedCount(), 0);
+    QCOMPARE(player.unusedCount(), 0);
+    QCOMPARE(player.requestCount(), recordedCount);
+    QVERIFY2(player.requestCount() <= baseline.value(QStringLiteral("requests")).toInt(),
+             qPrintable(QStringLiteral("%1 requests, baseline is %2").arg(player.requestCount())
+                        .arg(baseline.value(QStringLiteral("requests")).toInt())));
+    QVERIFY2(player.simulatedLatency() <= qint64(baseline.value(QStringLiteral("latency")).toDouble()),
+             qPrintable(QStringLiteral("%1 ms of simulated latency, baseline is %2 ms").arg(player.simulatedLatency())
+                        .arg(baseline.value(QStringLiteral("latency")).toDouble())));
+}
+
+void FixtureRegressionTest::runWorkflow(const QString &name)
+{
+    if (name == QLatin1String("browse")) {
+        browse();
+    } else if (name == QLatin1String("open")) {
+        open();
+    } else if (name == QLatin1String("crossaccount")) {
+        crossAccountCopy();
+    } else if (name == QLatin1String("create")) {
+        create();
+    } else {
+        queuedDeletes();
+    }
+}
+
+void FixtureRegressionTest::download(const QJsonObject &item)
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    const qint64 size = qint64(item.value(QStringLiteral("size")).toDouble());
+    FileDownloader downloader(QUrl(item.value(QStringLiteral("@microsoft.graph.downloadUrl")).toString()), &file, 0, size);
+    QVERIFY2(downloader.exec(), qPrintable(downloader.errorString()));
+    QCOMPARE(file.size(), size);
+}
+
+void FixtureRegressionTest::browse()
+{
+    // listDir() of the drive and of its folders, whose listings fill the path
+    // cache, then stat() and get() of a file, which share one fetch.
+    DriveNavigator navigator(m_account);
+    QStringList folderIds;
+    QVERIFY(navigator.children(m_drive.rootId(), [&](const QJsonObject &item) {
+        if (item.contains(QStringLiteral("folder"))) {
+            folderIds << item.value(QStringLiteral("id")).toString();
+        }
+    }));
+    QCOMPARE(folderIds.size(), 2);
+
+    QString fileId;
+    for (const auto &folderId : qAsConst(folderIds)) {
+        QVERIFY(navigator.children(folderId, [&](const QJsonObject &item) {
+            if (fileId.isEmpty() && !item.contains(QStringLiteral("folder"))) {
+                fileId = item.value(QStringLiteral("id")).toString();
+            }
+        }));
+    }
+    QCOMPARE(fileId, m_ids.value(QStringLiteral("folder0/file0.bin")));
+
+    QJsonObject item;
+    QVERIFY(navigator.item(fileId, &item));
+    download(item);
+}
+
+void FixtureRegressionTest::open()
+{
+    // A fresh worker asked for a file by path: each component is looked up,
+    // then the file is stat'ed and downloaded.
+    DriveNavigator navigator(m_account);
+    QJsonObject folder;
+    QVERIFY(navigator.child(m_drive.rootId(), QStringLiteral("folder1"), DriveNavigator::FolderItem, &folder));
+    QVERIFY(!folder.isEmpty());
+    QJsonObject file;
+    QVERIFY(navigator.child(folder.value(QStringLiteral("id")).toString(), QStringLiteral("file2.bin"), DriveNavigator::FileItem, &file));
+    QCOMPARE(file.value(QStringLiteral("id")).toString(), m_ids.value(QStringLiteral("folder1/file2.bin")));
+
+    QJsonObject item;
+    QVERIFY(navigator.item(m_ids.value(QStringLiteral("folder1/file2.bin")), &item));
+    download(item);
+}
+
+void FixtureRegressionTest::crossAccountCopy()
+{
+    // The source is fetched for its download URL, then streamed to the
+    // destination drive, here the same one.
+    DriveNavigator navigator(m_account);
+    QJsonObject item;
+    QVERIFY(navigator.item(m_ids.value(QStringLiteral("folder0/file0.bin")), &item));
+    CrossAccountTransfer transfer(QUrl(item.value(QStringLiteral("@microsoft.graph.downloadUrl")).toString()),
+                                  qint64(item.value(QStringLiteral("size")).toDouble()),
+                                  m_account, m_drive.rootId(), QStringLiteral("file0 copy.bin"), false);
+    QVERIFY2(transfer.exec(), qPrintable(transfer.errorString()));
+    QVERIFY(!transfer.createdId().isEmpty());
+}
+
+void FixtureRegressionTest::create()
+{
+    // mkdir() of a folder, then put() of a small file into it, both in a
+    // single request.
+    QJsonObject folder;
+    folder.insert(QStringLiteral("name"), QStringLiteral("created"));
+    folder.insert(QStringLiteral("folder"), QJsonObject());
+    folder.insert(QStringLiteral("@microsoft.graph.conflictBehavior"), QStringLiteral("fail"));
+    GraphRequest mkdir(OneDriveHelper::networkAccessManager(), "POST", QStringLiteral("/items/%1/children").arg(m_drive.rootId()), folder);
+    mkdir.setAccount(m_account);
+    QVERIFY2(mkdir.exec(), qPrintable(mkdir.errorString()));
+    const QString folderId = mkdir.response().value(QStringLiteral("id")).toString();
+    QVERIFY(!folderId.isEmpty());
+
+    GraphRequest put(OneDriveHelper::networkAccessManager(), "PUT", QStringLiteral("/items/%1:/created.txt:/content").arg(folderId));
+    put.setAccount(m_account);
+    put.setContent(QByteArray(1024, 'x'));
+    QVERIFY2(put.exec(), qPrintable(put.errorString()));
+    QCOMPARE(qint64(put.response().value(QStringLiteral("size")).toDouble()), qint64(1024));
+}
+
+void FixtureRegressionTest::queuedDeletes()
+{
+    // The deletions queued by consecutive del() calls, sent in one batch. An
+    // item already gone counts as deleted.
+    const QStringList ids = {m_ids.value(QStringLiteral("folder1/file1.bin")), m_ids.value(QStringLiteral("folder1/file2.bin")),
+                             QStringLiteral("missing")};
+    GraphBatch batch(OneDriveHelper::networkAccessManager(), m_account);
+    for (const auto &id : ids) {
+        batch.add("DELETE", QStringLiteral("/items/%1").arg(id));
+    }
+    QVERIFY(batch.exec());
+    QCOMPARE(batch.requestCount(), 1);
+
+    const auto responses = batch.responses();
+    QCOMPARE(responses.size(), 3);
+    QCOMPARE(responses.at(0).status, 204);
+    QCOMPARE(responses.at(1).status, 204);
+    QCOMPARE(responses.at(2).status, 404);
+}
+
+#include "fixtureregressiontest.moc"
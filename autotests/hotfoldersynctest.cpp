@@ -0,0 +1,378 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "mockdrive.h"
+#include "../src/graphrequest.h"
+#include "../src/hotfoldersync.h"
+#include "../src/offlinestore.h"
+#include "../src/onedrivehelper.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+using namespace KMGraph2;
+
+class HotFolderSyncTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void testInitialSync();
+    void testIncrementalSync();
+    void testContentBudget();
+    void testBandwidth();
+    void testClear();
+    void testFolderSizes();
+    void testVersionFields();
+    void testReservedCharacters();
+    void testStateWithoutDownloadUrls();
+    void testExtraFieldNames();
+
+private:
+    QStringList names(const QString &path) const;
+    QByteArray content(const QString &path) const;
+    void upload(const QString &id, const QByteArray &data);
+
+    MockDrive m_drive;
+    AccountPtr m_account;
+    QTemporaryDir *m_dir = nullptr;
+    OfflineStore *m_store = nullptr;
+};
+
+QTEST_GUILESS_MAIN(HotFolderSyncTest)
+
+static const QString HotPath = QStringLiteral("/foo@outlook.com/folder0");
+
+void HotFolderSyncTest::initTestCase()
+{
+    QVERIFY(m_drive.start());
+    qputenv("ONEDRIVE_GRAPH_URL", m_drive.url().toString().toLatin1());
+    m_account = AccountPtr(new Account(QStringLiteral("foo@outlook.com"), QStringLiteral("secret-token")));
+}
+
+void HotFolderSyncTest::init()
+{
+    // folder0 holds 3 files and 2 subfolders of 3 files each.
+    MockDrive::Shape shape;
+    shape.depth = 2;
+    shape.folders = 2;
+    shape.files = 3;
+    shape.fileSize = 1024;
+    m_drive.generate(shape);
+    m_drive.resetCounters();
+
+    m_dir = new QTemporaryDir;
+    QVERIFY(m_dir->isValid());
+    m_store = new OfflineStore(m_dir->filePath(QStringLiteral("store")));
+}
+
+void HotFolderSyncTest::cleanup()
+{
+    delete m_store;
+    m_store = nullptr;
+    delete m_dir;
+    m_dir = nullptr;
+}
+
+QStringList HotFolderSyncTest::names(const QString &path) const
+{
+    KIO::UDSEntryList entries;
+    QDateTime storedAt;
+    if (!m_store->listing(path, &entries, &storedAt)) {
+        return {QStringLiteral("<none>")};
+    }
+
+    QStringList names;
+    for (const auto &entry : qAsConst(entries)) {
+        names << entry.stringValue(KIO::UDSEntry::UDS_NAME);
+    }
+    names.sort();
+    return names;
+}
+
+QByteArray HotFolderSyncTest::content(const QString &path) const
+{
+    KIO::UDSEntry entry;
+    QDateTime storedAt;
+    if (!m_store->entry(path, &entry, &storedAt)) {
+        return QByteArray();
+    }
+
+    // The way the worker looks contents up.
+    const QString fileId = QUrlQuery(QUrl(entry.stringValue(KIO::UDSEntry::UDS_URL))).queryItemValue(QStringLiteral("id"));
+    QFile file(m_store->contentFile(fileId, QDateTime::fromTime_t(entry.numberValue(KIO::UDSEntry::UDS_MODIFICATION_TIME))));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+void HotFolderSyncTest::upload(const QString &id, const QByteArray &data)
+{
+    const QNetworkRequest request = OneDriveHelper::graphRequest(m_account, QStringLiteral("/items/%1/content").arg(id));
+    QNetworkReply *reply = OneDriveHelper::networkAccessManager()->put(request, data);
+    QSignalSpy spy(reply, &QNetworkReply::finished);
+    QVERIFY(spy.wait());
+    QCOMPARE(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt(), 200);
+    reply->deleteLater();
+}
+
+void HotFolderSyncTest::testInitialSync()
+{
+    HotFolderSync sync(m_account, HotPath, m_store, m_dir->filePath(QStringLiteral("state")));
+    QVERIFY2(sync.run(), qPrintable(sync.errorString()));
+
+    QCOMPARE(names(HotPath), QStringList({QStringLiteral("file0.bin"), QStringLiteral("file1.bin"), QStringLiteral("file2.bin"),
+                                          QStringLiteral("folder0"), QStringLiteral("folder1")}));
+    QCOMPARE(names(HotPath + QStringLiteral("/folder1")).size(), 3);
+    QCOMPARE(content(HotPath + QStringLiteral("/folder1/file2.bin")), m_drive.content(m_drive.idForPath(QStringLiteral("folder0/folder1/file2.bin"))));
+    QCOMPARE(sync.materializedBytes(), qint64(9 * 1024));
+    QCOMPARE(sync.downloadedBytes(), qint64(9 * 1024));
+
+    QDateTime syncedAt;
+    QVERIFY(m_store->hotFolder(HotPath + QStringLiteral("/folder1/file2.bin"), &syncedAt));
+    QVERIFY(!m_store->hotFolder(QStringLiteral("/foo@outlook.com/folder1"), &syncedAt));
+
+    // Nothing changed, a single request for the change feed.
+    m_drive.resetCounters();
+    QVERIFY(sync.run());
+    QCOMPARE(m_drive.requestCount(), 1);
+    QCOMPARE(sync.changeCount(), 0);
+    QCOMPARE(sync.downloadedBytes(), qint64(0));
+}
+
+void HotFolderSyncTest::testIncrementalSync()
+{
+    const QString stateDirectory = m_dir->filePath(QStringLiteral("state"));
+    {
+        HotFolderSync sync(m_account, HotPath, m_store, stateDirectory);
+        QVERIFY2(sync.run(), qPrintable(sync.errorString()));
+    }
+
+    upload(m_drive.idForPath(QStringLiteral("folder0/file0.bin")), "changed");
+    GraphRequest removal(OneDriveHelper::networkAccessManager(), "DELETE",
+                         QStringLiteral("/items/%1").arg(m_drive.idForPath(QStringLiteral("folder0/file1.bin"))));
+    removal.setAccount(m_account);
+    QVERIFY(removal.exec());
+    QJsonObject patch;
+    patch.insert(QStringLiteral("name"), QStringLiteral("renamed"));
+    GraphRequest rename(OneDriveHelper::networkAccessManager(), "PATCH",
+                        QStringLiteral("/items/%1").arg(m_drive.idForPath(QStringLiteral("folder0/folder1"))), patch);
+    rename.setAccount(m_account);
+    QVERIFY(rename.exec());
+
+    // A new instance picks up from the saved state.
+    m_drive.resetCounters();
+    HotFolderSync sync(m_account, HotPath, m_store, stateDirectory);
+    QVERIFY2(sync.run(), qPrintable(sync.errorString()));
+    QCOMPARE(sync.changeCount(), 3);
+    // The change feed, and the changed content.
+    QCOMPARE(m_drive.requestCount(), 2);
+    QCOMPARE(sync.downloadedBytes(), qint64(7));
+
+    QCOMPARE(names(HotPath), QStringList({QStringLiteral("file0.bin"), QStringLiteral("file2.bin"),
+                                          QStringLiteral("folder0"), QStringLiteral("renamed")}));
+    QCOMPARE(names(HotPath + QStringLiteral("/renamed")).size(), 3);
+    QCOMPARE(names(HotPath + QStringLiteral("/folder1")), QStringList({QStringLiteral("<none>")}));
+    QCOMPARE(content(HotPath + QStringLiteral("/file0.bin")), QByteArray("changed"));
+    QCOMPARE(content(HotPath + QStringLiteral("/renamed/file0.bin")), m_drive.content(m_drive.idForPath(QStringLiteral("folder0/renamed/file0.bin"))));
+    QVERIFY(content(HotPath + QStringLiteral("/file1.bin")).isEmpty());
+}
+
+void HotFolderSyncTest::testContentBudget()
+{
+    HotFolderSync sync(m_account, HotPath, m_store, m_dir->filePath(QStringLiteral("state")));
+    sync.setContentBudget(4 * 1024);
+    QVERIFY2(sync.run(), qPrintable(sync.errorString()));
+    QCOMPARE(sync.materializedBytes(), qint64(4 * 1024));
+    // Filled in the order of the paths, the metadata is complete regardless.
+    QVERIFY(!content(HotPath + QStringLiteral("/file0.bin")).isEmpty());
+    QVERIFY(content(HotPath + QStringLiteral("/folder1/file2.bin")).isEmpty());
+    QCOMPARE(names(HotPath + QStringLiteral("/folder1")).size(), 3);
+
+    // Shrinking the budget drops what no longer fits.
+    sync.setContentBudget(1024);
+    QVERIFY(sync.run());
+    QCOMPARE(sync.materializedBytes(), qint64(1024));
+    QVERIFY(content(HotPath + QStringLiteral("/file1.bin")).isEmpty());
+}
+
+void HotFolderSyncTest::testBandwidth()
+{
+    HotFolderSync sync(m_account, HotPath, m_store, m_dir->filePath(QStringLiteral("state")));
+    sync.setBandwidth(12 * 1024);
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY2(sync.run(), qPrintable(sync.errorString()));
+    // 9 KiB at 12 KiB/s.
+    QVERIFY(timer.elapsed() >= 700);
+}
+
+void HotFolderSyncTest::testClear()
+{
+    HotFolderSync sync(m_account, HotPath, m_store, m_dir->filePath(QStringLiteral("state")));
+    QVERIFY2(sync.run(), qPrintable(sync.errorString()));
+
+    sync.clear();
+    QDateTime syncedAt;
+    QVERIFY(!m_store->hotFolder(HotPath, &syncedAt));
+    QVERIFY(content(HotPath + QStringLiteral("/file0.bin")).isEmpty());
+    // The pinned listings would never be evicted.
+    KIO::UDSEntryList entries;
+    QDateTime storedAt;
+    QVERIFY(!m_store->listing(HotPath, &entries, &storedAt));
+    QVERIFY(!m_store->listing(HotPath + QStringLiteral("/folder1"), &entries, &storedAt));
+
+    // Starts over with a full enumeration.
+    m_drive.resetCounters();
+    QVERIFY(sync.run());
+    QCOMPARE(sync.downloadedBytes(), qint64(9 * 1024));
+}
+
+void HotFolderSyncTest::testFolderSizes()
+{
+    HotFolderSync sync(m_account, HotPath, m_store, m_dir->filePath(QStringLiteral("state")));
+    QVERIFY2(sync.run(), qPrintable(sync.errorString()));
+
+    // From the aggregates of the server, for the folder and its subfolders.
+    KIO::UDSEntry entry;
+    QDateTime storedAt;
+    QVERIFY(m_store->entry(HotPath, &entry, &storedAt));
+    QCOMPARE(entry.stringValue(OneDriveHelper::ContentSize), QStringLiteral("9216"));
+    QCOMPARE(entry.numberValue(KIO::UDSEntry::UDS_SIZE), 0LL);
+    QVERIFY(m_store->entry(HotPath + QStringLiteral("/folder1"), &entry, &storedAt));
+    QCOMPARE(entry.stringValue(OneDriveHelper::ContentSize), QStringLiteral("3072"));
+    QVERIFY(m_store->entry(HotPath + QStringLiteral("/file0.bin"), &entry, &storedAt));
+    QVERIFY(!entry.contains(OneDriveHelper::ContentSize));
+}
+
+void HotFolderSyncTest::testVersionFields()
+{
+    const auto fields = [this](const QString &path) {
+        KIO::UDSEntry entry;
+        QDateTime storedAt;
+        if (!m_store->entry(path, &entry, &storedAt)) {
+            return QStringList();
+        }
+        return QStringList({entry.stringValue(OneDriveHelper::ETag),
+                            entry.stringValue(OneDriveHelper::CTag),
+                            entry.stringValue(OneDriveHelper::Sha1Hash)});
+    };
+
+    HotFolderSync sync(m_account, HotPath, m_store, m_dir->filePath(QStringLiteral("state")));
+    QVERIFY2(sync.run(), qPrintable(sync.errorString()));
+    const QStringList changed = fields(HotPath + QStringLiteral("/file0.bin"));
+    const QStringList renamed = fields(HotPath + QStringLiteral("/file1.bin"));
+    QCOMPARE(changed.size(), 3);
+    QVERIFY(!changed.contains(QString()));
+    QVERIFY(changed != renamed);
+
+    upload(m_drive.idForPath(QStringLiteral("folder0/file0.bin")), "changed");
+    QJsonObject patch;
+    patch.insert(QStringLiteral("name"), QStringLiteral("renamed.bin"));
+    GraphRequest rename(OneDriveHelper::networkAccessManager(), "PATCH",
+                        QStringLiteral("/items/%1").arg(m_drive.idForPath(QStringLiteral("folder0/file1.bin"))), patch);
+    rename.setAccount(m_account);
+    QVERIFY(rename.exec());
+    QVERIFY(sync.run());
+
+    // A new content changes every field, a new name only the eTag.
+    const QStringList afterChange = fields(HotPath + QStringLiteral("/file0.bin"));
+    for (int i = 0; i < 3; ++i) {
+        QVERIFY(afterChange.at(i) != changed.at(i));
+    }
+    const QStringList afterRename = fields(HotPath + QStringLiteral("/renamed.bin"));
+    QVERIFY(afterRename.at(0) != renamed.at(0));
+    QCOMPARE(afterRename.mid(1), renamed.mid(1));
+}
+
+void HotFolderSyncTest::testReservedCharacters()
+{
+    QJsonObject patch;
+    patch.insert(QStringLiteral("name"), QStringLiteral("a#b%c?"));
+    GraphRequest rename(OneDriveHelper::networkAccessManager(), "PATCH",
+                        QStringLiteral("/items/%1").arg(m_drive.idForPath(QStringLiteral("folder0/folder1"))), patch);
+    rename.setAccount(m_account);
+    QVERIFY(rename.exec());
+
+    const QString path = HotPath + QStringLiteral("/a#b%c?");
+    HotFolderSync sync(m_account, path, m_store, m_dir->filePath(QStringLiteral("state")));
+    QVERIFY2(sync.run(), qPrintable(sync.errorString()));
+    QCOMPARE(names(path), QStringList({QStringLiteral("file0.bin"), QStringLiteral("file1.bin"), QStringLiteral("file2.bin")}));
+}
+
+void HotFolderSyncTest::testStateWithoutDownloadUrls()
+{
+    const QString stateDirectory = m_dir->filePath(QStringLiteral("state"));
+    HotFolderSync sync(m_account, HotPath, m_store, stateDirectory);
+    QVERIFY2(sync.run(), qPrintable(sync.errorString()));
+
+    // The download URLs are pre-authenticated, they must not reach the disk.
+    const auto files = QDir(stateDirectory).entryInfoList(QDir::Files);
+    QVERIFY(!files.isEmpty());
+    for (const auto &info : files) {
+        QFile file(info.filePath());
+        QVERIFY(file.open(QIODevice::ReadOnly));
+        const QByteArray state = file.readAll();
+        QVERIFY(!state.contains("downloadUrl"));
+        QVERIFY(!state.contains("/download/"));
+    }
+
+    // A new instance still downloads the changed content.
+    upload(m_drive.idForPath(QStringLiteral("folder0/file0.bin")), "changed");
+    HotFolderSync next(m_account, HotPath, m_store, stateDirectory);
+    QVERIFY2(next.run(), qPrintable(next.errorString()));
+    QCOMPARE(content(HotPath + QStringLiteral("/file0.bin")), QByteArray("changed"));
+}
+
+void HotFolderSyncTest::testExtraFieldNames()
+{
+    // KProtocolInfo drops the extra fields unless each name has a type, and
+    // the entries carry them in the order of the names.
+    QFile file(QFINDTESTDATA("../onedrive.json"));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const auto protocol = QJsonDocument::fromJson(file.readAll()).object()
+                          .value(QStringLiteral("KDE-KIO-Protocols")).toObject()
+                          .value(QStringLiteral("onedrive")).toObject();
+    const auto names = protocol.value(QStringLiteral("ExtraNames")).toArray();
+    const auto types = protocol.value(QStringLiteral("ExtraTypes")).toArray();
+    QCOMPARE(names.size(), OneDriveHelper::Sha256Hash - OneDriveHelper::ContentSize + 1);
+    QCOMPARE(types.size(), names.size());
+    for (const auto &type : types) {
+        QCOMPARE(type.toString(), QStringLiteral("QString"));
+    }
+    QCOMPARE(names.at(OneDriveHelper::ETag - OneDriveHelper::ContentSize).toString(), QStringLiteral("ETag"));
+    QCOMPARE(names.at(OneDriveHelper::CTag - OneDriveHelper::ContentSize).toString(), QStringLiteral("CTag"));
+    QCOMPARE(names.at(OneDriveHelper::Sha256Hash - OneDriveHelper::ContentSize).toString(), QStringLiteral("SHA256"));
+}
+
+#include "hotfoldersynctest.moc"
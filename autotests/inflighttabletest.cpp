@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "../src/inflighttable.h"
+
+#include <QTest>
+
+class InflightTableTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testSuppressDuplicates();
+    void testFailuresNotShared();
+    void testEmptyResultsNotShared();
+    void testWindowExpires();
+};
+
+QTEST_GUILESS_MAIN(InflightTableTest)
+
+void InflightTableTest::testSuppressDuplicates()
+{
+    InflightTable<QString> table;
+    int fetches = 0;
+    const auto fetch = [&fetches](QString *id) {
+        ++fetches;
+        *id = QStringLiteral("1");
+        return true;
+    };
+
+    for (int i = 0; i < 3; ++i) {
+        QCOMPARE(table.run(QStringLiteral("foo@outlook.com"), QStringLiteral("resolve"), QStringLiteral("/bar"), fetch), QStringLiteral("1"));
+    }
+    // Another account, operation or target is another lookup.
+    table.run(QStringLiteral("baz@outlook.com"), QStringLiteral("resolve"), QStringLiteral("/bar"), fetch);
+    table.run(QStringLiteral("foo@outlook.com"), QStringLiteral("fetch"), QStringLiteral("/bar"), fetch);
+    table.run(QStringLiteral("foo@outlook.com"), QStringLiteral("resolve"), QStringLiteral("/qux"), fetch);
+
+    QCOMPARE(fetches, 4);
+    QCOMPARE(table.issuedCount(), quint64(4));
+    QCOMPARE(table.suppressedCount(), quint64(2));
+
+    table.clear();
+    table.run(QStringLiteral("foo@outlook.com"), QStringLiteral("resolve"), QStringLiteral("/bar"), fetch);
+    QCOMPARE(fetches, 5);
+}
+
+void InflightTableTest::testFailuresNotShared()
+{
+    InflightTable<QString> table;
+    int fetches = 0;
+    const auto fetch = [&fetches](QString *) {
+        ++fetches;
+        return false;
+    };
+
+    bool ok = true;
+    table.run(QStringLiteral("foo@outlook.com"), QStringLiteral("resolve"), QStringLiteral("/bar"), fetch, &ok);
+    QVERIFY(!ok);
+    table.run(QStringLiteral("foo@outlook.com"), QStringLiteral("resolve"), QStringLiteral("/bar"), fetch, &ok);
+    QCOMPARE(fetches, 2);
+    QCOMPARE(table.suppressedCount(), quint64(0));
+}
+
+void InflightTableTest::testEmptyResultsNotShared()
+{
+    InflightTable<QString> table;
+    int fetches = 0;
+    const auto fetch = [&fetches](QString *id) {
+        // Not found at first, then created by another client.
+        if (fetches++ > 0) {
+            *id = QStringLiteral("1");
+        }
+        return true;
+    };
+
+    bool ok = false;
+    bool shared = true;
+    QVERIFY(table.run(QStringLiteral("foo@outlook.com"), QStringLiteral("resolve"), QStringLiteral("/bar"), fetch, &ok, &shared).isEmpty());
+    QVERIFY(ok);
+    QVERIFY(!shared);
+    QCOMPARE(table.run(QStringLiteral("foo@outlook.com"), QStringLiteral("resolve"), QStringLiteral("/bar"), fetch, &ok, &shared), QStringLiteral("1"));
+    QVERIFY(!shared);
+    QCOMPARE(table.run(QStringLiteral("foo@outlook.com"), QStringLiteral("resolve"), QStringLiteral("/bar"), fetch, &ok, &shared), QStringLiteral("1"));
+    QVERIFY(shared);
+    QCOMPARE(fetches, 2);
+}
+
+void InflightTableTest::testWindowExpires()
+{
+    InflightTable<QString> table(10);
+    int fetches = 0;
+    const auto fetch = [&fetches](QString *id) {
+        ++fetches;
+        *id = QStringLiteral("1");
+        return true;
+    };
+
+    table.run(QStringLiteral("foo@outlook.com"), QStringLiteral("resolve"), QStringLiteral("/bar"), fetch);
+    QTest::qWait(20);
+    table.run(QStringLiteral("foo@outlook.com"), QStringLiteral("resolve"), QStringLiteral("/bar"), fetch);
+    QCOMPARE(fetches, 2);
+}
+
+#include "inflighttabletest.moc"
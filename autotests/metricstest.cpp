@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "../src/metrics.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+class MetricsTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testHistogram();
+    void testPrometheus();
+    void testSnapshot();
+};
+
+QTEST_GUILESS_MAIN(MetricsTest)
+
+void MetricsTest::testHistogram()
+{
+    Metrics::Histogram histogram;
+    for (qint64 usecs = 1; usecs <= 1000; ++usecs) {
+        histogram.record(usecs);
+    }
+
+    QCOMPARE(histogram.count(), qint64(1000));
+    QCOMPARE(histogram.sum(), qint64(500500));
+    QCOMPARE(histogram.countAtMost(128), qint64(128));
+    QCOMPARE(histogram.countAtMost(127), qint64(127));
+    QCOMPARE(histogram.countAtMost(1024), qint64(1000));
+
+    // Percentiles are bucket bounds, at most 25% above the real value.
+    const qint64 p50 = histogram.percentile(50);
+    QVERIFY(p50 >= 500 && p50 <= 625);
+    const qint64 p99 = histogram.percentile(99);
+    QVERIFY(p99 >= 990 && p99 <= 1238);
+    QCOMPARE(Metrics::Histogram().percentile(99), qint64(0));
+}
+
+void MetricsTest::testPrometheus()
+{
+    Metrics metrics;
+    metrics.record(Metrics::Command, QStringLiteral("stat"), 200);
+    metrics.record(Metrics::Command, QStringLiteral("stat"), 512);
+    metrics.record(Metrics::Command, QStringLiteral("stat"), 3000);
+    metrics.record(Metrics::Job, QStringLiteral("FileFetchJob"), 2500);
+    metrics.add(Metrics::BytesUploaded, 42);
+    metrics.add(Metrics::PathCacheHits);
+    metrics.add(Metrics::FetchLookupsShared, 2);
+
+    const QByteArray text = metrics.toPrometheus();
+    QVERIFY(text.contains("# TYPE kio_onedrive_command_duration_seconds histogram\n"));
+    QVERIFY(text.contains("kio_onedrive_command_duration_seconds_bucket{command=\"stat\",le=\"0.000256\"} 1\n"));
+    // Le buckets include their bound.
+    QVERIFY(text.contains("kio_onedrive_command_duration_seconds_bucket{command=\"stat\",le=\"0.000512\"} 2\n"));
+    QVERIFY(text.contains("kio_onedrive_command_duration_seconds_bucket{command=\"stat\",le=\"+Inf\"} 3\n"));
+    QVERIFY(text.contains("kio_onedrive_command_duration_seconds_sum{command=\"stat\"} 0.003712\n"));
+    QVERIFY(text.contains("kio_onedrive_job_duration_seconds_count{job=\"FileFetchJob\"} 1\n"));
+    QVERIFY(text.contains("kio_onedrive_bytes_total{direction=\"up\"} 42\n"));
+    QVERIFY(text.contains("kio_onedrive_cache_lookups_total{cache=\"path\",result=\"hit\"} 1\n"));
+    QVERIFY(text.contains("kio_onedrive_lookups_total{lookup=\"fetch\",result=\"shared\"} 2\n"));
+    QVERIFY(text.contains("kio_onedrive_retries_total 0\n"));
+}
+
+void MetricsTest::testSnapshot()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    {
+        Metrics metrics(dir.path(), 60000);
+        {
+            Metrics::Timer timer(&metrics, Metrics::Command, "stat");
+        }
+        QCOMPARE(metrics.histogram(Metrics::Command, QStringLiteral("stat")).count(), qint64(1));
+        QCOMPARE(QDir(dir.path()).entryList(QDir::Files).count(), 1);
+    }
+
+    QFile file(QDir(dir.path()).filePath(QDir(dir.path()).entryList(QDir::Files).first()));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QVERIFY(file.readAll().contains("kio_onedrive_command_duration_seconds_count{command=\"stat\"} 1\n"));
+}
+
+#include "metricstest.moc"
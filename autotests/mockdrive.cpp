@@ -0,0 +1,713 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "mockdrive.h"
+
+#include <QCryptographicHash>
+#include <QJsonArray>
+
+#include <algorithm>
+
+namespace
+{
+QString conflictBehavior(const QUrlQuery &query, const QJsonObject &body)
+{
+    const QString key = QStringLiteral("@microsoft.graph.conflictBehavior");
+    if (query.hasQueryItem(key)) {
+        return query.queryItemValue(key);
+    }
+    if (body.contains(key)) {
+        return body.value(key).toString();
+    }
+    return body.value(QStringLiteral("item")).toObject().value(key).toString();
+}
+}
+
+MockDrive::MockDrive(QObject *parent)
+    : MockGraphServer(parent)
+{
+    Shape empty;
+    empty.depth = 0;
+    empty.files = 0;
+    generate(empty);
+}
+
+MockDrive::~MockDrive()
+{
+}
+
+void MockDrive::generate(const Shape &shape)
+{
+    m_items.clear();
+    m_children.clear();
+    m_removed.clear();
+    m_sessions.clear();
+    m_rootId = addItem(QString(), QStringLiteral("root"), true, 0);
+
+    QStringList level = { m_rootId };
+    for (int depth = 0; depth <= shape.depth; ++depth) {
+        QStringList nextLevel;
+        for (const auto &folderId : qAsConst(level)) {
+            if (depth < shape.depth) {
+                for (int i = 0; i < shape.folders; ++i) {
+                    nextLevel << addItem(folderId, QStringLiteral("folder%1").arg(i), true, 0);
+                }
+            }
+            for (int i = 0; i < shape.files; ++i) {
+                addItem(folderId, QStringLiteral("file%1.bin").arg(i), false, shape.fileSize);
+            }
+        }
+        level = nextLevel;
+    }
+}
+
+QString MockDrive::rootId() const
+{
+    return m_rootId;
+}
+
+QString MockDrive::idForPath(const QString &path) const
+{
+    QString id = m_rootId;
+    for (const auto &name : path.split(QLatin1Char('/'), QString::SkipEmptyParts)) {
+        id = child(id, name);
+        if (id.isEmpty()) {
+            break;
+        }
+    }
+    return id;
+}
+
+QStringList MockDrive::folderIds() const
+{
+    QStringList folders = { m_rootId };
+    for (int i = 0; i < folders.size(); ++i) {
+        for (const auto &id : children(folders.at(i))) {
+            if (m_items.value(id).folder) {
+                folders << id;
+            }
+        }
+    }
+    return folders;
+}
+
+QStringList MockDrive::fileIds() const
+{
+    QStringList files;
+    for (const auto &folderId : folderIds()) {
+        for (const auto &id : children(folderId)) {
+            if (!m_items.value(id).folder) {
+                files << id;
+            }
+        }
+    }
+    return files;
+}
+
+QByteArray MockDrive::content(const QString &id) const
+{
+    const Item item = m_items.value(id);
+    return read(item, 0, item.size - 1);
+}
+
+QString MockDrive::addItem(const QString &parentId, const QString &name, bool folder, qint64 size)
+{
+    Item item;
+    item.id = QString::number(++m_lastId);
+    item.seed = item.id;
+    item.name = name;
+    item.parentId = parentId;
+    item.folder = folder;
+    item.size = size;
+    touch(&item);
+    m_items.insert(item.id, item);
+    if (!parentId.isEmpty()) {
+        m_children[parentId].append(item.id);
+    }
+    return item.id;
+}
+
+QString MockDrive::child(const QString &parentId, const QString &name) const
+{
+    for (const auto &id : m_children.value(parentId)) {
+        if (m_items.value(id).name == name) {
+            return id;
+        }
+    }
+    return QString();
+}
+
+QStringList MockDrive::children(const QString &parentId) const
+{
+    return m_children.value(parentId);
+}
+
+QString MockDrive::copyItem(const QString &id, const QString &parentId, const QString &name)
+{
+    const Item source = m_items.value(id);
+    const QString copyId = addItem(parentId, name, source.folder, source.size);
+    m_items[copyId].seed = source.seed;
+    m_items[copyId].content = source.content;
+    for (const auto &childId : children(id)) {
+        copyItem(childId, copyId, m_items.value(childId).name);
+    }
+    return copyId;
+}
+
+void MockDrive::removeItem(const QString &id)
+{
+    for (const auto &childId : children(id)) {
+        removeItem(childId);
+    }
+    m_children.remove(id);
+    m_children[m_items.value(id).parentId].removeOne(id);
+    Item removed = m_items.take(id);
+    removed.change = ++m_lastChange;
+    m_removed.insert(id, removed);
+}
+
+void MockDrive::touch(Item *item)
+{
+    item->modified = QDateTime::currentDateTimeUtc();
+    item->change = ++m_lastChange;
+}
+
+bool MockDrive::isInside(const QString &id, const QString &folderId) const
+{
+    QString current = id;
+    while (!current.isEmpty()) {
+        if (current == folderId) {
+            return true;
+        }
+        current = m_items.contains(current) ? m_items.value(current).parentId : m_removed.value(current).parentId;
+    }
+    return false;
+}
+
+QByteArray MockDrive::read(const Item &item, qint64 first, qint64 last) const
+{
+    last = qMin(last, item.size - 1);
+    if (first > last) {
+        return QByteArray();
+    }
+    if (!item.content.isNull()) {
+        return item.content.mid(int(first), int(last - first + 1));
+    }
+
+    const uint seed = qHash(item.seed);
+    QByteArray data(int(last - first + 1), Qt::Uninitialized);
+    for (qint64 i = first; i <= last; ++i) {
+        data[int(i - first)] = char('a' + (seed + i) % 26);
+    }
+    return data;
+}
+
+QJsonObject MockDrive::toJson(const Item &item) const
+{
+    QJsonObject json;
+    json.insert(QStringLiteral("id"), item.id);
+    json.insert(QStringLiteral("name"), item.name);
+    // Folders report the total size of their content.
+    json.insert(QStringLiteral("size"), double(item.folder ? contentSize(item.id) : item.size));
+    json.insert(QStringLiteral("createdDateTime"), item.modified.toString(Qt::ISODate));
+    json.insert(QStringLiteral("lastModifiedDateTime"), item.modified.toString(Qt::ISODate));
+    json.insert(QStringLiteral("eTag"), QStringLiteral("\"{%1},%2\"").arg(item.id).arg(item.change));
+    if (!item.parentId.isEmpty()) {
+        QJsonObject parentReference;
+        parentReference.insert(QStringLiteral("id"), item.parentId);
+        parentReference.insert(QStringLiteral("driveId"), QStringLiteral("mock"));
+        json.insert(QStringLiteral("parentReference"), parentReference);
+    }
+    if (item.id == m_rootId) {
+        json.insert(QStringLiteral("root"), QJsonObject());
+    }
+    if (item.folder) {
+        QJsonObject folder;
+        folder.insert(QStringLiteral("childCount"), children(item.id).size());
+        json.insert(QStringLiteral("folder"), folder);
+    } else {
+        QJsonObject hashes;
+        hashes.insert(QStringLiteral("sha1Hash"), QString::fromLatin1(contentHash(item).toHex().toUpper()));
+        QJsonObject file;
+        file.insert(QStringLiteral("mimeType"), QStringLiteral("application/octet-stream"));
+        file.insert(QStringLiteral("hashes"), hashes);
+        json.insert(QStringLiteral("file"), file);
+        json.insert(QStringLiteral("cTag"), QStringLiteral("\"c:{%1},%2\"").arg(item.id, QString::fromLatin1(contentHash(item).toHex().left(8))));
+        json.insert(QStringLiteral("@microsoft.graph.downloadUrl"), url().toString() + QStringLiteral("/download/") + item.id);
+    }
+    return json;
+}
+
+QByteArray MockDrive::contentHash(const Item &item) const
+{
+    // Generated contents are told apart by their seed, hashing them would
+    // cost as much as downloading them.
+    const QByteArray data = item.content.isNull() ? item.seed.toUtf8() + '/' + QByteArray::number(item.size) : item.content;
+    return QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+}
+
+qint64 MockDrive::contentSize(const QString &folderId) const
+{
+    qint64 size = 0;
+    for (const auto &id : children(folderId)) {
+        const Item item = m_items.value(id);
+        size += item.folder ? contentSize(id) : item.size;
+    }
+    return size;
+}
+
+QString MockDrive::pathOf(const QString &id) const
+{
+    QStringList names;
+    for (QString current = id; current != m_rootId && m_items.contains(current); current = m_items.value(current).parentId) {
+        names.prepend(m_items.value(current).name);
+    }
+    return QLatin1Char('/') + names.join(QLatin1Char('/'));
+}
+
+MockGraphServer::Response MockDrive::error(int status, const QString &code)
+{
+    QJsonObject error;
+    error.insert(QStringLiteral("code"), code);
+    error.insert(QStringLiteral("message"), code);
+    Response response;
+    response.status = status;
+    response.body.insert(QStringLiteral("error"), error);
+    return response;
+}
+
+MockGraphServer::Response MockDrive::handle(const Request &request)
+{
+    QString path = request.path;
+
+    // Pre-authenticated URLs handed out by the drive.
+    if (path.startsWith(QLatin1String("/download/"))) {
+        const QString id = path.mid(10);
+        if (!m_items.contains(id)) {
+            return error(404, QStringLiteral("itemNotFound"));
+        }
+        return download(request, m_items.value(id));
+    }
+    if (path.startsWith(QLatin1String("/upload/"))) {
+        return handleUploadSession(request, path.mid(8));
+    }
+    if (path.startsWith(QLatin1String("/monitor/"))) {
+        Response response;
+        response.body.insert(QStringLiteral("status"), QStringLiteral("completed"));
+        response.body.insert(QStringLiteral("percentageComplete"), 100);
+        response.body.insert(QStringLiteral("resourceId"), path.mid(9));
+        return response;
+    }
+
+    const QString drivePath = QStringLiteral("/me/drive");
+    if (!path.startsWith(drivePath)) {
+        return error(404, QStringLiteral("invalidRequest"));
+    }
+    path = path.mid(drivePath.size());
+
+    if (path.isEmpty()) {
+        qint64 used = 0;
+        for (const auto &item : qAsConst(m_items)) {
+            used += item.size;
+        }
+        QJsonObject quota;
+        const qint64 total = qint64(1) << 40;
+        quota.insert(QStringLiteral("total"), double(total));
+        quota.insert(QStringLiteral("used"), double(used));
+        quota.insert(QStringLiteral("remaining"), double(total - used));
+        quota.insert(QStringLiteral("state"), QStringLiteral("normal"));
+        Response response;
+        response.body.insert(QStringLiteral("id"), QStringLiteral("mock"));
+        response.body.insert(QStringLiteral("driveType"), QStringLiteral("personal"));
+        response.body.insert(QStringLiteral("quota"), quota);
+        return response;
+    }
+
+    QString id;
+    if (path.startsWith(QLatin1String("/root"))) {
+        id = m_rootId;
+        path = path.mid(5);
+    } else if (path.startsWith(QLatin1String("/items/"))) {
+        int end = 7;
+        while (end < path.size() && path.at(end) != QLatin1Char('/') && path.at(end) != QLatin1Char(':')) {
+            ++end;
+        }
+        id = path.mid(7, end - 7);
+        path = path.mid(end);
+    }
+    if (!m_items.contains(id)) {
+        return error(404, QStringLiteral("itemNotFound"));
+    }
+
+    // Path-based addressing: /items/{id}:/relative/path:/action
+    if (path.startsWith(QLatin1String(":/"))) {
+        const int end = path.indexOf(QLatin1Char(':'), 2);
+        const QStringList names = path.mid(2, end < 0 ? -1 : end - 2).split(QLatin1Char('/'), QString::SkipEmptyParts);
+        path = end < 0 ? QString() : path.mid(end + 1);
+        if (names.isEmpty()) {
+            return error(400, QStringLiteral("invalidRequest"));
+        }
+        for (int i = 0; i < names.size() - 1; ++i) {
+            id = child(id, names.at(i));
+            if (id.isEmpty()) {
+                return error(404, QStringLiteral("itemNotFound"));
+            }
+        }
+        const QString found = child(id, names.last());
+        if (found.isEmpty()) {
+            return handleMissingItem(request, id, names.last(), path);
+        }
+        id = found;
+    }
+
+    return handleItem(request, id, path);
+}
+
+MockGraphServer::Response MockDrive::handleItem(const Request &request, const QString &id, const QString &action)
+{
+    const Item item = m_items.value(id);
+    const QJsonObject body = request.body();
+    const bool replace = conflictBehavior(request.query, body) == QLatin1String("replace");
+
+    if (action.isEmpty() && request.method == "GET") {
+        Response response;
+        response.body = toJson(item);
+        return response;
+    }
+
+    if (action.isEmpty() && request.method == "DELETE") {
+        if (id == m_rootId) {
+            return error(403, QStringLiteral("accessDenied"));
+        }
+        removeItem(id);
+        Response response;
+        response.status = 204;
+        return response;
+    }
+
+    if (action.isEmpty() && request.method == "PATCH") {
+        const QString name = body.value(QStringLiteral("name")).toString(item.name);
+        const QString parentId = body.value(QStringLiteral("parentReference")).toObject().value(QStringLiteral("id")).toString(item.parentId);
+        if (!m_items.value(parentId).folder) {
+            return error(400, QStringLiteral("invalidRequest"));
+        }
+        const QString existing = child(parentId, name);
+        if (!existing.isEmpty() && existing != id) {
+            if (!replace) {
+                return error(409, QStringLiteral("nameAlreadyExists"));
+            }
+            removeItem(existing);
+        }
+        if (parentId != item.parentId) {
+            m_children[item.parentId].removeOne(id);
+            m_children[parentId].append(id);
+        }
+        Item &modified = m_items[id];
+        modified.name = name;
+        modified.parentId = parentId;
+        touch(&modified);
+        Response response;
+        response.body = toJson(modified);
+        return response;
+    }
+
+    if (action == QLatin1String("/children") && request.method == "GET") {
+        const QStringList ids = children(id);
+        const int top = request.query.hasQueryItem(QStringLiteral("$top")) ? request.query.queryItemValue(QStringLiteral("$top")).toInt() : 200;
+        const int skip = request.query.queryItemValue(QStringLiteral("$skiptoken")).toInt();
+        QJsonArray value;
+        for (int i = skip; i < ids.size() && i < skip + top; ++i) {
+            value.append(toJson(m_items.value(ids.at(i))));
+        }
+        Response response;
+        response.body.insert(QStringLiteral("value"), value);
+        if (skip + top < ids.size()) {
+            QUrlQuery query;
+            query.addQueryItem(QStringLiteral("$top"), QString::number(top));
+            query.addQueryItem(QStringLiteral("$skiptoken"), QString::number(skip + top));
+            QUrl next(url().toString() + QStringLiteral("/me/drive/items/%1/children").arg(id));
+            next.setQuery(query);
+            response.body.insert(QStringLiteral("@odata.nextLink"), next.toString());
+        }
+        return response;
+    }
+
+    if (action == QLatin1String("/children") && request.method == "POST") {
+        const QString name = body.value(QStringLiteral("name")).toString();
+        if (name.isEmpty() || !item.folder) {
+            return error(400, QStringLiteral("invalidRequest"));
+        }
+        const QString existing = child(id, name);
+        if (!existing.isEmpty()) {
+            if (!replace) {
+                return error(409, QStringLiteral("nameAlreadyExists"));
+            }
+            removeItem(existing);
+        }
+        Response response;
+        response.status = 201;
+        response.body = toJson(m_items.value(addItem(id, name, body.contains(QStringLiteral("folder")), 0)));
+        return response;
+    }
+
+    if (action == QLatin1String("/content") && request.method == "GET") {
+        return download(request, item);
+    }
+
+    if (action == QLatin1String("/delta") && request.method == "GET") {
+        return delta(request, id);
+    }
+
+    const QString searchCall = QStringLiteral("/search(q='");
+    if (action.startsWith(searchCall) && action.endsWith(QLatin1String("')")) && request.method == "GET") {
+        QString term = action.mid(searchCall.size(), action.size() - searchCall.size() - 2);
+        term.replace(QStringLiteral("''"), QStringLiteral("'"));
+        return search(request, id, term);
+    }
+
+    if (action == QLatin1String("/content") && request.method == "PUT") {
+        // Uploading to an existing item replaces it, unless told otherwise.
+        return upload(item.parentId, item.name, request.data, conflictBehavior(request.query, body) != QLatin1String("fail"));
+    }
+
+    if (action == QLatin1String("/createUploadSession") && request.method == "POST") {
+        if (conflictBehavior(request.query, body) == QLatin1String("fail")) {
+            return error(409, QStringLiteral("nameAlreadyExists"));
+        }
+        return handleMissingItem(request, item.parentId, item.name, action);
+    }
+
+    if (action == QLatin1String("/copy") && request.method == "POST") {
+        const QString parentId = body.value(QStringLiteral("parentReference")).toObject().value(QStringLiteral("id")).toString(item.parentId);
+        const QString name = body.value(QStringLiteral("name")).toString(item.name);
+        if (!m_items.value(parentId).folder) {
+            return error(400, QStringLiteral("invalidRequest"));
+        }
+        const QString existing = child(parentId, name);
+        if (!existing.isEmpty()) {
+            if (!replace) {
+                return error(409, QStringLiteral("nameAlreadyExists"));
+            }
+            removeItem(existing);
+        }
+        const QString copyId = copyItem(id, parentId, name);
+        Response response;
+        response.status = 202;
+        response.headers.insert("Location", (url().toString() + QStringLiteral("/monitor/") + copyId).toLatin1());
+        return response;
+    }
+
+    return error(400, QStringLiteral("invalidRequest"));
+}
+
+MockGraphServer::Response MockDrive::handleMissingItem(const Request &request, const QString &parentId, const QString &name, const QString &action)
+{
+    if (action == QLatin1String("/content") && request.method == "PUT") {
+        return upload(parentId, name, request.data, false);
+    }
+
+    if (action == QLatin1String("/createUploadSession") && request.method == "POST") {
+        UploadSession session;
+        session.parentId = parentId;
+        session.name = name;
+        const QString sessionId = QStringLiteral("session%1").arg(++m_lastId);
+        m_sessions.insert(sessionId, session);
+
+        Response response;
+        response.body.insert(QStringLiteral("uploadUrl"), url().toString() + QStringLiteral("/upload/") + sessionId);
+        response.body.insert(QStringLiteral("expirationDateTime"), QDateTime::currentDateTimeUtc().addDays(1).toString(Qt::ISODate));
+        return response;
+    }
+
+    return error(404, QStringLiteral("itemNotFound"));
+}
+
+MockGraphServer::Response MockDrive::upload(const QString &parentId, const QString &name, const QByteArray &content, bool replace)
+{
+    Response response;
+    QString id = child(parentId, name);
+    if (!id.isEmpty()) {
+        if (!replace || m_items.value(id).folder) {
+            return error(409, QStringLiteral("nameAlreadyExists"));
+        }
+    } else {
+        id = addItem(parentId, name, false, 0);
+        response.status = 201;
+    }
+
+    Item &item = m_items[id];
+    // Never null, so that it is not generated.
+    item.content = content.isNull() ? QByteArray("") : content;
+    item.size = content.size();
+    touch(&item);
+    response.body = toJson(item);
+    return response;
+}
+
+MockGraphServer::Response MockDrive::download(const Request &request, const Item &item)
+{
+    if (item.folder) {
+        return error(400, QStringLiteral("notSupported"));
+    }
+
+    Response response;
+    qint64 first = 0;
+    qint64 last = item.size - 1;
+    const QByteArray range = request.headers.value("range");
+    if (range.startsWith("bytes=")) {
+        const QList<QByteArray> bounds = range.mid(6).split('-');
+        first = bounds.value(0).toLongLong();
+        if (!bounds.value(1).isEmpty()) {
+            last = qMin(last, bounds.value(1).toLongLong());
+        }
+        if (first >= item.size) {
+            return error(416, QStringLiteral("invalidRange"));
+        }
+        response.status = 206;
+        response.headers.insert("Content-Range", "bytes " + QByteArray::number(first) + '-' + QByteArray::number(last)
+                                                 + '/' + QByteArray::number(item.size));
+    }
+
+    response.data = read(item, first, last);
+    return response;
+}
+
+MockGraphServer::Response MockDrive::handleUploadSession(const Request &request, const QString &sessionId)
+{
+    if (!m_sessions.contains(sessionId) || request.method != "PUT") {
+        return error(404, QStringLiteral("itemNotFound"));
+    }
+
+    // Content-Range: bytes first-last/total
+    const QByteArray range = request.headers.value("content-range");
+    const qint64 first = range.mid(6, range.indexOf('-') - 6).toLongLong();
+    const qint64 total = range.mid(range.indexOf('/') + 1).toLongLong();
+
+    UploadSession &session = m_sessions[sessionId];
+    if (first != session.content.size()) {
+        return error(416, QStringLiteral("invalidRange"));
+    }
+    session.content += request.data;
+
+    if (session.content.size() < total) {
+        Response response;
+        response.status = 202;
+        response.body.insert(QStringLiteral("nextExpectedRanges"),
+                             QJsonArray{ QStringLiteral("%1-").arg(session.content.size()) });
+        return response;
+    }
+
+    const UploadSession done = m_sessions.take(sessionId);
+    return upload(done.parentId, done.name, done.content, true);
+}
+
+MockGraphServer::Response MockDrive::delta(const Request &request, const QString &folderId)
+{
+    // The token is the position in the change feed, without one the whole folder is enumerated.
+    const int token = request.query.queryItemValue(QStringLiteral("token")).toInt();
+    const int top = request.query.hasQueryItem(QStringLiteral("$top")) ? request.query.queryItemValue(QStringLiteral("$top")).toInt() : 200;
+    const int skip = request.query.queryItemValue(QStringLiteral("$skiptoken")).toInt();
+
+    QList<Item> changed;
+    for (const auto &item : qAsConst(m_items)) {
+        if (item.change > token && isInside(item.id, folderId)) {
+            changed << item;
+        }
+    }
+    if (token > 0) {
+        for (const auto &item : qAsConst(m_removed)) {
+            if (item.change > token && isInside(item.parentId, folderId)) {
+                changed << item;
+            }
+        }
+    }
+    std::sort(changed.begin(), changed.end(), [](const Item &a, const Item &b) { return a.change < b.change; });
+
+    QJsonArray value;
+    for (int i = skip; i < changed.size() && i < skip + top; ++i) {
+        const Item &item = changed.at(i);
+        if (m_items.contains(item.id)) {
+            value.append(toJson(item));
+        } else {
+            QJsonObject parentReference;
+            parentReference.insert(QStringLiteral("id"), item.parentId);
+            QJsonObject deleted;
+            deleted.insert(QStringLiteral("state"), QStringLiteral("deleted"));
+            QJsonObject json;
+            json.insert(QStringLiteral("id"), item.id);
+            json.insert(QStringLiteral("parentReference"), parentReference);
+            json.insert(QStringLiteral("deleted"), deleted);
+            value.append(json);
+        }
+    }
+
+    Response response;
+    response.body.insert(QStringLiteral("value"), value);
+    QUrlQuery query;
+    QUrl link(url().toString() + QStringLiteral("/me/drive/items/%1/delta").arg(folderId));
+    if (skip + top < changed.size()) {
+        query.addQueryItem(QStringLiteral("token"), QString::number(token));
+        query.addQueryItem(QStringLiteral("$top"), QString::number(top));
+        query.addQueryItem(QStringLiteral("$skiptoken"), QString::number(skip + top));
+        link.setQuery(query);
+        response.body.insert(QStringLiteral("@odata.nextLink"), link.toString());
+    } else {
+        query.addQueryItem(QStringLiteral("token"), QString::number(m_lastChange));
+        link.setQuery(query);
+        response.body.insert(QStringLiteral("@odata.deltaLink"), link.toString());
+    }
+    return response;
+}
+
+MockGraphServer::Response MockDrive::search(const Request &request, const QString &folderId, const QString &term)
+{
+    // Names only, in no particular order, like the server.
+    QStringList ids;
+    for (const auto &item : qAsConst(m_items)) {
+        if (item.id != folderId && item.name.contains(term, Qt::CaseInsensitive) && isInside(item.id, folderId)) {
+            ids << item.id;
+        }
+    }
+    const int top = request.query.hasQueryItem(QStringLiteral("$top")) ? request.query.queryItemValue(QStringLiteral("$top")).toInt() : 200;
+    const int skip = request.query.queryItemValue(QStringLiteral("$skiptoken")).toInt();
+
+    QJsonArray value;
+    for (int i = skip; i < ids.size() && i < skip + top; ++i) {
+        const Item &item = m_items[ids.at(i)];
+        QJsonObject json = toJson(item);
+        QJsonObject parentReference = json.value(QStringLiteral("parentReference")).toObject();
+        const QString parentPath = item.parentId == m_rootId ? QString() : pathOf(item.parentId);
+        parentReference.insert(QStringLiteral("path"), QStringLiteral("/drive/root:") + QString::fromLatin1(QUrl::toPercentEncoding(parentPath, "/")));
+        json.insert(QStringLiteral("parentReference"), parentReference);
+        value.append(json);
+    }
+
+    Response response;
+    response.body.insert(QStringLiteral("value"), value);
+    if (skip + top < ids.size()) {
+        QUrlQuery query;
+        query.addQueryItem(QStringLiteral("$top"), QString::number(top));
+        query.addQueryItem(QStringLiteral("$skiptoken"), QString::number(skip + top));
+        QUrl next(url().toString() + QStringLiteral("/me/drive/items/%1/search(q='%2')")
+                  .arg(folderId, QString::fromLatin1(QUrl::toPercentEncoding(QString(term).replace(QLatin1Char('\''), QStringLiteral("''"))))));
+        next.setQuery(query);
+        response.body.insert(QStringLiteral("@odata.nextLink"), next.toString());
+    }
+    return response;
+}
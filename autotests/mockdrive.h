@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#pragma once
+
+#include "mockgraphserver.h"
+
+#include <QDateTime>
+#include <QStringList>
+
+/**
+ * A mock Graph server holding an in-memory drive, which answers the drive
+ * requests of the worker: item, path and children lookups, folder creation,
+ * simple and session uploads, ranged downloads, server-side copies, moves
+ * and deletions, change feeds and searches.
+ *
+ * File contents are generated on the fly, so large drives cost no memory.
+ */
+class MockDrive : public MockGraphServer
+{
+    Q_OBJECT
+
+public:
+    struct Shape {
+        /** Levels of folders below the root. */
+        int depth = 2;
+        /** Subfolders of each folder. */
+        int folders = 4;
+        /** Files in each folder, including the root. */
+        int files = 8;
+        qint64 fileSize = 64 * 1024;
+    };
+
+    explicit MockDrive(QObject *parent = nullptr);
+    ~MockDrive();
+
+    /**
+     * Replaces the content of the drive with a synthetic tree.
+     */
+    void generate(const Shape &shape);
+
+    QString rootId() const;
+
+    /**
+     * @return The ID of the item at @p path, relative to the root, or an
+     * empty string.
+     */
+    QString idForPath(const QString &path) const;
+
+    /**
+     * @return The IDs of every folder, root included, or of every file, in
+     * breadth-first order.
+     */
+    QStringList folderIds() const;
+    QStringList fileIds() const;
+
+    QByteArray content(const QString &id) const;
+
+protected:
+    Response handle(const Request &request) override;
+
+private:
+    struct Item {
+        QString id;
+        QString name;
+        QString parentId;
+        bool folder = false;
+        qint64 size = 0;
+        /** Generated from the seed when null. */
+        QByteArray content;
+        /** The ID of the item the content was generated for. */
+        QString seed;
+        QDateTime modified;
+        /** Position in the change feed of the last change. */
+        int change = 0;
+    };
+
+    struct UploadSession {
+        QString parentId;
+        QString name;
+        QByteArray content;
+    };
+
+    QString addItem(const QString &parentId, const QString &name, bool folder, qint64 size);
+    QString child(const QString &parentId, const QString &name) const;
+    QStringList children(const QString &parentId) const;
+    QString copyItem(const QString &id, const QString &parentId, const QString &name);
+    void removeItem(const QString &id);
+    void touch(Item *item);
+    bool isInside(const QString &id, const QString &folderId) const;
+    QByteArray read(const Item &item, qint64 first, qint64 last) const;
+    QJsonObject toJson(const Item &item) const;
+    QString pathOf(const QString &id) const;
+    qint64 contentSize(const QString &folderId) const;
+    QByteArray contentHash(const Item &item) const;
+
+    Response handleItem(const Request &request, const QString &id, const QString &action);
+    Response handleMissingItem(const Request &request, const QString &parentId, const QString &name, const QString &action);
+    Response upload(const QString &parentId, const QString &name, const QByteArray &content, bool replace);
+    Response download(const Request &request, const Item &item);
+    Response delta(const Request &request, const QString &folderId);
+    Response search(const Request &request, const QString &folderId, const QString &term);
+    Response handleUploadSession(const Request &request, const QString &sessionId);
+    static Response error(int status, const QString &code);
+
+    QHash<QString, Item> m_items;
+    QHash<QString, QStringList> m_children;
+    /** Removed items, for the change feed. */
+    QHash<QString, Item> m_removed;
+    QHash<QString, UploadSession> m_sessions;
+    QString m_rootId;
+    int m_lastId = 0;
+    int m_lastChange = 0;
+};
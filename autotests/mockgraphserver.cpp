@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "mockgraphserver.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QPointer>
+#include <QTcpSocket>
+#include <QTimer>
+
+MockGraphServer::MockGraphServer(QObject *parent)
+    : QTcpServer(parent)
+{
+    connect(this, &QTcpServer::newConnection, this, [this]() {
+        while (QTcpSocket *socket = nextPendingConnection()) {
+            connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+                readRequests(socket);
+            });
+            connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+                m_buffers.remove(socket);
+                socket->deleteLater();
+            });
+        }
+    });
+}
+
+MockGraphServer::~MockGraphServer()
+{
+}
+
+bool MockGraphServer::start()
+{
+    return listen(QHostAddress::LocalHost);
+}
+
+QUrl MockGraphServer::url() const
+{
+    return QUrl(QStringLiteral("http://127.0.0.1:%1/v1.0").arg(serverPort()));
+}
+
+void MockGraphServer::setLatency(int msecs)
+{
+    m_latency = msecs;
+}
+
+void MockGraphServer::setBandwidth(qint64 bytesPerSecond)
+{
+    m_bandwidth = bytesPerSecond;
+}
+
+void MockGraphServer::setSharedLink(bool shared)
+{
+    m_sharedLink = shared;
+    m_link.start();
+    m_linkBusyUntil = 0;
+}
+
+int MockGraphServer::requestCount() const
+{
+    return m_requestCount;
+}
+
+int MockGraphServer::requestCount(const QByteArray &method) const
+{
+    return m_methodCounts.value(method);
+}
+
+void MockGraphServer::resetCounters()
+{
+    m_requestCount = 0;
+    m_methodCounts.clear();
+}
+
+void MockGraphServer::readRequests(QTcpSocket *socket)
+{
+    QByteArray &buffer = m_buffers[socket];
+    buffer.append(socket->readAll());
+
+    // Several requests may be pipelined on a kept-alive connection.
+    Q_FOREVER {
+        const int headerEnd = buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            return;
+        }
+
+        const QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+        const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+        if (requestLine.size() < 2) {
+            socket->disconnectFromHost();
+            return;
+        }
+
+        Request request;
+        for (const auto &line : lines.mid(1)) {
+            const int colon = line.indexOf(':');
+            if (colon > 0) {
+                request.headers.insert(line.left(colon).trimmed().toLower(), line.mid(colon + 1).trimmed());
+            }
+        }
+        const int contentLength = request.headers.value("content-length").toInt();
+        if (buffer.size() < headerEnd + 4 + contentLength) {
+            return;
+        }
+
+        request.method = requestLine.at(0);
+        request.data = buffer.mid(headerEnd + 4, contentLength);
+        buffer.remove(0, headerEnd + 4 + contentLength);
+
+        ++m_requestCount;
+        ++m_methodCounts[request.method];
+
+        const QUrl url(QString::fromLatin1(requestLine.at(1)));
+        request.path = url.path(QUrl::FullyDecoded);
+        request.query = QUrlQuery(url);
+        if (request.path.startsWith(QLatin1String("/v1.0"))) {
+            request.path = request.path.mid(5);
+        }
+
+        const Response response = (request.method == "POST" && request.path == QLatin1String("/$batch"))
+            ? handleBatch(request)
+            : answer(request);
+
+        int delay = m_latency;
+        if (m_bandwidth > 0) {
+            const qint64 transfer = (request.data.size() + payload(response).size()) * 1000 / m_bandwidth;
+            if (m_sharedLink) {
+                m_linkBusyUntil = qMax(m_linkBusyUntil, m_link.elapsed()) + transfer;
+                delay += int(m_linkBusyUntil - m_link.elapsed());
+            } else {
+                delay += int(transfer);
+            }
+        }
+        if (delay > 0) {
+            QPointer<QTcpSocket> guard(socket);
+            QTimer::singleShot(delay, this, [this, guard, response]() {
+                if (guard) {
+                    reply(guard, response);
+                }
+            });
+        } else {
+            reply(socket, response);
+        }
+    }
+}
+
+QJsonObject MockGraphServer::Request::body() const
+{
+    return QJsonDocument::fromJson(data).object();
+}
+
+MockGraphServer::Response MockGraphServer::handle(const Request &request)
+{
+    Response response;
+    if (request.method == "DELETE") {
+        response.status = 204;
+    } else if (request.method == "GET" || request.method == "PATCH") {
+        response.body.insert(QStringLiteral("id"), request.path.section(QLatin1Char('/'), -1));
+        response.body.insert(QStringLiteral("name"), request.path.section(QLatin1Char('/'), -1));
+    } else {
+        response.status = 501;
+    }
+
+    return response;
+}
+
+void MockGraphServer::rejectNext(int requests, int status, int retryAfter)
+{
+    m_rejectedRequests = requests;
+    m_rejectStatus = status;
+    m_rejectRetryAfter = retryAfter;
+}
+
+MockGraphServer::Response MockGraphServer::answer(const Request &request)
+{
+    if (m_rejectedRequests == 0) {
+        return handle(request);
+    }
+
+    --m_rejectedRequests;
+    Response response;
+    response.status = m_rejectStatus;
+    QJsonObject error;
+    error.insert(QStringLiteral("code"), QStringLiteral("rejected"));
+    error.insert(QStringLiteral("message"), QStringLiteral("Rejected by the test"));
+    response.body.insert(QStringLiteral("error"), error);
+    if (m_rejectRetryAfter >= 0) {
+        response.headers.insert("Retry-After", QByteArray::number(m_rejectRetryAfter));
+    }
+    return response;
+}
+
+MockGraphServer::Response MockGraphServer::handleBatch(const Request &request)
+{
+    QJsonArray responses;
+    QHash<QString, int> statuses;
+    const auto requests = request.body().value(QStringLiteral("requests")).toArray();
+    for (const auto &value : requests) {
+        const auto json = value.toObject();
+        const QString id = json.value(QStringLiteral("id")).toString();
+
+        // Like the server, run a request only if the ones it depends on succeeded.
+        bool dependenciesMet = true;
+        for (const auto &dependency : json.value(QStringLiteral("dependsOn")).toArray()) {
+            const int status = statuses.value(dependency.toString());
+            dependenciesMet = dependenciesMet && status >= 200 && status < 300;
+        }
+
+        Response single;
+        if (dependenciesMet) {
+            const QUrl url(json.value(QStringLiteral("url")).toString());
+            Request subRequest;
+            subRequest.method = json.value(QStringLiteral("method")).toString().toLatin1();
+            subRequest.path = url.path(QUrl::FullyDecoded);
+            subRequest.query = QUrlQuery(url);
+            if (json.contains(QStringLiteral("body"))) {
+                subRequest.data = QJsonDocument(json.value(QStringLiteral("body")).toObject()).toJson(QJsonDocument::Compact);
+            }
+            single = answer(subRequest);
+        } else {
+            single.status = 424;
+        }
+        statuses.insert(id, single.status);
+
+        QJsonObject response;
+        response.insert(QStringLiteral("id"), id);
+        response.insert(QStringLiteral("status"), single.status);
+        response.insert(QStringLiteral("body"), single.body);
+        if (!single.headers.isEmpty()) {
+            QJsonObject headers;
+            for (auto it = single.headers.constBegin(); it != single.headers.constEnd(); ++it) {
+                headers.insert(QString::fromLatin1(it.key()), QString::fromLatin1(it.value()));
+            }
+            response.insert(QStringLiteral("headers"), headers);
+        }
+        responses.append(response);
+    }
+
+    Response response;
+    response.body.insert(QStringLiteral("responses"), responses);
+    return response;
+}
+
+QByteArray MockGraphServer::payload(const Response &response)
+{
+    if (!response.data.isEmpty()) {
+        return response.data;
+    }
+    return response.body.isEmpty() ? QByteArray() : QJsonDocument(response.body).toJson(QJsonDocument::Compact);
+}
+
+void MockGraphServer::reply(QTcpSocket *socket, const Response &response)
+{
+    const QByteArray body = payload(response);
+
+    QByteArray data = "HTTP/1.1 " + QByteArray::number(response.status) + " Mock\r\n";
+    data += response.data.isEmpty() ? "Content-Type: application/json\r\n" : "Content-Type: application/octet-stream\r\n";
+    for (auto it = response.headers.constBegin(); it != response.headers.constEnd(); ++it) {
+        data += it.key() + ": " + it.value() + "\r\n";
+    }
+    data += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    data += "Connection: keep-alive\r\n\r\n";
+    data += body;
+    socket->write(data);
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QTcpServer>
+#include <QUrl>
+#include <QUrlQuery>
+
+/**
+ * A local stand-in for the Microsoft Graph drive API.
+ *
+ * Point the code under test to url() through the ONEDRIVE_GRAPH_URL
+ * environment variable. Every HTTP request is counted, and an artificial
+ * latency and bandwidth can be applied to every response.
+ */
+class MockGraphServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    explicit MockGraphServer(QObject *parent = nullptr);
+    ~MockGraphServer();
+
+    /**
+     * Starts listening on a random local port.
+     */
+    bool start();
+
+    QUrl url() const;
+
+    void setLatency(int msecs);
+
+    /**
+     * Delays every exchange by the time needed to transfer its request and
+     * response bodies at @p bytesPerSecond. 0, the default, means unlimited.
+     */
+    void setBandwidth(qint64 bytesPerSecond);
+
+    /**
+     * Makes all exchanges share a single link at the bandwidth, in the order
+     * of the requests, like the uplink of a home connection: each one waits
+     * for those still in flight.
+     */
+    void setSharedLink(bool shared);
+
+    /**
+     * Answers the next @p requests single requests with @p status, and a
+     * Retry-After of @p retryAfter seconds unless negative. Requests within a
+     * JSON batch count, the batch itself does not.
+     */
+    void rejectNext(int requests, int status, int retryAfter = -1);
+
+    int requestCount() const;
+    int requestCount(const QByteArray &method) const;
+    void resetCounters();
+
+protected:
+    struct Request {
+        QByteArray method;
+        /** Relative to the API root, e.g. /me/drive/items/1. */
+        QString path;
+        QUrlQuery query;
+        /** Header names are lower case. */
+        QHash<QByteArray, QByteArray> headers;
+        QByteArray data;
+
+        QJsonObject body() const;
+    };
+
+    struct Response {
+        int status = 200;
+        QJsonObject body;
+        /** Sent instead of the JSON body when not empty. */
+        QByteArray data;
+        QHash<QByteArray, QByteArray> headers;
+    };
+
+    /**
+     * Answers a single request, also when it is part of a JSON batch.
+     */
+    virtual Response handle(const Request &request);
+
+private:
+    void readRequests(QTcpSocket *socket);
+    Response answer(const Request &request);
+    Response handleBatch(const Request &request);
+    void reply(QTcpSocket *socket, const Response &response);
+    static QByteArray payload(const Response &response);
+
+    int m_latency = 0;
+    qint64 m_bandwidth = 0;
+    bool m_sharedLink = false;
+    QElapsedTimer m_link;
+    qint64 m_linkBusyUntil = 0;
+    int m_requestCount = 0;
+    int m_rejectedRequests = 0;
+    int m_rejectStatus = 0;
+    int m_rejectRetryAfter = -1;
+    QHash<QByteArray, int> m_methodCounts;
+    QHash<QTcpSocket*, QByteArray> m_buffers;
+};
@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "../src/offlinestore.h"
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+#include <QTest>
+
+class OfflineStoreTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testListing();
+    void testEntryFromParentListing();
+    void testContentVersions();
+    void testContentBudget();
+    void testContentsNotStored();
+    void testMetadataBudget();
+    void testInvalidate();
+    void testDisabled();
+
+private:
+    static KIO::UDSEntry fileEntry(const QString &name, const QString &id);
+};
+
+QTEST_GUILESS_MAIN(OfflineStoreTest)
+
+KIO::UDSEntry OfflineStoreTest::fileEntry(const QString &name, const QString &id)
+{
+    KIO::UDSEntry entry;
+    entry.insert(KIO::UDSEntry::UDS_NAME, name);
+    entry.insert(KIO::UDSEntry::UDS_URL, QStringLiteral("onedrive:/foo@outlook.com/%1?id=%2").arg(name, id));
+    entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFREG);
+    return entry;
+}
+
+void OfflineStoreTest::testListing()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    OfflineStore store(dir.path());
+
+    const QDateTime before = QDateTime::currentDateTimeUtc().addSecs(-1);
+    store.storeListing(QStringLiteral("/foo@outlook.com/bar/"),
+                       {fileEntry(QStringLiteral("a.txt"), QStringLiteral("1")), fileEntry(QStringLiteral("b.txt"), QStringLiteral("2"))});
+
+    // Stored data survives the worker.
+    OfflineStore reopened(dir.path());
+    KIO::UDSEntryList entries;
+    QDateTime storedAt;
+    QVERIFY(reopened.listing(QStringLiteral("/foo@outlook.com/bar"), &entries, &storedAt));
+    QCOMPARE(entries.count(), 2);
+    QCOMPARE(entries.at(1).stringValue(KIO::UDSEntry::UDS_NAME), QStringLiteral("b.txt"));
+    QVERIFY(storedAt >= before);
+
+    QVERIFY(!reopened.listing(QStringLiteral("/foo@outlook.com/baz"), &entries, &storedAt));
+}
+
+void OfflineStoreTest::testEntryFromParentListing()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    OfflineStore store(dir.path());
+    store.storeListing(QStringLiteral("/foo@outlook.com/bar"), {fileEntry(QStringLiteral("a.txt"), QStringLiteral("1"))});
+
+    KIO::UDSEntry entry;
+    QDateTime storedAt;
+    QVERIFY(store.entry(QStringLiteral("/foo@outlook.com/bar/a.txt"), &entry, &storedAt));
+    QCOMPARE(entry.stringValue(KIO::UDSEntry::UDS_NAME), QStringLiteral("a.txt"));
+    QVERIFY(!store.entry(QStringLiteral("/foo@outlook.com/bar/b.txt"), &entry, &storedAt));
+
+    // A stat'ed entry wins over the listing.
+    KIO::UDSEntry stated = fileEntry(QStringLiteral("a.txt"), QStringLiteral("1"));
+    stated.insert(KIO::UDSEntry::UDS_SIZE, 42);
+    store.storeEntry(QStringLiteral("/foo@outlook.com/bar/a.txt"), stated);
+    QVERIFY(store.entry(QStringLiteral("/foo@outlook.com/bar/a.txt"), &entry, &storedAt));
+    QCOMPARE(entry.numberValue(KIO::UDSEntry::UDS_SIZE), 42LL);
+}
+
+void OfflineStoreTest::testContentVersions()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    OfflineStore store(dir.path());
+
+    const QDateTime first = QDateTime::fromTime_t(1500000000);
+    const QDateTime second = first.addSecs(60);
+    store.storeContent(QStringLiteral("1"), first, "first");
+    QVERIFY(!store.contentFile(QStringLiteral("1"), first).isEmpty());
+    QVERIFY(store.contentFile(QStringLiteral("1"), second).isEmpty());
+
+    // Milliseconds are not part of the entries.
+    QVERIFY(!store.contentFile(QStringLiteral("1"), first.addMSecs(500)).isEmpty());
+
+    store.storeContent(QStringLiteral("1"), second, "second");
+    QVERIFY(store.contentFile(QStringLiteral("1"), first).isEmpty());
+    QFile file(store.contentFile(QStringLiteral("1"), second));
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), QByteArray("second"));
+
+    QTemporaryFile local;
+    QVERIFY(local.open());
+    local.write("local");
+    local.close();
+    store.storeContentFile(QStringLiteral("2"), first, local.fileName());
+    QCOMPARE(store.contentSize(), qint64(11));
+}
+
+void OfflineStoreTest::testContentBudget()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    OfflineStore store(dir.path(), 800);
+
+    // Too big for a budget of 800 bytes.
+    store.storeContent(QStringLiteral("big"), QDateTime::fromTime_t(0), QByteArray(101, 'x'));
+    QVERIFY(store.contentFile(QStringLiteral("big"), QDateTime::fromTime_t(0)).isEmpty());
+
+    for (int i = 0; i < 12; ++i) {
+        store.storeContent(QString::number(i), QDateTime::fromTime_t(0), QByteArray(100, 'x'));
+        QVERIFY(store.contentSize() <= 800);
+    }
+    QCOMPARE(store.contentSize(), qint64(800));
+    // The newest one is never evicted.
+    QVERIFY(!store.contentFile(QStringLiteral("11"), QDateTime::fromTime_t(0)).isEmpty());
+}
+
+void OfflineStoreTest::testContentsNotStored()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    OfflineStore store(dir.path());
+    store.setContentsStored(false);
+
+    store.storeContent(QStringLiteral("1"), QDateTime::fromTime_t(0), QByteArray("hello"));
+    QVERIFY(store.contentFile(QStringLiteral("1"), QDateTime::fromTime_t(0)).isEmpty());
+    QCOMPARE(store.contentSize(), qint64(0));
+
+    // Hot folders still get their contents.
+    store.storeContent(QStringLiteral("2"), QDateTime::fromTime_t(0), QByteArray("hello"), OfflineStore::Pinned);
+    QVERIFY(!store.contentFile(QStringLiteral("2"), QDateTime::fromTime_t(0)).isEmpty());
+}
+
+void OfflineStoreTest::testMetadataBudget()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    OfflineStore store(dir.path());
+    store.markHotFolder(QStringLiteral("/foo@outlook.com/hot"), QDateTime::currentDateTimeUtc());
+
+    store.storeListing(QStringLiteral("/foo@outlook.com/0"), {fileEntry(QStringLiteral("a.txt"), QStringLiteral("0"))});
+    const qint64 recordSize = QDir(dir.path() + QStringLiteral("/metadata")).entryInfoList({QStringLiteral("*.listing")}, QDir::Files).first().size();
+    store.setMetadataBudget(4 * recordSize);
+
+    for (int i = 1; i < 20; ++i) {
+        store.storeListing(QStringLiteral("/foo@outlook.com/%1").arg(i), {fileEntry(QStringLiteral("a.txt"), QString::number(i))});
+    }
+
+    const auto listings = QDir(dir.path() + QStringLiteral("/metadata")).entryInfoList({QStringLiteral("*.listing")}, QDir::Files);
+    QVERIFY(!listings.isEmpty());
+    QVERIFY(listings.size() <= 4);
+    KIO::UDSEntryList entries;
+    QDateTime storedAt;
+    QVERIFY(store.listing(QStringLiteral("/foo@outlook.com/19"), &entries, &storedAt));
+    QVERIFY(!store.listing(QStringLiteral("/foo@outlook.com/0"), &entries, &storedAt));
+    QDateTime syncedAt;
+    QVERIFY(store.hotFolder(QStringLiteral("/foo@outlook.com/hot"), &syncedAt));
+
+    // Hot folders keep their listings.
+    store.storeListing(QStringLiteral("/foo@outlook.com/hot"), {fileEntry(QStringLiteral("a.txt"), QStringLiteral("hot"))},
+                       OfflineStore::Pinned);
+    for (int i = 20; i < 40; ++i) {
+        store.storeListing(QStringLiteral("/foo@outlook.com/%1").arg(i), {fileEntry(QStringLiteral("a.txt"), QString::number(i))});
+    }
+    QVERIFY(store.listing(QStringLiteral("/foo@outlook.com/hot"), &entries, &storedAt));
+}
+
+void OfflineStoreTest::testInvalidate()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    OfflineStore store(dir.path());
+    store.storeListing(QStringLiteral("/foo@outlook.com"), {fileEntry(QStringLiteral("bar"), QStringLiteral("1"))});
+    store.storeListing(QStringLiteral("/foo@outlook.com/bar"), {fileEntry(QStringLiteral("a.txt"), QStringLiteral("2"))});
+    store.storeListing(QStringLiteral("/foo@outlook.com/baz"), {fileEntry(QStringLiteral("b.txt"), QStringLiteral("3"))});
+    store.storeEntry(QStringLiteral("/foo@outlook.com/bar"), fileEntry(QStringLiteral("bar"), QStringLiteral("1")));
+
+    store.invalidate(QStringLiteral("/foo@outlook.com/bar/"));
+
+    KIO::UDSEntryList entries;
+    KIO::UDSEntry entry;
+    QDateTime storedAt;
+    QVERIFY(!store.listing(QStringLiteral("/foo@outlook.com"), &entries, &storedAt));
+    QVERIFY(!store.listing(QStringLiteral("/foo@outlook.com/bar"), &entries, &storedAt));
+    QVERIFY(!store.entry(QStringLiteral("/foo@outlook.com/bar"), &entry, &storedAt));
+    QVERIFY(store.listing(QStringLiteral("/foo@outlook.com/baz"), &entries, &storedAt));
+}
+
+void OfflineStoreTest::testDisabled()
+{
+    OfflineStore store(QString());
+    QVERIFY(!store.isEnabled());
+
+    store.storeListing(QStringLiteral("/foo@outlook.com"), {fileEntry(QStringLiteral("bar"), QStringLiteral("1"))});
+    KIO::UDSEntryList entries;
+    QDateTime storedAt;
+    QVERIFY(!store.listing(QStringLiteral("/foo@outlook.com"), &entries, &storedAt));
+    QCOMPARE(store.contentSize(), qint64(0));
+}
+
+#include "offlinestoretest.moc"
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "../src/pathcache.h"
+
+#include <QTest>
+
+class PathCacheTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testRemoveSubtree();
+    void testParentsCount();
+};
+
+QTEST_GUILESS_MAIN(PathCacheTest)
+
+void PathCacheTest::testRemoveSubtree()
+{
+    PathCache cache;
+    cache.insertPath(QStringLiteral("/foo@outlook.com/bar"), QStringLiteral("1"));
+    cache.insertPath(QStringLiteral("/foo@outlook.com/bar/baz"), QStringLiteral("2"));
+    cache.insertPath(QStringLiteral("/foo@outlook.com/bar/baz/qux.txt"), QStringLiteral("3"));
+    cache.insertPath(QStringLiteral("/foo@outlook.com/barbaz"), QStringLiteral("4"));
+
+    cache.removeSubtree(QStringLiteral("/foo@outlook.com/bar"));
+
+    QVERIFY(cache.idForPath(QStringLiteral("/foo@outlook.com/bar")).isEmpty());
+    QVERIFY(cache.idForPath(QStringLiteral("/foo@outlook.com/bar/baz")).isEmpty());
+    QVERIFY(cache.idForPath(QStringLiteral("/foo@outlook.com/bar/baz/qux.txt")).isEmpty());
+    // Same prefix, but not below the removed folder.
+    QCOMPARE(cache.idForPath(QStringLiteral("/foo@outlook.com/barbaz")), QStringLiteral("4"));
+}
+
+void PathCacheTest::testParentsCount()
+{
+    PathCache cache;
+    cache.insertPath(QStringLiteral("/foo@outlook.com/bar.txt"), QStringLiteral("1"));
+    QCOMPARE(cache.parentsCount(QStringLiteral("/foo@outlook.com/bar.txt")), 0);
+
+    cache.setParentsCount(QStringLiteral("/foo@outlook.com/bar.txt"), 1);
+    QCOMPARE(cache.parentsCount(QStringLiteral("foo@outlook.com/bar.txt")), 1);
+
+    cache.removePath(QStringLiteral("/foo@outlook.com/bar.txt"));
+    QVERIFY(cache.idForPath(QStringLiteral("/foo@outlook.com/bar.txt")).isEmpty());
+    QCOMPARE(cache.parentsCount(QStringLiteral("/foo@outlook.com/bar.txt")), 0);
+}
+
+#include "pathcachetest.moc"
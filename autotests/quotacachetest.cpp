@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "../src/quotacache.h"
+
+#include <QTest>
+
+class QuotaCacheTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testLookup();
+    void testExpiry();
+    void testAdjustUsed();
+    void testInvalidate();
+};
+
+QTEST_GUILESS_MAIN(QuotaCacheTest)
+
+void QuotaCacheTest::testLookup()
+{
+    QuotaCache cache;
+    qint64 total = 0;
+    qint64 used = 0;
+    QVERIFY(!cache.lookup(QStringLiteral("foo@outlook.com"), &total, &used));
+
+    cache.insert(QStringLiteral("foo@outlook.com"), 1000, 400);
+    QVERIFY(cache.lookup(QStringLiteral("foo@outlook.com"), &total, &used));
+    QCOMPARE(total, qint64(1000));
+    QCOMPARE(used, qint64(400));
+    // Each account has its own quota.
+    QVERIFY(!cache.lookup(QStringLiteral("bar@outlook.com"), &total, &used));
+}
+
+void QuotaCacheTest::testExpiry()
+{
+    QuotaCache cache(20);
+    qint64 total = 0;
+    qint64 used = 0;
+    cache.insert(QStringLiteral("foo@outlook.com"), 1000, 400);
+    QVERIFY(cache.lookup(QStringLiteral("foo@outlook.com"), &total, &used));
+
+    QTest::qWait(40);
+    QVERIFY(!cache.lookup(QStringLiteral("foo@outlook.com"), &total, &used));
+
+    // A new quota from the server is fresh again.
+    cache.insert(QStringLiteral("foo@outlook.com"), 1000, 500);
+    QVERIFY(cache.lookup(QStringLiteral("foo@outlook.com"), &total, &used));
+    QCOMPARE(used, qint64(500));
+}
+
+void QuotaCacheTest::testAdjustUsed()
+{
+    QuotaCache cache(20);
+    qint64 total = 0;
+    qint64 used = 0;
+    cache.adjustUsed(QStringLiteral("foo@outlook.com"), 100);
+    QVERIFY(!cache.lookup(QStringLiteral("foo@outlook.com"), &total, &used));
+
+    cache.insert(QStringLiteral("foo@outlook.com"), 1000, 400);
+    cache.adjustUsed(QStringLiteral("foo@outlook.com"), 100);
+    QVERIFY(cache.lookup(QStringLiteral("foo@outlook.com"), &total, &used));
+    QCOMPARE(used, qint64(500));
+    cache.adjustUsed(QStringLiteral("foo@outlook.com"), -1000);
+    QVERIFY(cache.lookup(QStringLiteral("foo@outlook.com"), &total, &used));
+    QCOMPARE(used, qint64(0));
+
+    // Our own changes do not make the quota any fresher.
+    QTest::qWait(40);
+    cache.adjustUsed(QStringLiteral("foo@outlook.com"), 100);
+    QVERIFY(!cache.lookup(QStringLiteral("foo@outlook.com"), &total, &used));
+}
+
+void QuotaCacheTest::testInvalidate()
+{
+    QuotaCache cache;
+    qint64 total = 0;
+    qint64 used = 0;
+    cache.insert(QStringLiteral("foo@outlook.com"), 1000, 400);
+    cache.insert(QStringLiteral("bar@outlook.com"), 2000, 100);
+
+    cache.invalidate(QStringLiteral("foo@outlook.com"));
+    QVERIFY(!cache.lookup(QStringLiteral("foo@outlook.com"), &total, &used));
+    QVERIFY(cache.lookup(QStringLiteral("bar@outlook.com"), &total, &used));
+    QCOMPARE(total, qint64(2000));
+}
+
+#include "quotacachetest.moc"
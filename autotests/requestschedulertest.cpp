@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "../src/requestscheduler.h"
+
+#include <QCoreApplication>
+#include <QTest>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+class RequestSchedulerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testScope();
+    void testIdle();
+    void testInteractive();
+    void testTransfer();
+    void testBackground();
+    void testDeadProcess();
+};
+
+QTEST_GUILESS_MAIN(RequestSchedulerTest)
+
+void RequestSchedulerTest::initTestCase()
+{
+    // Away from the requests of the session, and of the other tests.
+    qputenv("ONEDRIVE_SCHEDULER_KEY", "kio_onedrive_scheduler_test_" + QByteArray::number(QCoreApplication::applicationPid()));
+}
+
+void RequestSchedulerTest::testScope()
+{
+    QCOMPARE(RequestScheduler::priority(), RequestScheduler::Interactive);
+    {
+        RequestScheduler::Scope transfer(RequestScheduler::Transfer);
+        QCOMPARE(RequestScheduler::priority(), RequestScheduler::Transfer);
+        {
+            RequestScheduler::Scope background(RequestScheduler::Background);
+            QCOMPARE(RequestScheduler::priority(), RequestScheduler::Background);
+        }
+        QCOMPARE(RequestScheduler::priority(), RequestScheduler::Transfer);
+    }
+    QCOMPARE(RequestScheduler::priority(), RequestScheduler::Interactive);
+}
+
+void RequestSchedulerTest::testIdle()
+{
+    for (auto priority : {RequestScheduler::Interactive, RequestScheduler::Transfer, RequestScheduler::Background}) {
+        QCOMPARE(RequestScheduler::holdOff(priority, 100), 0);
+        QCOMPARE(RequestScheduler::connectionShare(priority, 4), 4);
+    }
+
+    // A class never gives way to itself.
+    RequestScheduler::Scope scope(RequestScheduler::Transfer);
+    RequestScheduler::Ticket ticket;
+    QCOMPARE(RequestScheduler::holdOff(RequestScheduler::Transfer, 100), 0);
+    QCOMPARE(RequestScheduler::connectionShare(RequestScheduler::Transfer, 4), 4);
+}
+
+void RequestSchedulerTest::testInteractive()
+{
+    {
+        RequestScheduler::Ticket ticket;
+        QCOMPARE(RequestScheduler::holdOff(RequestScheduler::Interactive, 100), 0);
+        // Weights of 8 to 2.
+        QCOMPARE(RequestScheduler::holdOff(RequestScheduler::Transfer, 100), 400);
+        QCOMPARE(RequestScheduler::holdOff(RequestScheduler::Transfer, 0), 0);
+        QCOMPARE(RequestScheduler::connectionShare(RequestScheduler::Transfer, 4), 1);
+    }
+    QCOMPARE(RequestScheduler::holdOff(RequestScheduler::Transfer, 100), 0);
+}
+
+void RequestSchedulerTest::testTransfer()
+{
+    RequestScheduler::Scope scope(RequestScheduler::Transfer);
+    RequestScheduler::Ticket ticket;
+    QCOMPARE(RequestScheduler::holdOff(RequestScheduler::Background, 100), 200);
+    QCOMPARE(RequestScheduler::connectionShare(RequestScheduler::Background, 4), 1);
+    QCOMPARE(RequestScheduler::connectionShare(RequestScheduler::Background, 6), 2);
+}
+
+void RequestSchedulerTest::testBackground()
+{
+    RequestScheduler::Ticket ticket;
+    // Preempted, whatever the chunk took.
+    QVERIFY(RequestScheduler::holdOff(RequestScheduler::Background, 0) > 0);
+    QVERIFY(RequestScheduler::holdOff(RequestScheduler::Background, 100) > 0);
+}
+
+void RequestSchedulerTest::testDeadProcess()
+{
+    // Registers the table before forking, so that the child shares it.
+    QCOMPARE(RequestScheduler::holdOff(RequestScheduler::Transfer, 100), 0);
+
+    const pid_t child = fork();
+    QVERIFY(child >= 0);
+    if (child == 0) {
+        // Exits without releasing its ticket.
+        new RequestScheduler::Ticket;
+        _exit(0);
+    }
+    int status = 0;
+    QCOMPARE(waitpid(child, &status, 0), child);
+
+    QCOMPARE(RequestScheduler::holdOff(RequestScheduler::Transfer, 100), 0);
+}
+
+#include "requestschedulertest.moc"
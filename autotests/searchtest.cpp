@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "mockdrive.h"
+#include "../src/graphrequest.h"
+#include "../src/onedrivehelper.h"
+
+#include <QJsonArray>
+#include <QTest>
+
+#include <KMGraph/Account>
+
+using namespace KMGraph2;
+
+class SearchTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testItemPath_data();
+    void testItemPath();
+    void testSearchRoot();
+    void testSearchFolder();
+    void testPaging();
+    void testSpecialCharacters();
+
+private:
+    /**
+     * Follows the next links the way the worker does.
+     * @return The path of each match, by ID.
+     */
+    QHash<QString, QString> search(const QString &folderId, const QString &term, int top = 0);
+    void rename(const QString &path, const QString &name);
+
+    MockDrive m_drive;
+    AccountPtr m_account;
+};
+
+QTEST_GUILESS_MAIN(SearchTest)
+
+static const QString AccountId = QStringLiteral("foo@outlook.com");
+
+void SearchTest::initTestCase()
+{
+    QVERIFY(m_drive.start());
+    qputenv("ONEDRIVE_GRAPH_URL", m_drive.url().toString().toLatin1());
+    m_account = AccountPtr(new Account(AccountId, QStringLiteral("secret-token")));
+}
+
+void SearchTest::init()
+{
+    // Each of the 7 folders, root included, holds file0.bin to file2.bin.
+    MockDrive::Shape shape;
+    shape.depth = 2;
+    shape.folders = 2;
+    shape.files = 3;
+    shape.fileSize = 16;
+    m_drive.generate(shape);
+    m_drive.resetCounters();
+}
+
+QHash<QString, QString> SearchTest::search(const QString &folderId, const QString &term, int top)
+{
+    QHash<QString, QString> paths;
+    QUrl next;
+    do {
+        GraphRequest request(OneDriveHelper::networkAccessManager(), "GET", OneDriveHelper::searchPath(folderId, term));
+        request.setAccount(m_account);
+        if (next.isValid()) {
+            request.setUrl(next);
+        } else if (top > 0) {
+            QUrlQuery query;
+            query.addQueryItem(QStringLiteral("$top"), QString::number(top));
+            request.setQuery(query);
+        }
+        if (!request.exec()) {
+            qWarning() << "Search failed:" << request.statusCode() << request.errorString();
+            return {};
+        }
+
+        const QJsonObject response = request.response();
+        const auto values = response.value(QStringLiteral("value")).toArray();
+        for (const auto &value : values) {
+            const QJsonObject item = value.toObject();
+            paths.insert(item.value(QStringLiteral("id")).toString(), OneDriveHelper::itemPath(item, AccountId));
+        }
+        next = QUrl(response.value(QStringLiteral("@odata.nextLink")).toString());
+    } while (next.isValid());
+    return paths;
+}
+
+void SearchTest::rename(const QString &path, const QString &name)
+{
+    QJsonObject patch;
+    patch.insert(QStringLiteral("name"), name);
+    GraphRequest request(OneDriveHelper::networkAccessManager(), "PATCH",
+                         QStringLiteral("/items/%1").arg(m_drive.idForPath(path)), patch);
+    request.setAccount(m_account);
+    QVERIFY(request.exec());
+}
+
+void SearchTest::testItemPath_data()
+{
+    QTest::addColumn<QString>("parentPath");
+    QTest::addColumn<QString>("expectedPath");
+
+    QTest::newRow("in root") << QStringLiteral("/drive/root:") << QStringLiteral("/foo@outlook.com/a.txt");
+    QTest::newRow("in root, trailing slash") << QStringLiteral("/drive/root:/") << QStringLiteral("/foo@outlook.com/a.txt");
+    QTest::newRow("in subfolder") << QStringLiteral("/drive/root:/Documents/2018") << QStringLiteral("/foo@outlook.com/Documents/2018/a.txt");
+    QTest::newRow("encoded") << QStringLiteral("/drives/b!x/root:/My%20Documents") << QStringLiteral("/foo@outlook.com/My Documents/a.txt");
+    QTest::newRow("no path") << QString() << QString();
+}
+
+void SearchTest::testItemPath()
+{
+    QFETCH(QString, parentPath);
+    QFETCH(QString, expectedPath);
+
+    QJsonObject parentReference;
+    parentReference.insert(QStringLiteral("id"), QStringLiteral("parent"));
+    if (!parentPath.isEmpty()) {
+        parentReference.insert(QStringLiteral("path"), parentPath);
+    }
+    QJsonObject item;
+    item.insert(QStringLiteral("id"), QStringLiteral("item"));
+    item.insert(QStringLiteral("name"), QStringLiteral("a.txt"));
+    item.insert(QStringLiteral("parentReference"), parentReference);
+
+    QCOMPARE(OneDriveHelper::itemPath(item, AccountId), expectedPath);
+}
+
+void SearchTest::testSearchRoot()
+{
+    const auto paths = search(QString(), QStringLiteral("FILE1"));
+    QCOMPARE(paths.size(), 7);
+    QCOMPARE(m_drive.requestCount(), 1);
+    for (auto it = paths.constBegin(); it != paths.constEnd(); ++it) {
+        QVERIFY2(it.value().startsWith(QLatin1Char('/') + AccountId + QLatin1Char('/')), qPrintable(it.value()));
+        QVERIFY(it.value().endsWith(QLatin1String("/file1.bin")));
+        QCOMPARE(m_drive.idForPath(it.value().section(QLatin1Char('/'), 2)), it.key());
+    }
+}
+
+void SearchTest::testSearchFolder()
+{
+    const auto paths = search(m_drive.idForPath(QStringLiteral("folder1")), QStringLiteral("file1"));
+    QCOMPARE(paths.size(), 3);
+    for (const auto &path : paths) {
+        QVERIFY2(path.startsWith(QLatin1Char('/') + AccountId + QStringLiteral("/folder1/")), qPrintable(path));
+    }
+
+    // The folder itself is not a match of its own.
+    QCOMPARE(search(m_drive.idForPath(QStringLiteral("folder1")), QStringLiteral("folder1")).values(),
+             QStringList({QLatin1Char('/') + AccountId + QStringLiteral("/folder1/folder1")}));
+}
+
+void SearchTest::testPaging()
+{
+    const auto paths = search(QString(), QStringLiteral("file1"), 2);
+    QCOMPARE(paths.size(), 7);
+    QCOMPARE(m_drive.requestCount(), 4);
+}
+
+void SearchTest::testSpecialCharacters()
+{
+    rename(QStringLiteral("folder0/folder1"), QStringLiteral("My Folder"));
+    rename(QStringLiteral("folder0/My Folder/file1.bin"), QStringLiteral("it's 100%.bin"));
+
+    const auto paths = search(QString(), QStringLiteral("it's 100%"));
+    QCOMPARE(paths.values(), QStringList({QLatin1Char('/') + AccountId + QStringLiteral("/folder0/My Folder/it's 100%.bin")}));
+}
+
+#include "searchtest.moc"
@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "mockdrive.h"
+#include "../src/graphrequest.h"
+#include "../src/onedrivehelper.h"
+#include "../src/subtreelisting.h"
+
+#include <QJsonArray>
+#include <QTest>
+
+#include <KMGraph/Account>
+
+using namespace KMGraph2;
+
+class SubtreeListingTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testInOrder();
+    void testOutOfOrder();
+    void testDeleted();
+    void testRoot();
+    void testDelta();
+};
+
+QTEST_GUILESS_MAIN(SubtreeListingTest)
+
+static QJsonObject item(const QString &id, const QString &parentId, const QString &name, bool folder = false)
+{
+    QJsonObject parentReference;
+    parentReference.insert(QStringLiteral("id"), parentId);
+    QJsonObject json;
+    json.insert(QStringLiteral("id"), id);
+    json.insert(QStringLiteral("name"), name);
+    json.insert(QStringLiteral("parentReference"), parentReference);
+    if (folder) {
+        json.insert(QStringLiteral("folder"), QJsonObject());
+    } else {
+        json.insert(QStringLiteral("file"), QJsonObject());
+    }
+    return json;
+}
+
+static QStringList paths(const QList<SubtreeListing::Node> &nodes)
+{
+    QStringList paths;
+    for (const auto &node : nodes) {
+        paths << node.relativePath;
+    }
+    return paths;
+}
+
+void SubtreeListingTest::testInOrder()
+{
+    SubtreeListing listing(QStringLiteral("top"));
+    QVERIFY(listing.add(item(QStringLiteral("top"), QStringLiteral("root"), QStringLiteral("Top"), true)).isEmpty());
+    QCOMPARE(paths(listing.add(item(QStringLiteral("a"), QStringLiteral("top"), QStringLiteral("a"), true))), QStringList({QStringLiteral("a")}));
+    QCOMPARE(paths(listing.add(item(QStringLiteral("b"), QStringLiteral("a"), QStringLiteral("b"), true))), QStringList({QStringLiteral("a/b")}));
+
+    const auto nodes = listing.add(item(QStringLiteral("c"), QStringLiteral("b"), QStringLiteral("c.txt")));
+    QCOMPARE(paths(nodes), QStringList({QStringLiteral("a/b/c.txt")}));
+    QCOMPARE(nodes.first().id, QStringLiteral("c"));
+    QVERIFY(!nodes.first().folder);
+    QCOMPARE(listing.pendingCount(), 0);
+}
+
+void SubtreeListingTest::testOutOfOrder()
+{
+    SubtreeListing listing(QStringLiteral("top"));
+    QVERIFY(listing.add(item(QStringLiteral("c"), QStringLiteral("b"), QStringLiteral("c.txt"))).isEmpty());
+    QVERIFY(listing.add(item(QStringLiteral("b"), QStringLiteral("a"), QStringLiteral("b"), true)).isEmpty());
+    QVERIFY(listing.add(item(QStringLiteral("d"), QStringLiteral("top"), QStringLiteral("d.txt"))).isEmpty());
+    QCOMPARE(listing.pendingCount(), 3);
+
+    // Held back items follow their parent, parents first.
+    QCOMPARE(paths(listing.add(item(QStringLiteral("top"), QStringLiteral("root"), QStringLiteral("Top"), true))),
+             QStringList({QStringLiteral("d.txt")}));
+    QCOMPARE(paths(listing.add(item(QStringLiteral("a"), QStringLiteral("top"), QStringLiteral("a"), true))),
+             QStringList({QStringLiteral("a"), QStringLiteral("a/b"), QStringLiteral("a/b/c.txt")}));
+    QCOMPARE(listing.pendingCount(), 0);
+}
+
+void SubtreeListingTest::testDeleted()
+{
+    SubtreeListing listing(QStringLiteral("top"));
+    listing.add(item(QStringLiteral("top"), QStringLiteral("root"), QStringLiteral("Top"), true));
+
+    QJsonObject deleted = item(QStringLiteral("a"), QStringLiteral("top"), QStringLiteral("a"));
+    deleted.insert(QStringLiteral("deleted"), QJsonObject());
+    QVERIFY(listing.add(deleted).isEmpty());
+    QCOMPARE(listing.pendingCount(), 0);
+}
+
+void SubtreeListingTest::testRoot()
+{
+    SubtreeListing listing((QString()));
+    QJsonObject root = item(QStringLiteral("r"), QString(), QStringLiteral("root"), true);
+    root.insert(QStringLiteral("root"), QJsonObject());
+    QVERIFY(listing.add(item(QStringLiteral("a"), QStringLiteral("r"), QStringLiteral("a.txt"))).isEmpty());
+    QCOMPARE(paths(listing.add(root)), QStringList({QStringLiteral("a.txt")}));
+}
+
+void SubtreeListingTest::testDelta()
+{
+    MockDrive drive;
+    QVERIFY(drive.start());
+    qputenv("ONEDRIVE_GRAPH_URL", drive.url().toString().toLatin1());
+    MockDrive::Shape shape;
+    shape.depth = 3;
+    shape.folders = 3;
+    shape.files = 2;
+    drive.generate(shape);
+    const AccountPtr account(new Account(QStringLiteral("foo@outlook.com"), QStringLiteral("secret-token")));
+
+    const QString folderId = drive.idForPath(QStringLiteral("folder1"));
+    SubtreeListing listing(folderId);
+    QList<SubtreeListing::Node> nodes;
+    QUrl next;
+    do {
+        GraphRequest request(OneDriveHelper::networkAccessManager(), "GET", QStringLiteral("/items/%1/delta").arg(folderId));
+        request.setAccount(account);
+        if (next.isValid()) {
+            request.setUrl(next);
+        }
+        QVERIFY(request.exec());
+        const auto values = request.response().value(QStringLiteral("value")).toArray();
+        for (const auto &value : values) {
+            nodes << listing.add(value.toObject());
+        }
+        next = QUrl(request.response().value(QStringLiteral("@odata.nextLink")).toString());
+    } while (next.isValid());
+
+    // 3 + 9 folders, 2 files in each of the 13 folders, folder1 included.
+    QCOMPARE(nodes.size(), 12 + 26);
+    QCOMPARE(listing.pendingCount(), 0);
+    for (const auto &node : qAsConst(nodes)) {
+        QCOMPARE(drive.idForPath(QStringLiteral("folder1/") + node.relativePath), node.id);
+    }
+}
+
+#include "subtreelistingtest.moc"
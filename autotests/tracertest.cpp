@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "../src/tracer.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QThread>
+
+class TracerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    // Must run first: tracing cannot be disabled again.
+    void testDisabled();
+    void testSpans();
+    void testRingWraps();
+
+private:
+    static QJsonArray events();
+};
+
+QTEST_GUILESS_MAIN(TracerTest)
+
+QJsonArray TracerTest::events()
+{
+    const auto json = QJsonDocument::fromJson(Tracer::toJson());
+    return json.object().value(QStringLiteral("traceEvents")).toArray();
+}
+
+void TracerTest::testDisabled()
+{
+    QVERIFY(!Tracer::isEnabled());
+    {
+        Tracer::Span span("disabled");
+    }
+    QVERIFY(events().isEmpty());
+    QVERIFY(!Tracer::dump());
+}
+
+void TracerTest::testSpans()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(QStringLiteral("trace.json"));
+    Tracer::enable(fileName);
+
+    {
+        Tracer::Span outer("outer");
+        Tracer::Span inner("inner");
+        QThread::msleep(2);
+    }
+    QThread thread;
+    QObject::connect(&thread, &QThread::started, [&thread]() {
+        Tracer::Span span("thread");
+        thread.quit();
+    });
+    thread.start();
+    QVERIFY(thread.wait());
+
+    QVERIFY(Tracer::dump());
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    const auto array = QJsonDocument::fromJson(file.readAll()).object().value(QStringLiteral("traceEvents")).toArray();
+    QCOMPARE(array.size(), 3);
+
+    // The inner span ends first.
+    const auto inner = array.at(0).toObject();
+    const auto outer = array.at(1).toObject();
+    QCOMPARE(inner.value(QStringLiteral("name")).toString(), QStringLiteral("inner"));
+    QCOMPARE(inner.value(QStringLiteral("ph")).toString(), QStringLiteral("X"));
+    QCOMPARE(outer.value(QStringLiteral("name")).toString(), QStringLiteral("outer"));
+    QVERIFY(inner.value(QStringLiteral("dur")).toDouble() >= 2000);
+    QVERIFY(outer.value(QStringLiteral("ts")).toDouble() <= inner.value(QStringLiteral("ts")).toDouble());
+    QVERIFY(outer.value(QStringLiteral("dur")).toDouble() >= inner.value(QStringLiteral("dur")).toDouble());
+
+    const auto threadSpan = array.at(2).toObject();
+    QCOMPARE(threadSpan.value(QStringLiteral("name")).toString(), QStringLiteral("thread"));
+    QVERIFY(threadSpan.value(QStringLiteral("tid")).toInt() != outer.value(QStringLiteral("tid")).toInt());
+}
+
+void TracerTest::testRingWraps()
+{
+    QVERIFY(Tracer::isEnabled());
+    for (int i = 0; i < 100000; ++i) {
+        Tracer::Span span("loop");
+    }
+
+    // Only the most recent spans of this thread are left, plus the one of the other thread.
+    const auto array = events();
+    QCOMPARE(array.size(), (1 << 16) + 1);
+    QCOMPARE(array.first().toObject().value(QStringLiteral("name")).toString(), QStringLiteral("loop"));
+}
+
+#include "tracertest.moc"
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "mockdrive.h"
+#include "../src/uploadsession.h"
+
+#include <QBuffer>
+#include <QTest>
+
+using namespace KMGraph2;
+
+class UploadSessionTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+
+    void testCreate();
+    void testReplace();
+    void testRefused();
+
+private:
+    static QByteArray content(qint64 size);
+
+    MockDrive m_drive;
+    AccountPtr m_account;
+};
+
+QTEST_GUILESS_MAIN(UploadSessionTest)
+
+void UploadSessionTest::initTestCase()
+{
+    QVERIFY(m_drive.start());
+    qputenv("ONEDRIVE_GRAPH_URL", m_drive.url().toString().toLatin1());
+    m_account = AccountPtr(new Account(QStringLiteral("foo@outlook.com"), QStringLiteral("secret-token")));
+}
+
+void UploadSessionTest::init()
+{
+    MockDrive::Shape shape;
+    shape.depth = 1;
+    shape.folders = 1;
+    shape.files = 1;
+    shape.fileSize = 1024;
+    m_drive.generate(shape);
+}
+
+QByteArray UploadSessionTest::content(qint64 size)
+{
+    QByteArray data(int(size), 'x');
+    data[0] = 'a';
+    data[int(size) - 1] = 'z';
+    return data;
+}
+
+void UploadSessionTest::testCreate()
+{
+    QByteArray data = content(UploadSession::ChunkSize + 1024);
+    QBuffer buffer(&data);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    UploadSession session(m_account, QStringLiteral("/items/%1:/large%20file.bin:").arg(m_drive.rootId()));
+    QList<qint64> processed;
+    connect(&session, &UploadSession::processed, this, [&processed](qint64 bytes) {
+        processed << bytes;
+    });
+    QVERIFY2(session.exec(&buffer, data.size()), qPrintable(session.errorString()));
+
+    // Progress is reported after each chunk.
+    QCOMPARE(processed, QList<qint64>({ UploadSession::ChunkSize, data.size() }));
+    const QString id = m_drive.idForPath(QStringLiteral("large file.bin"));
+    QCOMPARE(session.item().value(QStringLiteral("id")).toString(), id);
+    QCOMPARE(m_drive.content(id), data);
+}
+
+void UploadSessionTest::testReplace()
+{
+    const QString id = m_drive.idForPath(QStringLiteral("file0.bin"));
+    QByteArray data = content(UploadSession::SimpleUploadLimit + 1);
+    QBuffer buffer(&data);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    UploadSession session(m_account, QStringLiteral("/items/%1").arg(id));
+    QVERIFY2(session.exec(&buffer, data.size()), qPrintable(session.errorString()));
+    // The item keeps its ID.
+    QCOMPARE(session.item().value(QStringLiteral("id")).toString(), id);
+    QCOMPARE(m_drive.content(id), data);
+}
+
+void UploadSessionTest::testRefused()
+{
+    QByteArray data = content(1024);
+    QBuffer buffer(&data);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    // The runner sees the failed session request, e.g. to report it.
+    m_drive.rejectNext(1, 507);
+    int runs = 0;
+    UploadSession session(m_account, QStringLiteral("/items/%1:/full.bin:").arg(m_drive.rootId()),
+                          [this, &runs](GraphRequest &request) {
+        ++runs;
+        request.setAccount(m_account);
+        return request.exec();
+    });
+    QVERIFY(!session.exec(&buffer, data.size()));
+    QCOMPARE(runs, 1);
+    QCOMPARE(session.statusCode(), 507);
+    QVERIFY(m_drive.idForPath(QStringLiteral("full.bin")).isEmpty());
+}
+
+#include "uploadsessiontest.moc"
@@ -28,6 +28,9 @@ class UrlTest : public QObject
 private Q_SLOTS:
     void testOneDriveUrl_data();
     void testOneDriveUrl();
+    void testSearchUrl_data();
+    void testSearchUrl();
+    void testRecursiveUrl();
 };
 
 QTEST_GUILESS_MAIN(UrlTest)
@@ -96,4 +99,63 @@ void UrlTest::testOneDriveUrl()
     }
 }
 
+void UrlTest::testSearchUrl_data()
+{
+    QTest::addColumn<QUrl>("url");
+    QTest::addColumn<bool>("expectedSearch");
+    QTest::addColumn<QString>("expectedTerm");
+    QTest::addColumn<QStringList>("expectedPathComponents");
+
+    QTest::newRow("no query")
+            << QUrl(QStringLiteral("onedrive:///foo@outlook.com/bar"))
+            << false
+            << QString()
+            << QStringList {QStringLiteral("foo@outlook.com"), QStringLiteral("bar")};
+
+    QTest::newRow("id query")
+            << QUrl(QStringLiteral("onedrive:///foo@outlook.com/bar.txt?id=123"))
+            << false
+            << QString()
+            << QStringList {QStringLiteral("foo@outlook.com"), QStringLiteral("bar.txt")};
+
+    QTest::newRow("search in account root")
+            << QUrl(QStringLiteral("onedrive:///foo@outlook.com/?search=report"))
+            << true
+            << QStringLiteral("report")
+            << QStringList {QStringLiteral("foo@outlook.com")};
+
+    QTest::newRow("search in subfolder, encoded term")
+            << QUrl(QStringLiteral("onedrive:///foo@outlook.com/bar?search=annual%20report%26co"))
+            << true
+            << QStringLiteral("annual report&co")
+            << QStringList {QStringLiteral("foo@outlook.com"), QStringLiteral("bar")};
+
+    QTest::newRow("search in root url")
+            << QUrl(QStringLiteral("onedrive://?search=report"))
+            << false
+            << QStringLiteral("report")
+            << QStringList();
+}
+
+void UrlTest::testSearchUrl()
+{
+    QFETCH(QUrl, url);
+    QFETCH(bool, expectedSearch);
+    QFETCH(QString, expectedTerm);
+    QFETCH(QStringList, expectedPathComponents);
+
+    const auto onedriveUrl = OneDriveUrl(url);
+
+    QCOMPARE(onedriveUrl.isSearch(), expectedSearch);
+    QCOMPARE(onedriveUrl.searchTerm(), expectedTerm);
+    QCOMPARE(onedriveUrl.pathComponents(), expectedPathComponents);
+}
+void UrlTest::testRecursiveUrl()
+{
+    QVERIFY(OneDriveUrl(QUrl(QStringLiteral("onedrive:///foo@outlook.com/?recursive"))).isRecursive());
+    QVERIFY(OneDriveUrl(QUrl(QStringLiteral("onedrive:///foo@outlook.com/bar?recursive=true"))).isRecursive());
+    QVERIFY(!OneDriveUrl(QUrl(QStringLiteral("onedrive:///foo@outlook.com/bar"))).isRecursive());
+    QVERIFY(!OneDriveUrl(QUrl(QStringLiteral("onedrive://?recursive"))).isRecursive());
+}
+
 #include "urltest.moc"
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * The blocking part of OneDriveSyncModule: syncs the hot folders or sends
+ * the queued uploads once, then exits. Running it out of process keeps the
+ * nested event loops and the bandwidth throttling out of kded.
+ *
+ *   kio_onedrive_syncagent sync [--clear <path>]... [<path>]...
+ *   kio_onedrive_syncagent upload
+ *
+ * The module is told about the outcome on the standard output, one line per
+ * event, the fields separated by tabs:
+ *
+ *   conflict <path> <conflict path>
+ *   next <msecs until the next upload attempt>
+ */
+
+#include "onedrivedebug.h"
+#include "../src/backgrounduploader.h"
+#include "../src/connectivity.h"
+#include "../src/hotfoldersync.h"
+#include "../src/kaccountsmanager.h"
+#include "../src/offlinestore.h"
+#include "../src/requestscheduler.h"
+#include "../src/uploadjournal.h"
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QTextStream>
+
+static const char ConfigName[] = "onedrivesyncrc";
+static const int OfflineRetryDelay = 60000;
+
+static QString accountOf(const QString &path)
+{
+    return path.section(QLatin1Char('/'), 1, 1);
+}
+
+static bool runSync(KAccountsManager *accountManager, HotFolderSync *sync)
+{
+    const auto account = accountManager->account(accountOf(sync->path()));
+    sync->setAccount(account);
+    if (sync->run()) {
+        return true;
+    }
+    if (sync->statusCode() != 401) {
+        return false;
+    }
+
+    // The access token expired.
+    sync->setAccount(accountManager->refreshAccount(account));
+    return sync->run();
+}
+
+static int sync(const QStringList &folders, const QStringList &removedFolders)
+{
+    KAccountsManager accountManager;
+    OfflineStore store(OfflineStore::defaultDirectory());
+    const QString stateDirectory = OfflineStore::defaultDirectory() + QStringLiteral("/sync");
+
+    for (const auto &path : removedFolders) {
+        qCDebug(ONEDRIVE) << "No longer syncing" << path;
+        HotFolderSync(accountManager.account(accountOf(path)), path, &store, stateDirectory).clear();
+    }
+    if (folders.isEmpty()) {
+        return 0;
+    }
+
+    Connectivity connectivity;
+    if (!connectivity.isOnline()) {
+        qCDebug(ONEDRIVE) << "Offline, not syncing";
+        return 0;
+    }
+
+    const KConfigGroup group(KSharedConfig::openConfig(QString::fromLatin1(ConfigName)), "General");
+    qint64 remaining = group.readEntry("ContentBudget", 2048) * qint64(1024 * 1024);
+    const qint64 bandwidth = group.readEntry("Bandwidth", 1024) * qint64(1024);
+
+    // Prefetch gives way to whatever the user is doing.
+    RequestScheduler::Scope scope(RequestScheduler::Background);
+    int failures = 0;
+    for (const auto &path : folders) {
+        HotFolderSync sync(accountManager.account(accountOf(path)), path, &store, stateDirectory);
+        sync.setContentBudget(remaining);
+        sync.setBandwidth(bandwidth);
+        if (!runSync(&accountManager, &sync)) {
+            qCWarning(ONEDRIVE) << "Cannot sync" << path << ":" << sync.errorString();
+            ++failures;
+        }
+        remaining = qMax<qint64>(0, remaining - sync.materializedBytes());
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+static int upload(QTextStream &out)
+{
+    UploadJournal journal(UploadJournal::defaultDirectory());
+    if (journal.isEmpty()) {
+        return 0;
+    }
+
+    Connectivity connectivity;
+    if (!connectivity.isOnline()) {
+        qCDebug(ONEDRIVE) << "Offline, not uploading";
+        out << "next\t" << OfflineRetryDelay << '\n';
+        return 0;
+    }
+
+    KAccountsManager accountManager;
+    OfflineStore store(OfflineStore::defaultDirectory());
+    BackgroundUploader uploader(&journal);
+    RequestScheduler::Scope scope(RequestScheduler::Background);
+    QDateTime nextAttempt;
+    const auto uploads = journal.uploads();
+    for (const auto &upload : uploads) {
+        const QDateTime readyAt = UploadJournal::readyAt(upload);
+        if (readyAt.isValid() && readyAt > QDateTime::currentDateTimeUtc()) {
+            if (!nextAttempt.isValid() || readyAt < nextAttempt) {
+                nextAttempt = readyAt;
+            }
+            continue;
+        }
+
+        const auto account = accountManager.account(accountOf(upload.path));
+        auto result = uploader.upload(upload, account);
+        if (result == BackgroundUploader::Failed && uploader.statusCode() == 401) {
+            // The access token expired.
+            result = uploader.upload(upload, accountManager.refreshAccount(account));
+        }
+        if (result == BackgroundUploader::Busy) {
+            // The worker is sending it.
+            continue;
+        }
+
+        if (result == BackgroundUploader::Failed) {
+            UploadJournal::Upload failed;
+            if (journal.upload(upload.path, &failed) && (!nextAttempt.isValid() || failed.nextAttempt < nextAttempt)) {
+                nextAttempt = failed.nextAttempt;
+            }
+            if (uploader.statusCode() == 0 && !connectivity.reportFailure()) {
+                nextAttempt = QDateTime::currentDateTimeUtc().addMSecs(OfflineRetryDelay);
+                break;
+            }
+            continue;
+        }
+
+        store.invalidate(upload.path);
+        if (result == BackgroundUploader::Conflict) {
+            out << "conflict\t" << upload.path << '\t' << uploader.conflictPath() << '\n';
+            out.flush();
+        }
+    }
+
+    if (nextAttempt.isValid()) {
+        out << "next\t" << qMax<qint64>(0, QDateTime::currentDateTimeUtc().msecsTo(nextAttempt)) << '\n';
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName(QStringLiteral("kio_onedrive_syncagent"));
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption(QStringLiteral("clear"), QStringLiteral("Forget a folder that is no longer hot."), QStringLiteral("path")));
+    parser.addPositionalArgument(QStringLiteral("command"), QStringLiteral("sync or upload"));
+    parser.addPositionalArgument(QStringLiteral("paths"), QStringLiteral("The hot folders to sync, account included."), QStringLiteral("[path...]"));
+    parser.process(app);
+
+    QStringList arguments = parser.positionalArguments();
+    const QString command = arguments.isEmpty() ? QString() : arguments.takeFirst();
+    if (command == QLatin1String("sync")) {
+        return sync(arguments, parser.values(QStringLiteral("clear")));
+    }
+    if (command == QLatin1String("upload") && arguments.isEmpty()) {
+        QTextStream out(stdout);
+        return upload(out);
+    }
+
+    parser.showHelp(1);
+}
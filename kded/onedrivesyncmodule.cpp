@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "onedrivesyncmodule.h"
+#include "onedrivedebug.h"
+#include "../src/uploadjournal.h"
+
+#include <KConfigGroup>
+#include <KLocalizedString>
+#include <KNotification>
+#include <KPluginFactory>
+#include <KSharedConfig>
+
+#include <QDir>
+#include <QUrl>
+
+K_PLUGIN_FACTORY_WITH_JSON(OneDriveSyncModuleFactory, "onedrivesync.json", registerPlugin<OneDriveSyncModule>();)
+
+static const char ConfigName[] = "onedrivesyncrc";
+// Uploads wait for the journal to settle, e.g. for the end of a safe save.
+static const int UploadDelay = 2000;
+static const int CrashRetryDelay = 60000;
+static const int ShutdownTimeout = 1000;
+
+static QString accountOf(const QString &path)
+{
+    return path.section(QLatin1Char('/'), 1, 1);
+}
+
+OneDriveSyncModule::OneDriveSyncModule(QObject *parent, const QVariantList &args)
+    : KDEDModule(parent)
+    , m_journal(new UploadJournal(UploadJournal::defaultDirectory()))
+{
+    Q_UNUSED(args)
+
+    m_syncAgent.setProcessChannelMode(QProcess::ForwardedChannels);
+    connect(&m_syncAgent, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished), this, [this]() {
+        // Folders removed during the sync are cleared right away.
+        if (!m_removedPaths.isEmpty()) {
+            sync();
+        }
+    });
+    connect(&m_syncAgent, &QProcess::errorOccurred, this, [this]() {
+        qCWarning(ONEDRIVE) << "Cannot run the sync agent:" << m_syncAgent.errorString();
+    });
+    connect(&m_timer, &QTimer::timeout, this, &OneDriveSyncModule::sync);
+    loadConfig();
+    syncNow();
+
+    // The worker only writes to the journal, this is how uploads are noticed.
+    QDir().mkpath(m_journal->directory());
+    m_journalWatcher.addPath(m_journal->directory());
+    connect(&m_journalWatcher, &QFileSystemWatcher::directoryChanged, this, [this]() {
+        scheduleUploads(UploadDelay);
+    });
+    m_uploadAgent.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    connect(&m_uploadAgent, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+            this, &OneDriveSyncModule::uploaded);
+    connect(&m_uploadAgent, &QProcess::errorOccurred, this, [this]() {
+        qCWarning(ONEDRIVE) << "Cannot run the upload agent:" << m_uploadAgent.errorString();
+    });
+    m_uploadTimer.setSingleShot(true);
+    connect(&m_uploadTimer, &QTimer::timeout, this, &OneDriveSyncModule::upload);
+    scheduleUploads(0);
+}
+
+OneDriveSyncModule::~OneDriveSyncModule()
+{
+    // The agents save their state as they go, and resume where they stopped.
+    for (auto agent : {&m_syncAgent, &m_uploadAgent}) {
+        if (agent->state() != QProcess::NotRunning) {
+            agent->terminate();
+            agent->waitForFinished(ShutdownTimeout);
+        }
+    }
+}
+
+void OneDriveSyncModule::loadConfig()
+{
+    const KConfigGroup group(KSharedConfig::openConfig(QString::fromLatin1(ConfigName)), "General");
+    m_folders = group.readEntry("Folders", QStringList());
+    m_timer.setInterval(qMax(10, group.readEntry("Interval", 60)) * 1000);
+    updateSyncs();
+}
+
+void OneDriveSyncModule::saveConfig() const
+{
+    KConfigGroup group(KSharedConfig::openConfig(QString::fromLatin1(ConfigName)), "General");
+    group.writeEntry("Folders", m_folders);
+    group.sync();
+}
+
+QStringList OneDriveSyncModule::folders() const
+{
+    return m_folders;
+}
+
+void OneDriveSyncModule::addFolder(const QString &url)
+{
+    const QString folder = QUrl(url).adjusted(QUrl::StripTrailingSlash).toString();
+    if (m_folders.contains(folder)) {
+        return;
+    }
+
+    m_folders << folder;
+    saveConfig();
+    updateSyncs();
+    syncNow();
+}
+
+void OneDriveSyncModule::removeFolder(const QString &url)
+{
+    const QString folder = QUrl(url).adjusted(QUrl::StripTrailingSlash).toString();
+    if (!m_folders.removeOne(folder)) {
+        return;
+    }
+
+    saveConfig();
+    updateSyncs();
+    syncNow();
+}
+
+void OneDriveSyncModule::syncNow()
+{
+    // The caller of the D-Bus method does not wait for the sync.
+    QTimer::singleShot(0, this, &OneDriveSyncModule::sync);
+}
+
+void OneDriveSyncModule::updateSyncs()
+{
+    QStringList paths;
+    for (const auto &folder : qAsConst(m_folders)) {
+        const QUrl url(folder);
+        if (url.scheme() != QLatin1String("onedrive") || accountOf(url.path()).isEmpty()) {
+            qCWarning(ONEDRIVE) << "Ignoring the hot folder" << folder;
+            continue;
+        }
+        paths << url.path();
+        m_removedPaths.removeAll(url.path());
+    }
+
+    // Whatever is left is no longer a hot folder.
+    for (const auto &path : qAsConst(m_paths)) {
+        if (!paths.contains(path) && !m_removedPaths.contains(path)) {
+            m_removedPaths << path;
+        }
+    }
+    m_paths = paths;
+
+    if (m_paths.isEmpty()) {
+        m_timer.stop();
+    } else if (!m_timer.isActive()) {
+        m_timer.start();
+    }
+}
+
+void OneDriveSyncModule::sync()
+{
+    // The running agent is not interrupted, the next one gets the changes.
+    if (m_syncAgent.state() != QProcess::NotRunning) {
+        return;
+    }
+    if (m_paths.isEmpty() && m_removedPaths.isEmpty()) {
+        return;
+    }
+
+    QStringList arguments({QStringLiteral("sync")});
+    for (const auto &path : qAsConst(m_removedPaths)) {
+        arguments << QStringLiteral("--clear") << path;
+    }
+    arguments << QStringLiteral("--") << m_paths;
+    m_removedPaths.clear();
+    m_syncAgent.start(QStringLiteral(ONEDRIVE_SYNC_AGENT), arguments);
+}
+
+void OneDriveSyncModule::scheduleUploads(int delay)
+{
+    if (!m_uploadTimer.isActive() || m_uploadTimer.remainingTime() > delay) {
+        m_uploadTimer.start(delay);
+    }
+}
+
+void OneDriveSyncModule::upload()
+{
+    if (m_uploadAgent.state() != QProcess::NotRunning) {
+        scheduleUploads(UploadDelay);
+        return;
+    }
+    if (m_journal->isEmpty()) {
+        return;
+    }
+
+    m_uploadAgent.start(QStringLiteral(ONEDRIVE_SYNC_AGENT), {QStringLiteral("upload")});
+}
+
+void OneDriveSyncModule::uploaded()
+{
+    if (m_uploadAgent.exitStatus() != QProcess::NormalExit) {
+        qCWarning(ONEDRIVE) << "The upload agent crashed";
+        scheduleUploads(CrashRetryDelay);
+        return;
+    }
+
+    const auto lines = QString::fromUtf8(m_uploadAgent.readAllStandardOutput()).split(QLatin1Char('\n'), QString::SkipEmptyParts);
+    for (const auto &line : lines) {
+        const QStringList fields = line.split(QLatin1Char('\t'));
+        if (fields.at(0) == QLatin1String("next") && fields.size() == 2) {
+            scheduleUploads(fields.at(1).toInt());
+        } else if (fields.at(0) == QLatin1String("conflict") && fields.size() == 3) {
+            auto notification = new KNotification(QStringLiteral("upload-conflict"));
+            notification->setComponentName(QStringLiteral("onedrive"));
+            notification->setTitle(i18n("Upload Conflict"));
+            notification->setText(xi18nc("@info", "<filename>%1</filename> was changed on the server before your version could be uploaded. Your version was saved as <filename>%2</filename>.",
+                                         fields.at(1), fields.at(2)));
+            notification->sendEvent();
+        }
+    }
+}
+
+#include "onedrivesyncmodule.moc"
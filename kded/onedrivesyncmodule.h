@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#pragma once
+
+#include <KDEDModule>
+
+#include <QFileSystemWatcher>
+#include <QProcess>
+#include <QStringList>
+#include <QTimer>
+
+#include <memory>
+
+class UploadJournal;
+
+/**
+ * Keeps the hot folders of the user materialized in the offline store of the
+ * worker, which then answers for them without any request. See HotFolderSync.
+ *
+ * The folders and budgets are read from onedrivesyncrc:
+ *
+ *   [General]
+ *   Folders=onedrive:/foo@outlook.com/Documents,onedrive:/foo@outlook.com/Work
+ *   ContentBudget=2048 (MiB, shared by all the folders, in their order)
+ *   Bandwidth=1024 (KiB/s, 0 means unlimited)
+ *   Interval=60 (seconds between two syncs)
+ *
+ * Nothing runs while the list is empty, or while offline.
+ *
+ * It also sends the uploads queued by the worker in write-back mode, where
+ * put() returns as soon as the data is in the journal. See UploadJournal and
+ * BackgroundUploader. This is off by default:
+ *
+ *   [WriteBack]
+ *   Enabled=true
+ *
+ * Uploads already queued are sent even when write-back is turned off.
+ * Conflicts with changes made on the server are notified.
+ *
+ * Syncs and uploads block on the network for minutes, and are throttled, so
+ * they run in kio_onedrive_syncagent rather than in kded. The module only
+ * schedules them, one agent of each kind at a time.
+ */
+class OneDriveSyncModule : public KDEDModule
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.OneDriveSync")
+
+public:
+    OneDriveSyncModule(QObject *parent, const QVariantList &args);
+    ~OneDriveSyncModule() override;
+
+public Q_SLOTS:
+    Q_SCRIPTABLE QStringList folders() const;
+    Q_SCRIPTABLE void addFolder(const QString &url);
+    Q_SCRIPTABLE void removeFolder(const QString &url);
+    Q_SCRIPTABLE void syncNow();
+
+private:
+    void loadConfig();
+    void saveConfig() const;
+    void updateSyncs();
+    void sync();
+    void scheduleUploads(int delay);
+    void upload();
+    void uploaded();
+
+    QStringList m_folders;
+    // The paths of the hot folders, and of the ones to clear on the next sync.
+    QStringList m_paths;
+    QStringList m_removedPaths;
+    QTimer m_timer;
+    QProcess m_syncAgent;
+
+    std::unique_ptr<UploadJournal> m_journal;
+    QFileSystemWatcher m_journalWatcher;
+    QTimer m_uploadTimer;
+    QProcess m_uploadAgent;
+};
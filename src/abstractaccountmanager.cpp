@@ -21,3 +21,49 @@
 
 AbstractAccountManager::~AbstractAccountManager() {}
 
+KMGraph2::AccountPtr AbstractAccountManager::account(const QString &accountName)
+{
+    ensureAccountsLoaded();
+
+    const auto it = m_accountsByName.constFind(accountName);
+    if (it == m_accountsByName.constEnd()) {
+        return KMGraph2::AccountPtr(new KMGraph2::Account());
+    }
+
+    return *it;
+}
+
+QSet<QString> AbstractAccountManager::accounts()
+{
+    ensureAccountsLoaded();
+    return m_accountNames;
+}
+
+void AbstractAccountManager::insertAccount(const KMGraph2::AccountPtr &account)
+{
+    m_accountsByName.insert(account->accountName(), account);
+    m_accountNames.insert(account->accountName());
+}
+
+void AbstractAccountManager::invalidateAccounts()
+{
+    m_accountsLoaded = false;
+}
+
+void AbstractAccountManager::ensureAccountsLoaded()
+{
+    if (m_accountsLoaded) {
+        return;
+    }
+
+    m_accountsByName.clear();
+    m_accountNames.clear();
+    loadAccounts();
+    m_accountsLoaded = true;
+}
+
+
+void AbstractAccountManager::prepareAccounts(const QSet<QString> &accountNames)
+{
+    Q_UNUSED(accountNames)
+}
@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <QHash>
 #include <QSet>
 
 #include <KMGraph/Account>
@@ -32,9 +33,17 @@ public:
     /**
      * @return Pointer to the account for @p accountName.
      * The account is valid only if @p accountName is in accounts().
+     * The lookup is served from an index that is rebuilt only after invalidateAccounts().
      * @see accounts()
      */
-    virtual KMGraph2::AccountPtr account(const QString &accountName) = 0;
+    virtual KMGraph2::AccountPtr account(const QString &accountName);
+
+    /**
+     * Makes sure the accounts in @p accountNames are ready to be used.
+     * Backends that load the credentials lazily should fetch them all at once here.
+     * The default implementation does nothing.
+     */
+    virtual void prepareAccounts(const QSet<QString> &accountNames);
 
     /**
      * Creates a new account.
@@ -52,7 +61,35 @@ public:
 
     /**
      * @return The onedrive accounts managed by this object.
+     * The set is cached and rebuilt only after invalidateAccounts().
+     */
+    QSet<QString> accounts();
+
+protected:
+    /**
+     * Fills the account index through insertAccount().
+     * Called on first use and on the first use after invalidateAccounts().
+     */
+    virtual void loadAccounts() = 0;
+
+    /**
+     * Adds @p account to the index. Meant to be called from loadAccounts().
+     */
+    void insertAccount(const KMGraph2::AccountPtr &account);
+
+    /**
+     * Marks the index as stale, e.g. because the backend signaled a change.
      */
-    virtual QSet<QString> accounts() = 0;
+    void invalidateAccounts();
+
+    /**
+     * Reloads the index if it has been invalidated.
+     */
+    void ensureAccountsLoaded();
+
+private:
+    QHash<QString, KMGraph2::AccountPtr> m_accountsByName;
+    QSet<QString> m_accountNames;
+    bool m_accountsLoaded = false;
 };
 
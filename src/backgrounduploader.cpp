@@ -0,0 +1,247 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "backgrounduploader.h"
+#include "graphrequest.h"
+#include "onedrivedebug.h"
+#include "onedrivehelper.h"
+#include "requestscheduler.h"
+#include "uploadsession.h"
+
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonDocument>
+#include <QLockFile>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+
+const qint64 BackgroundUploader::SimpleUploadLimit;
+const qint64 BackgroundUploader::ChunkSize;
+
+// Failed uploads are retried after 30 seconds, then twice as late each time, up to an hour.
+static const int FirstRetryDelay = 30;
+static const int MaxRetryDelay = 3600;
+
+static QString graphPath(const QString &relativePath)
+{
+    return QStringLiteral("/root:/") + QString::fromLatin1(QUrl::toPercentEncoding(relativePath, "/"));
+}
+
+BackgroundUploader::BackgroundUploader(UploadJournal *journal)
+    : m_journal(journal)
+{
+}
+
+BackgroundUploader::~BackgroundUploader()
+{
+}
+
+int BackgroundUploader::statusCode() const
+{
+    return m_statusCode;
+}
+
+QString BackgroundUploader::errorString() const
+{
+    return m_errorString;
+}
+
+int BackgroundUploader::claimTimeout() const
+{
+    return m_claimTimeout;
+}
+
+void BackgroundUploader::setClaimTimeout(int msecs)
+{
+    m_claimTimeout = msecs;
+}
+
+QString BackgroundUploader::conflictPath() const
+{
+    return m_conflictPath;
+}
+
+QString BackgroundUploader::conflictName(const QString &name, const QDateTime &at)
+{
+    // The suffix goes before the extension, so that the type does not change.
+    const int dot = name.lastIndexOf(QLatin1Char('.'));
+    const int split = dot > 0 ? dot : name.size();
+    return QStringLiteral("%1 (conflict %2)%3").arg(name.left(split),
+                                                    at.toLocalTime().toString(QStringLiteral("yyyy-MM-dd hhmmss")),
+                                                    name.mid(split));
+}
+
+BackgroundUploader::Result BackgroundUploader::upload(const UploadJournal::Upload &queued, const KMGraph2::AccountPtr &account)
+{
+    m_account = account;
+    m_statusCode = 0;
+    m_errorString.clear();
+    m_conflictPath.clear();
+
+    // The path is relative to the root of the account.
+    QString relativePath = queued.path.section(QLatin1Char('/'), 2);
+    if (relativePath.isEmpty()) {
+        m_errorString = QStringLiteral("Cannot upload %1").arg(queued.path);
+        m_journal->remove(queued);
+        return Failed;
+    }
+
+    // Only the owner process is checked, a send takes as long as it takes.
+    QLockFile lock(m_journal->lockFile(queued.path));
+    lock.setStaleLockTime(0);
+    if (!lock.tryLock(m_claimTimeout)) {
+        m_errorString = QStringLiteral("%1 is being uploaded by another process").arg(queued.path);
+        return Busy;
+    }
+    // Whoever held the claim before may have committed it.
+    UploadJournal::Upload upload;
+    if (!m_journal->upload(queued.path, &upload)) {
+        return Committed;
+    }
+
+    bool failed = false;
+    const bool conflict = isInConflict(upload, relativePath, &failed);
+    if (failed) {
+        fail(upload);
+        return Failed;
+    }
+    if (conflict) {
+        const int slash = relativePath.lastIndexOf(QLatin1Char('/'));
+        relativePath = relativePath.left(slash + 1) + conflictName(relativePath.mid(slash + 1), upload.queuedAt);
+        m_conflictPath = upload.path.section(QLatin1Char('/'), 0, 1) + QLatin1Char('/') + relativePath;
+        qCWarning(ONEDRIVE) << upload.path << "changed on the server, uploading the local version as" << m_conflictPath;
+    }
+
+    if (!send(relativePath, m_journal->contentFile(upload), upload.size)) {
+        fail(upload);
+        return Failed;
+    }
+
+    qCDebug(ONEDRIVE) << "Uploaded" << upload.path << "queued at" << upload.queuedAt;
+    if (!upload.deletedTarget.isEmpty()) {
+        deleteTarget(upload.deletedTarget, m_account);
+    }
+    if (conflict) {
+        m_journal->remove(upload);
+        return Conflict;
+    }
+    m_journal->commit(upload, m_response.value(QStringLiteral("cTag")).toString());
+    return Committed;
+}
+
+bool BackgroundUploader::isInConflict(const UploadJournal::Upload &upload, const QString &relativePath, bool *failed)
+{
+    GraphRequest request(OneDriveHelper::networkAccessManager(), "GET", graphPath(relativePath));
+    request.setAccount(m_account);
+    if (!request.exec()) {
+        if (request.statusCode() == 404) {
+            // Nothing to conflict with, even if it was there when the
+            // upload was queued: the local version wins over a deletion.
+            return false;
+        }
+        m_statusCode = request.statusCode();
+        m_errorString = request.errorString();
+        *failed = true;
+        return false;
+    }
+
+    const QJsonObject item = request.response();
+    if (item.contains(QStringLiteral("folder"))) {
+        return true;
+    }
+    if (!upload.baseCTag.isEmpty()) {
+        return item.value(QStringLiteral("cTag")).toString() != upload.baseCTag;
+    }
+    // A new file, unless someone else created it after the put().
+    const QDateTime modified = QDateTime::fromString(item.value(QStringLiteral("lastModifiedDateTime")).toString(), Qt::ISODate);
+    return modified.isValid() && modified > upload.queuedAt;
+}
+
+void BackgroundUploader::deleteTarget(const QString &path, const KMGraph2::AccountPtr &account)
+{
+    // The content is committed already, a failure here is not worth uploading it again.
+    GraphRequest request(OneDriveHelper::networkAccessManager(), "DELETE", graphPath(path.section(QLatin1Char('/'), 2)));
+    request.setAccount(account);
+    if (!request.exec() && request.statusCode() != 404) {
+        qCWarning(ONEDRIVE) << "Cannot delete" << path << "replaced by a safe save:" << request.errorString();
+    }
+}
+
+bool BackgroundUploader::send(const QString &relativePath, const QString &fileName, qint64 size)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_errorString = file.errorString();
+        return false;
+    }
+    if (size > SimpleUploadLimit) {
+        return sendSession(relativePath, &file, size);
+    }
+
+    // Uploading by path replaces the content of an existing item, which
+    // keeps its ID, sharing and version history.
+    QNetworkRequest request = OneDriveHelper::graphRequest(m_account, graphPath(relativePath) + QStringLiteral(":/content"));
+    request.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/octet-stream"));
+    RequestScheduler::Ticket ticket;
+    return wait(OneDriveHelper::networkAccessManager()->put(request, file.readAll()));
+}
+
+bool BackgroundUploader::sendSession(const QString &relativePath, QIODevice *content, qint64 size)
+{
+    UploadSession session(m_account, graphPath(relativePath) + QLatin1Char(':'));
+    if (!session.exec(content, size)) {
+        m_statusCode = session.statusCode();
+        m_errorString = session.errorString();
+        return false;
+    }
+    m_response = session.item();
+    return true;
+}
+
+bool BackgroundUploader::wait(QNetworkReply *reply)
+{
+    QEventLoop eventLoop;
+    QObject::connect(reply, &QNetworkReply::finished, &eventLoop, &QEventLoop::quit);
+    eventLoop.exec();
+
+    const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const bool succeeded = statusCode >= 200 && statusCode < 300;
+    m_response = QJsonDocument::fromJson(reply->readAll()).object();
+    if (!succeeded) {
+        m_statusCode = statusCode;
+        m_errorString = m_response.value(QStringLiteral("error")).toObject().value(QStringLiteral("message")).toString();
+        if (m_errorString.isEmpty()) {
+            m_errorString = reply->errorString();
+        }
+    }
+    reply->deleteLater();
+    return succeeded;
+}
+
+void BackgroundUploader::fail(const UploadJournal::Upload &upload)
+{
+    qCWarning(ONEDRIVE) << "Cannot upload" << upload.path << ":" << m_errorString;
+
+    UploadJournal::Upload failed = upload;
+    ++failed.attempts;
+    const int delay = qMin(MaxRetryDelay, FirstRetryDelay << qMin(failed.attempts - 1, 16));
+    failed.nextAttempt = QDateTime::currentDateTimeUtc().addSecs(delay);
+    failed.lastError = m_errorString;
+    m_journal->update(failed);
+}
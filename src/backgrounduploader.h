@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#pragma once
+
+#include "uploadjournal.h"
+#include "uploadsession.h"
+
+#include <KMGraph/Account>
+
+#include <QJsonObject>
+
+class QIODevice;
+class QNetworkReply;
+
+/**
+ * Sends the uploads of an UploadJournal to the server, one at a time, and
+ * drops them from the journal once they are committed.
+ *
+ * Before sending, the item is looked up by path: if its cTag no longer is
+ * the one the upload was based on, or if a new file was created there by
+ * someone else meanwhile, the server version is kept and the local one is
+ * uploaded next to it, as "name (conflict date).ext". A failed upload stays
+ * in the journal, to be retried with an exponential backoff.
+ *
+ * An upload that stands for the partial file of an unfinished safe save is
+ * replayed as such: the file it was to replace is deleted after it.
+ */
+class BackgroundUploader
+{
+public:
+    enum Result {
+        Committed,
+        /** Committed under conflictPath(). */
+        Conflict,
+        Failed,
+        /** Being sent by another process, left to it. */
+        Busy
+    };
+
+    explicit BackgroundUploader(UploadJournal *journal);
+    ~BackgroundUploader();
+
+    /**
+     * Sends @p upload with @p account, blocking until done.
+     *
+     * The worker and the agent may both try to send the same upload, whoever
+     * claims it first sends it. The other one waits up to claimTimeout() for
+     * the claim, then sends whatever is still pending for the path: nothing
+     * if the upload was committed meanwhile, a newer put() if any.
+     */
+    Result upload(const UploadJournal::Upload &upload, const KMGraph2::AccountPtr &account);
+
+    /**
+     * How long upload() waits for another process to send the same upload,
+     * in milliseconds, -1 for ever. 0 by default, which returns Busy.
+     */
+    int claimTimeout() const;
+    void setClaimTimeout(int msecs);
+
+    /**
+     * @return The HTTP status of the request that failed the last upload, or 0.
+     */
+    int statusCode() const;
+    QString errorString() const;
+
+    /**
+     * @return The path the last upload was committed under, after a conflict.
+     */
+    QString conflictPath() const;
+
+    /**
+     * @return The name to give the local version of @p name, in conflict
+     * with the server version since @p at.
+     */
+    static QString conflictName(const QString &name, const QDateTime &at);
+
+    /**
+     * Deletes @p path with @p account, the file a safe save was to replace.
+     * Failures are only logged.
+     */
+    void deleteTarget(const QString &path, const KMGraph2::AccountPtr &account);
+
+    /** Larger contents go through an UploadSession. */
+    static const qint64 SimpleUploadLimit = UploadSession::SimpleUploadLimit;
+    static const qint64 ChunkSize = UploadSession::ChunkSize;
+
+private:
+    bool isInConflict(const UploadJournal::Upload &upload, const QString &relativePath, bool *failed);
+    bool send(const QString &relativePath, const QString &fileName, qint64 size);
+    bool sendSession(const QString &relativePath, QIODevice *content, qint64 size);
+    bool wait(QNetworkReply *reply);
+    void fail(const UploadJournal::Upload &upload);
+
+    UploadJournal *m_journal;
+    KMGraph2::AccountPtr m_account;
+    int m_claimTimeout = 0;
+    /** The item returned by the last successful request. */
+    QJsonObject m_response;
+    int m_statusCode = 0;
+    QString m_errorString;
+    QString m_conflictPath;
+};
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "connectivity.h"
+#include "onedrivedebug.h"
+#include "onedrivehelper.h"
+
+#include <QEventLoop>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QTimer>
+
+// Without any bearer plugin there are no configurations, and the state of
+// the system means nothing.
+Connectivity::Connectivity(int probeInterval, int probeTimeout)
+    : m_systemStateKnown(!m_manager.allConfigurations().isEmpty())
+    , m_forcedOffline(qEnvironmentVariableIsSet("ONEDRIVE_OFFLINE"))
+    , m_probeInterval(probeInterval)
+    , m_probeTimeout(probeTimeout)
+{
+}
+
+Connectivity::~Connectivity()
+{
+}
+
+bool Connectivity::isOnline()
+{
+    if (m_forcedOffline || (m_systemStateKnown && !m_manager.isOnline())) {
+        m_online = false;
+        return false;
+    }
+    if (m_online) {
+        return true;
+    }
+    if (m_lastProbe.isValid() && !m_lastProbe.hasExpired(m_probeInterval)) {
+        return false;
+    }
+
+    m_online = probe();
+    if (m_online) {
+        qCDebug(ONEDRIVE) << "Back online";
+    }
+    return m_online;
+}
+
+bool Connectivity::reportFailure()
+{
+    if (!m_online) {
+        return false;
+    }
+
+    m_online = probe();
+    if (!m_online) {
+        qCWarning(ONEDRIVE) << "Going offline, the Graph servers cannot be reached";
+    }
+    return m_online;
+}
+
+bool Connectivity::probe()
+{
+    m_lastProbe.start();
+
+    QNetworkRequest request(OneDriveHelper::graphUrl());
+    QNetworkReply *reply = OneDriveHelper::networkAccessManager()->head(request);
+    QEventLoop eventLoop;
+    QObject::connect(reply, &QNetworkReply::finished, &eventLoop, &QEventLoop::quit);
+    QTimer::singleShot(m_probeTimeout, &eventLoop, &QEventLoop::quit);
+    eventLoop.exec();
+
+    // Any HTTP answer, even an error, means the servers are reachable.
+    const bool reachable = reply->isFinished() && reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() > 0;
+    if (!reply->isFinished()) {
+        reply->abort();
+    }
+    reply->deleteLater();
+    return reachable;
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef CONNECTIVITY_H
+#define CONNECTIVITY_H
+
+#include <QElapsedTimer>
+#include <QNetworkConfigurationManager>
+
+/**
+ * Tracks whether the Graph servers can be reached.
+ *
+ * The network state of the system is checked on every call, which costs
+ * nothing. Failures it does not see (a dead VPN, a captive portal) are
+ * reported by the callers when a request got no answer at all, and
+ * confirmed with a probe: an unauthenticated HEAD request to the Graph root,
+ * with a short timeout. While offline, the probe is repeated at most once
+ * per interval, which is how reconnection is noticed.
+ *
+ * Setting ONEDRIVE_OFFLINE forces the offline state.
+ */
+class Connectivity
+{
+public:
+    explicit Connectivity(int probeInterval = 15000, int probeTimeout = 3000);
+    ~Connectivity();
+
+    bool isOnline();
+
+    /**
+     * To be called when a request failed without any answer from the server.
+     * @return Whether the servers can still be reached.
+     */
+    bool reportFailure();
+
+private:
+    bool probe();
+
+    QNetworkConfigurationManager m_manager;
+    bool m_systemStateKnown;
+    bool m_forcedOffline;
+    bool m_online = true;
+    int m_probeInterval;
+    int m_probeTimeout;
+    QElapsedTimer m_lastProbe;
+};
+
+#endif // CONNECTIVITY_H
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "credentialsstore.h"
+
+#include <KJob>
+
+#include <QEventLoop>
+#include <QUrl>
+
+using namespace KMGraph2;
+
+CredentialsStore::~CredentialsStore()
+{}
+
+void CredentialsStore::addAccount(quint32 id, const AccountPtr &account)
+{
+    m_accounts.insert(id, account);
+    m_loaded.remove(id);
+}
+
+void CredentialsStore::clear()
+{
+    m_accounts.clear();
+    m_loaded.clear();
+}
+
+bool CredentialsStore::isLoaded(quint32 id) const
+{
+    return m_loaded.contains(id);
+}
+
+void CredentialsStore::load(const QList<quint32> &ids)
+{
+    QHash<KJob*, quint32> pendingJobs;
+    const auto uniqueIds = ids.toSet();
+    for (const auto id : uniqueIds) {
+        if (isLoaded(id) || !m_accounts.contains(id)) {
+            continue;
+        }
+        pendingJobs.insert(createJob(id), id);
+    }
+
+    if (pendingJobs.isEmpty()) {
+        return;
+    }
+
+    QEventLoop eventLoop;
+    int running = pendingJobs.size();
+    for (auto it = pendingJobs.constBegin(); it != pendingJobs.constEnd(); ++it) {
+        KJob *job = it.key();
+        const quint32 id = it.value();
+        QObject::connect(job, &KJob::result, &eventLoop, [&, job, id]() {
+            if (!job->error()) {
+                const auto data = credentialsData(job);
+                const auto account = m_accounts.value(id);
+                account->setAccessToken(data.value(QStringLiteral("AccessToken")).toString());
+                account->setRefreshToken(data.value(QStringLiteral("RefreshToken")).toString());
+
+                const auto scopes = data.value(QStringLiteral("Scope")).toStringList();
+                for (const auto &scope : scopes) {
+                    account->addScope(QUrl::fromUserInput(scope));
+                }
+                m_loaded.insert(id);
+            }
+
+            if (--running == 0) {
+                eventLoop.quit();
+            }
+        });
+        job->start();
+    }
+
+    // Jobs may finish synchronously while being started.
+    if (running > 0) {
+        eventLoop.exec();
+    }
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QSet>
+#include <QVariantMap>
+
+#include <KMGraph/Account>
+
+class KJob;
+
+/**
+ * Fills the tokens of registered accounts on demand.
+ *
+ * Accounts are registered without credentials, which keeps the worker startup
+ * cheap. The credentials are fetched the first time an account is needed;
+ * when several accounts are needed together, their jobs run concurrently.
+ */
+class CredentialsStore
+{
+public:
+    virtual ~CredentialsStore();
+
+    /**
+     * Registers @p account (still without tokens) under @p id.
+     */
+    void addAccount(quint32 id, const KMGraph2::AccountPtr &account);
+
+    /**
+     * Forgets all the registered accounts and their credentials.
+     */
+    void clear();
+
+    /**
+     * @return Whether the credentials of @p id have already been fetched.
+     */
+    bool isLoaded(quint32 id) const;
+
+    /**
+     * Fetches the credentials of the accounts in @p ids that are not loaded yet.
+     * All the jobs are started at once; this method blocks until the last one finishes.
+     */
+    void load(const QList<quint32> &ids);
+
+protected:
+    /**
+     * @return A new, not yet started, job fetching the credentials of @p id.
+     */
+    virtual KJob *createJob(quint32 id) = 0;
+
+    /**
+     * @return The credentials fetched by @p job, after it has finished.
+     */
+    virtual QVariantMap credentialsData(KJob *job) const = 0;
+
+private:
+    QHash<quint32, KMGraph2::AccountPtr> m_accounts;
+    QSet<quint32> m_loaded;
+};
@@ -0,0 +1,260 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "crossaccounttransfer.h"
+#include "onedrivedebug.h"
+#include "onedrivehelper.h"
+
+#include <QEventLoop>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTimer>
+
+// Upload session chunks must be a multiple of 320 KiB.
+static const qint64 ChunkSize = 10 * 320 * 1024;
+
+CrossAccountTransfer::CrossAccountTransfer(const QUrl &downloadUrl,
+                                           qint64 size,
+                                           const KMGraph2::AccountPtr &destAccount,
+                                           const QString &destParentId,
+                                           const QString &destName,
+                                           bool overwrite,
+                                           QObject *parent)
+    : QObject(parent)
+    , m_network(OneDriveHelper::networkAccessManager())
+    , m_downloadUrl(downloadUrl)
+    , m_size(size)
+    , m_destAccount(destAccount)
+    , m_destParentId(destParentId)
+    , m_destName(destName)
+    , m_overwrite(overwrite)
+    , m_priority(RequestScheduler::priority())
+{
+}
+
+CrossAccountTransfer::~CrossAccountTransfer()
+{
+    delete m_downloadReply;
+    delete m_uploadReply;
+}
+
+CrossAccountTransfer::Error CrossAccountTransfer::error() const
+{
+    return m_error;
+}
+
+QString CrossAccountTransfer::errorString() const
+{
+    return m_errorString;
+}
+
+QString CrossAccountTransfer::createdId() const
+{
+    return m_createdId;
+}
+
+bool CrossAccountTransfer::exec()
+{
+    if (m_size < 0) {
+        fail(TransferError, QStringLiteral("The size of the source file is unknown"));
+        return false;
+    }
+
+    RequestScheduler::Ticket ticket;
+
+    if (m_size == 0) {
+        // Upload sessions cannot be empty, create the file with a simple upload.
+        const auto request = apiRequest(QStringLiteral(":/content"));
+        m_uploadReply = m_network->put(request, QByteArray());
+        connect(m_uploadReply, &QNetworkReply::finished, this, [this]() {
+            uploadFinished(m_uploadReply);
+        });
+    } else {
+        createSession();
+    }
+
+    QEventLoop eventLoop;
+    while (!m_done) {
+        eventLoop.processEvents(QEventLoop::WaitForMoreEvents);
+    }
+
+    return m_error == NoError;
+}
+
+QNetworkRequest CrossAccountTransfer::apiRequest(const QString &suffix) const
+{
+    // A '#' or '?' in the name would otherwise start a fragment or a query.
+    const QString name = QString::fromLatin1(QUrl::toPercentEncoding(m_destName));
+    auto request = OneDriveHelper::graphRequest(m_destAccount,
+                                                QStringLiteral("/items/%1:/%2").arg(m_destParentId, name) + suffix);
+    QUrl url = request.url();
+    url.setQuery(QStringLiteral("@microsoft.graph.conflictBehavior=%1")
+                 .arg(m_overwrite ? QStringLiteral("replace") : QStringLiteral("fail")));
+    request.setUrl(url);
+    return request;
+}
+
+void CrossAccountTransfer::createSession()
+{
+    QJsonObject item;
+    item.insert(QStringLiteral("@microsoft.graph.conflictBehavior"),
+                m_overwrite ? QStringLiteral("replace") : QStringLiteral("fail"));
+    QJsonObject body;
+    body.insert(QStringLiteral("item"), item);
+
+    auto reply = m_network->post(apiRequest(QStringLiteral(":/createUploadSession")),
+                                 QJsonDocument(body).toJson(QJsonDocument::Compact));
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        reply->deleteLater();
+        const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (status == 401) {
+            fail(AuthError, reply->errorString());
+            return;
+        }
+        if (status == 409) {
+            fail(AlreadyExists, reply->errorString());
+            return;
+        }
+        if (reply->error() != QNetworkReply::NoError) {
+            fail(TransferError, reply->errorString());
+            return;
+        }
+
+        const auto session = QJsonDocument::fromJson(reply->readAll()).object();
+        m_uploadUrl = QUrl(session.value(QStringLiteral("uploadUrl")).toString());
+        if (!m_uploadUrl.isValid()) {
+            fail(TransferError, QStringLiteral("Invalid upload session"));
+            return;
+        }
+
+        startDownload();
+    });
+}
+
+void CrossAccountTransfer::startDownload()
+{
+    QNetworkRequest request(m_downloadUrl);
+    request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+    m_downloadReply = m_network->get(request);
+    m_downloadReply->setReadBufferSize(ChunkSize);
+
+    connect(m_downloadReply, &QNetworkReply::readyRead, this, &CrossAccountTransfer::readDownload);
+    connect(m_downloadReply, &QNetworkReply::finished, this, [this]() {
+        if (m_downloadReply->error() != QNetworkReply::NoError) {
+            fail(TransferError, m_downloadReply->errorString());
+            return;
+        }
+        m_downloadFinished = true;
+        readDownload();
+    });
+}
+
+void CrossAccountTransfer::readDownload()
+{
+    // Don't read while a chunk is in flight: this is our only buffer.
+    if (m_done || m_uploadReply || m_paused) {
+        return;
+    }
+
+    const qint64 wanted = qMin(ChunkSize, m_size - m_uploaded) - m_chunk.size();
+    if (wanted > 0) {
+        m_chunk.append(m_downloadReply->read(wanted));
+    }
+
+    const bool chunkComplete = m_chunk.size() == qMin(ChunkSize, m_size - m_uploaded);
+    if (chunkComplete) {
+        uploadChunk();
+    } else if (m_downloadFinished && m_downloadReply->bytesAvailable() == 0) {
+        fail(TransferError, QStringLiteral("Download of %1 ended prematurely").arg(m_downloadUrl.toDisplayString()));
+    }
+}
+
+void CrossAccountTransfer::uploadChunk()
+{
+    const qint64 first = m_uploaded;
+    const qint64 last = m_uploaded + m_chunk.size() - 1;
+
+    // The upload URL is pre-authenticated, so no Authorization header here.
+    QNetworkRequest request(m_uploadUrl);
+    request.setRawHeader("Content-Range", QStringLiteral("bytes %1-%2/%3").arg(first).arg(last).arg(m_size).toLatin1());
+    request.setHeader(QNetworkRequest::ContentLengthHeader, m_chunk.size());
+
+    m_uploadReply = m_network->put(request, m_chunk);
+    m_chunkTimer.start();
+    connect(m_uploadReply, &QNetworkReply::finished, this, [this]() {
+        uploadFinished(m_uploadReply);
+    });
+}
+
+void CrossAccountTransfer::uploadFinished(QNetworkReply *reply)
+{
+    m_uploadReply = nullptr;
+    reply->deleteLater();
+
+    // Only the simple upload of an empty file carries the token.
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 401) {
+        fail(AuthError, reply->errorString());
+        return;
+    }
+    if (reply->error() != QNetworkReply::NoError) {
+        fail(TransferError, reply->errorString());
+        return;
+    }
+
+    m_uploaded += m_chunk.size();
+    m_chunk.clear();
+    emit processed(m_uploaded);
+
+    if (status == 200 || status == 201) {
+        // The last chunk returns the new item.
+        const auto item = QJsonDocument::fromJson(reply->readAll()).object();
+        m_createdId = item.value(QStringLiteral("id")).toString();
+        m_done = true;
+        return;
+    }
+
+    // Higher priority requests get their share between two chunks.
+    m_paused = true;
+    QTimer::singleShot(RequestScheduler::holdOff(m_priority, m_chunkTimer.elapsed()), this, [this]() {
+        m_paused = false;
+        readDownload();
+    });
+}
+
+void CrossAccountTransfer::fail(Error error, const QString &errorString)
+{
+    if (m_done) {
+        return;
+    }
+
+    qCWarning(ONEDRIVE) << "Cross-account transfer to" << m_destName << "failed:" << errorString;
+    m_error = error;
+    m_errorString = errorString;
+    m_done = true;
+
+    if (m_downloadReply && m_downloadReply->isRunning()) {
+        m_downloadReply->abort();
+    }
+    if (m_uploadReply && m_uploadReply->isRunning()) {
+        m_uploadReply->abort();
+    }
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#pragma once
+
+#include "requestscheduler.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QUrl>
+
+#include <KMGraph/Account>
+
+class QNetworkReply;
+
+/**
+ * Copies a file from one account to another without temporary files.
+ *
+ * The content is downloaded from @p downloadUrl and piped, chunk by chunk, into
+ * an upload session on the destination account. At most one chunk is held in
+ * memory: while a chunk is being uploaded the download is not read, which
+ * throttles it through the bounded read buffer of its reply.
+ */
+class CrossAccountTransfer : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Error {
+        NoError,
+        AlreadyExists,
+        /** The token was refused, before anything was streamed. */
+        AuthError,
+        TransferError
+    };
+
+    CrossAccountTransfer(const QUrl &downloadUrl,
+                         qint64 size,
+                         const KMGraph2::AccountPtr &destAccount,
+                         const QString &destParentId,
+                         const QString &destName,
+                         bool overwrite,
+                         QObject *parent = nullptr);
+    ~CrossAccountTransfer();
+
+    /**
+     * Runs the transfer and blocks until it is complete or failed.
+     * @return Whether the transfer succeeded.
+     */
+    bool exec();
+
+    Error error() const;
+    QString errorString() const;
+
+    /**
+     * @return The id of the new item on the destination account.
+     */
+    QString createdId() const;
+
+Q_SIGNALS:
+    void processed(qint64 bytes);
+
+private:
+    QNetworkRequest apiRequest(const QString &suffix) const;
+    void createSession();
+    void startDownload();
+    void readDownload();
+    void uploadChunk();
+    void uploadFinished(QNetworkReply *reply);
+    void fail(Error error, const QString &errorString);
+
+    QNetworkAccessManager *m_network;
+    QUrl m_downloadUrl;
+    qint64 m_size;
+    KMGraph2::AccountPtr m_destAccount;
+    QString m_destParentId;
+    QString m_destName;
+    bool m_overwrite;
+    RequestScheduler::Priority m_priority;
+
+    QUrl m_uploadUrl;
+    QNetworkReply *m_downloadReply = nullptr;
+    QNetworkReply *m_uploadReply = nullptr;
+    QByteArray m_chunk;
+    qint64 m_uploaded = 0;
+    bool m_downloadFinished = false;
+    bool m_paused = false;
+    QElapsedTimer m_chunkTimer;
+    bool m_done = false;
+
+    Error m_error = NoError;
+    QString m_errorString;
+    QString m_createdId;
+};
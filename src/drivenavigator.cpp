@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "drivenavigator.h"
+#include "onedrivehelper.h"
+
+#include <QJsonArray>
+#include <QUrl>
+
+DriveNavigator::DriveNavigator(const KMGraph2::AccountPtr &account, const GraphRunner &runner)
+    : m_account(account)
+    , m_runner(runner)
+{
+}
+
+bool DriveNavigator::run(GraphRequest &request)
+{
+    if (m_runner) {
+        return m_runner(request);
+    }
+
+    request.setAccount(m_account);
+    return request.exec();
+}
+
+bool DriveNavigator::child(const QString &parentId, const QString &name, ItemKind kind, QJsonObject *item)
+{
+    // Path-based addressing finds the child in one request, whatever the
+    // size of the folder.
+    const QString encodedName = QString::fromLatin1(QUrl::toPercentEncoding(name));
+    GraphRequest request(OneDriveHelper::networkAccessManager(), "GET",
+                         QStringLiteral("/items/%1:/%2:").arg(parentId, encodedName));
+    request.setNotFoundAccepted(true);
+    if (!run(request)) {
+        return false;
+    }
+
+    *item = QJsonObject();
+    if (request.statusCode() == 404) {
+        return true;
+    }
+
+    const QJsonObject found = request.response();
+    const bool isFolder = found.contains(QStringLiteral("folder"));
+    if ((kind == FolderItem && !isFolder) || (kind == FileItem && isFolder)) {
+        return true;
+    }
+    *item = found;
+    return true;
+}
+
+bool DriveNavigator::item(const QString &id, QJsonObject *item)
+{
+    GraphRequest request(OneDriveHelper::networkAccessManager(), "GET", QStringLiteral("/items/%1").arg(id));
+    if (!run(request)) {
+        return false;
+    }
+
+    *item = request.response();
+    return true;
+}
+
+bool DriveNavigator::children(const QString &folderId, const std::function<void(const QJsonObject &item)> &visit)
+{
+    QUrl next;
+    do {
+        GraphRequest request(OneDriveHelper::networkAccessManager(), "GET", QStringLiteral("/items/%1/children").arg(folderId));
+        if (next.isValid()) {
+            request.setUrl(next);
+        }
+        if (!run(request)) {
+            return false;
+        }
+
+        const QJsonObject response = request.response();
+        const auto values = response.value(QStringLiteral("value")).toArray();
+        for (const auto &value : values) {
+            visit(value.toObject());
+        }
+
+        next = QUrl(response.value(QStringLiteral("@odata.nextLink")).toString());
+    } while (next.isValid());
+
+    return true;
+}
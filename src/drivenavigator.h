@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#pragma once
+
+#include "graphrequest.h"
+
+#include <QJsonObject>
+#include <QString>
+
+/**
+ * The Graph requests behind looking up, listing and stat'ing items, shared
+ * by the worker and fixtureregressiontest, so that the test replays the very
+ * sequences the worker sends.
+ *
+ * Requests go through a runner, which the worker uses to refresh tokens, wait
+ * out throttling and report errors. By default they are sent once.
+ */
+class DriveNavigator
+{
+public:
+    enum ItemKind {
+        AnyItem,
+        FolderItem,
+        FileItem
+    };
+
+    explicit DriveNavigator(const KMGraph2::AccountPtr &account, const GraphRunner &runner = GraphRunner());
+
+    /**
+     * Looks up the child @p name of the folder @p parentId.
+     * @return Whether the lookup went through. @p item is left empty when
+     * there is no such child, or when it is not of @p kind.
+     */
+    bool child(const QString &parentId, const QString &name, ItemKind kind, QJsonObject *item);
+
+    bool item(const QString &id, QJsonObject *item);
+
+    /**
+     * Lists the folder @p folderId, a page at a time, and calls @p visit for
+     * each of its children.
+     */
+    bool children(const QString &folderId, const std::function<void(const QJsonObject &item)> &visit);
+
+private:
+    bool run(GraphRequest &request);
+
+    KMGraph2::AccountPtr m_account;
+    GraphRunner m_runner;
+};
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "filedownloader.h"
+#include "onedrivedebug.h"
+#include "onedrivehelper.h"
+
+#include <QEventLoop>
+#include <QFile>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QTimer>
+
+// Per-connection read buffer, this is what bounds the memory usage.
+static const qint64 ReadBufferSize = 1024 * 1024;
+// Below this size a single connection is as fast as several ones.
+static const qint64 ParallelThreshold = 64 * 1024 * 1024;
+static const int MaxConnections = 4;
+// Scheduled downloads yield at most this far apart on each connection.
+static const qint64 RangeSize = 8 * 1024 * 1024;
+static const int PollInterval = 50;
+
+FileDownloader::FileDownloader(const QUrl &url, QFile *file, qint64 offset, qint64 size, QObject *parent)
+    : QObject(parent)
+    , m_network(OneDriveHelper::networkAccessManager())
+    , m_url(url)
+    , m_file(file)
+    , m_offset(offset)
+    , m_size(size)
+    , m_priority(RequestScheduler::priority())
+{
+    const qint64 remaining = size - offset;
+    if (size < 0 || remaining < ParallelThreshold) {
+        m_segments.append({offset, size, nullptr});
+        return;
+    }
+
+    const qint64 segmentSize = remaining / MaxConnections;
+    for (int i = 0; i < MaxConnections; ++i) {
+        const qint64 position = offset + i * segmentSize;
+        const qint64 end = (i == MaxConnections - 1) ? size : position + segmentSize;
+        m_segments.append({position, end, nullptr});
+    }
+}
+
+FileDownloader::~FileDownloader()
+{
+    for (const auto &segment : qAsConst(m_segments)) {
+        delete segment.reply;
+    }
+}
+
+bool FileDownloader::isParallel() const
+{
+    return m_segments.size() > 1;
+}
+
+QString FileDownloader::errorString() const
+{
+    return m_errorString;
+}
+
+int FileDownloader::statusCode() const
+{
+    return m_statusCode;
+}
+
+bool FileDownloader::exec()
+{
+    RequestScheduler::Ticket ticket;
+    m_written = m_offset;
+    for (int i = 0; i < m_segments.size(); ++i) {
+        startSegment(i);
+    }
+
+    QEventLoop eventLoop;
+    while (m_running > 0) {
+        eventLoop.processEvents(QEventLoop::WaitForMoreEvents);
+    }
+
+    return m_errorString.isEmpty();
+}
+
+void FileDownloader::startSegment(int index)
+{
+    // Counts the segment until it is complete, paused ones included.
+    ++m_running;
+    requestRange(index);
+}
+
+void FileDownloader::requestRange(int index)
+{
+    Segment &segment = m_segments[index];
+    if (!m_errorString.isEmpty()) {
+        --m_running;
+        return;
+    }
+
+    QNetworkRequest request(m_url);
+    request.setAttribute(QNetworkRequest::FollowRedirectsAttribute, true);
+    // Scheduled downloads go in bounded ranges, so that they can yield between two.
+    qint64 rangeEnd = segment.end;
+    if (m_priority != RequestScheduler::Interactive && segment.end >= 0) {
+        rangeEnd = qMin(segment.end, segment.position + RangeSize);
+    }
+    const bool ranged = segment.position > 0 || isParallel() || rangeEnd != segment.end;
+    if (ranged) {
+        // The end of an HTTP byte range is inclusive.
+        const QString range = rangeEnd < 0 ? QStringLiteral("bytes=%1-").arg(segment.position)
+                                           : QStringLiteral("bytes=%1-%2").arg(segment.position).arg(rangeEnd - 1);
+        request.setRawHeader("Range", range.toLatin1());
+    }
+
+    if (segment.reply) {
+        segment.reply->deleteLater();
+    }
+    segment.reply = m_network->get(request);
+    segment.reply->setReadBufferSize(ReadBufferSize);
+    segment.timer.start();
+
+    connect(segment.reply, &QNetworkReply::readyRead, this, [this, index]() {
+        writeSegmentData(index);
+    });
+    connect(segment.reply, &QNetworkReply::finished, this, [this, index, ranged, rangeEnd]() {
+        Segment &segment = m_segments[index];
+
+        if (segment.reply->error() != QNetworkReply::NoError) {
+            --m_running;
+            if (m_errorString.isEmpty()) {
+                m_statusCode = segment.reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+            }
+            fail(segment.reply->errorString());
+            return;
+        }
+
+        const int status = segment.reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (ranged && status != 206) {
+            --m_running;
+            fail(QStringLiteral("Server does not support ranged downloads (HTTP %1)").arg(status));
+            return;
+        }
+
+        writeSegmentData(index);
+        if (segment.position == rangeEnd && rangeEnd != segment.end && m_errorString.isEmpty()) {
+            QTimer::singleShot(RequestScheduler::holdOff(m_priority, segment.timer.elapsed()), this, [this, index]() {
+                resumeSegment(index);
+            });
+            return;
+        }
+
+        --m_running;
+        if (segment.end >= 0 && segment.position != segment.end) {
+            fail(QStringLiteral("Download of %1 ended prematurely").arg(m_url.toDisplayString()));
+        }
+    });
+}
+
+void FileDownloader::resumeSegment(int index)
+{
+    // The connections beyond the share of this download stay idle, as well as
+    // all of them while it is preempted.
+    int pause = RequestScheduler::holdOff(m_priority, 0);
+    if (pause == 0 && index >= RequestScheduler::connectionShare(m_priority, m_segments.size())) {
+        pause = PollInterval;
+    }
+    if (pause > 0 && m_errorString.isEmpty()) {
+        QTimer::singleShot(pause, this, [this, index]() {
+            resumeSegment(index);
+        });
+        return;
+    }
+    requestRange(index);
+}
+
+void FileDownloader::writeSegmentData(int index)
+{
+    Segment &segment = m_segments[index];
+    if (!m_errorString.isEmpty()) {
+        return;
+    }
+
+    const QByteArray data = segment.reply->readAll();
+    if (data.isEmpty()) {
+        return;
+    }
+
+    if (!m_file->seek(segment.position) || m_file->write(data) != data.size()) {
+        fail(m_file->errorString());
+        return;
+    }
+
+    segment.position += data.size();
+    m_written += data.size();
+    emit processed(m_written);
+}
+
+void FileDownloader::fail(const QString &errorString)
+{
+    if (!m_errorString.isEmpty()) {
+        return;
+    }
+
+    qCWarning(ONEDRIVE) << "Download of" << m_url << "failed:" << errorString;
+    m_errorString = errorString;
+
+    // Abort the other connections, their data is useless now.
+    for (const auto &segment : qAsConst(m_segments)) {
+        if (segment.reply && segment.reply->isRunning()) {
+            segment.reply->abort();
+        }
+    }
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#pragma once
+
+#include "requestscheduler.h"
+
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QUrl>
+#include <QVector>
+
+class QFile;
+class QNetworkReply;
+
+/**
+ * Downloads @p url straight into an open file, chunk by chunk.
+ *
+ * Only a small read buffer is kept per connection, so memory usage does not
+ * depend on the file size. Large downloads are split into byte ranges that
+ * are fetched concurrently and written at their offset in the file.
+ *
+ * Downloads of a lower class than Interactive in the RequestScheduler go in
+ * bounded ranges, and give way to higher classes between two.
+ */
+class FileDownloader : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @param file Open, writable file. Data is written starting at @p offset.
+     * @param size Total size of the remote file, or -1 if unknown.
+     */
+    FileDownloader(const QUrl &url, QFile *file, qint64 offset, qint64 size, QObject *parent = nullptr);
+    ~FileDownloader();
+
+    /**
+     * Runs the download and blocks until it is complete or failed.
+     * @return Whether the download succeeded.
+     */
+    bool exec();
+
+    /**
+     * @return Whether the download was split in concurrent ranges. When such a
+     * download fails, the file may contain holes and must not be resumed.
+     */
+    bool isParallel() const;
+
+    QString errorString() const;
+
+    /**
+     * @return The HTTP status that failed the download, 0 if it failed
+     * otherwise. A pre-authenticated URL that expired is answered with 401
+     * or 403.
+     */
+    int statusCode() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted whenever data was written, with the number of bytes present in the file.
+     */
+    void processed(qint64 bytes);
+
+private:
+    struct Segment {
+        qint64 position;
+        qint64 end;
+        QNetworkReply *reply;
+        QElapsedTimer timer;
+    };
+
+    void startSegment(int index);
+    void requestRange(int index);
+    void resumeSegment(int index);
+    void writeSegmentData(int index);
+    void fail(const QString &errorString);
+
+    QNetworkAccessManager *m_network;
+    QUrl m_url;
+    QFile *m_file;
+    qint64 m_offset;
+    qint64 m_size;
+    qint64 m_written = 0;
+    int m_running = 0;
+    RequestScheduler::Priority m_priority;
+    QVector<Segment> m_segments;
+    int m_statusCode = 0;
+    QString m_errorString;
+};
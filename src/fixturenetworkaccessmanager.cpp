@@ -0,0 +1,489 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "fixturenetworkaccessmanager.h"
+#include "onedrivedebug.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkReply>
+#include <QSaveFile>
+#include <QTimer>
+#include <QUrlQuery>
+
+#include <memory>
+
+// Larger non-JSON bodies (file content) are only stored by size.
+static const int MaxStoredBodySize = 4096;
+
+static const char *const RecordedHeaders[] = { "Location", "Content-Range", "Content-Type", "Retry-After" };
+
+static const QString Scrubbed = QStringLiteral("scrubbed");
+
+static bool isSecret(const QString &key)
+{
+    const QString name = key.toLower();
+    return name.contains(QLatin1String("token"))
+        || name == QLatin1String("tempauth")
+        || name == QLatin1String("sig")
+        || name == QLatin1String("signature")
+        || name == QLatin1String("code")
+        || name == QLatin1String("client_secret");
+}
+
+static QUrl scrubbedUrl(const QUrl &url)
+{
+    if (!url.hasQuery()) {
+        return url;
+    }
+
+    QUrlQuery query(url);
+    auto items = query.queryItems(QUrl::FullyEncoded);
+    for (auto &item : items) {
+        if (isSecret(item.first)) {
+            item.second = Scrubbed;
+        }
+    }
+    query.setQueryItems(items);
+
+    QUrl scrubbed = url;
+    scrubbed.setQuery(query);
+    return scrubbed;
+}
+
+static QJsonValue scrubbedJson(const QJsonValue &value)
+{
+    if (value.isObject()) {
+        QJsonObject object = value.toObject();
+        for (auto it = object.begin(); it != object.end(); ++it) {
+            it.value() = isSecret(it.key()) ? QJsonValue(Scrubbed) : scrubbedJson(it.value());
+        }
+        return object;
+    }
+    if (value.isArray()) {
+        QJsonArray array;
+        for (const auto &element : value.toArray()) {
+            array.append(scrubbedJson(element));
+        }
+        return array;
+    }
+    if (value.isString() && value.toString().startsWith(QLatin1String("http"))) {
+        return scrubbedUrl(QUrl(value.toString())).toString(QUrl::FullyEncoded);
+    }
+    return value;
+}
+
+static QNetworkReply::NetworkError errorForStatus(int status)
+{
+    switch (status) {
+    case 401:
+        return QNetworkReply::AuthenticationRequiredError;
+    case 403:
+        return QNetworkReply::ContentAccessDenied;
+    case 404:
+        return QNetworkReply::ContentNotFoundError;
+    case 405:
+        return QNetworkReply::ContentOperationNotPermittedError;
+    case 409:
+        return QNetworkReply::ContentConflictError;
+    case 410:
+        return QNetworkReply::ContentGoneError;
+    case 500:
+        return QNetworkReply::InternalServerError;
+    case 501:
+        return QNetworkReply::OperationNotImplementedError;
+    case 503:
+        return QNetworkReply::ServiceUnavailableError;
+    }
+    if (status >= 500) {
+        return QNetworkReply::UnknownServerError;
+    }
+    if (status >= 400) {
+        return QNetworkReply::UnknownContentError;
+    }
+    return status == 0 ? QNetworkReply::UnknownNetworkError : QNetworkReply::NoError;
+}
+
+/**
+ * Reply delivering a recorded exchange once its delay has elapsed.
+ */
+class FixtureReply : public QNetworkReply
+{
+public:
+    FixtureReply(QNetworkAccessManager::Operation op,
+                 const QNetworkRequest &request,
+                 int status,
+                 const QList<QPair<QByteArray, QByteArray>> &headers,
+                 const QByteArray &body,
+                 qint64 delay,
+                 QObject *parent)
+        : QNetworkReply(parent)
+        , m_body(body)
+    {
+        setOperation(op);
+        setRequest(request);
+        setUrl(request.url());
+        open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+        if (status > 0) {
+            setAttribute(QNetworkRequest::HttpStatusCodeAttribute, status);
+        }
+        for (const auto &header : headers) {
+            setRawHeader(header.first, header.second);
+        }
+        setHeader(QNetworkRequest::ContentLengthHeader, m_body.size());
+
+        const auto error = errorForStatus(status);
+        if (error != NoError) {
+            setError(error, QStringLiteral("HTTP %1 (replayed)").arg(status));
+        }
+
+        QTimer::singleShot(int(delay), this, [this]() {
+            deliver();
+        });
+    }
+
+    void abort() Q_DECL_OVERRIDE
+    {
+        if (!isFinished()) {
+            setError(OperationCanceledError, QStringLiteral("Operation canceled"));
+            m_body.clear();
+            deliver();
+        }
+    }
+
+    bool isSequential() const Q_DECL_OVERRIDE
+    {
+        return true;
+    }
+
+    qint64 bytesAvailable() const Q_DECL_OVERRIDE
+    {
+        return m_body.size() - m_offset + QNetworkReply::bytesAvailable();
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) Q_DECL_OVERRIDE
+    {
+        const qint64 size = qMin(maxSize, m_body.size() - m_offset);
+        if (size <= 0) {
+            return isFinished() ? -1 : 0;
+        }
+        memcpy(data, m_body.constData() + m_offset, size_t(size));
+        m_offset += size;
+        return size;
+    }
+
+private:
+    void deliver()
+    {
+        if (isFinished()) {
+            return;
+        }
+
+        emit metaDataChanged();
+        if (!m_body.isEmpty()) {
+            emit readyRead();
+            emit downloadProgress(m_body.size(), m_body.size());
+        }
+        setFinished(true);
+        emit finished();
+    }
+
+    QByteArray m_body;
+    qint64 m_offset = 0;
+};
+
+FixtureNetworkAccessManager::FixtureNetworkAccessManager(Mode mode, const QString &fileName, QObject *parent)
+    : QNetworkAccessManager(parent)
+    , m_mode(mode)
+    , m_fileName(fileName)
+{
+    if (m_mode == Replay) {
+        m_valid = load();
+    }
+}
+
+FixtureNetworkAccessManager::~FixtureNetworkAccessManager()
+{
+    if (m_mode == Record) {
+        save();
+    } else if (m_unmatchedCount > 0 || unusedCount() > 0) {
+        qCDebug(ONEDRIVE) << "Replay of" << m_fileName << "had" << m_unmatchedCount << "unmatched requests and"
+                          << unusedCount() << "unused exchanges";
+    }
+}
+
+FixtureNetworkAccessManager::Mode FixtureNetworkAccessManager::mode() const
+{
+    return m_mode;
+}
+
+bool FixtureNetworkAccessManager::isValid() const
+{
+    return m_valid;
+}
+
+void FixtureNetworkAccessManager::setTiming(Timing timing, bool wait)
+{
+    m_timing = timing;
+    m_wait = wait;
+}
+
+void FixtureNetworkAccessManager::setSyntheticTiming(int latency, qint64 bytesPerSecond)
+{
+    m_syntheticLatency = latency;
+    m_syntheticBandwidth = bytesPerSecond;
+}
+
+int FixtureNetworkAccessManager::requestCount() const
+{
+    return m_requestCount;
+}
+
+int FixtureNetworkAccessManager::unmatchedCount() const
+{
+    return m_unmatchedCount;
+}
+
+int FixtureNetworkAccessManager::unusedCount() const
+{
+    int count = 0;
+    for (const auto &exchange : m_exchanges) {
+        if (!exchange.used) {
+            ++count;
+        }
+    }
+    return m_mode == Replay ? count : 0;
+}
+
+qint64 FixtureNetworkAccessManager::simulatedLatency() const
+{
+    return m_simulatedLatency;
+}
+
+QString FixtureNetworkAccessManager::scrubbedTarget(const QUrl &url)
+{
+    return scrubbedUrl(url).toString(QUrl::RemoveScheme | QUrl::RemoveAuthority | QUrl::RemoveFragment);
+}
+
+QByteArray FixtureNetworkAccessManager::method(Operation op, const QNetworkRequest &request)
+{
+    switch (op) {
+    case HeadOperation:
+        return "HEAD";
+    case GetOperation:
+        return "GET";
+    case PutOperation:
+        return "PUT";
+    case PostOperation:
+        return "POST";
+    case DeleteOperation:
+        return "DELETE";
+    default:
+        return request.attribute(QNetworkRequest::CustomVerbAttribute).toByteArray();
+    }
+}
+
+QNetworkReply *FixtureNetworkAccessManager::createRequest(Operation op, const QNetworkRequest &request, QIODevice *outgoingData)
+{
+    ++m_requestCount;
+    return m_mode == Record ? record(op, request, outgoingData) : replay(op, request);
+}
+
+QNetworkReply *FixtureNetworkAccessManager::record(Operation op, const QNetworkRequest &request, QIODevice *outgoingData)
+{
+    const int index = m_exchanges.size();
+    m_exchanges.append({method(op, request), scrubbedTarget(request.url()), request.rawHeader("Range"),
+                        0, {}, QByteArray(), 0, 0, true});
+
+    auto timer = std::make_shared<QElapsedTimer>();
+    timer->start();
+
+    // Our slots are connected first, so they see the data before the caller reads it.
+    QNetworkReply *reply = QNetworkAccessManager::createRequest(op, request, outgoingData);
+    connect(reply, &QNetworkReply::downloadProgress, this, [this, index](qint64 received) {
+        m_exchanges[index].size = received;
+    });
+    connect(reply, &QNetworkReply::finished, this, [this, index, reply, timer]() {
+        Exchange &exchange = m_exchanges[index];
+        exchange.elapsed = timer->elapsed();
+        exchange.status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        for (const char *name : RecordedHeaders) {
+            if (!reply->hasRawHeader(name)) {
+                continue;
+            }
+            QByteArray value = reply->rawHeader(name);
+            if (qstrcmp(name, "Location") == 0) {
+                value = scrubbedUrl(QUrl::fromEncoded(value)).toEncoded();
+            }
+            exchange.headers.append({QByteArray(name), value});
+        }
+
+        // Bodies read while downloading are gone, only their size is known.
+        const QByteArray body = reply->peek(reply->bytesAvailable());
+        if (body.size() >= exchange.size) {
+            exchange.body = body;
+            exchange.size = body.size();
+        }
+    });
+    return reply;
+}
+
+QNetworkReply *FixtureNetworkAccessManager::replay(Operation op, const QNetworkRequest &request)
+{
+    const QByteArray verb = method(op, request);
+    const QString target = scrubbedTarget(request.url());
+    const QByteArray range = request.rawHeader("Range");
+
+    for (auto &exchange : m_exchanges) {
+        if (exchange.used || exchange.method != verb || exchange.target != target || exchange.range != range) {
+            continue;
+        }
+
+        exchange.used = true;
+        if (exchange.body.isEmpty() && exchange.size > 0) {
+            exchange.body = QByteArray(int(exchange.size), 'x');
+        }
+        const qint64 replyDelay = delay(exchange);
+        m_simulatedLatency += replyDelay;
+        return new FixtureReply(op, request, exchange.status, exchange.headers, exchange.body,
+                                m_wait ? replyDelay : 0, this);
+    }
+
+    qCWarning(ONEDRIVE) << "No fixture for" << verb << target << range;
+    ++m_unmatchedCount;
+    QJsonObject error;
+    error.insert(QStringLiteral("code"), QStringLiteral("itemNotFound"));
+    error.insert(QStringLiteral("message"), QStringLiteral("No fixture for %1 %2").arg(QString::fromLatin1(verb), target));
+    QJsonObject body;
+    body.insert(QStringLiteral("error"), error);
+    return new FixtureReply(op, request, 404, {}, QJsonDocument(body).toJson(QJsonDocument::Compact), 0, this);
+}
+
+qint64 FixtureNetworkAccessManager::delay(const Exchange &exchange) const
+{
+    if (m_timing == RecordedTiming) {
+        return exchange.elapsed;
+    }
+
+    qint64 delay = m_syntheticLatency;
+    if (m_syntheticBandwidth > 0) {
+        delay += exchange.body.size() * 1000 / m_syntheticBandwidth;
+    }
+    return delay;
+}
+
+bool FixtureNetworkAccessManager::load()
+{
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(ONEDRIVE) << "Cannot open fixture" << m_fileName << ":" << file.errorString();
+        return false;
+    }
+
+    QJsonParseError parseError;
+    const auto document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
+        qCWarning(ONEDRIVE) << "Invalid fixture" << m_fileName << ":" << parseError.errorString();
+        return false;
+    }
+
+    const auto exchanges = document.object().value(QStringLiteral("exchanges")).toArray();
+    for (const auto &value : exchanges) {
+        const auto object = value.toObject();
+        Exchange exchange{object.value(QStringLiteral("method")).toString().toLatin1(),
+                          object.value(QStringLiteral("target")).toString(),
+                          object.value(QStringLiteral("range")).toString().toLatin1(),
+                          object.value(QStringLiteral("status")).toInt(),
+                          {}, QByteArray(),
+                          qint64(object.value(QStringLiteral("size")).toDouble()),
+                          qint64(object.value(QStringLiteral("ms")).toDouble()),
+                          false};
+
+        const auto headers = object.value(QStringLiteral("headers")).toObject();
+        for (auto it = headers.constBegin(); it != headers.constEnd(); ++it) {
+            exchange.headers.append({it.key().toLatin1(), it.value().toString().toUtf8()});
+        }
+
+        const auto json = object.value(QStringLiteral("json"));
+        if (json.isObject()) {
+            exchange.body = QJsonDocument(json.toObject()).toJson(QJsonDocument::Compact);
+        } else if (json.isArray()) {
+            exchange.body = QJsonDocument(json.toArray()).toJson(QJsonDocument::Compact);
+        } else if (object.contains(QStringLiteral("data"))) {
+            exchange.body = QByteArray::fromBase64(object.value(QStringLiteral("data")).toString().toLatin1());
+        }
+        exchange.size = qMax(exchange.size, qint64(exchange.body.size()));
+
+        m_exchanges.append(exchange);
+    }
+    return true;
+}
+
+bool FixtureNetworkAccessManager::save() const
+{
+    QJsonArray exchanges;
+    for (const auto &exchange : m_exchanges) {
+        QJsonObject object;
+        object.insert(QStringLiteral("method"), QString::fromLatin1(exchange.method));
+        object.insert(QStringLiteral("target"), exchange.target);
+        if (!exchange.range.isEmpty()) {
+            object.insert(QStringLiteral("range"), QString::fromLatin1(exchange.range));
+        }
+        object.insert(QStringLiteral("status"), exchange.status);
+
+        if (!exchange.headers.isEmpty()) {
+            QJsonObject headers;
+            for (const auto &header : exchange.headers) {
+                headers.insert(QString::fromLatin1(header.first), QString::fromUtf8(header.second));
+            }
+            object.insert(QStringLiteral("headers"), headers);
+        }
+
+        const auto document = QJsonDocument::fromJson(exchange.body);
+        if (document.isObject()) {
+            object.insert(QStringLiteral("json"), scrubbedJson(document.object()));
+        } else if (document.isArray()) {
+            object.insert(QStringLiteral("json"), scrubbedJson(document.array()));
+        } else if (!exchange.body.isEmpty() && exchange.body.size() <= MaxStoredBodySize) {
+            object.insert(QStringLiteral("data"), QString::fromLatin1(exchange.body.toBase64()));
+        } else if (exchange.size > 0) {
+            object.insert(QStringLiteral("size"), double(exchange.size));
+        }
+        object.insert(QStringLiteral("ms"), double(exchange.elapsed));
+
+        exchanges.append(object);
+    }
+
+    QJsonObject root;
+    root.insert(QStringLiteral("version"), 1);
+    root.insert(QStringLiteral("exchanges"), exchanges);
+
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(ONEDRIVE) << "Cannot write fixture" << m_fileName << ":" << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    return file.commit();
+}
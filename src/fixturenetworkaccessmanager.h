@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef FIXTURENETWORKACCESSMANAGER_H
+#define FIXTURENETWORKACCESSMANAGER_H
+
+#include <QByteArray>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QPair>
+#include <QVector>
+
+/**
+ * Network access manager that records the HTTP exchanges of the worker into a
+ * fixture file, or replays them from one without touching the network.
+ *
+ * Fixtures are JSON: one entry per exchange, with the method, the path and
+ * query of the request (the host is dropped), the status, a few response
+ * headers, the response body and the time it took. Authorization headers are
+ * never stored, and tokens are scrubbed from queries and JSON bodies. Bodies
+ * that are not JSON and larger than a few KiB are only stored by size, and
+ * replayed as filler bytes.
+ *
+ * On replay each request takes the first unused exchange with the same method,
+ * target and Range header; requests without any are answered with a 404 and
+ * counted as unmatched. Replies are delayed by the recorded duration, or by a
+ * synthetic one computed from a latency and a bandwidth.
+ */
+class FixtureNetworkAccessManager : public QNetworkAccessManager
+{
+    Q_OBJECT
+
+public:
+    enum Mode {
+        Record,
+        Replay
+    };
+
+    enum Timing {
+        /** Replies take as long as when they were recorded. */
+        RecordedTiming,
+        /** Replies take the synthetic latency, plus their size over the synthetic bandwidth. */
+        SyntheticTiming
+    };
+
+    /**
+     * In Replay mode, @p fileName is loaded right away, see isValid().
+     * In Record mode, it is written by save() and on destruction.
+     */
+    FixtureNetworkAccessManager(Mode mode, const QString &fileName, QObject *parent = nullptr);
+    ~FixtureNetworkAccessManager();
+
+    Mode mode() const;
+
+    /**
+     * @return Whether the fixture could be loaded, always true when recording.
+     */
+    bool isValid() const;
+
+    /**
+     * Sets how long replayed replies take. When @p wait is false, replies are
+     * delivered right away, and the delays are only added to simulatedLatency().
+     */
+    void setTiming(Timing timing, bool wait = true);
+    void setSyntheticTiming(int latency, qint64 bytesPerSecond);
+
+    bool save() const;
+
+    /**
+     * @return The number of requests sent through this manager.
+     */
+    int requestCount() const;
+
+    /**
+     * @return The number of replayed requests that had no matching exchange.
+     */
+    int unmatchedCount() const;
+
+    /**
+     * @return The number of exchanges of the fixture that were not replayed.
+     */
+    int unusedCount() const;
+
+    /**
+     * @return The sum of the delays of the replayed replies, in milliseconds.
+     */
+    qint64 simulatedLatency() const;
+
+    /**
+     * @return @p url without host, and with the value of its token-like
+     * query items replaced.
+     */
+    static QString scrubbedTarget(const QUrl &url);
+
+protected:
+    QNetworkReply *createRequest(Operation op, const QNetworkRequest &request, QIODevice *outgoingData) Q_DECL_OVERRIDE;
+
+private:
+    struct Exchange {
+        QByteArray method;
+        QString target;
+        QByteArray range;
+        int status;
+        QList<QPair<QByteArray, QByteArray>> headers;
+        QByteArray body;
+        qint64 size;
+        qint64 elapsed;
+        bool used;
+    };
+
+    bool load();
+    QNetworkReply *record(Operation op, const QNetworkRequest &request, QIODevice *outgoingData);
+    QNetworkReply *replay(Operation op, const QNetworkRequest &request);
+    qint64 delay(const Exchange &exchange) const;
+
+    static QByteArray method(Operation op, const QNetworkRequest &request);
+
+    Mode m_mode;
+    QString m_fileName;
+    bool m_valid = true;
+    Timing m_timing = RecordedTiming;
+    bool m_wait = true;
+    int m_syntheticLatency = 0;
+    qint64 m_syntheticBandwidth = 0;
+
+    QVector<Exchange> m_exchanges;
+    int m_requestCount = 0;
+    int m_unmatchedCount = 0;
+    qint64 m_simulatedLatency = 0;
+};
+
+#endif // FIXTURENETWORKACCESSMANAGER_H
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "graphbatch.h"
+#include "onedrivedebug.h"
+#include "onedrivehelper.h"
+#include "requestscheduler.h"
+
+#include <QEventLoop>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QTimer>
+
+// Throttled requests are sent again up to MaxThrottleRetries times, after
+// their Retry-After, if no longer than MaxRetryAfter seconds. Without it the
+// wait doubles from one second.
+static const int MaxThrottleRetries = 3;
+static const int MaxRetryAfter = 60;
+
+static bool isThrottled(int status)
+{
+    return status == 429 || status == 503;
+}
+
+GraphBatch::GraphBatch(QNetworkAccessManager *network, const KMGraph2::AccountPtr &account)
+    : m_network(network)
+    , m_account(account)
+{
+}
+
+GraphBatch::~GraphBatch()
+{
+}
+
+void GraphBatch::setAccount(const KMGraph2::AccountPtr &account)
+{
+    m_account = account;
+}
+
+int GraphBatch::add(const QByteArray &method, const QString &path, const QJsonObject &body)
+{
+    m_requests.append({method, path, body});
+    m_responses.append(Response());
+    return m_requests.size() - 1;
+}
+
+int GraphBatch::size() const
+{
+    return m_requests.size();
+}
+
+QVector<GraphBatch::Response> GraphBatch::responses() const
+{
+    return m_responses;
+}
+
+int GraphBatch::requestCount() const
+{
+    return m_requestCount;
+}
+
+int GraphBatch::statusCode() const
+{
+    return m_statusCode;
+}
+
+int GraphBatch::retryAfter() const
+{
+    return m_retryAfter;
+}
+
+QString GraphBatch::errorString() const
+{
+    return m_errorString;
+}
+
+bool GraphBatch::exec()
+{
+    m_statusCode = 0;
+    m_retryAfter = 0;
+    m_errorString.clear();
+
+    int throttleRetries = 0;
+    Q_FOREVER {
+        QVector<int> pending;
+        for (int i = 0; i < m_responses.size(); ++i) {
+            if (m_responses.at(i).status == 0) {
+                pending << i;
+            }
+        }
+        for (int first = 0; first < pending.size(); first += MaxRequests) {
+            if (!sendBatch(pending.mid(first, MaxRequests))) {
+                return false;
+            }
+        }
+
+        // The access token expired while sending, the whole batch fails like
+        // a single request would.
+        for (int i : qAsConst(pending)) {
+            if (m_responses.at(i).status == 401) {
+                m_statusCode = 401;
+                m_errorString = m_responses.at(i).body.value(QStringLiteral("error")).toObject().value(QStringLiteral("message")).toString();
+                m_responses[i] = Response();
+            }
+        }
+        if (m_statusCode == 401) {
+            return false;
+        }
+
+        // Throttled requests go again together, after the longest wait asked.
+        QVector<int> throttled;
+        int delay = 0;
+        for (int i = 0; i < m_responses.size(); ++i) {
+            const Response &response = m_responses.at(i);
+            if (isThrottled(response.status)) {
+                throttled << i;
+                delay = qMax(delay, response.retryAfter >= 0 ? response.retryAfter : 1 << throttleRetries);
+            }
+        }
+        if (throttled.isEmpty() || throttleRetries == MaxThrottleRetries || delay > MaxRetryAfter) {
+            return true;
+        }
+
+        qCDebug(ONEDRIVE) << throttled.size() << "batched requests throttled, retrying in" << delay << "seconds";
+        ++throttleRetries;
+        QEventLoop eventLoop;
+        QTimer::singleShot(delay * 1000, &eventLoop, &QEventLoop::quit);
+        eventLoop.exec();
+        for (int i : qAsConst(throttled)) {
+            m_responses[i] = Response();
+        }
+    }
+}
+
+bool GraphBatch::sendBatch(const QVector<int> &indexes)
+{
+    QJsonArray requests;
+    for (int i : indexes) {
+        const Request &request = m_requests.at(i);
+        QJsonObject json;
+        // The ids only need to be unique within one batch.
+        json.insert(QStringLiteral("id"), QString::number(i));
+        json.insert(QStringLiteral("method"), QString::fromLatin1(request.method));
+        json.insert(QStringLiteral("url"), OneDriveHelper::graphDrivePath() + request.path);
+        if (!request.body.isEmpty()) {
+            json.insert(QStringLiteral("body"), request.body);
+            QJsonObject headers;
+            headers.insert(QStringLiteral("Content-Type"), QStringLiteral("application/json"));
+            json.insert(QStringLiteral("headers"), headers);
+        }
+        requests.append(json);
+    }
+
+    QJsonObject payload;
+    payload.insert(QStringLiteral("requests"), requests);
+
+    auto request = OneDriveHelper::graphRequest(m_account, QString());
+    request.setUrl(QUrl(OneDriveHelper::graphUrl().toString() + QStringLiteral("/$batch")));
+
+    RequestScheduler::Ticket ticket;
+    QNetworkReply *reply = m_network->post(request, QJsonDocument(payload).toJson(QJsonDocument::Compact));
+    ++m_requestCount;
+    QEventLoop eventLoop;
+    QObject::connect(reply, &QNetworkReply::finished, &eventLoop, &QEventLoop::quit);
+    eventLoop.exec();
+    reply->deleteLater();
+
+    if (reply->error() != QNetworkReply::NoError) {
+        qCWarning(ONEDRIVE) << "Batch request failed:" << reply->errorString();
+        m_statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        m_retryAfter = reply->rawHeader("Retry-After").toInt();
+        m_errorString = reply->errorString();
+        return false;
+    }
+
+    // Responses may come back in any order.
+    const auto responses = QJsonDocument::fromJson(reply->readAll()).object().value(QStringLiteral("responses")).toArray();
+    for (const auto &value : responses) {
+        const auto json = value.toObject();
+        bool ok = false;
+        const int index = json.value(QStringLiteral("id")).toString().toInt(&ok);
+        if (!ok || !indexes.contains(index)) {
+            continue;
+        }
+        Response &response = m_responses[index];
+        response.status = json.value(QStringLiteral("status")).toInt();
+        response.body = json.value(QStringLiteral("body")).toObject();
+        const auto headers = json.value(QStringLiteral("headers")).toObject();
+        if (headers.contains(QStringLiteral("Retry-After"))) {
+            response.retryAfter = headers.value(QStringLiteral("Retry-After")).toString().toInt();
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#pragma once
+
+#include <QJsonObject>
+#include <QVector>
+
+#include <KMGraph/Account>
+
+class QNetworkAccessManager;
+
+/**
+ * Sends many drive requests through the Microsoft Graph JSON $batch endpoint.
+ *
+ * Requests are packed by MaxRequests, the limit of the server, so N requests
+ * cost N / MaxRequests round trips instead of N.
+ *
+ * Throttled requests are sent again after their Retry-After. The batch
+ * itself may be rejected, e.g. with 401 when the access token expired: its
+ * requests then stay unanswered, and the next exec() sends them. So do the
+ * single requests rejected with 401.
+ */
+class GraphBatch
+{
+public:
+    static const int MaxRequests = 20;
+
+    struct Response {
+        /** 0 while not answered. */
+        int status = 0;
+        QJsonObject body;
+        /** The Retry-After of a throttled request, in seconds, -1 without one. */
+        int retryAfter = -1;
+    };
+
+    GraphBatch(QNetworkAccessManager *network, const KMGraph2::AccountPtr &account);
+    ~GraphBatch();
+
+    void setAccount(const KMGraph2::AccountPtr &account);
+
+    /**
+     * Queues a request to @p path, relative to the drive endpoint.
+     * @return The index of the request in responses().
+     */
+    int add(const QByteArray &method, const QString &path, const QJsonObject &body = QJsonObject());
+
+    int size() const;
+
+    /**
+     * Sends the queued requests not answered yet and blocks until all the
+     * answers arrived.
+     * @return Whether every batch was delivered. The status of each single
+     * request is reported by responses().
+     */
+    bool exec();
+
+    QVector<Response> responses() const;
+
+    /**
+     * @return The number of HTTP requests sent by exec().
+     */
+    int requestCount() const;
+
+    /**
+     * @return The HTTP status of the batch that was not delivered, or 0.
+     */
+    int statusCode() const;
+
+    /**
+     * @return The Retry-After of the batch that was not delivered, in seconds.
+     */
+    int retryAfter() const;
+
+    QString errorString() const;
+
+private:
+    struct Request {
+        QByteArray method;
+        QString path;
+        QJsonObject body;
+    };
+
+    bool sendBatch(const QVector<int> &indexes);
+
+    QNetworkAccessManager *m_network;
+    KMGraph2::AccountPtr m_account;
+    QVector<Request> m_requests;
+    QVector<Response> m_responses;
+    int m_requestCount = 0;
+    int m_statusCode = 0;
+    int m_retryAfter = 0;
+    QString m_errorString;
+};
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "graphrequest.h"
+#include "onedrivehelper.h"
+#include "requestscheduler.h"
+
+#include <QBuffer>
+#include <QEventLoop>
+#include <QJsonDocument>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+
+GraphRequest::GraphRequest(QNetworkAccessManager *network,
+                           const QByteArray &verb,
+                           const QString &path,
+                           const QJsonObject &body)
+    : m_network(network)
+    , m_verb(verb)
+    , m_path(path)
+    , m_body(body)
+{
+}
+
+GraphRequest::~GraphRequest()
+{
+}
+
+void GraphRequest::setAccount(const KMGraph2::AccountPtr &account)
+{
+    m_account = account;
+}
+
+KMGraph2::AccountPtr GraphRequest::account() const
+{
+    return m_account;
+}
+
+void GraphRequest::setQuery(const QUrlQuery &query)
+{
+    m_query = query;
+}
+
+void GraphRequest::setUrl(const QUrl &url)
+{
+    m_url = url;
+}
+
+void GraphRequest::setNotFoundAccepted(bool accepted)
+{
+    m_notFoundAccepted = accepted;
+}
+
+void GraphRequest::setContent(const QByteArray &content)
+{
+    m_content = content;
+    m_hasContent = true;
+}
+
+bool GraphRequest::exec()
+{
+    auto request = OneDriveHelper::graphRequest(m_account, m_path);
+    if (m_url.isValid()) {
+        request.setUrl(m_url);
+    } else if (!m_query.isEmpty()) {
+        QUrl url = request.url();
+        url.setQuery(m_query);
+        request.setUrl(url);
+    }
+
+    QByteArray payload;
+    if (m_hasContent) {
+        payload = m_content;
+        request.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/octet-stream"));
+    } else if (!m_body.isEmpty()) {
+        payload = QJsonDocument(m_body).toJson(QJsonDocument::Compact);
+    }
+    QBuffer buffer(&payload);
+    buffer.open(QIODevice::ReadOnly);
+
+    RequestScheduler::Ticket ticket;
+    QNetworkReply *reply = m_network->sendCustomRequest(request, m_verb, &buffer);
+    QEventLoop eventLoop;
+    QObject::connect(reply, &QNetworkReply::finished, &eventLoop, &QEventLoop::quit);
+    eventLoop.exec();
+
+    m_statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    m_retryAfter = reply->rawHeader("Retry-After").toInt();
+    m_location = reply->header(QNetworkRequest::LocationHeader).toUrl();
+    m_response = QJsonDocument::fromJson(reply->readAll()).object();
+    m_errorString = m_response.value(QStringLiteral("error")).toObject().value(QStringLiteral("message")).toString();
+    if (m_errorString.isEmpty()) {
+        m_errorString = reply->errorString();
+    }
+    reply->deleteLater();
+
+    return (m_statusCode >= 200 && m_statusCode < 300) || (m_notFoundAccepted && m_statusCode == 404);
+}
+
+int GraphRequest::statusCode() const
+{
+    return m_statusCode;
+}
+
+QJsonObject GraphRequest::response() const
+{
+    return m_response;
+}
+
+QString GraphRequest::errorString() const
+{
+    return m_errorString;
+}
+
+int GraphRequest::retryAfter() const
+{
+    return m_retryAfter;
+}
+
+QUrl GraphRequest::location() const
+{
+    return m_location;
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#pragma once
+
+#include <QJsonObject>
+#include <QUrlQuery>
+
+#include <KMGraph/Account>
+
+#include <functional>
+
+class QNetworkAccessManager;
+
+/**
+ * A blocking request to a Microsoft Graph drive endpoint. The worker sends
+ * all of its requests this way, through the shared network access manager,
+ * so that fixtures record and replay them all.
+ */
+class GraphRequest
+{
+public:
+    /**
+     * @param path Path relative to the drive endpoint, e.g. "/items/{id}".
+     */
+    GraphRequest(QNetworkAccessManager *network,
+                 const QByteArray &verb,
+                 const QString &path,
+                 const QJsonObject &body = QJsonObject());
+    ~GraphRequest();
+
+    void setAccount(const KMGraph2::AccountPtr &account);
+    KMGraph2::AccountPtr account() const;
+
+    void setQuery(const QUrlQuery &query);
+
+    /**
+     * Sends the request to @p url instead of the path, e.g. to follow a next
+     * or delta link returned by the server.
+     */
+    void setUrl(const QUrl &url);
+
+    /**
+     * Makes exec() succeed when the server answers 404, e.g. to look up a
+     * path that may not exist. statusCode() tells the two apart.
+     */
+    void setNotFoundAccepted(bool accepted);
+
+    /**
+     * Sends @p content as the body instead of the JSON one, e.g. the
+     * content of a file uploaded in a single request.
+     */
+    void setContent(const QByteArray &content);
+
+    /**
+     * Sends the request and blocks until the response has been received.
+     * May be called again to retry, e.g. with a refreshed account.
+     * @return Whether the server answered with a 2xx status, or an accepted 404.
+     */
+    bool exec();
+
+    int statusCode() const;
+    QJsonObject response() const;
+    QString errorString() const;
+
+    /**
+     * @return The delay the server asked for before a retry, in seconds,
+     * from the Retry-After header of a 429 or 503 response, or 0.
+     */
+    int retryAfter() const;
+
+    /**
+     * @return The Location header of the response, e.g. the monitor of an
+     * asynchronous copy.
+     */
+    QUrl location() const;
+
+private:
+    QNetworkAccessManager *m_network;
+    QByteArray m_verb;
+    QString m_path;
+    QJsonObject m_body;
+    QByteArray m_content;
+    bool m_hasContent = false;
+    QUrlQuery m_query;
+    QUrl m_url;
+    bool m_notFoundAccepted = false;
+    KMGraph2::AccountPtr m_account;
+
+    int m_statusCode = 0;
+    int m_retryAfter = 0;
+    QUrl m_location;
+    QJsonObject m_response;
+    QString m_errorString;
+};
+
+/**
+ * Sends @p request, possibly several times, e.g. to refresh the token or
+ * wait out throttling. The worker's runs report their errors.
+ * @return Whether the request succeeded.
+ */
+using GraphRunner = std::function<bool(GraphRequest &request)>;
@@ -0,0 +1,571 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "hotfoldersync.h"
+#include "filedownloader.h"
+#include "graphrequest.h"
+#include "offlinestore.h"
+#include "onedrivedebug.h"
+#include "onedrivehelper.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QMap>
+#include <QSaveFile>
+#include <QTemporaryFile>
+#include <QTimer>
+
+// Version 1 kept the download URLs of the items.
+static const quint32 StateVersion = 2;
+// Deeper than any real tree, guards against loops in a corrupted index.
+static const int MaxDepth = 1000;
+
+HotFolderSync::HotFolderSync(const KMGraph2::AccountPtr &account, const QString &path,
+                             OfflineStore *store, const QString &stateDirectory)
+    : m_account(account)
+    , m_path(path)
+    , m_store(store)
+{
+    while (m_path.size() > 1 && m_path.endsWith(QLatin1Char('/'))) {
+        m_path.chop(1);
+    }
+    const QByteArray hash = QCryptographicHash::hash(m_path.toUtf8(), QCryptographicHash::Sha1).toHex();
+    m_stateFile = QStringLiteral("%1/%2.sync").arg(stateDirectory, QString::fromLatin1(hash));
+    QDir().mkpath(stateDirectory);
+}
+
+HotFolderSync::~HotFolderSync()
+{
+}
+
+QString HotFolderSync::path() const
+{
+    return m_path;
+}
+
+void HotFolderSync::setAccount(const KMGraph2::AccountPtr &account)
+{
+    m_account = account;
+}
+
+void HotFolderSync::setContentBudget(qint64 bytes)
+{
+    m_contentBudget = bytes;
+}
+
+void HotFolderSync::setBandwidth(qint64 bytesPerSecond)
+{
+    m_bandwidth = bytesPerSecond;
+}
+
+int HotFolderSync::statusCode() const
+{
+    return m_statusCode;
+}
+
+QString HotFolderSync::errorString() const
+{
+    return m_errorString;
+}
+
+int HotFolderSync::changeCount() const
+{
+    return m_changeCount;
+}
+
+qint64 HotFolderSync::downloadedBytes() const
+{
+    return m_downloadedBytes;
+}
+
+qint64 HotFolderSync::materializedBytes() const
+{
+    return m_materializedBytes;
+}
+
+bool HotFolderSync::run()
+{
+    m_runTimer.start();
+    m_statusCode = 0;
+    m_errorString.clear();
+    m_changeCount = 0;
+    m_downloadedBytes = 0;
+    if (!m_stateLoaded) {
+        loadState();
+        m_stateLoaded = true;
+    }
+
+    if (!resolveFolder()) {
+        return false;
+    }
+
+    QList<QJsonObject> changes;
+    QString deltaLink;
+    if (!fetchChanges(&changes, &deltaLink)) {
+        if (m_statusCode != 410) {
+            return false;
+        }
+        // The saved link expired, start over.
+        qCDebug(ONEDRIVE) << "Resyncing" << m_path;
+        m_deltaLink.clear();
+        changes.clear();
+        if (!fetchChanges(&changes, &deltaLink)) {
+            return false;
+        }
+    }
+
+    const bool enumeration = m_deltaLink.isEmpty();
+    if (enumeration) {
+        m_dirtyFolders << m_folderId;
+    }
+    QSet<QString> seen;
+    for (const auto &change : qAsConst(changes)) {
+        apply(change);
+        seen << change.value(QStringLiteral("id")).toString();
+    }
+    if (enumeration) {
+        // Whatever the enumeration did not return is gone.
+        const auto ids = m_items.keys();
+        for (const auto &id : ids) {
+            if (!seen.contains(id) && m_items.contains(id)) {
+                invalidateSubtree(id);
+                removeItem(id);
+            }
+        }
+    }
+    m_changeCount = changes.size();
+    m_deltaLink = deltaLink;
+
+    updateStore();
+    saveState();
+    m_store->markHotFolder(m_path, QDateTime::currentDateTimeUtc());
+
+    const bool contents = updateContents();
+    m_changedItems.clear();
+    m_downloadUrls.clear();
+    qCDebug(ONEDRIVE) << "Synced" << m_path << "-" << m_changeCount << "changes," << m_downloadedBytes
+                      << "bytes downloaded in" << m_runTimer.elapsed() << "ms";
+    return contents;
+}
+
+void HotFolderSync::clear()
+{
+    if (!m_stateLoaded) {
+        loadState();
+        m_stateLoaded = true;
+    }
+
+    // Pinned metadata would never be evicted otherwise.
+    for (auto it = m_items.constBegin(); it != m_items.constEnd(); ++it) {
+        if (!it->folder) {
+            m_store->removeContent(it.key());
+        }
+        const QString path = pathOf(it.key());
+        if (!path.isEmpty()) {
+            m_store->invalidate(path);
+        }
+    }
+    m_store->invalidate(m_path);
+    m_store->unmarkHotFolder(m_path);
+    QFile::remove(m_stateFile);
+
+    m_folderId.clear();
+    m_deltaLink.clear();
+    m_items.clear();
+    m_children.clear();
+    m_materializedBytes = 0;
+}
+
+bool HotFolderSync::resolveFolder()
+{
+    if (!m_folderId.isEmpty()) {
+        return true;
+    }
+
+    // The first component of the path is the account.
+    const QString relativePath = m_path.section(QLatin1Char('/'), 2);
+    const QString encodedPath = QString::fromLatin1(QUrl::toPercentEncoding(relativePath, "/"));
+    GraphRequest request(OneDriveHelper::networkAccessManager(), "GET",
+                         relativePath.isEmpty() ? QStringLiteral("/root") : QStringLiteral("/root:/%1").arg(encodedPath));
+    request.setAccount(m_account);
+    if (!request.exec()) {
+        m_statusCode = request.statusCode();
+        m_errorString = request.errorString();
+        return false;
+    }
+
+    m_folderId = request.response().value(QStringLiteral("id")).toString();
+    return !m_folderId.isEmpty();
+}
+
+bool HotFolderSync::fetchChanges(QList<QJsonObject> *changes, QString *deltaLink)
+{
+    QUrl next(m_deltaLink);
+    while (true) {
+        GraphRequest request(OneDriveHelper::networkAccessManager(), "GET", QStringLiteral("/items/%1/delta").arg(m_folderId));
+        request.setAccount(m_account);
+        if (next.isValid()) {
+            request.setUrl(next);
+        }
+        if (!request.exec()) {
+            m_statusCode = request.statusCode();
+            m_errorString = request.errorString();
+            return false;
+        }
+
+        const QJsonObject response = request.response();
+        const auto values = response.value(QStringLiteral("value")).toArray();
+        for (const auto &value : values) {
+            changes->append(value.toObject());
+        }
+
+        const QString nextLink = response.value(QStringLiteral("@odata.nextLink")).toString();
+        if (nextLink.isEmpty()) {
+            *deltaLink = response.value(QStringLiteral("@odata.deltaLink")).toString();
+            return true;
+        }
+        next = QUrl(nextLink);
+    }
+}
+
+void HotFolderSync::apply(const QJsonObject &change)
+{
+    const QString id = change.value(QStringLiteral("id")).toString();
+    if (id.isEmpty()) {
+        return;
+    }
+    const bool deleted = change.contains(QStringLiteral("deleted"));
+
+    if (id == m_folderId) {
+        // Account roots have no entry of their own.
+        if (!deleted && m_path.count(QLatin1Char('/')) > 1) {
+            const KIO::UDSEntry entry = OneDriveHelper::itemToUDSEntry(change, m_path.left(m_path.lastIndexOf(QLatin1Char('/'))));
+            if (entry.count() > 0) {
+                m_store->storeEntry(m_path, entry, OfflineStore::Pinned);
+            }
+        }
+        return;
+    }
+
+    if (deleted) {
+        if (m_items.contains(id)) {
+            invalidateSubtree(id);
+            removeItem(id);
+        }
+        return;
+    }
+
+    const QString parentId = change.value(QStringLiteral("parentReference")).toObject().value(QStringLiteral("id")).toString();
+    const QString name = change.value(QStringLiteral("name")).toString();
+    const qint64 size = qint64(change.value(QStringLiteral("size")).toDouble());
+    const QDateTime modified = QDateTime::fromString(change.value(QStringLiteral("lastModifiedDateTime")).toString(), Qt::ISODate);
+    const auto existing = m_items.constFind(id);
+    if (existing != m_items.constEnd()) {
+        if (existing->parentId != parentId || existing->name != name) {
+            // Moved or renamed: everything below gets a new path.
+            invalidateSubtree(id);
+            m_dirtyFolders << existing->parentId;
+            m_children[existing->parentId].remove(id);
+        }
+        // Contents are stored per modification time, in seconds, which does
+        // not tell apart two changes within the same second. The cTag does.
+        const QJsonObject previous = QJsonDocument::fromJson(existing->json).object();
+        if (!existing->folder && (previous.value(QStringLiteral("cTag")) != change.value(QStringLiteral("cTag"))
+                                  || existing->size != size || existing->modified != modified)) {
+            m_store->removeContent(id);
+        }
+    }
+
+    // Download URLs are pre-authenticated: kept in memory for this run only,
+    // never in the saved state.
+    QJsonObject stored = change;
+    const QUrl downloadUrl(stored.take(QStringLiteral("@microsoft.graph.downloadUrl")).toString());
+    if (downloadUrl.isValid()) {
+        m_downloadUrls.insert(id, downloadUrl);
+    } else {
+        m_downloadUrls.remove(id);
+    }
+
+    Item &item = m_items[id];
+    item.parentId = parentId;
+    item.name = name;
+    item.folder = change.contains(QStringLiteral("folder"));
+    item.size = size;
+    item.modified = modified;
+    item.json = QJsonDocument(stored).toJson(QJsonDocument::Compact);
+    item.entryPath.clear();
+
+    m_children[parentId].insert(id);
+    m_dirtyFolders << parentId;
+    m_changedItems << id;
+    if (item.folder) {
+        m_dirtyFolders << id;
+    }
+}
+
+void HotFolderSync::removeItem(const QString &id)
+{
+    const auto children = m_children.take(id);
+    for (const auto &childId : children) {
+        removeItem(childId);
+    }
+
+    const Item item = m_items.take(id);
+    m_children[item.parentId].remove(id);
+    m_dirtyFolders << item.parentId;
+    m_dirtyFolders.remove(id);
+    m_changedItems.remove(id);
+    m_downloadUrls.remove(id);
+    if (!item.folder) {
+        m_store->removeContent(id);
+    }
+}
+
+void HotFolderSync::invalidateSubtree(const QString &id)
+{
+    const QString path = pathOf(id);
+    if (path.isEmpty()) {
+        return;
+    }
+
+    m_store->invalidate(path);
+    m_changedItems << id;
+    if (m_items.value(id).folder) {
+        m_dirtyFolders << id;
+    }
+    const auto children = m_children.value(id);
+    for (const auto &childId : children) {
+        invalidateSubtree(childId);
+    }
+}
+
+QString HotFolderSync::pathOf(const QString &id) const
+{
+    if (id == m_folderId) {
+        return m_path;
+    }
+
+    QStringList names;
+    QString current = id;
+    for (int depth = 0; depth < MaxDepth; ++depth) {
+        const auto it = m_items.constFind(current);
+        if (it == m_items.constEnd()) {
+            // Outside of the folder, or not received yet.
+            return QString();
+        }
+        names.prepend(it->name);
+        if (it->parentId == m_folderId) {
+            return m_path + QLatin1Char('/') + names.join(QLatin1Char('/'));
+        }
+        current = it->parentId;
+    }
+    return QString();
+}
+
+KIO::UDSEntry HotFolderSync::entryOf(const QString &id, const QString &parentPath)
+{
+    Item &item = m_items[id];
+    if (item.entryPath != parentPath || item.entry.count() == 0) {
+        item.entry = OneDriveHelper::itemToUDSEntry(QJsonDocument::fromJson(item.json).object(), parentPath);
+        item.entryPath = parentPath;
+    }
+    return item.entry;
+}
+
+void HotFolderSync::updateStore()
+{
+    for (const auto &folderId : qAsConst(m_dirtyFolders)) {
+        const QString path = pathOf(folderId);
+        if (path.isEmpty() || (folderId != m_folderId && !m_items.value(folderId).folder)) {
+            continue;
+        }
+        KIO::UDSEntryList entries;
+        const auto children = m_children.value(folderId);
+        for (const auto &childId : children) {
+            const KIO::UDSEntry entry = entryOf(childId, path);
+            if (entry.count() > 0) {
+                entries << entry;
+            }
+        }
+        m_store->storeListing(path, entries, OfflineStore::Pinned);
+    }
+
+    for (const auto &id : qAsConst(m_changedItems)) {
+        const QString path = pathOf(id);
+        if (path.isEmpty()) {
+            continue;
+        }
+        m_store->storeEntry(path, entryOf(id, path.left(path.lastIndexOf(QLatin1Char('/')))), OfflineStore::Pinned);
+    }
+    m_dirtyFolders.clear();
+}
+
+bool HotFolderSync::updateContents()
+{
+    QMap<QString /* path */, QString /* id */> files;
+    for (auto it = m_items.constBegin(); it != m_items.constEnd(); ++it) {
+        if (!it->folder) {
+            const QString path = pathOf(it.key());
+            if (!path.isEmpty()) {
+                files.insert(path, it.key());
+            }
+        }
+    }
+
+    m_materializedBytes = 0;
+    qint64 planned = 0;
+    bool ok = true;
+    for (auto it = files.constBegin(); it != files.constEnd(); ++it) {
+        const QString id = it.value();
+        const Item item = m_items.value(id);
+        if (m_contentBudget >= 0 && planned + item.size > m_contentBudget) {
+            m_store->removeContent(id);
+            continue;
+        }
+        planned += item.size;
+
+        if (m_store->contentFile(id, item.modified).isEmpty()) {
+            // Keep going after a failure, to drop what no longer fits.
+            if (!ok || !download(id, item)) {
+                ok = false;
+                continue;
+            }
+        }
+        m_materializedBytes += item.size;
+    }
+    return ok;
+}
+
+bool HotFolderSync::download(const QString &id, const Item &item)
+{
+    if (item.size == 0) {
+        m_store->storeContent(id, item.modified, QByteArray(), OfflineStore::Pinned);
+        return true;
+    }
+
+    // Download URLs expire, only the ones received by this run are used as is.
+    QUrl url = m_downloadUrls.value(id);
+    if (url.isEmpty()) {
+        GraphRequest request(OneDriveHelper::networkAccessManager(), "GET", QStringLiteral("/items/%1").arg(id));
+        request.setAccount(m_account);
+        if (!request.exec()) {
+            m_statusCode = request.statusCode();
+            m_errorString = request.errorString();
+            return false;
+        }
+        url = QUrl(request.response().value(QStringLiteral("@microsoft.graph.downloadUrl")).toString());
+    }
+    if (url.isEmpty()) {
+        m_errorString = QStringLiteral("No download URL for %1").arg(id);
+        return false;
+    }
+
+    QTemporaryFile file;
+    if (!file.open()) {
+        m_errorString = file.errorString();
+        return false;
+    }
+    FileDownloader downloader(url, &file, 0, item.size);
+    if (!downloader.exec()) {
+        m_errorString = downloader.errorString();
+        return false;
+    }
+    file.flush();
+
+    m_store->storeContentFile(id, item.modified, file.fileName(), OfflineStore::Pinned);
+    m_downloadedBytes += item.size;
+    throttle();
+    return true;
+}
+
+void HotFolderSync::throttle()
+{
+    if (m_bandwidth <= 0) {
+        return;
+    }
+
+    // Waits until the average rate since the start of the run is back within the budget.
+    const qint64 wait = m_downloadedBytes * 1000 / m_bandwidth - m_runTimer.elapsed();
+    if (wait > 0) {
+        QEventLoop eventLoop;
+        QTimer::singleShot(int(wait), &eventLoop, &QEventLoop::quit);
+        eventLoop.exec();
+    }
+}
+
+bool HotFolderSync::loadState()
+{
+    QFile file(m_stateFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream(&file);
+    quint32 version = 0;
+    stream >> version;
+    if (version != StateVersion) {
+        return false;
+    }
+
+    QString folderId;
+    QString deltaLink;
+    quint32 count = 0;
+    stream >> folderId >> deltaLink >> count;
+    QHash<QString, Item> items;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+        QString id;
+        Item item;
+        stream >> id >> item.parentId >> item.name >> item.folder >> item.size >> item.modified >> item.json;
+        items.insert(id, item);
+    }
+    if (stream.status() != QDataStream::Ok) {
+        qCWarning(ONEDRIVE) << "Ignoring the corrupted sync state of" << m_path;
+        return false;
+    }
+
+    m_folderId = folderId;
+    m_deltaLink = deltaLink;
+    m_items = items;
+    m_children.clear();
+    for (auto it = m_items.constBegin(); it != m_items.constEnd(); ++it) {
+        m_children[it->parentId].insert(it.key());
+    }
+    return true;
+}
+
+void HotFolderSync::saveState() const
+{
+    QSaveFile file(m_stateFile);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(ONEDRIVE) << "Cannot write" << m_stateFile << ":" << file.errorString();
+        return;
+    }
+
+    QDataStream stream(&file);
+    stream << StateVersion << m_folderId << m_deltaLink << quint32(m_items.size());
+    for (auto it = m_items.constBegin(); it != m_items.constEnd(); ++it) {
+        stream << it.key() << it->parentId << it->name << it->folder << it->size << it->modified << it->json;
+    }
+    file.commit();
+}
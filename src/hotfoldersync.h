@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#pragma once
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QSet>
+#include <QUrl>
+
+#include <KIO/UDSEntry>
+#include <KMGraph/Account>
+
+class OfflineStore;
+
+/**
+ * Keeps a folder of the drive materialized in the OfflineStore: the listing
+ * of every folder below it, and the content of as many files as the content
+ * budget allows, so that the worker can serve them without any request.
+ *
+ * Each run() follows the change feed of the folder (its delta) from the link
+ * saved by the previous run, so only what changed since is fetched. The first
+ * run, and any run after the server asked for a resync, enumerates the whole
+ * folder instead.
+ */
+class HotFolderSync
+{
+public:
+    /**
+     * @param path Path of the folder, account included, e.g. "/foo@outlook.com/Documents".
+     * @param stateDirectory Where to persist the delta link and the index of the items.
+     */
+    HotFolderSync(const KMGraph2::AccountPtr &account, const QString &path,
+                  OfflineStore *store, const QString &stateDirectory);
+    ~HotFolderSync();
+
+    QString path() const;
+    void setAccount(const KMGraph2::AccountPtr &account);
+
+    /**
+     * Limits the contents kept for the folder to @p bytes, filled in the
+     * order of the paths. Other files are fetched from the network on use.
+     * -1, the default, means unlimited.
+     */
+    void setContentBudget(qint64 bytes);
+
+    /**
+     * Limits the average download rate of a run to @p bytesPerSecond.
+     * 0, the default, means unlimited.
+     */
+    void setBandwidth(qint64 bytesPerSecond);
+
+    /**
+     * Fetches what changed since the previous run and updates the store.
+     * Blocks until done.
+     * @return Whether the folder is in sync.
+     */
+    bool run();
+
+    /**
+     * Forgets the folder: its state, its mark and its pinned contents.
+     */
+    void clear();
+
+    /**
+     * @return The HTTP status of the request that failed the last run, or 0.
+     */
+    int statusCode() const;
+    QString errorString() const;
+
+    /**
+     * @return The number of changed items fetched by the last run.
+     */
+    int changeCount() const;
+    qint64 downloadedBytes() const;
+
+    /**
+     * @return The total size of the contents kept for the folder.
+     */
+    qint64 materializedBytes() const;
+
+    struct Item {
+        QString parentId;
+        QString name;
+        bool folder = false;
+        qint64 size = 0;
+        QDateTime modified;
+        /** The item as last received, compact JSON. */
+        QByteArray json;
+        /** Cached, valid for entryPath only. */
+        KIO::UDSEntry entry;
+        QString entryPath;
+    };
+
+private:
+    bool resolveFolder();
+    bool fetchChanges(QList<QJsonObject> *changes, QString *deltaLink);
+    void apply(const QJsonObject &change);
+    void removeItem(const QString &id);
+    void invalidateSubtree(const QString &id);
+    QString pathOf(const QString &id) const;
+    KIO::UDSEntry entryOf(const QString &id, const QString &parentPath);
+    void updateStore();
+    bool updateContents();
+    bool download(const QString &id, const Item &item);
+    void throttle();
+    bool loadState();
+    void saveState() const;
+
+    KMGraph2::AccountPtr m_account;
+    QString m_path;
+    OfflineStore *m_store;
+    QString m_stateFile;
+    qint64 m_contentBudget = -1;
+    qint64 m_bandwidth = 0;
+    bool m_stateLoaded = false;
+
+    QString m_folderId;
+    QString m_deltaLink;
+    QHash<QString, Item> m_items;
+    QHash<QString, QSet<QString>> m_children;
+
+    QSet<QString> m_dirtyFolders;
+    QSet<QString> m_changedItems;
+    QHash<QString, QUrl> m_downloadUrls;
+    QElapsedTimer m_runTimer;
+    int m_statusCode = 0;
+    QString m_errorString;
+    int m_changeCount = 0;
+    qint64 m_downloadedBytes = 0;
+    qint64 m_materializedBytes = 0;
+};
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef INFLIGHTTABLE_H
+#define INFLIGHTTABLE_H
+
+#include "onedrivedebug.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+
+#include <functional>
+
+/**
+ * Shares the result of a lookup with every identical lookup, keyed by
+ * (account, operation, target), instead of sending it to the server again.
+ *
+ * The worker runs one command at a time, so a duplicate can only show up once
+ * the first lookup completed: the result is then handed to identical lookups
+ * for @p window milliseconds, e.g. the stat(), mimetype() and get() a file
+ * manager sends in a row for the same file. Failed lookups and empty results
+ * are not shared, so that an item another client creates meanwhile is found,
+ * and callers clear() the table before changing anything on the server.
+ */
+template<typename T>
+class InflightTable
+{
+public:
+    explicit InflightTable(qint64 window = 1000)
+        : m_window(window)
+    {
+    }
+
+    /**
+     * Returns the shared result for the key, or else runs @p fetch, which
+     * must fill its argument and return whether the lookup succeeded.
+     * @p ok, when given, is set to that outcome, and @p shared to whether
+     * the result of an identical lookup was returned.
+     */
+    T run(const QString &account, const QString &operation, const QString &target,
+          const std::function<bool(T *)> &fetch, bool *ok = nullptr, bool *shared = nullptr)
+    {
+        const QString key = account + QLatin1Char('\n') + operation + QLatin1Char('\n') + target;
+
+        const auto it = m_entries.constFind(key);
+        if (it != m_entries.constEnd() && !it->age.hasExpired(m_window)) {
+            ++m_suppressed;
+            qCDebug(ONEDRIVE) << "Suppressed duplicate" << operation << target
+                              << "(" << m_suppressed << "of" << m_suppressed + m_issued << "lookups)";
+            if (ok) {
+                *ok = true;
+            }
+            if (shared) {
+                *shared = true;
+            }
+            return it->result;
+        }
+
+        ++m_issued;
+        T result = T();
+        const bool succeeded = fetch(&result);
+        if (succeeded && !(result == T())) {
+            Entry entry;
+            entry.result = result;
+            entry.age.start();
+            m_entries.insert(key, entry);
+        } else {
+            m_entries.remove(key);
+        }
+
+        if (ok) {
+            *ok = succeeded;
+        }
+        if (shared) {
+            *shared = false;
+        }
+        return result;
+    }
+
+    void clear()
+    {
+        m_entries.clear();
+    }
+
+    /**
+     * @return The number of lookups that were sent to the server.
+     */
+    quint64 issuedCount() const
+    {
+        return m_issued;
+    }
+
+    /**
+     * @return The number of lookups answered with the result of an identical one.
+     */
+    quint64 suppressedCount() const
+    {
+        return m_suppressed;
+    }
+
+private:
+    struct Entry {
+        T result;
+        QElapsedTimer age;
+    };
+
+    qint64 m_window;
+    QHash<QString, Entry> m_entries;
+    quint64 m_issued = 0;
+    quint64 m_suppressed = 0;
+};
+
+#endif // INFLIGHTTABLE_H
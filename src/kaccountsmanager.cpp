@@ -18,6 +18,7 @@
  */
 
 #include "kaccountsmanager.h"
+#include "credentialsstore.h"
 #include "onedrivedebug.h"
 
 #include <Accounts/Manager>
@@ -31,24 +32,72 @@
 
 using namespace KMGraph2;
 
+namespace {
+
+class KAccountsCredentialsStore : public CredentialsStore
+{
+protected:
+    KJob *createJob(quint32 id) override
+    {
+        return new GetCredentialsJob(id, nullptr);
+    }
+
+    QVariantMap credentialsData(KJob *job) const override
+    {
+        return static_cast<GetCredentialsJob*>(job)->credentialsData();
+    }
+};
+
+}
+
 KAccountsManager::KAccountsManager()
+    : m_credentials(new KAccountsCredentialsStore)
 {
-    loadAccounts();
+    // Rebuild the account index only when KAccounts tells us something changed.
+    auto manager = KAccounts::accountsManager();
+    const auto invalidate = [this](Accounts::AccountId) {
+        invalidateAccounts();
+    };
+    m_connections << QObject::connect(manager, &Accounts::Manager::accountCreated, invalidate)
+                  << QObject::connect(manager, &Accounts::Manager::accountRemoved, invalidate)
+                  << QObject::connect(manager, &Accounts::Manager::accountUpdated, invalidate)
+                  << QObject::connect(manager, &Accounts::Manager::enabledEvent, invalidate);
+
+    ensureAccountsLoaded();
 }
 
 KAccountsManager::~KAccountsManager()
-{}
+{
+    for (const auto &connection : qAsConst(m_connections)) {
+        QObject::disconnect(connection);
+    }
+}
 
 AccountPtr KAccountsManager::account(const QString &accountName)
 {
-    const auto accounts = m_accounts.values();
-    for (const auto &account : accounts) {
-        if (account->accountName() == accountName) {
-            return account;
+    const auto account = AbstractAccountManager::account(accountName);
+
+    const auto it = m_accountIds.constFind(accountName);
+    if (it != m_accountIds.constEnd()) {
+        m_credentials->load({*it});
+    }
+
+    return account;
+}
+
+void KAccountsManager::prepareAccounts(const QSet<QString> &accountNames)
+{
+    ensureAccountsLoaded();
+
+    QList<Accounts::AccountId> ids;
+    for (const auto &accountName : accountNames) {
+        const auto it = m_accountIds.constFind(accountName);
+        if (it != m_accountIds.constEnd()) {
+            ids << *it;
         }
     }
 
-    return AccountPtr(new Account());
+    m_credentials->load(ids);
 }
 
 AccountPtr KAccountsManager::createAccount()
@@ -63,7 +112,7 @@ AccountPtr KAccountsManager::createAccount()
     process.start(QStringLiteral("kcmshell5"), {QStringLiteral("kcm_kaccounts")});
     qCDebug(ONEDRIVE) << "Waiting for kcmshell process...";
     if (process.waitForFinished(-1)) {
-        loadAccounts();
+        invalidateAccounts();
     }
 
     const auto newAccounts = accounts();
@@ -92,41 +141,27 @@ AccountPtr KAccountsManager::refreshAccount(const AccountPtr &account)
 
 void KAccountsManager::removeAccount(const QString &accountName)
 {
-    if (!accounts().contains(accountName)) {
-        return;
-    }
+    ensureAccountsLoaded();
 
-    for (auto it = m_accounts.constBegin(); it != m_accounts.constEnd(); ++it) {
-        if (it.value()->accountName() != accountName) {
-            continue;
-        }
-
-        auto manager = KAccounts::accountsManager();
-        auto account = Accounts::Account::fromId(manager, it.key());
-        Q_ASSERT(account->displayName() == accountName);
-        qCDebug(ONEDRIVE) << "Going to remove account:" << account->displayName();
-        account->selectService(manager->service(QStringLiteral("microsoft-onedrive")));
-        account->setEnabled(false);
-        account->sync();
+    const auto it = m_accountIds.constFind(accountName);
+    if (it == m_accountIds.constEnd()) {
         return;
     }
-}
 
-QSet<QString> KAccountsManager::accounts()
-{
-    auto accountNames = QSet<QString>();
-
-    const auto accounts = m_accounts.values();
-    for (const auto &account : accounts) {
-        accountNames << account->accountName();
-    }
-
-    return accountNames;
+    auto manager = KAccounts::accountsManager();
+    auto account = Accounts::Account::fromId(manager, *it);
+    Q_ASSERT(account->displayName() == accountName);
+    qCDebug(ONEDRIVE) << "Going to remove account:" << account->displayName();
+    account->selectService(manager->service(QStringLiteral("microsoft-onedrive")));
+    account->setEnabled(false);
+    account->sync();
+    invalidateAccounts();
 }
 
 void KAccountsManager::loadAccounts()
 {
-    m_accounts.clear();
+    m_accountIds.clear();
+    m_credentials->clear();
 
     auto manager = KAccounts::accountsManager();
     const auto enabledIDs = manager->accountListEnabled();
@@ -143,19 +178,11 @@ void KAccountsManager::loadAccounts()
             }
             qCDebug(ONEDRIVE) << account->displayName() << "supports onedrive!";
 
-            auto job = new GetCredentialsJob(id, nullptr);
-            job->exec();
-
-            auto mgraphAccount = AccountPtr(new Account(account->displayName(),
-                                                      job->credentialsData().value(QStringLiteral("AccessToken")).toString(),
-                                                      job->credentialsData().value(QStringLiteral("RefreshToken")).toString()));
-
-            const auto scopes = job->credentialsData().value(QStringLiteral("Scope")).toStringList();
-            for (const auto &scope : scopes) {
-                mgraphAccount->addScope(QUrl::fromUserInput(scope));
-            }
-
-            m_accounts.insert(id, mgraphAccount);
+            // The credentials are fetched only once the account is actually used.
+            auto mgraphAccount = AccountPtr(new Account(account->displayName()));
+            m_credentials->addAccount(id, mgraphAccount);
+            m_accountIds.insert(mgraphAccount->accountName(), id);
+            insertAccount(mgraphAccount);
         }
     }
 }
@@ -21,10 +21,16 @@
 
 #include "abstractaccountmanager.h"
 
-#include <QMap>
+#include <QHash>
+#include <QList>
+#include <QMetaObject>
 
 #include <Accounts/Account>
 
+#include <memory>
+
+class CredentialsStore;
+
 class KAccountsManager : public AbstractAccountManager
 {
 public:
@@ -32,14 +38,17 @@ public:
     virtual ~KAccountsManager();
 
     KMGraph2::AccountPtr account(const QString &accountName) override;
+    void prepareAccounts(const QSet<QString> &accountNames) override;
     KMGraph2::AccountPtr createAccount() override;
     KMGraph2::AccountPtr refreshAccount(const KMGraph2::AccountPtr &account) override;
     void removeAccount(const QString &accountName) override;
-    QSet<QString> accounts() override;
 
-private:
-    void loadAccounts();
+protected:
+    void loadAccounts() override;
 
-    QMap<Accounts::AccountId, KMGraph2::AccountPtr> m_accounts;
+private:
+    QHash<QString /* accountName */, Accounts::AccountId> m_accountIds;
+    std::unique_ptr<CredentialsStore> m_credentials;
+    QList<QMetaObject::Connection> m_connections;
 };
 
@@ -18,43 +18,99 @@
  */
 
 #include "kio_onedrive.h"
+#include "backgrounduploader.h"
+#include "crossaccounttransfer.h"
+#include "drivenavigator.h"
+#include "filedownloader.h"
+#include "graphbatch.h"
+#include "graphrequest.h"
 #include "onedrivebackend.h"
 #include "onedrivedebug.h"
 #include "onedrivehelper.h"
 #include "onedriveurl.h"
 #include "onedriveversion.h"
+#include "requestscheduler.h"
+#include "subtreelisting.h"
+#include "tracer.h"
+#include "uploadsession.h"
 
 #include <QApplication>
+#include <QDataStream>
+#include <QDir>
+#include <QEventLoop>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMimeDatabase>
 #include <QUrlQuery>
 #include <QTemporaryFile>
 
 #include <KMGraph/Account>
-#include <KMGraph/OneDrive/About>
-#include <KMGraph/OneDrive/AboutFetchJob>
 #include <KMGraph/OneDrive/ChildReference>
-#include <KMGraph/OneDrive/ChildReferenceFetchJob>
 #include <KMGraph/OneDrive/File>
-#include <KMGraph/OneDrive/FileCopyJob>
-#include <KMGraph/OneDrive/FileCreateJob>
-#include <KMGraph/OneDrive/FileDeleteJob>
-#include <KMGraph/OneDrive/FileModifyJob>
-#include <KMGraph/OneDrive/FileFetchJob>
-#include <KMGraph/OneDrive/FileFetchContentJob>
-#include <KMGraph/OneDrive/FileSearchQuery>
-#include <KMGraph/OneDrive/ParentReference>
-#include <KMGraph/OneDrive/ParentReferenceDeleteJob>
-#include <KMGraph/OneDrive/ParentReferenceFetchJob>
 #include <KMGraph/OneDrive/Permission>
 #include <KIO/AccessManager>
+#include <KIO/Global>
 #include <KIO/Job>
+#include <KConfigGroup>
 #include <KLocalizedString>
+#include <KSharedConfig>
 
 #include <QNetworkRequest>
 #include <QNetworkReply>
+#include <QTimer>
+
+#include <fcntl.h>
+#include <utime.h>
 
 using namespace KMGraph2;
 using namespace OneDrive;
 
+// Hot folders are no longer trusted when the sync agent did not refresh
+// them for this long, in seconds, e.g. because it stopped.
+static const int HotFolderMaxAge = 600;
+
+// The folders of a subtree listed with ?recursive are then listed from the
+// offline store for this long, in seconds, e.g. while a file manager walks
+// the tree it just counted.
+static const int SubtreeMaxAge = 30;
+
+// Safe saves write "name.part", delete "name", and rename the former over
+// the latter. See KIOOneDrive::put().
+static const QLatin1String PartSuffix(".part");
+
+// The sync agent may be sending an upload the worker needs on the server,
+// the worker waits for it this long, in milliseconds.
+static const int UploadClaimTimeout = 10 * 60 * 1000;
+
+// Throttled requests are retried this many times, when the server asks to
+// wait no longer than MaxRetryAfter seconds. Without Retry-After, the
+// delays are 1, 2 and 4 seconds.
+static const int MaxThrottleRetries = 3;
+static const int MaxRetryAfter = 60;
+
+// The monitor of a copy is asked for its progress this often, in milliseconds.
+static const int CopyPollInterval = 1000;
+
+// The deletions queued by del() are sent once the worker was idle this long,
+// in seconds, see KIOOneDrive::queueDelete().
+static const int QueuedDeletesDelay = 1;
+
+static KIO::UDSEntry uploadToUDSEntry(const UploadJournal::Upload &upload)
+{
+    const QString name = upload.path.section(QLatin1Char('/'), -1);
+    KIO::UDSEntry entry;
+    entry.insert(KIO::UDSEntry::UDS_NAME, name);
+    entry.insert(KIO::UDSEntry::UDS_DISPLAY_NAME, name);
+    entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFREG);
+    entry.insert(KIO::UDSEntry::UDS_MIME_TYPE, QMimeDatabase().mimeTypeForFile(name, QMimeDatabase::MatchExtension).name());
+    entry.insert(KIO::UDSEntry::UDS_SIZE, upload.size);
+    entry.insert(KIO::UDSEntry::UDS_MODIFICATION_TIME, upload.queuedAt.toTime_t());
+    entry.insert(KIO::UDSEntry::UDS_ACCESS, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
+    return entry;
+}
+
 class KIOPluginForMetaData : public QObject
 {
     Q_OBJECT
@@ -81,10 +137,28 @@ extern "C"
 
 KIOOneDrive::KIOOneDrive(const QByteArray &protocol, const QByteArray &pool_socket,
                       const QByteArray &app_socket):
-    SlaveBase("onedrive", pool_socket, app_socket)
+    SlaveBase("onedrive", pool_socket, app_socket),
+    m_metrics(QString::fromLocal8Bit(qgetenv("ONEDRIVE_METRICS_DIR"))),
+    m_offline(OfflineStore::defaultDirectory()),
+    m_journal(UploadJournal::defaultDirectory())
 {
     Q_UNUSED(protocol);
 
+    // Shared with the sync agent, which sends the uploads.
+    const KConfigGroup writeBack(KSharedConfig::openConfig(QStringLiteral("onedrivesyncrc")), "WriteBack");
+    m_writeBack = writeBack.readEntry("Enabled", false);
+
+    // Copies of the contents are not encrypted, they are only kept on request.
+    const KConfigGroup offline(KSharedConfig::openConfig(QStringLiteral("onedrivesyncrc")), "Offline");
+    m_offline.setContentsStored(offline.readEntry("StoreContents", false));
+    m_offline.setContentBudget(offline.readEntry("ContentBudget", OfflineStore::DefaultContentBudget / (1024 * 1024)) * qint64(1024 * 1024));
+    m_offline.setMetadataBudget(offline.readEntry("MetadataBudget", OfflineStore::DefaultMetadataBudget / (1024 * 1024)) * qint64(1024 * 1024));
+
+    const QString traceDir = QString::fromLocal8Bit(qgetenv("ONEDRIVE_TRACE_DIR"));
+    if (!traceDir.isEmpty()) {
+        Tracer::enable(QDir(traceDir).filePath(QStringLiteral("kio_onedrive-%1.json").arg(QCoreApplication::applicationPid())));
+    }
+
     m_accountManager.reset(new AccountManager);
 
     qCDebug(ONEDRIVE) << "KIO OneDrive ready: version" << ONEDRIVE_VERSION_STRING;
@@ -92,52 +166,234 @@ KIOOneDrive::KIOOneDrive(const QByteArray &protocol, const QByteArray &pool_sock
 
 KIOOneDrive::~KIOOneDrive()
 {
+    if (Tracer::isEnabled()) {
+        Tracer::dump();
+    }
     closeConnection();
 }
 
-KIOOneDrive::Action KIOOneDrive::handleError(const KMGraph2::Job &job, const QUrl &url)
-{
-    qCDebug(ONEDRIVE) << "Job status code:" << job.error() << "- message:" << job.errorString();
-
-    switch (job.error()) {
-        case KMGraph2::OK:
-        case KMGraph2::NoError:
-            return Success;
-        case KMGraph2::AuthCancelled:
-        case KMGraph2::AuthError:
-            error(KIO::ERR_CANNOT_LOGIN, url.toDisplayString());
-            return Fail;
-        case KMGraph2::Unauthorized: {
-            const AccountPtr oldAccount = job.account();
-            const AccountPtr account = m_accountManager->refreshAccount(oldAccount);
-            if (!account) {
-                error(KIO::ERR_CANNOT_LOGIN, url.toDisplayString());
-                return Fail;
+bool KIOOneDrive::checkOnline(const QUrl &url)
+{
+    if (m_connectivity.isOnline()) {
+        return true;
+    }
+
+    error(KIO::ERR_CANNOT_CONNECT, url.toDisplayString());
+    return false;
+}
+
+KIOOneDrive::StoreUse KIOOneDrive::storeUse(const QUrl &url)
+{
+    if (!m_connectivity.isOnline()) {
+        return StoreOnly;
+    }
+
+    // Hot folders are kept in sync by the agent, as long as it runs.
+    QDateTime syncedAt;
+    if (m_offline.hotFolder(url.adjusted(QUrl::StripTrailingSlash).path(), &syncedAt)
+        && syncedAt.secsTo(QDateTime::currentDateTimeUtc()) < HotFolderMaxAge) {
+        return StoreFirst;
+    }
+
+    const QString path = url.adjusted(QUrl::StripTrailingSlash).path();
+    const QDateTime now = QDateTime::currentDateTimeUtc();
+    for (auto it = m_subtreesListedAt.begin(); it != m_subtreesListedAt.end();) {
+        if (it.value().secsTo(now) >= SubtreeMaxAge) {
+            it = m_subtreesListedAt.erase(it);
+            continue;
+        }
+        if (path == it.key() || path.startsWith(it.key() + QLatin1Char('/'))) {
+            return StoreFirst;
+        }
+        ++it;
+    }
+    return NetworkOnly;
+}
+
+void KIOOneDrive::invalidateStored(const QString &path)
+{
+    m_offline.invalidate(path);
+
+    // The other listings of a subtree may mention the item, or lie below it.
+    for (auto it = m_subtreesListedAt.begin(); it != m_subtreesListedAt.end();) {
+        if (path == it.key() || path.startsWith(it.key() + QLatin1Char('/')) || it.key().startsWith(path + QLatin1Char('/'))) {
+            it = m_subtreesListedAt.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool KIOOneDrive::storeMiss(const QUrl &url, StoreUse use)
+{
+    if (use != StoreOnly) {
+        return false;
+    }
+
+    error(KIO::ERR_CANNOT_CONNECT, url.toDisplayString());
+    return true;
+}
+
+void KIOOneDrive::setStoreMetaData(const QDateTime &storedAt, StoreUse use)
+{
+    if (use == StoreOnly) {
+        setMetaData(QStringLiteral("offline"), QStringLiteral("true"));
+    }
+    setMetaData(QStringLiteral("cachedAt"), storedAt.toString(Qt::ISODate));
+}
+
+QString KIOOneDrive::storedContent(const KIO::UDSEntry &entry) const
+{
+    // Only the version that was current when the entry was stored will do.
+    const QUrl entryUrl(entry.stringValue(KIO::UDSEntry::UDS_URL));
+    const QString fileId = QUrlQuery(entryUrl).queryItemValue(QStringLiteral("id"));
+    const QDateTime modified = QDateTime::fromTime_t(entry.numberValue(KIO::UDSEntry::UDS_MODIFICATION_TIME));
+    return m_offline.contentFile(fileId, modified);
+}
+
+bool KIOOneDrive::listDirFromStore(const QUrl &url, StoreUse use)
+{
+    KIO::UDSEntryList entries;
+    QDateTime storedAt;
+    if (!m_offline.listing(url.adjusted(QUrl::StripTrailingSlash).path(), &entries, &storedAt)) {
+        return false;
+    }
+
+    qCDebug(ONEDRIVE) << "Listing" << url << "from the offline store";
+    setStoreMetaData(storedAt, use);
+    const QString path = url.adjusted(QUrl::StripTrailingSlash).path();
+    const auto pending = pendingUploadEntries(path);
+    if (!pending.isEmpty()) {
+        KIO::UDSEntryList listed;
+        for (const auto &entry : qAsConst(entries)) {
+            if (!pending.contains(entry.stringValue(KIO::UDSEntry::UDS_NAME))) {
+                listed << entry;
             }
-            return Restart;
-        }
-        case KMGraph2::Forbidden:
-            error(KIO::ERR_ACCESS_DENIED, url.toDisplayString());
-            return Fail;
-        case KMGraph2::NotFound:
-            error(KIO::ERR_DOES_NOT_EXIST, url.toDisplayString());
-            return Fail;
-        case KMGraph2::NoContent:
-            error(KIO::ERR_NO_CONTENT, url.toDisplayString());
-            return Fail;
-        case KMGraph2::QuotaExceeded:
-            error(KIO::ERR_DISK_FULL, url.toDisplayString());
-            return Fail;
-        default:
-            error(KIO::ERR_SLAVE_DEFINED, job.errorString());
-            return Fail;
+        }
+        listEntries(listed + pending.values());
+    } else {
+        listEntries(entries);
+    }
+
+    for (const auto &entry : qAsConst(entries)) {
+        const QString fileId = QUrlQuery(QUrl(entry.stringValue(KIO::UDSEntry::UDS_URL))).queryItemValue(QStringLiteral("id"));
+        if (!fileId.isEmpty()) {
+            m_cache.insertPath(path + QLatin1Char('/') + entry.stringValue(KIO::UDSEntry::UDS_NAME), fileId);
+        }
     }
 
-    return Fail;
+    // Nothing can be written while offline.
+    KIO::UDSEntry entry;
+    entry.insert(KIO::UDSEntry::UDS_NAME, QStringLiteral("."));
+    entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFDIR);
+    entry.insert(KIO::UDSEntry::UDS_SIZE, 0);
+    if (use == StoreOnly) {
+        entry.insert(KIO::UDSEntry::UDS_ACCESS, S_IRUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH);
+    } else {
+        entry.insert(KIO::UDSEntry::UDS_ACCESS, S_IRUSR | S_IWUSR | S_IXUSR | S_IRGRP | S_IWGRP | S_IXGRP | S_IROTH | S_IXOTH);
+    }
+    listEntry(entry);
+
+    finished();
+    return true;
+}
+
+bool KIOOneDrive::statFromStore(const QUrl &url, StoreUse use)
+{
+    KIO::UDSEntry entry;
+    QDateTime storedAt;
+    if (!m_offline.entry(url.adjusted(QUrl::StripTrailingSlash).path(), &entry, &storedAt)) {
+        return false;
+    }
+
+    setStoreMetaData(storedAt, use);
+    statEntry(entry);
+    finished();
+    return true;
+}
+
+bool KIOOneDrive::mimetypeFromStore(const QUrl &url, StoreUse use)
+{
+    KIO::UDSEntry entry;
+    QDateTime storedAt;
+    if (!m_offline.entry(url.adjusted(QUrl::StripTrailingSlash).path(), &entry, &storedAt)) {
+        return false;
+    }
+
+    setStoreMetaData(storedAt, use);
+    mimeType(entry.isDir() ? QStringLiteral("inode/directory") : entry.stringValue(KIO::UDSEntry::UDS_MIME_TYPE));
+    finished();
+    return true;
+}
+
+bool KIOOneDrive::getFromStore(const QUrl &url, StoreUse use)
+{
+    KIO::UDSEntry entry;
+    QDateTime storedAt;
+    if (!m_offline.entry(url.adjusted(QUrl::StripTrailingSlash).path(), &entry, &storedAt)) {
+        return false;
+    }
+    if (entry.isDir()) {
+        error(KIO::ERR_IS_DIRECTORY, url.path());
+        return true;
+    }
+
+    QFile file(storedContent(entry));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    qCDebug(ONEDRIVE) << "Reading" << url << "from the offline store";
+    setStoreMetaData(storedAt, use);
+    mimeType(entry.stringValue(KIO::UDSEntry::UDS_MIME_TYPE));
+    totalSize(file.size());
+    while (!file.atEnd()) {
+        data(file.read(1024 * 1024));
+    }
+    data(QByteArray());
+    finished();
+    return true;
+}
+
+bool KIOOneDrive::copyToFileFromStore(const QUrl &src, const QUrl &dest, KIO::JobFlags flags, StoreUse use)
+{
+    KIO::UDSEntry entry;
+    QDateTime storedAt;
+    if (!m_offline.entry(src.adjusted(QUrl::StripTrailingSlash).path(), &entry, &storedAt)) {
+        return false;
+    }
+    if (entry.isDir()) {
+        error(KIO::ERR_IS_DIRECTORY, src.path());
+        return true;
+    }
+    const QString fileName = storedContent(entry);
+    if (fileName.isEmpty()) {
+        return false;
+    }
+
+    const QString destPath = dest.toLocalFile();
+    if (QFileInfo::exists(destPath)) {
+        if (!(flags & KIO::Overwrite)) {
+            error(KIO::ERR_FILE_ALREADY_EXIST, destPath);
+            return true;
+        }
+        QFile::remove(destPath);
+    }
+    if (!QFile::copy(fileName, destPath)) {
+        error(KIO::ERR_CANNOT_WRITE, destPath);
+        return true;
+    }
+
+    setStoreMetaData(storedAt, use);
+    processedSize(QFileInfo(destPath).size());
+    finished();
+    return true;
 }
 
 void KIOOneDrive::fileSystemFreeSpace(const QUrl &url)
 {
+    Metrics::Timer timer(&m_metrics, Metrics::Command, "freespace");
+
     const auto onedriveUrl = OneDriveUrl(url);
     const QString accountId = onedriveUrl.account();
     if (accountId == QLatin1String("new-account")) {
@@ -145,20 +401,40 @@ void KIOOneDrive::fileSystemFreeSpace(const QUrl &url)
         return;
     }
     if (!onedriveUrl.isRoot()) {
-        AboutFetchJob aboutFetch(getAccount(accountId));
-        if (runJob(aboutFetch, url, accountId)) {
-            const AboutPtr about = aboutFetch.aboutData();
-            if (about) {
-                setMetaData(QStringLiteral("total"), QString::number(about->quotaBytesTotal()));
-                setMetaData(QStringLiteral("available"), QString::number(about->quotaBytesTotal() - about->quotaBytesUsedAggregate()));
-                finished();
-                return;
-            }
+        qint64 total = 0;
+        qint64 used = 0;
+        const bool cached = m_quotas.lookup(accountId, &total, &used);
+        m_metrics.add(cached ? Metrics::QuotaCacheHits : Metrics::QuotaCacheMisses);
+        if (cached || (fetchQuota(accountId, url) && m_quotas.lookup(accountId, &total, &used))) {
+            setMetaData(QStringLiteral("total"), QString::number(total));
+            setMetaData(QStringLiteral("available"), QString::number(total - used));
+            finished();
+            return;
         }
     }
     error(KIO::ERR_CANNOT_STAT, url.toDisplayString());
 }
 
+bool KIOOneDrive::fetchQuota(const QString &accountId, const QUrl &url)
+{
+    GraphRequest request(OneDriveHelper::networkAccessManager(), "GET", QString());
+    QUrlQuery query;
+    query.addQueryItem(QStringLiteral("$select"), QStringLiteral("quota"));
+    request.setQuery(query);
+    if (!runGraphRequest(request, url, accountId)) {
+        return false;
+    }
+
+    const QJsonObject quota = request.response().value(QStringLiteral("quota")).toObject();
+    if (quota.isEmpty()) {
+        return false;
+    }
+
+    m_quotas.insert(accountId, qint64(quota.value(QStringLiteral("total")).toDouble()),
+                    qint64(quota.value(QStringLiteral("used")).toDouble()));
+    return true;
+}
+
 AccountPtr KIOOneDrive::getAccount(const QString &accountName)
 {
     return m_accountManager->account(accountName);
@@ -177,54 +453,32 @@ void KIOOneDrive::virtual_hook(int id, void *data)
     }
 }
 
-KIO::UDSEntry KIOOneDrive::fileToUDSEntry(const FilePtr &origFile, const QString &path) const
+void KIOOneDrive::openConnection()
 {
-    KIO::UDSEntry entry;
-    bool isFolder = false;
-
-    FilePtr file = origFile;
-    if (OneDriveHelper::isGDocsDocument(file)) {
-        OneDriveHelper::convertFromGDocs(file);
-    }
-
-    entry.insert(KIO::UDSEntry::UDS_NAME, file->title());
-    entry.insert(KIO::UDSEntry::UDS_DISPLAY_NAME, file->title());
-    entry.insert(KIO::UDSEntry::UDS_COMMENT, file->description());
-
-    if (file->isFolder()) {
-        entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFDIR);
-        entry.insert(KIO::UDSEntry::UDS_SIZE, 0);
-        isFolder = true;
-    } else {
-        entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFREG);
-        entry.insert(KIO::UDSEntry::UDS_MIME_TYPE, file->mimeType());
-        entry.insert(KIO::UDSEntry::UDS_SIZE, file->fileSize());
-        entry.insert(KIO::UDSEntry::UDS_URL, QStringLiteral("onedrive://%1/%2?id=%3").arg(path, origFile->title(), origFile->id()));
-    }
-
-    entry.insert(KIO::UDSEntry::UDS_CREATION_TIME, file->createdDate().toTime_t());
-    entry.insert(KIO::UDSEntry::UDS_MODIFICATION_TIME, file->modifiedDate().toTime_t());
-    entry.insert(KIO::UDSEntry::UDS_ACCESS_TIME, file->lastViewedByMeDate().toTime_t());
-    if (!file->ownerNames().isEmpty()) {
-        entry.insert(KIO::UDSEntry::UDS_USER, file->ownerNames().first());
-    }
-
-    if (!isFolder) {
-        if (file->editable()) {
-            entry.insert(KIO::UDSEntry::UDS_ACCESS, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
-        } else {
-            entry.insert(KIO::UDSEntry::UDS_ACCESS, S_IRUSR | S_IRGRP | S_IROTH);
-        }
-    } else {
-        entry.insert(KIO::UDSEntry::UDS_ACCESS, S_IRUSR | S_IWUSR | S_IXUSR | S_IRGRP | S_IWGRP | S_IXGRP | S_IROTH | S_IXOTH);
-    }
+    qCDebug(ONEDRIVE) << "Ready to talk to OneDrive";
+}
 
-    return entry;
+void KIOOneDrive::closeConnection()
+{
+    sendQueuedDeletes();
 }
 
-void KIOOneDrive::openConnection()
+void KIOOneDrive::dispatch(int command, const QByteArray &data)
 {
-    qCDebug(ONEDRIVE) << "Ready to talk to OneDrive";
+    m_errorReported = false;
+    switch (command) {
+        // Sent along with the commands, not commands of their own.
+        case KIO::CMD_HOST:
+        case KIO::CMD_CONFIG:
+        case KIO::CMD_META_DATA:
+        case KIO::CMD_SLAVE_STATUS:
+        // The next deletion of a DeleteJob, queued in turn.
+        case KIO::CMD_DEL:
+            break;
+        default:
+            flushQueuedDeletes();
+    }
+    SlaveBase::dispatch(command, data);
 }
 
 KIO::UDSEntry KIOOneDrive::accountToUDSEntry(const QString &accountNAme)
@@ -321,6 +575,7 @@ int RecursionDepthCounter::sDepth = 0;
 
 QString KIOOneDrive::resolveFileIdFromPath(const QString &path, PathFlags flags)
 {
+    Tracer::Span span("resolveFileIdFromPath");
     qCDebug(ONEDRIVE) << Q_FUNC_INFO << path;
 
     if (path.isEmpty()) {
@@ -329,9 +584,11 @@ QString KIOOneDrive::resolveFileIdFromPath(const QString &path, PathFlags flags)
 
     QString fileId = m_cache.idForPath(path);
     if (!fileId.isEmpty()) {
+        m_metrics.add(Metrics::PathCacheHits);
         qCDebug(ONEDRIVE) << "Resolved" << path << "to" << fileId << "(from cache)";
         return fileId;
     }
+    m_metrics.add(Metrics::PathCacheMisses);
 
     QUrl url;
     url.setScheme(QStringLiteral("onedrive"));
@@ -340,7 +597,7 @@ QString KIOOneDrive::resolveFileIdFromPath(const QString &path, PathFlags flags)
     Q_ASSERT(!onedriveUrl.isRoot());
 
     const QStringList components = onedriveUrl.pathComponents();
-    if (onedriveUrl.isAccountRoot() || (components.size() == 2 && components[1] == QLatin1String("trash"))) {
+    if (onedriveUrl.isAccountRoot()) {
         qCDebug(ONEDRIVE) << "Resolved" << path << "to \"root\"";
         return rootFolderId(components[0]);
     }
@@ -353,56 +610,141 @@ QString KIOOneDrive::resolveFileIdFromPath(const QString &path, PathFlags flags)
         return QString();
     }
 
-    FileSearchQuery query;
-    if (flags != KIOOneDrive::None) {
-        query.addQuery(FileSearchQuery::MimeType,
-                       (flags & KIOOneDrive::PathIsFolder ? FileSearchQuery::Equals : FileSearchQuery::NotEquals),
-                       OneDriveHelper::folderMimeType());
-    }
-    query.addQuery(FileSearchQuery::Title, FileSearchQuery::Equals, components.last());
-    query.addQuery(FileSearchQuery::Parents, FileSearchQuery::In, parentId);
-    query.addQuery(FileSearchQuery::Trashed, FileSearchQuery::Equals, components[1] == QLatin1String("trash"));
-
     const QString accountId = onedriveUrl.account();
-    FileFetchJob fetchJob(query, getAccount(accountId));
-    fetchJob.setFields(FileFetchJob::Id | FileFetchJob::Title | FileFetchJob::Labels);
-    if (!runJob(fetchJob, url, accountId)) {
-        return QString();
-    }
+    bool shared = false;
+    fileId = m_resolveFlights.run(accountId, QStringLiteral("resolve%1").arg(flags), path, [&](QString *id) {
+        const DriveNavigator::ItemKind kind = flags & KIOOneDrive::PathIsFolder ? DriveNavigator::FolderItem
+                                            : flags & KIOOneDrive::PathIsFile ? DriveNavigator::FileItem
+                                            : DriveNavigator::AnyItem;
+        QJsonObject item;
+        if (!navigator(url, accountId).child(parentId, components.last(), kind, &item)) {
+            return false;
+        }
+
+        *id = item.value(QStringLiteral("id")).toString();
+        return true;
+    }, nullptr, &shared);
+    m_metrics.add(shared ? Metrics::ResolveLookupsShared : Metrics::ResolveLookupsSent);
 
-    const ObjectsList objects = fetchJob.items();
-    qCDebug(ONEDRIVE) << objects;
-    if (objects.count() == 0) {
+    if (fileId.isEmpty()) {
         qCWarning(ONEDRIVE) << "Failed to resolve" << path;
         return QString();
     }
 
-    const FilePtr file = objects[0].dynamicCast<File>();
+    m_cache.insertPath(path, fileId);
+
+    qCDebug(ONEDRIVE) << "Resolved" << path << "to" << fileId << "(from network)";
+    return fileId;
+}
+
+QString KIOOneDrive::fileIdForUrl(const QUrl &url, PathFlags flags)
+{
+    const QUrlQuery urlQuery(url);
+    if (urlQuery.hasQueryItem(QStringLiteral("id"))) {
+        return urlQuery.queryItemValue(QStringLiteral("id"));
+    }
+
+    return resolveFileIdFromPath(url.adjusted(QUrl::StripTrailingSlash).path(), flags);
+}
+
+FilePtr KIOOneDrive::fetchFile(const QString &fileId, const QUrl &url, const QString &accountId, QJsonObject *item)
+{
+    bool shared = false;
+    const QJsonObject json = m_fetchFlights.run(accountId, QStringLiteral("fetch"), fileId, [&](QJsonObject *result) {
+        return navigator(url, accountId).item(fileId, result);
+    }, nullptr, &shared);
+    m_metrics.add(shared ? Metrics::FetchLookupsShared : Metrics::FetchLookupsSent);
+    if (item) {
+        *item = json;
+    }
+    return json.isEmpty() ? FilePtr() : File::fromJSON(QJsonDocument(json).toJson());
+}
+
+DriveNavigator KIOOneDrive::navigator(const QUrl &url, const QString &accountId)
+{
+    return DriveNavigator(getAccount(accountId), [this, url, accountId](GraphRequest &request) {
+        return runGraphRequest(request, url, accountId);
+    });
+}
+
+QJsonObject KIOOneDrive::uploadContent(const QString &itemPath, QIODevice *content, qint64 size,
+                                       const QUrl &url, const QString &accountId, const QDateTime &modified)
+{
+    if (size > UploadSession::SimpleUploadLimit) {
+        return uploadInSession(itemPath, content, size, url, accountId, modified);
+    }
+
+    GraphRequest request(OneDriveHelper::networkAccessManager(), "PUT", itemPath + QStringLiteral("/content"));
+    request.setContent(content->readAll());
+    if (!runGraphRequest(request, url, accountId)) {
+        return QJsonObject();
+    }
+    if (!modified.isValid()) {
+        return request.response();
+    }
+
+    // Unlike an upload session, a single request cannot carry the
+    // modification time.
+    QJsonObject fileSystemInfo;
+    fileSystemInfo.insert(QStringLiteral("lastModifiedDateTime"), modified.toUTC().toString(Qt::ISODate));
+    QJsonObject patch;
+    patch.insert(QStringLiteral("fileSystemInfo"), fileSystemInfo);
+    GraphRequest modify(OneDriveHelper::networkAccessManager(), "PATCH",
+                        QStringLiteral("/items/%1").arg(request.response().value(QStringLiteral("id")).toString()), patch);
+    if (!runGraphRequest(modify, url, accountId)) {
+        return QJsonObject();
+    }
+    return modify.response();
+}
 
-    m_cache.insertPath(path, file->id());
+QJsonObject KIOOneDrive::uploadInSession(const QString &itemPath, QIODevice *content, qint64 size,
+                                         const QUrl &url, const QString &accountId, const QDateTime &modified)
+{
+    UploadSession session(getAccount(accountId), itemPath, [this, url, accountId](GraphRequest &request) {
+        return runGraphRequest(request, url, accountId);
+    });
+    session.setModifiedDate(modified);
+    QObject::connect(&session, &UploadSession::processed, [this](qint64 bytes) {
+        processedSize(bytes);
+    });
+    if (!session.exec(content, size)) {
+        // A failure to create the session was reported like any other request.
+        if (!m_errorReported) {
+            if (session.statusCode() == 507) {
+                error(KIO::ERR_DISK_FULL, url.path());
+            } else {
+                error(KIO::ERR_SLAVE_DEFINED, session.errorString());
+            }
+        }
+        return QJsonObject();
+    }
+    return session.item();
+}
 
-    qCDebug(ONEDRIVE) << "Resolved" << path << "to" << file->id() << "(from network)";
-    return file->id();
+void KIOOneDrive::clearLookups()
+{
+    m_resolveFlights.clear();
+    m_fetchFlights.clear();
 }
 
 QString KIOOneDrive::rootFolderId(const QString &accountId)
 {
     auto it = m_rootIds.constFind(accountId);
     if (it == m_rootIds.cend()) {
-        AboutFetchJob aboutFetch(getAccount(accountId));
-        QUrl url;
-        if (!runJob(aboutFetch, url, accountId)) {
+        GraphRequest request(OneDriveHelper::networkAccessManager(), "GET", QStringLiteral("/root"));
+        QUrlQuery query;
+        query.addQueryItem(QStringLiteral("$select"), QStringLiteral("id"));
+        request.setQuery(query);
+        if (!runGraphRequest(request, QUrl(), accountId)) {
             return QString();
         }
 
-        const AboutPtr about = aboutFetch.aboutData();
-        if (!about || about->rootFolderId().isEmpty()) {
+        const QString rootId = request.response().value(QStringLiteral("id")).toString();
+        if (rootId.isEmpty()) {
             qCWarning(ONEDRIVE) << "Failed to obtain root ID";
             return QString();
         }
-
-        auto v = m_rootIds.insert(accountId, about->rootFolderId());
-        return *v;
+        it = m_rootIds.insert(accountId, rootId);
     }
 
     return *it;
@@ -410,6 +752,8 @@ QString KIOOneDrive::rootFolderId(const QString &accountId)
 
 void KIOOneDrive::listDir(const QUrl &url)
 {
+    Metrics::Timer timer(&m_metrics, Metrics::Command, "listDir");
+
     qCDebug(ONEDRIVE) << "Going to list" << url;
 
     const auto onedriveUrl = OneDriveUrl(url);
@@ -423,7 +767,20 @@ void KIOOneDrive::listDir(const QUrl &url)
     if (onedriveUrl.isRoot())  {
         listAccounts();
         return;
-    } else if (onedriveUrl.isAccountRoot()) {
+    }
+    if (onedriveUrl.isSearch()) {
+        search(url);
+        return;
+    }
+    if (onedriveUrl.isRecursive()) {
+        listRecursive(url);
+        return;
+    }
+    const StoreUse use = storeUse(url);
+    if (use != NetworkOnly && (listDirFromStore(url, use) || storeMiss(url, use))) {
+        return;
+    }
+    if (onedriveUrl.isAccountRoot()) {
         folderId = rootFolderId(accountId);
     } else {
         folderId = m_cache.idForPath(url.path());
@@ -437,27 +794,33 @@ void KIOOneDrive::listDir(const QUrl &url)
         }
     }
 
-    FileSearchQuery query;
-    query.addQuery(FileSearchQuery::Trashed, FileSearchQuery::Equals, false);
-    query.addQuery(FileSearchQuery::Parents, FileSearchQuery::In, folderId);
-    FileFetchJob fileFetchJob(query, getAccount(accountId));
-    fileFetchJob.setFields((FileFetchJob::BasicFields & ~FileFetchJob::Permissions)
-                            | FileFetchJob::Labels
-                            | FileFetchJob::ExportLinks
-                            | FileFetchJob::LastViewedByMeDate);
-    runJob(fileFetchJob, url, accountId);
-
-    ObjectsList objects = fileFetchJob.items();
-    Q_FOREACH (const ObjectPtr &object, objects) {
-        const FilePtr file = object.dynamicCast<File>();
+    const QString path = url.path().endsWith(QLatin1Char('/')) ? url.path() : url.path() + QLatin1Char('/');
+    const auto pending = pendingUploadEntries(url.adjusted(QUrl::StripTrailingSlash).path());
+    KIO::UDSEntryList entries;
+    const bool listed = navigator(url, accountId).children(folderId, [&](const QJsonObject &item) {
+        const KIO::UDSEntry entry = OneDriveHelper::itemToUDSEntry(item, url.adjusted(QUrl::StripTrailingSlash).path());
+        if (entry.count() == 0) {
+            return;
+        }
 
-        const KIO::UDSEntry entry = fileToUDSEntry(file, url.adjusted(QUrl::StripTrailingSlash).path());
-        listEntry(entry);
+        const QString name = item.value(QStringLiteral("name")).toString();
+        if (!pending.contains(name)) {
+            Tracer::Span span("SlaveBase::listEntry");
+            listEntry(entry);
+        }
+        entries << entry;
 
-        const QString path = url.path().endsWith(QLatin1Char('/')) ? url.path() : url.path() + QLatin1Char('/');
-        m_cache.insertPath(path + file->title(), file->id());
+        // A drive item is in a single folder, the one listed.
+        m_cache.insertPath(path + name, item.value(QStringLiteral("id")).toString());
+        m_cache.setParentsCount(path + name, 1);
+    });
+    if (!listed) {
+        return;
     }
 
+    m_offline.storeListing(url.adjusted(QUrl::StripTrailingSlash).path(), entries);
+    listEntries(pending.values());
+
     // We also need a non-null and writable UDSentry for "."
     KIO::UDSEntry entry;
     entry.insert(KIO::UDSEntry::UDS_NAME, QStringLiteral("."));
@@ -470,52 +833,245 @@ void KIOOneDrive::listDir(const QUrl &url)
 }
 
 
-void KIOOneDrive::mkdir(const QUrl &url, int permissions)
+void KIOOneDrive::search(const QUrl &url)
 {
-    // NOTE: We deliberately ignore the permissions field here, because OneDrive
-    // does not recognize any privileges that could be mapped to standard UNIX
-    // file permissions.
-    Q_UNUSED(permissions);
-
-    qCDebug(ONEDRIVE) << "Creating directory" << url;
+    if (!checkOnline(url)) {
+        return;
+    }
 
     const auto onedriveUrl = OneDriveUrl(url);
     const QString accountId = onedriveUrl.account();
-    // At least account and new folder name
-    if (onedriveUrl.isRoot() || onedriveUrl.isAccountRoot()) {
-        error(KIO::ERR_DOES_NOT_EXIST, url.path());
-        return;
-    }
-    QString parentId;
-    const auto components = onedriveUrl.pathComponents();
-    if (components.size() == 2) {
-        parentId = rootFolderId(accountId);
-    } else {
-        parentId = resolveFileIdFromPath(onedriveUrl.parentPath(), KIOOneDrive::PathIsFolder);
-    }
+    const QString folderPath = url.adjusted(QUrl::StripTrailingSlash | QUrl::RemoveQuery).path();
+    qCDebug(ONEDRIVE) << "Searching" << folderPath << "for" << onedriveUrl.searchTerm();
 
-    if (parentId.isEmpty()) {
-        error(KIO::ERR_DOES_NOT_EXIST, url.path());
-        return;
+    QString folderId;
+    if (!onedriveUrl.isAccountRoot()) {
+        folderId = m_cache.idForPath(folderPath);
+        if (folderId.isEmpty()) {
+            folderId = resolveFileIdFromPath(folderPath, KIOOneDrive::PathIsFolder);
+        }
+        if (folderId.isEmpty()) {
+            error(KIO::ERR_DOES_NOT_EXIST, folderPath);
+            return;
+        }
     }
 
-    const QString folderName = components.last();
-
-    FilePtr file(new File());
-    file->setTitle(folderName);
-    file->setMimeType(File::folderMimeType());
+    // Each page is listed as soon as it arrives, so that the first matches
+    // show up while the server is still looking for more.
+    QUrl next;
+    do {
+        GraphRequest request(OneDriveHelper::networkAccessManager(), "GET",
+                             OneDriveHelper::searchPath(folderId, onedriveUrl.searchTerm()));
+        if (next.isValid()) {
+            request.setUrl(next);
+        }
+        if (!runGraphRequest(request, url, accountId)) {
+            return;
+        }
 
-    ParentReferencePtr parent(new ParentReference(parentId));
-    file->setParents(ParentReferencesList() << parent);
+        const QJsonObject response = request.response();
+        const auto values = response.value(QStringLiteral("value")).toArray();
+        for (const auto &value : values) {
+            const QJsonObject item = value.toObject();
+
+            // Matches come from anywhere below the folder.
+            const QString filePath = OneDriveHelper::itemPath(item, accountId);
+            const QString parentPath = filePath.isEmpty() ? folderPath : filePath.left(filePath.lastIndexOf(QLatin1Char('/')));
+            KIO::UDSEntry entry = OneDriveHelper::itemToUDSEntry(item, parentPath);
+            if (entry.count() == 0) {
+                continue;
+            }
+            // Names are only unique within a folder, the matches are told
+            // apart by ID and opened through their URL.
+            const QString id = item.value(QStringLiteral("id")).toString();
+            entry.insert(KIO::UDSEntry::UDS_NAME, id);
+            if (entry.isDir() && !filePath.isEmpty()) {
+                QUrl folderUrl;
+                folderUrl.setScheme(QStringLiteral("onedrive"));
+                folderUrl.setPath(filePath);
+                entry.insert(KIO::UDSEntry::UDS_URL, folderUrl.toString());
+            }
+            {
+                Tracer::Span span("SlaveBase::listEntry");
+                listEntry(entry);
+            }
+
+            if (!filePath.isEmpty()) {
+                m_cache.insertPath(filePath, id);
+            }
+        }
+
+        next = QUrl(response.value(QStringLiteral("@odata.nextLink")).toString());
+    } while (next.isValid());
+
+    KIO::UDSEntry entry;
+    entry.insert(KIO::UDSEntry::UDS_NAME, QStringLiteral("."));
+    entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFDIR);
+    entry.insert(KIO::UDSEntry::UDS_SIZE, 0);
+    entry.insert(KIO::UDSEntry::UDS_ACCESS, S_IRUSR | S_IXUSR | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH);
+    listEntry(entry);
+
+    finished();
+}
+
+
+void KIOOneDrive::listRecursive(const QUrl &url)
+{
+    if (!checkOnline(url)) {
+        return;
+    }
+
+    const auto onedriveUrl = OneDriveUrl(url);
+    const QString accountId = onedriveUrl.account();
+    const QString folderPath = url.adjusted(QUrl::StripTrailingSlash | QUrl::RemoveQuery).path();
+    qCDebug(ONEDRIVE) << "Listing the subtree of" << folderPath;
+
+    QString folderId;
+    if (!onedriveUrl.isAccountRoot()) {
+        folderId = m_cache.idForPath(folderPath);
+        if (folderId.isEmpty()) {
+            folderId = resolveFileIdFromPath(folderPath, KIOOneDrive::PathIsFolder);
+        }
+        if (folderId.isEmpty()) {
+            error(KIO::ERR_DOES_NOT_EXIST, folderPath);
+            return;
+        }
+    }
+
+    // Enumerating the change feed from scratch gives every item below the
+    // folder, a page of a few hundred at a time.
+    SubtreeListing listing(folderId);
+    QHash<QString, KIO::UDSEntryList> listings;
+    listings.insert(folderPath, KIO::UDSEntryList());
+    QUrl next;
+    do {
+        GraphRequest request(OneDriveHelper::networkAccessManager(), "GET",
+                             folderId.isEmpty() ? QStringLiteral("/root/delta") : QStringLiteral("/items/%1/delta").arg(folderId));
+        if (next.isValid()) {
+            request.setUrl(next);
+        }
+        if (!runGraphRequest(request, url, accountId)) {
+            return;
+        }
+
+        const QJsonObject response = request.response();
+        const auto values = response.value(QStringLiteral("value")).toArray();
+        for (const auto &value : values) {
+            const auto nodes = listing.add(value.toObject());
+            for (const auto &node : nodes) {
+                const QString path = folderPath + QLatin1Char('/') + node.relativePath;
+                const QString parentPath = path.left(path.lastIndexOf(QLatin1Char('/')));
+                KIO::UDSEntry entry = OneDriveHelper::itemToUDSEntry(node.item, parentPath);
+                if (entry.count() == 0) {
+                    continue;
+                }
+                listings[parentPath] << entry;
+                if (node.folder) {
+                    listings.insert(path, KIO::UDSEntryList());
+                }
+                m_cache.insertPath(path, node.id);
+                m_cache.setParentsCount(path, 1);
+
+                entry.insert(KIO::UDSEntry::UDS_NAME, node.relativePath);
+                {
+                    Tracer::Span span("SlaveBase::listEntry");
+                    listEntry(entry);
+                }
+            }
+        }
+
+        next = QUrl(response.value(QStringLiteral("@odata.nextLink")).toString());
+    } while (next.isValid());
+
+    if (listing.pendingCount() > 0) {
+        qCWarning(ONEDRIVE) << listing.pendingCount() << "items of" << folderPath << "have no known parent, skipped";
+    }
+
+    // Every folder of the subtree was listed in full.
+    for (auto it = listings.constBegin(); it != listings.constEnd(); ++it) {
+        m_offline.storeListing(it.key(), it.value());
+    }
+    if (m_offline.isEnabled()) {
+        m_subtreesListedAt.insert(folderPath, QDateTime::currentDateTimeUtc());
+    }
+
+    KIO::UDSEntry entry;
+    entry.insert(KIO::UDSEntry::UDS_NAME, QStringLiteral("."));
+    entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFDIR);
+    entry.insert(KIO::UDSEntry::UDS_SIZE, 0);
+    entry.insert(KIO::UDSEntry::UDS_ACCESS, S_IRUSR | S_IWUSR | S_IXUSR | S_IRGRP | S_IWGRP | S_IXGRP | S_IROTH | S_IXOTH);
+    listEntry(entry);
+
+    finished();
+}
+
+
+void KIOOneDrive::mkdir(const QUrl &url, int permissions)
+{
+    Metrics::Timer timer(&m_metrics, Metrics::Command, "mkdir");
+    clearLookups();
+    if (!checkOnline(url)) {
+        return;
+    }
+    invalidateStored(url.path());
+
+    // NOTE: We deliberately ignore the permissions field here, because OneDrive
+    // does not recognize any privileges that could be mapped to standard UNIX
+    // file permissions.
+    Q_UNUSED(permissions);
+
+    qCDebug(ONEDRIVE) << "Creating directory" << url;
+
+    const auto onedriveUrl = OneDriveUrl(url);
+    const QString accountId = onedriveUrl.account();
+    // At least account and new folder name
+    if (onedriveUrl.isRoot() || onedriveUrl.isAccountRoot()) {
+        error(KIO::ERR_DOES_NOT_EXIST, url.path());
+        return;
+    }
+    QString parentId;
+    const auto components = onedriveUrl.pathComponents();
+    if (components.size() == 2) {
+        parentId = rootFolderId(accountId);
+    } else {
+        parentId = resolveFileIdFromPath(onedriveUrl.parentPath(), KIOOneDrive::PathIsFolder);
+    }
+
+    if (parentId.isEmpty()) {
+        // Unless the lookup failed, the parent is missing: KIO creates the
+        // parents first when asked to.
+        if (!m_errorReported) {
+            error(KIO::ERR_DOES_NOT_EXIST, url.path());
+        }
+        return;
+    }
+
+    QJsonObject folder;
+    folder.insert(QStringLiteral("name"), components.last());
+    folder.insert(QStringLiteral("folder"), QJsonObject());
+    folder.insert(QStringLiteral("@microsoft.graph.conflictBehavior"), QStringLiteral("fail"));
 
-    FileCreateJob createJob(file, getAccount(accountId));
-    runJob(createJob, url, accountId);
+    GraphRequest request(OneDriveHelper::networkAccessManager(), "POST", QStringLiteral("/items/%1/children").arg(parentId), folder);
+    if (!runGraphRequest(request, url, accountId)) {
+        return;
+    }
+
+    // Remember the new folder, so that whatever gets uploaded into it next
+    // does not have to look it up again.
+    const QString folderId = request.response().value(QStringLiteral("id")).toString();
+    if (!folderId.isEmpty()) {
+        const QString path = url.adjusted(QUrl::StripTrailingSlash).path();
+        m_cache.insertPath(path, folderId);
+        m_cache.setParentsCount(path, 1);
+    }
 
     finished();
 }
 
 void KIOOneDrive::stat(const QUrl &url)
 {
+    Metrics::Timer timer(&m_metrics, Metrics::Command, "stat");
+
     qCDebug(ONEDRIVE) << "Going to stat()" << url;
 
     const auto onedriveUrl = OneDriveUrl(url);
@@ -531,6 +1087,16 @@ void KIOOneDrive::stat(const QUrl &url)
         finished();
         return;
     }
+    UploadJournal::Upload upload;
+    if (m_journal.upload(url.adjusted(QUrl::StripTrailingSlash).path(), &upload)) {
+        statEntry(uploadToUDSEntry(upload));
+        finished();
+        return;
+    }
+    const StoreUse use = storeUse(url);
+    if (use != NetworkOnly && (statFromStore(url, use) || storeMiss(url, use))) {
+        return;
+    }
 
     const QUrlQuery urlQuery(url);
     const QString fileId
@@ -543,29 +1109,34 @@ void KIOOneDrive::stat(const QUrl &url)
         return;
     }
 
-    FileFetchJob fileFetchJob(fileId, getAccount(accountId));
-    runJob(fileFetchJob, url, accountId);
-
-    const ObjectsList objects = fileFetchJob.items();
-    if (objects.count() != 1) {
+    QJsonObject item;
+    const FilePtr file = fetchFile(fileId, url, accountId, &item);
+    if (!file) {
         error(KIO::ERR_DOES_NOT_EXIST, url.path());
         return;
     }
 
-    const FilePtr file = objects.first().dynamicCast<File>();
-    if (file->labels()->trashed()) {
+    if (file->labels() && file->labels()->trashed()) {
         error(KIO::ERR_DOES_NOT_EXIST, url.path());
         return;
     }
 
-    const KIO::UDSEntry entry = fileToUDSEntry(file, onedriveUrl.parentPath());
+    const KIO::UDSEntry entry = OneDriveHelper::itemToUDSEntry(item, onedriveUrl.parentPath());
+    m_offline.storeEntry(url.adjusted(QUrl::StripTrailingSlash).path(), entry);
 
-    statEntry(entry);
+    {
+        Tracer::Span span("SlaveBase::statEntry");
+        statEntry(entry);
+    }
     finished();
 }
 
 void KIOOneDrive::get(const QUrl &url)
 {
+    Metrics::Timer timer(&m_metrics, Metrics::Command, "get");
+    // Transfers give way to the metadata requests of other workers.
+    RequestScheduler::Scope scope(RequestScheduler::Transfer);
+
     qCDebug(ONEDRIVE) << "Fetching content of" << url;
 
     const auto onedriveUrl = OneDriveUrl(url);
@@ -580,6 +1151,26 @@ void KIOOneDrive::get(const QUrl &url)
         error(KIO::ERR_ACCESS_DENIED, url.path());
         return;
     }
+    UploadJournal::Upload upload;
+    if (m_journal.upload(url.adjusted(QUrl::StripTrailingSlash).path(), &upload)) {
+        QFile file(m_journal.contentFile(upload));
+        if (!file.open(QIODevice::ReadOnly)) {
+            error(KIO::ERR_CANNOT_OPEN_FOR_READING, url.path());
+            return;
+        }
+        mimeType(uploadToUDSEntry(upload).stringValue(KIO::UDSEntry::UDS_MIME_TYPE));
+        totalSize(file.size());
+        while (!file.atEnd()) {
+            data(file.read(1024 * 1024));
+        }
+        data(QByteArray());
+        finished();
+        return;
+    }
+    const StoreUse use = storeUse(url);
+    if (use != NetworkOnly && (getFromStore(url, use) || storeMiss(url, use))) {
+        return;
+    }
 
     const QUrlQuery urlQuery(url);
     const QString fileId =
@@ -592,20 +1183,18 @@ void KIOOneDrive::get(const QUrl &url)
         return;
     }
 
-    FileFetchJob fileFetchJob(fileId, getAccount(accountId));
-    fileFetchJob.setFields(FileFetchJob::Id
-                            | FileFetchJob::MimeType
-                            | FileFetchJob::ExportLinks
-                            | FileFetchJob::DownloadUrl);
-    runJob(fileFetchJob, url, accountId);
-
-    const ObjectsList objects = fileFetchJob.items();
-    if (objects.count() != 1) {
-        error(KIO::ERR_DOES_NOT_EXIST, url.fileName());
+    FilePtr file = fetchFile(fileId, url, accountId);
+    if (!file) {
+        if (!m_errorReported) {
+            error(KIO::ERR_DOES_NOT_EXIST, url.path());
+        }
+        return;
+    }
+    if (file->isFolder()) {
+        error(KIO::ERR_IS_DIRECTORY, url.path());
         return;
     }
 
-    FilePtr file = objects.first().dynamicCast<File>();
     QUrl downloadUrl;
     if (OneDriveHelper::isGDocsDocument(file)) {
         downloadUrl = OneDriveHelper::convertFromGDocs(file);
@@ -615,10 +1204,33 @@ void KIOOneDrive::get(const QUrl &url)
 
     mimeType(file->mimeType());
 
-    FileFetchContentJob contentJob(downloadUrl, getAccount(accountId));
-    runJob(contentJob, url, accountId);
+    // The content is spooled to disk, so that big files do not sit in memory.
+    QTemporaryFile content;
+    if (!content.open()) {
+        error(KIO::ERR_CANNOT_OPEN_FOR_WRITING, content.fileName());
+        return;
+    }
+    const qint64 size = file->fileSize() > 0 ? file->fileSize() : -1;
+    if (size >= 0) {
+        totalSize(size);
+    }
+    FileDownloader downloader(downloadUrl, &content, 0, size);
+    if (!downloader.exec()) {
+        error(KIO::ERR_SLAVE_DEFINED, downloader.errorString());
+        return;
+    }
 
-    data(contentJob.data());
+    m_metrics.add(Metrics::BytesDownloaded, content.size());
+    content.flush();
+    m_offline.storeContentFile(file->id(), file->modifiedDate(), content.fileName());
+    content.seek(0);
+    {
+        Tracer::Span span("SlaveBase::data");
+        while (!content.atEnd()) {
+            data(content.read(1024 * 1024));
+        }
+    }
+    data(QByteArray());
     finished();
 }
 
@@ -627,9 +1239,6 @@ bool KIOOneDrive::readPutData(QTemporaryFile &tempFile)
     // TODO: Instead of using a temp file, upload directly the raw data (requires
     // support in LibKMGraph)
 
-    // TODO: For large files, switch to resumable upload and upload the file in
-    // reasonably large chunks (requires support in LibKMGraph)
-
     // TODO: Support resumable upload (requires support in LibKMGraph)
 
     if (!tempFile.open()) {
@@ -661,26 +1270,84 @@ bool KIOOneDrive::readPutData(QTemporaryFile &tempFile)
     return true;
 }
 
-bool KIOOneDrive::runJob(KMGraph2::Job &job, const QUrl &url, const QString &accountId)
+bool KIOOneDrive::runGraphRequest(GraphRequest &request, const QUrl &url, const QString &accountId)
+{
+    if (sendGraphRequest(request, url, accountId)) {
+        return true;
+    }
+    m_errorReported = true;
+    return false;
+}
+
+bool KIOOneDrive::sendGraphRequest(GraphRequest &request, const QUrl &url, const QString &accountId)
 {
-    KIOOneDrive::Action action = KIOOneDrive::Fail;
+    request.setAccount(getAccount(accountId));
+    int throttleRetries = 0;
     Q_FOREVER {
-        qCDebug(ONEDRIVE) << "Running job" << (&job) << "with accessToken" << job.account()->accessToken();
-        QEventLoop eventLoop;
-        QObject::connect(&job, &KMGraph2::Job::finished,
-                         &eventLoop, &QEventLoop::quit);
-        eventLoop.exec();
-        action = handleError(job, url);
-        if (action == KIOOneDrive::Success) {
-            break;
-        } else if (action == KIOOneDrive::Fail) {
-            return false;
+        bool succeeded = false;
+        {
+            Metrics::Timer timer(&m_metrics, Metrics::Job, "GraphRequest");
+            succeeded = request.exec();
+        }
+        if (succeeded) {
+            return true;
         }
-        job.setAccount(getAccount(accountId));
-        job.restart();
-    };
 
-    return true;
+        qCDebug(ONEDRIVE) << "Graph request status code:" << request.statusCode() << "- message:" << request.errorString();
+        switch (request.statusCode()) {
+            case 401: {
+                const AccountPtr account = m_accountManager->refreshAccount(request.account());
+                if (!account) {
+                    error(KIO::ERR_CANNOT_LOGIN, url.toDisplayString());
+                    return false;
+                }
+                m_metrics.add(Metrics::Retries);
+                request.setAccount(getAccount(accountId));
+                continue;
+            }
+            case 429:
+            case 503: {
+                m_metrics.add(Metrics::Throttles);
+                const int delay = request.retryAfter() > 0 ? request.retryAfter() : 1 << throttleRetries;
+                if (throttleRetries == MaxThrottleRetries || delay > MaxRetryAfter) {
+                    error(KIO::ERR_SLAVE_DEFINED, request.errorString());
+                    return false;
+                }
+                qCDebug(ONEDRIVE) << "Throttled, retrying in" << delay << "seconds";
+                ++throttleRetries;
+                m_metrics.add(Metrics::Retries);
+                QEventLoop eventLoop;
+                QTimer::singleShot(delay * 1000, &eventLoop, &QEventLoop::quit);
+                eventLoop.exec();
+                continue;
+            }
+            case 403:
+                error(KIO::ERR_ACCESS_DENIED, url.toDisplayString());
+                return false;
+            case 404:
+                error(KIO::ERR_DOES_NOT_EXIST, url.toDisplayString());
+                return false;
+            case 409:
+                error(KIO::ERR_FILE_ALREADY_EXIST, url.toDisplayString());
+                return false;
+            case 507:
+                error(KIO::ERR_DISK_FULL, url.toDisplayString());
+                return false;
+            case 0:
+                // No answer at all.
+                if (!m_connectivity.reportFailure()) {
+                    error(KIO::ERR_CANNOT_CONNECT, url.toDisplayString());
+                    return false;
+                }
+                error(KIO::ERR_SLAVE_DEFINED, request.errorString());
+                return false;
+            default:
+                error(KIO::ERR_SLAVE_DEFINED, request.errorString());
+                return false;
+        }
+    }
+
+    return false;
 }
 
 bool KIOOneDrive::putUpdate(const QUrl &url)
@@ -691,84 +1358,86 @@ bool KIOOneDrive::putUpdate(const QUrl &url)
     const auto onedriveUrl = OneDriveUrl(url);
     const auto accountId = onedriveUrl.account();
 
-    FileFetchJob fetchJob(fileId, getAccount(accountId));
-    if (!runJob(fetchJob, url, accountId)) {
-        return false;
-    }
-
-    const ObjectsList objects = fetchJob.items();
-    if (objects.size() != 1) {
-        putCreate(url);
+    const FilePtr file = fetchFile(fileId, url, accountId);
+    if (!file) {
+        if (!m_errorReported) {
+            error(KIO::ERR_DOES_NOT_EXIST, url.path());
+        }
         return false;
     }
 
-    const FilePtr file = objects[0].dynamicCast<File>();
     QTemporaryFile tmpFile;
     if (!readPutData(tmpFile)) {
         error(KIO::ERR_CANNOT_READ, url.path());
         return false;
     }
+    if (!tmpFile.open()) {
+        error(KIO::ERR_CANNOT_READ, tmpFile.fileName());
+        return false;
+    }
 
-    FileModifyJob modifyJob(tmpFile.fileName(), file, getAccount(accountId));
-    modifyJob.setUpdateModifiedDate(true);
-    if (!runJob(modifyJob, url, accountId)) {
+    if (uploadContent(QStringLiteral("/items/%1").arg(fileId), &tmpFile, tmpFile.size(), url, accountId).isEmpty()) {
         return false;
     }
 
+    m_quotas.adjustUsed(accountId, tmpFile.size() - file->fileSize());
+    m_metrics.add(Metrics::BytesUploaded, tmpFile.size());
     return true;
 }
 
 bool KIOOneDrive::putCreate(const QUrl &url)
 {
     qCDebug(ONEDRIVE) << Q_FUNC_INFO << url;
-    ParentReferencesList parentReferences;
 
     const auto onedriveUrl = OneDriveUrl(url);
     if (onedriveUrl.isRoot() || onedriveUrl.isAccountRoot()) {
         error(KIO::ERR_ACCESS_DENIED, url.path());
         return false;
     }
+    const auto accountId = onedriveUrl.account();
     const auto components = onedriveUrl.pathComponents();
-    if (components.length() == 2) {
-        // Creating in root directory
-    } else {
-        const QString parentId = resolveFileIdFromPath(onedriveUrl.parentPath());
-        if (parentId.isEmpty()) {
+    const QString parentId = components.length() == 2
+        ? rootFolderId(accountId)
+        : resolveFileIdFromPath(onedriveUrl.parentPath());
+    if (parentId.isEmpty()) {
+        if (!m_errorReported) {
             error(KIO::ERR_DOES_NOT_EXIST, url.adjusted(QUrl::RemoveFilename|QUrl::StripTrailingSlash).path());
-            return false;
         }
-        parentReferences << ParentReferencePtr(new ParentReference(parentId));
-    }
-
-    FilePtr file(new File);
-    file->setTitle(components.last());
-    file->setParents(parentReferences);
-    /*
-    if (hasMetaData(QLatin1String("modified"))) {
-        const QString modified = metaData(QLatin1String("modified"));
-        qCDebug(ONEDRIVE) << modified;
-        file->setModifiedDate(KDateTime::fromString(modified, KDateTime::ISODate));
+        return false;
     }
-    */
 
     QTemporaryFile tmpFile;
     if (!readPutData(tmpFile)) {
         error(KIO::ERR_CANNOT_READ, url.path());
         return false;
     }
+    if (!tmpFile.open()) {
+        error(KIO::ERR_CANNOT_READ, tmpFile.fileName());
+        return false;
+    }
 
-    const auto accountId = onedriveUrl.account();
-    FileCreateJob createJob(tmpFile.fileName(), file, getAccount(accountId));
-    if (!runJob(createJob, url, accountId)) {
+    const QJsonObject item = uploadContent(QStringLiteral("/items/%1:/%2:").arg(parentId, QString::fromLatin1(QUrl::toPercentEncoding(components.last()))),
+                                           &tmpFile, tmpFile.size(), url, accountId);
+    if (item.isEmpty()) {
         return false;
     }
+    const QString createdId = item.value(QStringLiteral("id")).toString();
+    if (!createdId.isEmpty()) {
+        m_cache.insertPath(url.adjusted(QUrl::StripTrailingSlash).path(), createdId);
+    }
 
+    m_quotas.adjustUsed(accountId, tmpFile.size());
+    m_metrics.add(Metrics::BytesUploaded, tmpFile.size());
     return true;
 }
 
 
 void KIOOneDrive::put(const QUrl &url, int permissions, KIO::JobFlags flags)
 {
+    Metrics::Timer timer(&m_metrics, Metrics::Command, "put");
+    RequestScheduler::Scope scope(RequestScheduler::Transfer);
+    clearLookups();
+
     // NOTE: We deliberately ignore the permissions field here, because OneDrive
     // does not recognize any privileges that could be mapped to standard UNIX
     // file permissions.
@@ -777,6 +1446,20 @@ void KIOOneDrive::put(const QUrl &url, int permissions, KIO::JobFlags flags)
 
     qCDebug(ONEDRIVE) << Q_FUNC_INFO << url;
 
+    // With write-back, a partial file stays in the journal to be uploaded
+    // straight over the file it replaces when renamed. That keeps the ID and
+    // version history of the file, and saves creating the partial file,
+    // deleting the original and renaming.
+    if (m_writeBack) {
+        putWriteBack(url);
+        return;
+    }
+    if (!checkOnline(url)) {
+        return;
+    }
+    invalidateStored(url.path());
+    dropPendingUploads(url.adjusted(QUrl::StripTrailingSlash).path());
+
     if (QUrlQuery(url).hasQueryItem(QStringLiteral("id"))) {
         if (!putUpdate(url)) {
             return;
@@ -787,14 +1470,138 @@ void KIOOneDrive::put(const QUrl &url, int permissions, KIO::JobFlags flags)
         }
     }
 
-    // FIXME: Update the cache now!
+    finished();
+}
+
+void KIOOneDrive::putWriteBack(const QUrl &url)
+{
+    const auto onedriveUrl = OneDriveUrl(url);
+    if (onedriveUrl.isRoot() || onedriveUrl.isAccountRoot()) {
+        error(KIO::ERR_ACCESS_DENIED, url.path());
+        return;
+    }
+
+    QTemporaryFile tmpFile;
+    if (!readPutData(tmpFile)) {
+        return;
+    }
+
+    // The version the data replaces, as last seen, for the agent to detect
+    // concurrent changes.
+    const QString path = url.adjusted(QUrl::StripTrailingSlash).path();
+    UploadJournal::Upload upload;
+    upload.path = path;
+    upload.queuedAt = QDateTime::currentDateTimeUtc();
+    KIO::UDSEntry entry;
+    QDateTime storedAt;
+    if (m_offline.entry(path, &entry, &storedAt)) {
+        upload.baseCTag = entry.stringValue(OneDriveHelper::CTag);
+    }
+
+    if (!m_journal.add(upload, tmpFile.fileName())) {
+        error(KIO::ERR_CANNOT_WRITE, url.path());
+        return;
+    }
 
+    qCDebug(ONEDRIVE) << "Queued" << url << "for upload";
+    invalidateStored(path);
     finished();
 }
 
+void KIOOneDrive::deleteDeferredTarget(const QString &path)
+{
+    qCDebug(ONEDRIVE) << "The safe save over" << path << "was abandoned, deleting it";
+    BackgroundUploader uploader(&m_journal);
+    uploader.deleteTarget(path, getAccount(path.section(QLatin1Char('/'), 1, 1)));
+    m_cache.removeSubtree(path);
+    invalidateStored(path);
+}
+
+QHash<QString, KIO::UDSEntry> KIOOneDrive::pendingUploadEntries(const QString &path) const
+{
+    QHash<QString, KIO::UDSEntry> entries;
+    if (m_journal.isEmpty()) {
+        return entries;
+    }
+
+    const auto uploads = m_journal.uploadsIn(path);
+    for (const auto &upload : uploads) {
+        const KIO::UDSEntry entry = uploadToUDSEntry(upload);
+        entries.insert(entry.stringValue(KIO::UDSEntry::UDS_NAME), entry);
+    }
+    return entries;
+}
+
+bool KIOOneDrive::flushPendingUpload(const QUrl &url)
+{
+    UploadJournal::Upload upload;
+    if (!m_journal.upload(url.adjusted(QUrl::StripTrailingSlash).path(), &upload)) {
+        return true;
+    }
+
+    qCDebug(ONEDRIVE) << "Uploading" << url << "ahead of the sync agent";
+    const QString accountId = OneDriveUrl(url).account();
+    BackgroundUploader uploader(&m_journal);
+    uploader.setClaimTimeout(UploadClaimTimeout);
+    auto result = uploader.upload(upload, getAccount(accountId));
+    if (result == BackgroundUploader::Failed && uploader.statusCode() == 401) {
+        m_accountManager->refreshAccount(getAccount(accountId));
+        result = uploader.upload(upload, getAccount(accountId));
+    }
+
+    switch (result) {
+        case BackgroundUploader::Committed:
+            m_metrics.add(Metrics::BytesUploaded, upload.size);
+            return true;
+        case BackgroundUploader::Conflict:
+            error(KIO::ERR_SLAVE_DEFINED, i18n("%1 was changed on the server meanwhile. Your version was saved as %2.",
+                                               url.toDisplayString(), uploader.conflictPath()));
+            return false;
+        case BackgroundUploader::Busy:
+            error(KIO::ERR_SLAVE_DEFINED, i18n("%1 is being uploaded by another process.", url.toDisplayString()));
+            return false;
+        case BackgroundUploader::Failed:
+            break;
+    }
+    if (uploader.statusCode() == 0 && !m_connectivity.reportFailure()) {
+        error(KIO::ERR_CANNOT_CONNECT, url.toDisplayString());
+    } else {
+        error(KIO::ERR_SLAVE_DEFINED, uploader.errorString());
+    }
+    return false;
+}
+
+bool KIOOneDrive::dropPendingUploads(const QString &path)
+{
+    if (m_journal.isEmpty()) {
+        return false;
+    }
+
+    bool dropped = false;
+    const auto uploads = m_journal.uploads();
+    for (const auto &upload : uploads) {
+        if (upload.path == path || upload.path.startsWith(path + QLatin1Char('/'))) {
+            qCDebug(ONEDRIVE) << "Dropping the pending upload of" << upload.path;
+            m_journal.remove(upload);
+            dropped = true;
+            // The rename the deletion of the target waits for will not
+            // come, unless the target goes with the rest.
+            if (!upload.deletedTarget.isEmpty() && upload.deletedTarget != path
+                && !upload.deletedTarget.startsWith(path + QLatin1Char('/'))) {
+                deleteDeferredTarget(upload.deletedTarget);
+            }
+        }
+    }
+    return dropped;
+}
+
 
 void KIOOneDrive::copy(const QUrl &src, const QUrl &dest, int permissions, KIO::JobFlags flags)
 {
+    Metrics::Timer timer(&m_metrics, Metrics::Command, "copy");
+    RequestScheduler::Scope scope(RequestScheduler::Transfer);
+    clearLookups();
+
     qCDebug(ONEDRIVE) << "Going to copy" << src << "to" << dest;
 
     // NOTE: We deliberately ignore the permissions field here, because OneDrive
@@ -802,22 +1609,54 @@ void KIOOneDrive::copy(const QUrl &src, const QUrl &dest, int permissions, KIO::
     // file permissions.
     Q_UNUSED(permissions);
 
-    // NOTE: We deliberately ignore the flags field here, because the "overwrite"
-    // flag would have no effect on OneDrive, since file name don't have to be
-    // unique. IOW if there is a file "foo.bar" and user copy-pastes into the
-    // same directory, the FileCopyJob will succeed and a new file with the same
-    // name will be created.
-    Q_UNUSED(flags);
+    if (dest.isLocalFile()) {
+        UploadJournal::Upload upload;
+        if (m_journal.upload(src.adjusted(QUrl::StripTrailingSlash).path(), &upload)) {
+            const QString destPath = dest.toLocalFile();
+            if (QFileInfo::exists(destPath)) {
+                if (!(flags & KIO::Overwrite)) {
+                    error(KIO::ERR_FILE_ALREADY_EXIST, destPath);
+                    return;
+                }
+                QFile::remove(destPath);
+            }
+            if (!QFile::copy(m_journal.contentFile(upload), destPath)) {
+                error(KIO::ERR_CANNOT_WRITE, destPath);
+                return;
+            }
+            processedSize(upload.size);
+            finished();
+            return;
+        }
+        const StoreUse use = storeUse(src);
+        if (use != NetworkOnly && (copyToFileFromStore(src, dest, flags, use) || storeMiss(src, use))) {
+            return;
+        }
+        copyToFile(src, dest, flags);
+        return;
+    }
+    if (!checkOnline(dest)) {
+        return;
+    }
+    if (!src.isLocalFile() && !flushPendingUpload(src)) {
+        return;
+    }
+    dropPendingUploads(dest.adjusted(QUrl::StripTrailingSlash).path());
+    invalidateStored(dest.path());
+    if (src.isLocalFile()) {
+        copyFromFile(src, dest);
+        return;
+    }
 
     const auto srcOneDriveUrl = OneDriveUrl(src);
     const auto destOneDriveUrl = OneDriveUrl(dest);
     const QString sourceAccountId = srcOneDriveUrl.account();
     const QString destAccountId = destOneDriveUrl.account();
 
-    // TODO: Does this actually happen, or does KIO treat our account name as host?
     if (sourceAccountId != destAccountId) {
-        // KIO will fallback to get+post
-        error(KIO::ERR_UNSUPPORTED_ACTION, src.path());
+        if (!copyAcrossAccounts(src, dest, flags).isEmpty()) {
+            finished();
+        }
         return;
     }
 
@@ -839,52 +1678,416 @@ void KIOOneDrive::copy(const QUrl &src, const QUrl &dest, int permissions, KIO::
         error(KIO::ERR_DOES_NOT_EXIST, src.path());
         return;
     }
-    FileFetchJob sourceFileFetchJob(sourceFileId, getAccount(sourceAccountId));
-    sourceFileFetchJob.setFields(FileFetchJob::Id | FileFetchJob::ModifiedDate |
-                                 FileFetchJob::LastViewedByMeDate | FileFetchJob::Description);
-    runJob(sourceFileFetchJob, src, sourceAccountId);
-
-    const ObjectsList objects = sourceFileFetchJob.items();
-    if (objects.count() != 1) {
-        error(KIO::ERR_DOES_NOT_EXIST, src.path());
-        return;
-    }
-
-    const FilePtr sourceFile = objects[0].dynamicCast<File>();
-
-    ParentReferencesList destParentReferences;
     if (destOneDriveUrl.isRoot()) {
         error(KIO::ERR_ACCESS_DENIED, dest.path());
         return;
     }
 
-    QString destDirId;
     const auto destPathComps = destOneDriveUrl.pathComponents();
-    const QString destFileName = destPathComps.last();
-    if (destPathComps.size() == 2) {
-        destDirId = rootFolderId(destAccountId);
-    } else {
-        destDirId = resolveFileIdFromPath(destOneDriveUrl.parentPath(), KIOOneDrive::PathIsFolder);
+    const QString destDirId = destPathComps.size() == 2
+        ? rootFolderId(destAccountId)
+        : resolveFileIdFromPath(destOneDriveUrl.parentPath(), KIOOneDrive::PathIsFolder);
+    if (destDirId.isEmpty()) {
+        error(KIO::ERR_DOES_NOT_EXIST, dest.adjusted(QUrl::RemoveFilename|QUrl::StripTrailingSlash).path());
+        return;
     }
-    destParentReferences << ParentReferencePtr(new ParentReference(destDirId));
 
-    FilePtr destFile(new File);
-    destFile->setTitle(destFileName);
-    destFile->setModifiedDate(sourceFile->modifiedDate());
-    destFile->setLastViewedByMeDate(sourceFile->lastViewedByMeDate());
-    destFile->setDescription(sourceFile->description());
-    destFile->setParents(destParentReferences);
+    // The copy keeps the dates of the source, the server takes them along.
+    QJsonObject parentReference;
+    parentReference.insert(QStringLiteral("id"), destDirId);
+    QJsonObject copy;
+    copy.insert(QStringLiteral("name"), destPathComps.last());
+    copy.insert(QStringLiteral("parentReference"), parentReference);
 
-    FileCopyJob copyJob(sourceFile, destFile, getAccount(sourceAccountId));
-    runJob(copyJob, dest, sourceAccountId);
+    GraphRequest request(OneDriveHelper::networkAccessManager(), "POST", QStringLiteral("/items/%1/copy").arg(sourceFileId), copy);
+    QUrlQuery query;
+    query.addQueryItem(QStringLiteral("@microsoft.graph.conflictBehavior"),
+                       flags & KIO::Overwrite ? QStringLiteral("replace") : QStringLiteral("fail"));
+    request.setQuery(query);
+    if (!runGraphRequest(request, dest, sourceAccountId)) {
+        return;
+    }
 
-    finished();
-}
+    // The server copies in the background, the copy is done once its
+    // monitor says so.
+    const QUrl monitor = request.location();
+    while (monitor.isValid()) {
+        GraphRequest status(OneDriveHelper::networkAccessManager(), "GET", QString());
+        status.setUrl(monitor);
+        if (!runGraphRequest(status, dest, sourceAccountId)) {
+            return;
+        }
+
+        const QString state = status.response().value(QStringLiteral("status")).toString();
+        if (state == QLatin1String("completed")) {
+            break;
+        }
+        if (state == QLatin1String("failed")) {
+            error(KIO::ERR_CANNOT_WRITE, dest.path());
+            return;
+        }
+
+        QEventLoop eventLoop;
+        QTimer::singleShot(CopyPollInterval, &eventLoop, &QEventLoop::quit);
+        eventLoop.exec();
+    }
+
+    // The size of the copy is unknown here, refresh the quota on next use.
+    m_quotas.invalidate(destAccountId);
+
+    finished();
+}
+
+void KIOOneDrive::copyFromFile(const QUrl &src, const QUrl &dest)
+{
+    qCDebug(ONEDRIVE) << "Uploading local file" << src << "to" << dest;
+
+    const QFileInfo srcInfo(src.toLocalFile());
+    if (!srcInfo.exists()) {
+        error(KIO::ERR_DOES_NOT_EXIST, src.toLocalFile());
+        return;
+    }
+    if (srcInfo.isDir()) {
+        error(KIO::ERR_IS_DIRECTORY, src.toLocalFile());
+        return;
+    }
+    if (!srcInfo.isReadable()) {
+        error(KIO::ERR_CANNOT_OPEN_FOR_READING, src.toLocalFile());
+        return;
+    }
+
+    const auto destOneDriveUrl = OneDriveUrl(dest);
+    if (destOneDriveUrl.isRoot() || destOneDriveUrl.isAccountRoot()) {
+        error(KIO::ERR_ACCESS_DENIED, dest.path());
+        return;
+    }
+
+    const QString accountId = destOneDriveUrl.account();
+    const auto components = destOneDriveUrl.pathComponents();
+    QString parentId;
+    if (components.size() == 2) {
+        parentId = rootFolderId(accountId);
+    } else {
+        parentId = resolveFileIdFromPath(destOneDriveUrl.parentPath(), KIOOneDrive::PathIsFolder);
+    }
+    if (parentId.isEmpty()) {
+        error(KIO::ERR_DOES_NOT_EXIST, dest.adjusted(QUrl::RemoveFilename|QUrl::StripTrailingSlash).path());
+        return;
+    }
+
+    totalSize(srcInfo.size());
+
+    // The content is read directly from the source file, so there is no
+    // temp file to spool into.
+    QFile srcFile(srcInfo.absoluteFilePath());
+    if (!srcFile.open(QIODevice::ReadOnly)) {
+        error(KIO::ERR_CANNOT_OPEN_FOR_READING, src.toLocalFile());
+        return;
+    }
+    const QJsonObject item = uploadContent(QStringLiteral("/items/%1:/%2:").arg(parentId, QString::fromLatin1(QUrl::toPercentEncoding(components.last()))),
+                                           &srcFile, srcInfo.size(), dest, accountId, srcInfo.lastModified());
+    if (item.isEmpty()) {
+        return;
+    }
+    const QString createdId = item.value(QStringLiteral("id")).toString();
+    if (!createdId.isEmpty()) {
+        m_cache.insertPath(dest.adjusted(QUrl::StripTrailingSlash).path(), createdId);
+    }
+    m_quotas.adjustUsed(accountId, srcInfo.size());
+    m_metrics.add(Metrics::BytesUploaded, srcInfo.size());
+
+    processedSize(srcInfo.size());
+    finished();
+}
+
+QString KIOOneDrive::copyAcrossAccounts(const QUrl &src, const QUrl &dest, KIO::JobFlags flags)
+{
+    qCDebug(ONEDRIVE) << "Streaming" << src << "to" << dest << "across accounts";
+
+    const auto srcOneDriveUrl = OneDriveUrl(src);
+    const auto destOneDriveUrl = OneDriveUrl(dest);
+    if (srcOneDriveUrl.isRoot() || srcOneDriveUrl.isAccountRoot()
+        || destOneDriveUrl.isRoot() || destOneDriveUrl.isAccountRoot()) {
+        error(KIO::ERR_UNSUPPORTED_ACTION, src.path());
+        return QString();
+    }
+
+    const QString sourceAccountId = srcOneDriveUrl.account();
+    const QString destAccountId = destOneDriveUrl.account();
+
+    // Get both accounts ready at once, rather than one after the other.
+    m_accountManager->prepareAccounts({sourceAccountId, destAccountId});
+
+    const QUrlQuery urlQuery(src);
+    const QString sourceFileId
+        = urlQuery.hasQueryItem(QStringLiteral("id"))
+            ? urlQuery.queryItemValue(QStringLiteral("id"))
+            : resolveFileIdFromPath(src.adjusted(QUrl::StripTrailingSlash).path());
+    if (sourceFileId.isEmpty()) {
+        error(KIO::ERR_DOES_NOT_EXIST, src.path());
+        return QString();
+    }
+
+    const FilePtr sourceFile = fetchFile(sourceFileId, src, sourceAccountId);
+    if (!sourceFile) {
+        if (!m_errorReported) {
+            error(KIO::ERR_DOES_NOT_EXIST, src.path());
+        }
+        return QString();
+    }
+    if (sourceFile->isFolder()) {
+        // KIO will recurse and call us back for every file.
+        error(KIO::ERR_UNSUPPORTED_ACTION, src.path());
+        return QString();
+    }
+
+    const auto destPathComps = destOneDriveUrl.pathComponents();
+    const QString destDirId = destPathComps.size() == 2
+        ? rootFolderId(destAccountId)
+        : resolveFileIdFromPath(destOneDriveUrl.parentPath(), KIOOneDrive::PathIsFolder);
+    if (destDirId.isEmpty()) {
+        error(KIO::ERR_DOES_NOT_EXIST, dest.adjusted(QUrl::RemoveFilename|QUrl::StripTrailingSlash).path());
+        return QString();
+    }
+
+    totalSize(sourceFile->fileSize());
+
+    std::unique_ptr<CrossAccountTransfer> transfer;
+    bool refreshed = false;
+    Q_FOREVER {
+        transfer.reset(new CrossAccountTransfer(sourceFile->downloadUrl(), sourceFile->fileSize(),
+                                                getAccount(destAccountId), destDirId, destPathComps.last(),
+                                                flags & KIO::Overwrite));
+        QObject::connect(transfer.get(), &CrossAccountTransfer::processed, [this](qint64 bytes) {
+            processedSize(bytes);
+        });
+        if (transfer->exec()) {
+            break;
+        }
+
+        // Rejected before anything was streamed, like runGraphRequest(),
+        // once more with a fresh token.
+        if (transfer->error() == CrossAccountTransfer::AuthError && !refreshed
+            && m_accountManager->refreshAccount(getAccount(destAccountId))) {
+            refreshed = true;
+            m_metrics.add(Metrics::Retries);
+            continue;
+        }
+        switch (transfer->error()) {
+            case CrossAccountTransfer::AlreadyExists:
+                error(KIO::ERR_FILE_ALREADY_EXIST, dest.path());
+                break;
+            case CrossAccountTransfer::AuthError:
+                error(KIO::ERR_CANNOT_LOGIN, dest.toDisplayString());
+                break;
+            default:
+                error(KIO::ERR_SLAVE_DEFINED, transfer->errorString());
+                break;
+        }
+        return QString();
+    }
+
+    if (!transfer->createdId().isEmpty()) {
+        m_cache.insertPath(dest.adjusted(QUrl::StripTrailingSlash).path(), transfer->createdId());
+    }
+    m_quotas.adjustUsed(destAccountId, sourceFile->fileSize());
+    m_metrics.add(Metrics::BytesDownloaded, sourceFile->fileSize());
+    m_metrics.add(Metrics::BytesUploaded, sourceFile->fileSize());
+
+    return sourceFileId;
+}
+
+static void preallocate(QFile &file, qint64 size)
+{
+#ifdef Q_OS_LINUX
+    // Reserve the blocks but keep the file size, so that the size of a partial
+    // file still tells how much of it has been downloaded.
+    if (size > 0 && fallocate(file.handle(), FALLOC_FL_KEEP_SIZE, 0, size) != 0) {
+        qCDebug(ONEDRIVE) << "Could not preallocate" << size << "bytes for" << file.fileName();
+    }
+#else
+    Q_UNUSED(file)
+    Q_UNUSED(size)
+#endif
+}
+
+void KIOOneDrive::copyToFile(const QUrl &src, const QUrl &dest, KIO::JobFlags flags)
+{
+    qCDebug(ONEDRIVE) << "Downloading" << src << "to local file" << dest;
+
+    const auto srcOneDriveUrl = OneDriveUrl(src);
+    if (srcOneDriveUrl.isRoot()) {
+        error(KIO::ERR_DOES_NOT_EXIST, src.path());
+        return;
+    }
+    if (srcOneDriveUrl.isAccountRoot()) {
+        error(KIO::ERR_IS_DIRECTORY, src.path());
+        return;
+    }
+
+    const QString accountId = srcOneDriveUrl.account();
+    const QUrlQuery urlQuery(src);
+    const QString fileId
+        = urlQuery.hasQueryItem(QStringLiteral("id"))
+            ? urlQuery.queryItemValue(QStringLiteral("id"))
+            : resolveFileIdFromPath(src.adjusted(QUrl::StripTrailingSlash).path(),
+                                    KIOOneDrive::PathIsFile);
+    if (fileId.isEmpty()) {
+        error(KIO::ERR_DOES_NOT_EXIST, src.path());
+        return;
+    }
+
+    FilePtr file = fetchFile(fileId, src, accountId);
+    if (!file) {
+        if (!m_errorReported) {
+            error(KIO::ERR_DOES_NOT_EXIST, src.path());
+        }
+        return;
+    }
+    if (file->isFolder()) {
+        error(KIO::ERR_IS_DIRECTORY, src.path());
+        return;
+    }
+
+    QUrl downloadUrl;
+    if (OneDriveHelper::isGDocsDocument(file)) {
+        downloadUrl = OneDriveHelper::convertFromGDocs(file);
+    } else {
+        downloadUrl = file->downloadUrl();
+    }
+
+    const QString destPath = dest.toLocalFile();
+    if (QFileInfo::exists(destPath) && !(flags & KIO::Overwrite)) {
+        error(KIO::ERR_FILE_ALREADY_EXIST, destPath);
+        return;
+    }
+
+    const bool markPartial = config()->readEntry("MarkPartial", true);
+    const QString partPath = markPartial ? destPath + QLatin1String(".part") : destPath;
+    const qint64 size = file->fileSize() > 0 ? file->fileSize() : -1;
+
+    QFile partFile(partPath);
+    qint64 offset = 0;
+    if (markPartial && (flags & KIO::Resume) && partFile.exists() && (size < 0 || partFile.size() < size)) {
+        offset = partFile.size();
+        qCDebug(ONEDRIVE) << "Resuming download of" << src << "at offset" << offset;
+    }
+
+    const QIODevice::OpenMode openMode = offset > 0 ? QIODevice::ReadWrite : (QIODevice::WriteOnly | QIODevice::Truncate);
+    if (!partFile.open(openMode | QIODevice::Unbuffered)) {
+        error(KIO::ERR_CANNOT_OPEN_FOR_WRITING, partPath);
+        return;
+    }
+
+    preallocate(partFile, size);
+    if (size >= 0) {
+        totalSize(size);
+    }
+
+    qint64 written = offset;
+    qint64 start = offset;
+    bool downloaded = false;
+    bool holes = false;
+    QString downloadError;
+    for (bool refreshed = false; ; refreshed = true) {
+        FileDownloader downloader(downloadUrl, &partFile, start, size);
+        QObject::connect(&downloader, &FileDownloader::processed, [this, &written](qint64 bytes) {
+            written = bytes;
+            processedSize(bytes);
+        });
+        downloaded = downloader.exec();
+        // A partial file written by concurrent ranges has holes, so it cannot be resumed.
+        holes = downloader.isParallel();
+        downloadError = downloader.errorString();
+        const int status = downloader.statusCode();
+        if (downloaded || refreshed || (status != 401 && status != 403) || OneDriveHelper::isGDocsDocument(file)) {
+            break;
+        }
+
+        // The pre-authenticated URL expired during the download, ask for a
+        // new one and go on from where the content stops.
+        qCDebug(ONEDRIVE) << "Download URL of" << src << "expired at" << written << "bytes, fetching a new one";
+        clearLookups();
+        const FilePtr current = fetchFile(fileId, src, accountId);
+        if (!current) {
+            partFile.close();
+            m_metrics.add(Metrics::BytesDownloaded, written - offset);
+            if (!m_errorReported) {
+                error(KIO::ERR_DOES_NOT_EXIST, src.path());
+            }
+            return;
+        }
+        downloadUrl = current->downloadUrl();
+        start = holes ? offset : written;
+        written = start;
+    }
+    partFile.close();
+    m_metrics.add(Metrics::BytesDownloaded, written - offset);
+
+    if (!downloaded) {
+        if (holes || !markPartial) {
+            QFile::remove(partPath);
+        }
+        error(KIO::ERR_SLAVE_DEFINED, downloadError);
+        return;
+    }
+
+    if (markPartial) {
+        QFile::remove(destPath);
+        if (!QFile::rename(partPath, destPath)) {
+            error(KIO::ERR_CANNOT_RENAME_PARTIAL, destPath);
+            return;
+        }
+    }
+
+    if (file->modifiedDate().isValid()) {
+        struct utimbuf times;
+        times.actime = QDateTime::currentDateTime().toTime_t();
+        times.modtime = file->modifiedDate().toTime_t();
+        ::utime(QFile::encodeName(destPath).constData(), &times);
+    }
+    m_offline.storeContentFile(file->id(), file->modifiedDate(), destPath);
+
+    finished();
+}
 
 void KIOOneDrive::del(const QUrl &url, bool isfile)
+{
+    Metrics::Timer timer(&m_metrics, Metrics::Command, "del");
+    clearLookups();
+
+    if (deleteItem(url, isfile)) {
+        finished();
+    }
+}
+
+bool KIOOneDrive::deleteItem(const QUrl &url, bool isfile)
 {
     qCDebug(ONEDRIVE) << "Deleting URL" << url << "- is it a file?" << isfile;
 
+    // Part of a safe save, the partial file is about to be renamed over it.
+    // The deletion is kept with the partial file in the journal, and done by
+    // whoever uploads or drops it if the rename does not come.
+    UploadJournal::Upload partial;
+    if (isfile && m_writeBack && m_journal.upload(url.adjusted(QUrl::StripTrailingSlash).path() + PartSuffix, &partial)) {
+        qCDebug(ONEDRIVE) << "Deferring the deletion of" << url << "to the rename of its partial file";
+        dropPendingUploads(url.adjusted(QUrl::StripTrailingSlash).path());
+        partial.deletedTarget = url.adjusted(QUrl::StripTrailingSlash).path();
+        m_journal.update(partial);
+        invalidateStored(url.path());
+        return true;
+    }
+
+    if (!checkOnline(url)) {
+        return false;
+    }
+    // Whether a folder is empty depends on the deletions still queued.
+    if (!isfile) {
+        flushQueuedDeletes();
+    }
+    invalidateStored(url.path());
+    const bool wasPending = dropPendingUploads(url.adjusted(QUrl::StripTrailingSlash).path());
+
     const QUrlQuery urlQuery(url);
     const QString fileId
         = isfile && urlQuery.hasQueryItem(QStringLiteral("id"))
@@ -892,8 +2095,12 @@ void KIOOneDrive::del(const QUrl &url, bool isfile)
             : resolveFileIdFromPath(url.adjusted(QUrl::StripTrailingSlash).path(),
                                     isfile ? KIOOneDrive::PathIsFile : KIOOneDrive::PathIsFolder);
     if (fileId.isEmpty()) {
+        // A file that was never uploaded.
+        if (wasPending && isfile) {
+            return true;
+        }
         error(KIO::ERR_DOES_NOT_EXIST, url.path());
-        return;
+        return false;
     }
     const auto onedriveUrl = OneDriveUrl(url);
     const QString accountId = onedriveUrl.account();
@@ -903,76 +2110,214 @@ void KIOOneDrive::del(const QUrl &url, bool isfile)
         const KMGraph2::AccountPtr account = getAccount(accountId);
         if (account->accountName().isEmpty()) {
             error(KIO::ERR_DOES_NOT_EXIST, accountId);
-            return;
+            return false;
         }
         m_accountManager->removeAccount(accountId);
-        finished();
-        return;
+        return true;
     }
 
     // OneDrive allows us to delete entire directory even when it's not empty,
-    // so we need to emulate the normal behavior ourselves by checking number of
-    // child references
-    if (!isfile) {
-        ChildReferenceFetchJob referencesFetch(fileId, getAccount(accountId));
-        runJob(referencesFetch, url, accountId);
-        const bool isEmpty = !referencesFetch.items().count();
+    // so we need to emulate the normal behavior ourselves by checking whether
+    // it has any child. Asking for a single one is enough.
+    if (!isfile && metaData(QStringLiteral("recurse")) != QLatin1String("true")) {
+        GraphRequest childProbe(OneDriveHelper::networkAccessManager(), "GET", QStringLiteral("/items/%1/children").arg(fileId));
+        QUrlQuery query;
+        query.addQueryItem(QStringLiteral("$top"), QStringLiteral("1"));
+        query.addQueryItem(QStringLiteral("$select"), QStringLiteral("id"));
+        childProbe.setQuery(query);
+        if (!runGraphRequest(childProbe, url, accountId)) {
+            return false;
+        }
 
-        if (!isEmpty && metaData(QStringLiteral("recurse")) != QLatin1String("true")) {
+        if (!childProbe.response().value(QStringLiteral("value")).toArray().isEmpty()) {
             error(KIO::ERR_CANNOT_RMDIR, url.path());
-            return;
+            return false;
         }
     }
 
-    // Files can have multiple parentReferences, meaning the same fileId and name
-    // can show up as a childReference in more than one folder. However, outright
-    // deleting the fileId would remove it from both folders which might result
-    // in an unintended loss of data.
-
-    // Therefore, we first check if the file has more than one parent - when this
-    // is the case we find the parentId of the current folder and remove that
-    // parentId from the fileId.
-
-    // If the fileId has exactly one parentId, we delete the entire fileId rather
-    // than removing the last parentId (which would cause the file to become
-    // invisible in your OneDrive).
-
-    ParentReferenceFetchJob parentsFetch(fileId, getAccount(accountId));
-    runJob(parentsFetch, url, accountId);
-    const ObjectsList objects = parentsFetch.items();
-    if (objects.count() > 1) {
-        const QString parentId = resolveFileIdFromPath(onedriveUrl.parentPath());
-        qCDebug(ONEDRIVE) << "More than one parent - deleting parentReference" << parentId << "from URL:" << url;
-        ParentReferenceDeleteJob parentDeleteJob(fileId, parentId, getAccount(accountId));
-        runJob(parentDeleteJob, url, accountId);
-    } else if (objects.count() == 1) {
-        qCDebug(ONEDRIVE) << "Exactly one parent - outright deleting the URL:" << url;
-        FileDeleteJob deleteJob(fileId, getAccount(accountId));
-        runJob(deleteJob, url, accountId);
-    } else {
-        qCDebug(ONEDRIVE) << "ParentReferenceFetchJob retrieved" << objects.count() << "items, while one or more were expected.";
+    // A OneDrive item is in a single folder, deleting it cannot remove it from
+    // any other one. An item without a parent is not one that can be deleted.
+    const QString path = url.adjusted(QUrl::StripTrailingSlash).path();
+    const int parentsCount = this->parentsCount(url, fileId, accountId);
+    if (m_errorReported) {
+        return false;
+    }
+
+    if (parentsCount == 0) {
+        qCDebug(ONEDRIVE) << "No parent known for" << url;
         error(KIO::ERR_DOES_NOT_EXIST, url.path());
-        return;
+        return false;
+    }
+
+    qCDebug(ONEDRIVE) << "Deleting the URL:" << url;
+    if (isfile) {
+        if (!queueDelete(url, fileId, accountId)) {
+            return false;
+        }
+    } else {
+        GraphRequest request(OneDriveHelper::networkAccessManager(), "DELETE", QStringLiteral("/items/%1").arg(fileId));
+        if (!runGraphRequest(request, url, accountId)) {
+            return false;
+        }
     }
 
-    m_cache.removePath(url.path());
+    m_cache.removeSubtree(path);
+    // We don't know how much space the deleted item freed (if any, since the
+    // recycle bin still counts against the quota), so refresh it on next use.
+    m_quotas.invalidate(accountId);
 
-    finished();
+    return true;
+}
+
+int KIOOneDrive::parentsCount(const QUrl &url, const QString &fileId, const QString &accountId)
+{
+    // The number of parents is known without asking when the item was listed.
+    const int count = m_cache.parentsCount(url.adjusted(QUrl::StripTrailingSlash).path());
+    if (count > 0) {
+        return count;
+    }
+
+    const FilePtr file = fetchFile(fileId, url, accountId);
+    return file ? file->parents().count() : 0;
+}
+
+bool KIOOneDrive::queueDelete(const QUrl &url, const QString &fileId, const QString &accountId)
+{
+    // A batch goes to a single drive.
+    if (m_queuedDeletesAccount != accountId) {
+        flushQueuedDeletes();
+        m_queuedDeletesAccount = accountId;
+    }
+
+    m_queuedDeletes << qMakePair(url, fileId);
+    if (m_queuedDeletes.size() < GraphBatch::MaxRequests) {
+        QByteArray data;
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream << qint32(FlushDeletes);
+        setTimeoutSpecialCommand(QueuedDeletesDelay, data);
+        return true;
+    }
+
+    const QString path = url.adjusted(QUrl::StripTrailingSlash).path();
+    if (!flushQueuedDeletes(path)) {
+        error(KIO::ERR_CANNOT_DELETE, path);
+        return false;
+    }
+    return true;
+}
+
+QStringList KIOOneDrive::sendQueuedDeletes()
+{
+    if (m_queuedDeletes.isEmpty()) {
+        return QStringList();
+    }
+
+    const auto queued = m_queuedDeletes;
+    const QString accountId = m_queuedDeletesAccount;
+    m_queuedDeletes.clear();
+    qCDebug(ONEDRIVE) << "Deleting" << queued.size() << "queued files in one batch";
+
+    GraphBatch batch(OneDriveHelper::networkAccessManager(), getAccount(accountId));
+    for (const auto &item : queued) {
+        batch.add("DELETE", QStringLiteral("/items/%1").arg(item.second));
+    }
+    bool sent = false;
+    {
+        Metrics::Timer timer(&m_metrics, Metrics::Job, "GraphBatch");
+        sent = batch.exec();
+        // Like runGraphRequest(), once more with a fresh token. Throttled
+        // deletions are retried by GraphBatch.
+        if (!sent && batch.statusCode() == 401 && m_accountManager->refreshAccount(getAccount(accountId))) {
+            m_metrics.add(Metrics::Retries);
+            batch.setAccount(getAccount(accountId));
+            sent = batch.exec();
+        }
+    }
+    if (!sent) {
+        qCWarning(ONEDRIVE) << "Cannot send the queued deletions:" << batch.errorString();
+    }
+
+    QStringList failedPaths;
+    const auto responses = batch.responses();
+    for (int i = 0; i < responses.size(); ++i) {
+        const int status = responses.at(i).status;
+        // Already gone is as good as deleted.
+        if ((status >= 200 && status < 300) || status == 404) {
+            continue;
+        }
+        const QString path = queued.at(i).first.adjusted(QUrl::StripTrailingSlash).path();
+        qCWarning(ONEDRIVE) << "Cannot delete" << path << "- status" << status;
+        // Still there, the next listing shows it again.
+        invalidateStored(path);
+        failedPaths << path;
+    }
+    m_quotas.invalidate(accountId);
+
+    return failedPaths;
+}
+
+bool KIOOneDrive::flushQueuedDeletes(const QString &path)
+{
+    QStringList failedPaths = sendQueuedDeletes();
+    const bool deleted = failedPaths.removeAll(path) == 0;
+    if (!failedPaths.isEmpty()) {
+        warning(i18np("The following item could not be deleted: %2",
+                      "The following %1 items could not be deleted: %2",
+                      failedPaths.count(),
+                      failedPaths.join(QStringLiteral(", "))));
+    }
+    return deleted;
 }
 
 void KIOOneDrive::rename(const QUrl &src, const QUrl &dest, KIO::JobFlags flags)
 {
-    Q_UNUSED(flags)
+    Metrics::Timer timer(&m_metrics, Metrics::Command, "rename");
+    clearLookups();
+
     qCDebug(ONEDRIVE) << "Renaming" << src << "to" << dest;
 
+    const QString srcPath = src.adjusted(QUrl::StripTrailingSlash).path();
+    const QString destPath = dest.adjusted(QUrl::StripTrailingSlash).path();
+    UploadJournal::Upload partial;
+    if (m_writeBack && srcPath == destPath + PartSuffix && m_journal.upload(srcPath, &partial)) {
+        renamePartial(partial, dest, flags);
+        return;
+    }
+
+    if (!checkOnline(src)) {
+        return;
+    }
+    if (!flushPendingUpload(src)) {
+        return;
+    }
+    if (flags & KIO::Overwrite) {
+        dropPendingUploads(dest.adjusted(QUrl::StripTrailingSlash).path());
+    }
+    invalidateStored(src.path());
+    invalidateStored(dest.path());
+
     const auto srcOneDriveUrl = OneDriveUrl(src);
     const auto destOneDriveUrl = OneDriveUrl(dest);
     const QString sourceAccountId = srcOneDriveUrl.account();
     const QString destAccountId = destOneDriveUrl.account();
 
-    // TODO: Does this actually happen, or does KIO treat our account name as host?
     if (sourceAccountId != destAccountId) {
-        error(KIO::ERR_UNSUPPORTED_ACTION, src.path());
+        // Move across accounts: copy, then delete the source.
+        if (copyAcrossAccounts(src, dest, flags).isEmpty()) {
+            return;
+        }
+
+        // Deleted like del() does, but not left queued: the move fails
+        // when the source stays.
+        if (!deleteItem(src, true)) {
+            return;
+        }
+        if (!flushQueuedDeletes(srcPath)) {
+            error(KIO::ERR_CANNOT_DELETE, src.path());
+            return;
+        }
+
+        finished();
         return;
     }
 
@@ -985,84 +2330,114 @@ void KIOOneDrive::rename(const QUrl &src, const QUrl &dest, KIO::JobFlags flags)
         return;
     }
 
+    if (destOneDriveUrl.isRoot() || destOneDriveUrl.isAccountRoot()) {
+        // user is trying to move to top-level onedrive:/// or to replace an account
+        error(KIO::ERR_ACCESS_DENIED, dest.fileName());
+        return;
+    }
+
+    // Both IDs usually come from the cache, filled when the folders were listed.
     const QUrlQuery urlQuery(src);
     const QString sourceFileId
         = urlQuery.hasQueryItem(QStringLiteral("id"))
             ? urlQuery.queryItemValue(QStringLiteral("id"))
-            : resolveFileIdFromPath(src.adjusted(QUrl::StripTrailingSlash).path(),
-                                    KIOOneDrive::PathIsFile);
+            : resolveFileIdFromPath(src.adjusted(QUrl::StripTrailingSlash).path());
     if (sourceFileId.isEmpty()) {
         error(KIO::ERR_DOES_NOT_EXIST, src.path());
         return;
     }
 
-    // We need to fetch ALL, so that we can do update later
-    FileFetchJob sourceFileFetchJob(sourceFileId, getAccount(sourceAccountId));
-    runJob(sourceFileFetchJob, src, sourceAccountId);
+    // Send only what changes: the name, and the parent when moving.
+    QJsonObject patch;
+    patch.insert(QStringLiteral("name"), destOneDriveUrl.pathComponents().last());
+    if (srcOneDriveUrl.parentPath() != destOneDriveUrl.parentPath()) {
+        const QString destDirId = destOneDriveUrl.pathComponents().size() == 2
+            ? rootFolderId(destAccountId)
+            : resolveFileIdFromPath(destOneDriveUrl.parentPath(), KIOOneDrive::PathIsFolder);
+        if (destDirId.isEmpty()) {
+            error(KIO::ERR_DOES_NOT_EXIST, dest.adjusted(QUrl::RemoveFilename|QUrl::StripTrailingSlash).path());
+            return;
+        }
 
-    const ObjectsList objects = sourceFileFetchJob.items();
-    if (objects.count() != 1) {
-        qCDebug(ONEDRIVE) << "FileFetchJob retrieved" << objects.count() << "items, while only one was expected.";
-        error(KIO::ERR_DOES_NOT_EXIST, src.path());
-        return;
+        QJsonObject parentReference;
+        parentReference.insert(QStringLiteral("id"), destDirId);
+        patch.insert(QStringLiteral("parentReference"), parentReference);
     }
 
-    const FilePtr sourceFile = objects[0].dynamicCast<File>();
-
-    ParentReferencesList parentReferences = sourceFile->parents();
-    if (destOneDriveUrl.isRoot()) {
-        // user is trying to move to top-level onedrive:///
-        error(KIO::ERR_ACCESS_DENIED, dest.fileName());
+    GraphRequest request(OneDriveHelper::networkAccessManager(), "PATCH", QStringLiteral("/items/%1").arg(sourceFileId), patch);
+    QUrlQuery query;
+    query.addQueryItem(QStringLiteral("@microsoft.graph.conflictBehavior"),
+                       flags & KIO::Overwrite ? QStringLiteral("replace") : QStringLiteral("fail"));
+    request.setQuery(query);
+    if (!runGraphRequest(request, dest, sourceAccountId)) {
         return;
     }
-    const auto srcPathComps = srcOneDriveUrl.pathComponents();
-    const auto destPathComps = destOneDriveUrl.pathComponents();
-    if (destOneDriveUrl.isAccountRoot()) {
-        // user is trying to move to root -> we are only renaming
-    } else {
-         // skip filename and extract the second-to-last component
-        const QString destDirId = resolveFileIdFromPath(destOneDriveUrl.parentPath(), KIOOneDrive::PathIsFolder);
-        const QString srcDirId = resolveFileIdFromPath(srcOneDriveUrl.parentPath(), KIOOneDrive::PathIsFolder);
-
-        // Remove source from parent references
-        auto iter = parentReferences.begin();
-        bool removed = false;
-        while (iter != parentReferences.end()) {
-            const ParentReferencePtr ref = *iter;
-            if (ref->id() == srcDirId) {
-                parentReferences.erase(iter);
-                removed = true;
-                break;
-            }
-            ++iter;
+
+    m_cache.removeSubtree(src.adjusted(QUrl::StripTrailingSlash).path());
+    m_cache.insertPath(dest.adjusted(QUrl::StripTrailingSlash).path(), sourceFileId);
+
+    finished();
+}
+
+void KIOOneDrive::renamePartial(const UploadJournal::Upload &partial, const QUrl &dest, KIO::JobFlags flags)
+{
+    const QString destPath = dest.adjusted(QUrl::StripTrailingSlash).path();
+
+    // Unless the original was just deleted, or is to be overwritten, only a
+    // new file can be saved this way.
+    if (!(flags & KIO::Overwrite) && partial.deletedTarget != destPath) {
+        UploadJournal::Upload pending;
+        if (m_journal.upload(destPath, &pending)) {
+            error(KIO::ERR_FILE_ALREADY_EXIST, dest.path());
+            return;
         }
-        if (!removed) {
-            qCDebug(ONEDRIVE) << "Could not remove" << src << "from parent references.";
-            error(KIO::ERR_DOES_NOT_EXIST, src.path());
+        if (!checkOnline(dest)) {
+            return;
+        }
+        if (!resolveFileIdFromPath(destPath).isEmpty()) {
+            error(KIO::ERR_FILE_ALREADY_EXIST, dest.path());
             return;
         }
-
-        // Add destination to parent references
-        parentReferences << ParentReferencePtr(new ParentReference(destDirId));
     }
 
-    const QString destFileName = destPathComps.last();
-
-    FilePtr destFile(sourceFile);
-    destFile->setTitle(destFileName);
-    destFile->setParents(parentReferences);
+    // The version the data replaces, as last seen, for the agent to detect
+    // concurrent changes.
+    QString baseCTag;
+    KIO::UDSEntry entry;
+    QDateTime storedAt;
+    if (m_offline.entry(destPath, &entry, &storedAt)) {
+        baseCTag = entry.stringValue(OneDriveHelper::CTag);
+    }
 
-    FileModifyJob modifyJob(destFile, getAccount(sourceAccountId));
-    modifyJob.setUpdateModifiedDate(true);
-    runJob(modifyJob, dest, sourceAccountId);
+    qCDebug(ONEDRIVE) << "Uploading the partial file of" << dest << "over it";
+    if (!m_journal.rename(partial, destPath, baseCTag)) {
+        error(KIO::ERR_CANNOT_WRITE, dest.path());
+        return;
+    }
+    invalidateStored(partial.path);
+    invalidateStored(destPath);
 
     finished();
 }
 
 void KIOOneDrive::mimetype(const QUrl &url)
 {
+    Metrics::Timer timer(&m_metrics, Metrics::Command, "mimetype");
+
     qCDebug(ONEDRIVE) << Q_FUNC_INFO << url;
 
+    UploadJournal::Upload upload;
+    if (m_journal.upload(url.adjusted(QUrl::StripTrailingSlash).path(), &upload)) {
+        mimeType(uploadToUDSEntry(upload).stringValue(KIO::UDSEntry::UDS_MIME_TYPE));
+        finished();
+        return;
+    }
+
+    const StoreUse use = storeUse(url);
+    if (use != NetworkOnly && (mimetypeFromStore(url, use) || storeMiss(url, use))) {
+        return;
+    }
+
     const QUrlQuery urlQuery(url);
     const QString fileId
         = urlQuery.hasQueryItem(QStringLiteral("id"))
@@ -1074,19 +2449,45 @@ void KIOOneDrive::mimetype(const QUrl &url)
     }
     const QString accountId = OneDriveUrl(url).account();
 
-    FileFetchJob fileFetchJob(fileId, getAccount(accountId));
-    fileFetchJob.setFields(FileFetchJob::Id | FileFetchJob::MimeType);
-    runJob(fileFetchJob, url, accountId);
-
-    const ObjectsList objects = fileFetchJob.items();
-    if (objects.count() != 1) {
+    const FilePtr file = fetchFile(fileId, url, accountId);
+    if (!file) {
         error(KIO::ERR_DOES_NOT_EXIST, url.path());
         return;
     }
 
-    const FilePtr file = objects.first().dynamicCast<File>();
     mimeType(file->mimeType());
     finished();
 }
 
+void KIOOneDrive::special(const QByteArray &data)
+{
+    Metrics::Timer timer(&m_metrics, Metrics::Command, "special");
+    clearLookups();
+
+    QDataStream stream(data);
+    qint32 command = 0;
+    stream >> command;
+
+    switch (command) {
+        case DumpTrace: {
+            QString fileName;
+            stream >> fileName;
+            if (!Tracer::isEnabled()) {
+                error(KIO::ERR_UNSUPPORTED_ACTION, i18n("Tracing is not enabled, set ONEDRIVE_TRACE_DIR."));
+            } else if (!Tracer::dump(fileName)) {
+                error(KIO::ERR_CANNOT_WRITE, fileName);
+            } else {
+                finished();
+            }
+            break;
+        }
+        case FlushDeletes:
+            // Sent by the worker itself, not by a job waiting for finished().
+            sendQueuedDeletes();
+            break;
+        default:
+            error(KIO::ERR_UNSUPPORTED_ACTION, QString::number(command));
+    }
+}
+
 #include "kio_onedrive.moc"
@@ -20,7 +20,17 @@
 #ifndef ONEDRIVESLAVE_H
 #define ONEDRIVESLAVE_H
 
+#include "connectivity.h"
+#include "inflighttable.h"
+#include "metrics.h"
+#include "offlinestore.h"
 #include "pathcache.h"
+#include "quotacache.h"
+#include "uploadjournal.h"
+
+#include <QDateTime>
+#include <QHash>
+#include <QJsonObject>
 
 #include <KMGraph/Account>
 #include <KMGraph/Types>
@@ -29,21 +39,31 @@
 #include <memory>
 
 class AbstractAccountManager;
+class DriveNavigator;
+class GraphRequest;
 
+class QIODevice;
 class QTemporaryFile;
 
-namespace KMGraph2
-{
-class Job;
-}
-
 class KIOOneDrive : public KIO::SlaveBase
 {
 public:
-    enum Action {
-        Success,
-        Fail,
-        Restart
+    /**
+     * Commands accepted by special(). The data is a QDataStream holding the
+     * command (qint32) followed by its arguments.
+     */
+    enum SpecialCommand {
+        /**
+         * Arguments: QString fileName. Writes the trace recorded so far there,
+         * or in ONEDRIVE_TRACE_DIR if empty. See Tracer.
+         */
+        DumpTrace = 4,
+        /**
+         * No arguments. Sent by the worker to itself once idle, see
+         * setTimeoutSpecialCommand(): sends the deletions queued by del().
+         * Nothing is reported back, there is no job to report to.
+         */
+        FlushDeletes = 7
     };
 
     explicit KIOOneDrive(const QByteArray &protocol,
@@ -52,6 +72,7 @@ public:
     virtual ~KIOOneDrive();
 
     virtual void openConnection() Q_DECL_OVERRIDE;
+    virtual void closeConnection() Q_DECL_OVERRIDE;
     virtual void listDir(const QUrl &url) Q_DECL_OVERRIDE;
     virtual void mkdir(const QUrl &url, int permissions) Q_DECL_OVERRIDE;
 
@@ -64,8 +85,10 @@ public:
     virtual void del(const QUrl &url, bool isfile) Q_DECL_OVERRIDE;
 
     virtual void mimetype(const QUrl &url) Q_DECL_OVERRIDE;
+    virtual void special(const QByteArray &data) Q_DECL_OVERRIDE;
 
 protected:
+    void dispatch(int command, const QByteArray &data) Q_DECL_OVERRIDE;
     void virtual_hook(int id, void *data) Q_DECL_OVERRIDE;
 
 private:
@@ -82,10 +105,81 @@ private:
     void listAccounts();
     void createAccount();
 
+    /**
+     * Lists the items below the folder of @p url whose name or content
+     * matches its "search" query item, as found by the server.
+     */
+    void search(const QUrl &url);
+
+    /**
+     * Lists the whole subtree of the folder of @p url from its change feed,
+     * in a few pages rather than one listing per folder. Entries are named
+     * by their path relative to the folder, as in KIO::listRecursive().
+     */
+    void listRecursive(const QUrl &url);
+
     QString resolveFileIdFromPath(const QString &path, PathFlags flags = None);
 
-    Action handleError(const KMGraph2::Job &job, const QUrl &url);
-    KIO::UDSEntry fileToUDSEntry(const KMGraph2::OneDrive::FilePtr &file, const QString &path) const;
+    /**
+     * @return The file ID in the "id" query item of @p url, or else the resolved ID of its path.
+     */
+    QString fileIdForUrl(const QUrl &url, PathFlags flags = None);
+
+    /**
+     * Fails the current command if the servers cannot be reached, rather
+     * than waiting for the network to time out.
+     * @return Whether we are online.
+     */
+    bool checkOnline(const QUrl &url);
+
+    enum StoreUse {
+        NetworkOnly,
+        /** In a hot folder or a subtree just listed, the network is used on a miss only. */
+        StoreFirst,
+        /** Offline. */
+        StoreOnly
+    };
+
+    /**
+     * @return Whether the current command on @p url can, or must, be answered
+     * from the offline store.
+     */
+    StoreUse storeUse(const QUrl &url);
+
+    /**
+     * To be called when the store could not answer. Fails the current command
+     * if offline.
+     * @return Whether the command is over.
+     */
+    bool storeMiss(const QUrl &url, StoreUse use);
+
+    /**
+     * Forgets what the store knows of @p path, which is about to change on
+     * the server, and stops trusting the subtree listings around it.
+     */
+    void invalidateStored(const QString &path);
+
+    /**
+     * Flags the answer of the current command as served from the store, with
+     * the time the data was stored at.
+     */
+    void setStoreMetaData(const QDateTime &storedAt, StoreUse use);
+
+    /**
+     * @return The local file holding the stored content of @p entry, or an
+     * empty string.
+     */
+    QString storedContent(const KIO::UDSEntry &entry) const;
+
+    /**
+     * These answer the command from the store.
+     * @return Whether the command is over, false on a miss.
+     */
+    bool listDirFromStore(const QUrl &url, StoreUse use);
+    bool statFromStore(const QUrl &url, StoreUse use);
+    bool mimetypeFromStore(const QUrl &url, StoreUse use);
+    bool getFromStore(const QUrl &url, StoreUse use);
+    bool copyToFileFromStore(const QUrl &src, const QUrl &dest, KIO::JobFlags flags, StoreUse use);
 
     void fileSystemFreeSpace(const QUrl &url);
 
@@ -93,17 +187,177 @@ private:
 
     QString rootFolderId(const QString &accountId);
 
+    /**
+     * Fetches the metadata of @p fileId, sharing the result with the
+     * identical fetches that follow closely.
+     * @param item Set to the item as received, when given.
+     * @return The file, or a null pointer if it could not be fetched.
+     */
+    KMGraph2::OneDrive::FilePtr fetchFile(const QString &fileId, const QUrl &url, const QString &accountId,
+                                          QJsonObject *item = nullptr);
+
+    /**
+     * @return A navigator whose requests go through runGraphRequest().
+     */
+    DriveNavigator navigator(const QUrl &url, const QString &accountId);
+
+    /**
+     * Uploads @p content to @p itemPath, e.g. "/items/{id}", replacing the
+     * content of an existing item. Contents up to SimpleUploadLimit take a
+     * single request, larger ones go through uploadInSession().
+     * @return The uploaded item, or an empty object after calling error().
+     */
+    QJsonObject uploadContent(const QString &itemPath, QIODevice *content, qint64 size,
+                              const QUrl &url, const QString &accountId,
+                              const QDateTime &modified = QDateTime());
+
+    /**
+     * Uploads @p content to @p itemPath through an UploadSession, which gives
+     * way to browsing between chunks, and reports the progress.
+     * @return The uploaded item, or an empty object after calling error().
+     */
+    QJsonObject uploadInSession(const QString &itemPath, QIODevice *content, qint64 size,
+                                const QUrl &url, const QString &accountId,
+                                const QDateTime &modified = QDateTime());
+
+    /**
+     * Stops sharing lookup results, before changing anything on the server.
+     */
+    void clearLookups();
+
+    /**
+     * Fetches the quota of the drive of @p accountId into the quota cache.
+     * @return Whether the quota was fetched.
+     */
+    bool fetchQuota(const QString &accountId, const QUrl &url);
+
+    /**
+     * Uploads the local file @p src straight from disk, without going
+     * through the get+put data round trips of the file worker.
+     */
+    void copyFromFile(const QUrl &src, const QUrl &dest);
+
+    /**
+     * Downloads @p src straight into the local file @p dest, honoring
+     * KIO's partial files and resume.
+     */
+    void copyToFile(const QUrl &src, const QUrl &dest, KIO::JobFlags flags);
+
+    /**
+     * Streams the file @p src into @p dest, which belongs to another account.
+     * @return The id of the source file, or an empty string if the copy failed
+     * (in which case error() has already been called).
+     */
+    QString copyAcrossAccounts(const QUrl &src, const QUrl &dest, KIO::JobFlags flags);
+
     bool putUpdate(const QUrl &url);
     bool putCreate(const QUrl &url);
     bool readPutData(QTemporaryFile &tmpFile);
 
     /**
-     * @return Whether @p job succeeded.
+     * Queues the data of the current put() in the upload journal, for the
+     * sync agent to send. See UploadJournal.
+     */
+    void putWriteBack(const QUrl &url);
+
+    /**
+     * Completes a safe save: the pending upload @p partial of "name.part"
+     * becomes a single upload over @p dest, instead of a new item renamed.
+     */
+    void renamePartial(const UploadJournal::Upload &partial, const QUrl &dest, KIO::JobFlags flags);
+
+    /**
+     * @return The entries of the uploads pending in the folder @p path, by name.
+     * They replace the entries of the server until the uploads are committed.
+     */
+    QHash<QString, KIO::UDSEntry> pendingUploadEntries(const QString &path) const;
+
+    /**
+     * Sends the pending upload of @p url now, if any, before an operation
+     * that needs its content on the server.
+     * @return Whether the content is on the server, or else error() was called.
      */
-    bool runJob(KMGraph2::Job &job, const QUrl &url, const QString &accountId);
+    bool flushPendingUpload(const QUrl &url);
+
+    /**
+     * Forgets the pending uploads of @p path and below, which is being
+     * deleted or overwritten.
+     * @return Whether there were any.
+     */
+    bool dropPendingUploads(const QString &path);
+
+    /**
+     * Deletes @p path, whose deletion was deferred to a safe save that was
+     * abandoned. Failures are only logged, the command that deleted it is over.
+     */
+    void deleteDeferredTarget(const QString &path);
+
+    /**
+     * Sends @p request, refreshing the token and waiting out throttling as
+     * needed, and calls error() if it fails.
+     * @return Whether @p request succeeded.
+     */
+    bool runGraphRequest(GraphRequest &request, const QUrl &url, const QString &accountId);
+    bool sendGraphRequest(GraphRequest &request, const QUrl &url, const QString &accountId);
+
+    /**
+     * Deletes @p url the way del() does, without finishing the command.
+     * @return Whether the item was deleted, or its deletion queued or
+     * deferred, false after calling error().
+     */
+    bool deleteItem(const QUrl &url, bool isfile);
+
+    /**
+     * @return The number of parents of the item @p fileId at @p url, 0 if
+     * unknown.
+     */
+    int parentsCount(const QUrl &url, const QString &fileId, const QString &accountId);
+
+    /**
+     * Queues the deletion of the file @p fileId at @p url, sent in one batch
+     * with the deletions that follow. KIO deletes file by file, with one del()
+     * each: the batch is sent once MaxRequests are queued, before any other
+     * command, and once the worker is idle.
+     * @return Whether the file was deleted, or queued. Fails if it was in the
+     * batch sent and could not be deleted.
+     */
+    bool queueDelete(const QUrl &url, const QString &fileId, const QString &accountId);
+
+    /**
+     * Sends the deletions queued by queueDelete(), without reporting
+     * anything: the commands that queued them are over.
+     * @return The paths that could not be deleted.
+     */
+    QStringList sendQueuedDeletes();
+
+    /**
+     * Same as sendQueuedDeletes(), from within a command, which is warned
+     * about the deletions that failed, except the one of @p path.
+     * @return Whether @p path, if queued, was deleted.
+     */
+    bool flushQueuedDeletes(const QString &path = QString());
 
     std::unique_ptr<AbstractAccountManager> m_accountManager;
     PathCache m_cache;
+    QuotaCache m_quotas;
+    InflightTable<QString> m_resolveFlights;
+    InflightTable<QJsonObject> m_fetchFlights;
+    Metrics m_metrics;
+    Connectivity m_connectivity;
+    OfflineStore m_offline;
+    /** The folders listed with ?recursive, and when, see storeUse(). */
+    QHash<QString, QDateTime> m_subtreesListedAt;
+    UploadJournal m_journal;
+    /** Whether put() returns once the data is in the journal, see UploadJournal. */
+    bool m_writeBack = false;
+    /** The files whose deletion is queued, see queueDelete(). */
+    QList<QPair<QUrl, QString /* fileId */>> m_queuedDeletes;
+    QString m_queuedDeletesAccount;
+    /**
+     * Whether runGraphRequest() called error() during the current
+     * command, e.g. while looking up a path.
+     */
+    bool m_errorReported = false;
 
     QMap<QString /* account */, QString /* rootId */> m_rootIds;
 
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "metrics.h"
+#include "onedrivedebug.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QSaveFile>
+#include <QtAlgorithms>
+#include <QtMath>
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+// Below 4 us values have a bucket each, above each power of two has four.
+const int SubBuckets = 4;
+const int MaxExponent = 40;
+const int BucketCount = SubBuckets + (MaxExponent - 1) * SubBuckets;
+
+// Exported bucket bounds: from 128 us to 67 s, by powers of two.
+const int FirstExportedExponent = 7;
+const int LastExportedExponent = 26;
+
+const char *const KindNames[] = { "command", "job" };
+
+const struct {
+    Metrics::Counter counter;
+    const char *name;
+    const char *labels;
+    const char *help;
+} CounterInfo[] = {
+    { Metrics::BytesUploaded, "kio_onedrive_bytes_total", "direction=\"up\"", "Bytes sent to or received from the server." },
+    { Metrics::BytesDownloaded, "kio_onedrive_bytes_total", "direction=\"down\"", nullptr },
+    { Metrics::PathCacheHits, "kio_onedrive_cache_lookups_total", "cache=\"path\",result=\"hit\"", "Lookups in the caches of the worker." },
+    { Metrics::PathCacheMisses, "kio_onedrive_cache_lookups_total", "cache=\"path\",result=\"miss\"", nullptr },
+    { Metrics::QuotaCacheHits, "kio_onedrive_cache_lookups_total", "cache=\"quota\",result=\"hit\"", nullptr },
+    { Metrics::QuotaCacheMisses, "kio_onedrive_cache_lookups_total", "cache=\"quota\",result=\"miss\"", nullptr },
+    { Metrics::ResolveLookupsSent, "kio_onedrive_lookups_total", "lookup=\"resolve\",result=\"sent\"", "Path resolutions and item fetches, sent to the server or shared with an identical one." },
+    { Metrics::ResolveLookupsShared, "kio_onedrive_lookups_total", "lookup=\"resolve\",result=\"shared\"", nullptr },
+    { Metrics::FetchLookupsSent, "kio_onedrive_lookups_total", "lookup=\"fetch\",result=\"sent\"", nullptr },
+    { Metrics::FetchLookupsShared, "kio_onedrive_lookups_total", "lookup=\"fetch\",result=\"shared\"", nullptr },
+    { Metrics::Retries, ""kio_onedrive_retries_total", "", "Requests sent again, e.g. after refreshing the access token." },
+    { Metrics::Throttles, "kio_onedrive_throttles_total", "", "Requests rejected by the server because of throttling." },
+};
+}
+
+Metrics::Histogram::Histogram()
+    : m_buckets(BucketCount, 0)
+{
+}
+
+int Metrics::Histogram::bucket(qint64 usecs)
+{
+    if (usecs < SubBuckets) {
+        return qMax<qint64>(0, usecs);
+    }
+
+    const int exponent = 63 - qCountLeadingZeroBits(quint64(usecs));
+    if (exponent >= MaxExponent) {
+        return BucketCount - 1;
+    }
+    const int sub = int(usecs >> (exponent - 2)) - SubBuckets;
+    return SubBuckets + (exponent - 2) * SubBuckets + sub;
+}
+
+qint64 Metrics::Histogram::upperBound(int bucket)
+{
+    if (bucket < SubBuckets) {
+        return bucket + 1;
+    }
+
+    const int exponent = (bucket - SubBuckets) / SubBuckets + 2;
+    const int sub = (bucket - SubBuckets) % SubBuckets;
+    return qint64(SubBuckets + sub + 1) << (exponent - 2);
+}
+
+// Buckets hold the values above their lower bound, up to their upper bound
+// included, so that the upper bound of a power of two is exact.
+void Metrics::Histogram::record(qint64 usecs)
+{
+    ++m_buckets[bucket(usecs - 1)];
+    ++m_count;
+    m_sum += usecs;
+}
+
+qint64 Metrics::Histogram::count() const
+{
+    return m_count;
+}
+
+qint64 Metrics::Histogram::sum() const
+{
+    return m_sum;
+}
+
+qint64 Metrics::Histogram::countAtMost(qint64 usecs) const
+{
+    const int last = bucket(usecs - 1);
+    qint64 count = 0;
+    for (int i = 0; i <= last; ++i) {
+        count += m_buckets.at(i);
+    }
+    return count;
+}
+
+qint64 Metrics::Histogram::percentile(double percentile) const
+{
+    const qint64 rank = qCeil(m_count * percentile / 100.0);
+    qint64 count = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        count += m_buckets.at(i);
+        if (count >= rank && count > 0) {
+            return upperBound(i);
+        }
+    }
+    return 0;
+}
+
+Metrics::Timer::Timer(Metrics *metrics, Kind kind, const char *name)
+    : m_metrics(metrics)
+    , m_kind(kind)
+    , m_name(name)
+    , m_span(name)
+{
+    m_timer.start();
+}
+
+Metrics::Timer::~Timer()
+{
+    const char *shortName = strrchr(m_name, ':');
+    m_metrics->record(m_kind, QString::fromLatin1(shortName ? shortName + 1 : m_name), m_timer.nsecsElapsed() / 1000);
+    if (m_kind == Command) {
+        m_metrics->maybeWriteSnapshot();
+    }
+}
+
+Metrics::Metrics(const QString &directory, qint64 interval)
+    : m_directory(directory)
+    , m_interval(interval)
+{
+}
+
+Metrics::~Metrics()
+{
+    for (const auto kind : { Command, Job }) {
+        for (auto it = m_histograms[kind].constBegin(); it != m_histograms[kind].constEnd(); ++it) {
+            qCDebug(ONEDRIVE) << KindNames[kind] << it.key() << "count" << it->count()
+                              << "p50" << it->percentile(50) << "us p99" << it->percentile(99) << "us";
+        }
+    }
+    if (!m_directory.isEmpty()) {
+        writeSnapshot();
+    }
+}
+
+void Metrics::record(Kind kind, const QString &name, qint64 usecs)
+{
+    m_histograms[kind][name].record(usecs);
+}
+
+Metrics::Histogram Metrics::histogram(Kind kind, const QString &name) const
+{
+    return m_histograms[kind].value(name);
+}
+
+void Metrics::add(Counter counter, qint64 value)
+{
+    m_counters[counter] += value;
+}
+
+qint64 Metrics::counter(Counter counter) const
+{
+    return m_counters[counter];
+}
+
+QByteArray Metrics::toPrometheus() const
+{
+    QByteArray text;
+
+    for (const auto kind : { Command, Job }) {
+        const QByteArray name = QByteArray("kio_onedrive_") + KindNames[kind] + "_duration_seconds";
+        text += "# HELP " + name + " Duration of the " + KindNames[kind] + "s run by the worker.\n";
+        text += "# TYPE " + name + " histogram\n";
+
+        // Sorted, so that consecutive snapshots are easy to compare.
+        QStringList names = m_histograms[kind].keys();
+        std::sort(names.begin(), names.end());
+        for (const auto &histogramName : qAsConst(names)) {
+            const Histogram &histogram = m_histograms[kind][histogramName];
+            const QByteArray label = QByteArray(KindNames[kind]) + "=\"" + histogramName.toUtf8() + '"';
+            for (int exponent = FirstExportedExponent; exponent <= LastExportedExponent; ++exponent) {
+                const qint64 bound = qint64(1) << exponent;
+                text += name + "_bucket{" + label + ",le=\"" + QByteArray::number(bound / 1e6, 'g', 9) + "\"} "
+                        + QByteArray::number(histogram.countAtMost(bound)) + '\n';
+            }
+            text += name + "_bucket{" + label + ",le=\"+Inf\"} " + QByteArray::number(histogram.count()) + '\n';
+            text += name + "_sum{" + label + "} " + QByteArray::number(histogram.sum() / 1e6, 'g', 12) + '\n';
+            text += name + "_count{" + label + "} " + QByteArray::number(histogram.count()) + '\n';
+        }
+    }
+
+    for (const auto &info : CounterInfo) {
+        if (info.help) {
+            text += QByteArray("# HELP ") + info.name + ' ' + info.help + '\n';
+            text += QByteArray("# TYPE ") + info.name + " counter\n";
+        }
+        text += info.name;
+        if (*info.labels) {
+            text += QByteArray("{") + info.labels + '}';
+        }
+        text += ' ' + QByteArray::number(m_counters[info.counter]) + '\n';
+    }
+
+    return text;
+}
+
+void Metrics::maybeWriteSnapshot()
+{
+    if (m_directory.isEmpty() || (m_lastSnapshot.isValid() && !m_lastSnapshot.hasExpired(m_interval))) {
+        return;
+    }
+    writeSnapshot();
+}
+
+bool Metrics::writeSnapshot()
+{
+    m_lastSnapshot.start();
+
+    const QString fileName = QStringLiteral("kio_onedrive-%1.prom").arg(QCoreApplication::applicationPid());
+    // Written atomically, so that scrapers never read half a snapshot.
+    QSaveFile file(QDir(m_directory).filePath(fileName));
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(ONEDRIVE) << "Cannot write metrics to" << file.fileName() << file.errorString();
+        return false;
+    }
+    file.write(toPrometheus());
+    return file.commit();
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "tracer.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+/**
+ * Latencies and counters of the worker, exported in the Prometheus text format.
+ *
+ * When a directory is set, a snapshot is written there as
+ * kio_onedrive-<pid>.prom at most once per interval, after a command, and on
+ * exit; node_exporter's textfile collector can scrape it from there.
+ */
+class Metrics
+{
+public:
+    /**
+     * Latency histogram with four buckets per power of two, in microseconds,
+     * so that percentiles are within 25% of the recorded values.
+     */
+    class Histogram
+    {
+    public:
+        Histogram();
+
+        void record(qint64 usecs);
+
+        qint64 count() const;
+        qint64 sum() const;
+
+        /**
+         * @return The number of recorded values up to @p usecs included, as
+         * Prometheus counts its buckets. Exact when @p usecs is a power of two.
+         */
+        qint64 countAtMost(qint64 usecs) const;
+
+        /**
+         * @return An upper bound of the @p percentile (0 to 100) of the values.
+         */
+        qint64 percentile(double percentile) const;
+
+    private:
+        static int bucket(qint64 usecs);
+        static qint64 upperBound(int bucket);
+
+        QVector<qint64> m_buckets;
+        qint64 m_count = 0;
+        qint64 m_sum = 0;
+    };
+
+    enum Kind {
+        Command,
+        Job
+    };
+
+    enum Counter {
+        BytesUploaded,
+        BytesDownloaded,
+        PathCacheHits,
+        PathCacheMisses,
+        QuotaCacheHits,
+        QuotaCacheMisses,
+        ResolveLookupsSent,
+        ResolveLookupsShared,
+        FetchLookupsSent,
+        FetchLookupsShared,
+        Retries,
+        Throttles,
+        CounterCount
+    };
+
+    /**
+     * Records the time until it goes out of scope, also as a trace span.
+     * @p name must outlive the tracer, see Tracer. Namespaces are stripped
+     * from the name in the metrics.
+     */
+    class Timer
+    {
+    public:
+        Timer(Metrics *metrics, Kind kind, const char *name);
+        ~Timer();
+
+    private:
+        Metrics *m_metrics;
+        Kind m_kind;
+        const char *m_name;
+        QElapsedTimer m_timer;
+        Tracer::Span m_span;
+    };
+
+    explicit Metrics(const QString &directory = QString(), qint64 interval = 10000);
+    ~Metrics();
+
+    void record(Kind kind, const QString &name, qint64 usecs);
+    Histogram histogram(Kind kind, const QString &name) const;
+
+    void add(Counter counter, qint64 value = 1);
+    qint64 counter(Counter counter) const;
+
+    QByteArray toPrometheus() const;
+
+    /**
+     * Writes a snapshot, unless the previous one is more recent than the interval.
+     */
+    void maybeWriteSnapshot();
+    bool writeSnapshot();
+
+private:
+    QString m_directory;
+    qint64 m_interval;
+    QElapsedTimer m_lastSnapshot;
+    QHash<QString, Histogram> m_histograms[2];
+    qint64 m_counters[CounterCount] = {};
+};
+
+#endif // METRICS_H
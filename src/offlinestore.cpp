@@ -0,0 +1,420 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "offlinestore.h"
+#include "onedrivedebug.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+static const quint32 FormatVersion = 1;
+// A single content may take at most this fraction of the budget.
+static const int MaxContentShare = 8;
+// Metadata beyond the budget is trimmed down to this fraction of it, so that
+// the records are not listed again on every write.
+static const int MetadataTrimNumerator = 3;
+static const int MetadataTrimDenominator = 4;
+
+static QString normalized(const QString &path)
+{
+    QString result = path;
+    while (result.endsWith(QLatin1Char('/'))) {
+        result.chop(1);
+    }
+    if (!result.startsWith(QLatin1Char('/'))) {
+        result.prepend(QLatin1Char('/'));
+    }
+    return result;
+}
+
+template<typename T>
+static bool writeRecord(const QString &fileName, const T &value)
+{
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(ONEDRIVE) << "Cannot write" << fileName << ":" << file.errorString();
+        return false;
+    }
+    QDataStream stream(&file);
+    stream << FormatVersion << QDateTime::currentDateTimeUtc() << value;
+    return file.commit();
+}
+
+template<typename T>
+static bool readRecord(const QString &fileName, T *value, QDateTime *storedAt)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    quint32 version = 0;
+    stream >> version;
+    if (version != FormatVersion) {
+        return false;
+    }
+    stream >> *storedAt >> *value;
+    return stream.status() == QDataStream::Ok;
+}
+
+// Hot folders write pinned records, which the worker may have written again
+// since, so the newer of the two wins.
+template<typename T>
+static bool readNewerRecord(const QString &evictable, const QString &pinned, T *value, QDateTime *storedAt)
+{
+    T pinnedValue;
+    QDateTime pinnedAt;
+    const bool hasPinned = readRecord(pinned, &pinnedValue, &pinnedAt);
+    if (readRecord(evictable, value, storedAt) && (!hasPinned || *storedAt >= pinnedAt)) {
+        return true;
+    }
+    if (hasPinned) {
+        *value = pinnedValue;
+        *storedAt = pinnedAt;
+    }
+    return hasPinned;
+}
+
+OfflineStore::OfflineStore(const QString &directory, qint64 contentBudget)
+    : m_directory(directory)
+    , m_contentBudget(contentBudget)
+{
+    if (!m_directory.isEmpty()) {
+        QDir().mkpath(m_directory + QStringLiteral("/metadata/pinned"));
+        QDir().mkpath(m_directory + QStringLiteral("/content/pinned"));
+    }
+}
+
+OfflineStore::~OfflineStore()
+{
+}
+
+QString OfflineStore::defaultDirectory()
+{
+    if (qEnvironmentVariableIsSet("ONEDRIVE_OFFLINE_DIR")) {
+        return QString::fromLocal8Bit(qgetenv("ONEDRIVE_OFFLINE_DIR"));
+    }
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + QStringLiteral("/kio_onedrive");
+}
+
+bool OfflineStore::isEnabled() const
+{
+    return !m_directory.isEmpty();
+}
+
+void OfflineStore::setContentBudget(qint64 budget)
+{
+    m_contentBudget = budget;
+}
+
+void OfflineStore::setContentsStored(bool stored)
+{
+    m_contentsStored = stored;
+}
+
+void OfflineStore::setMetadataBudget(qint64 budget)
+{
+    m_metadataBudget = budget;
+}
+
+QString OfflineStore::metadataFile(const QString &path, const QString &kind, Retention retention) const
+{
+    const QByteArray hash = QCryptographicHash::hash(normalized(path).toUtf8(), QCryptographicHash::Sha1).toHex();
+    const QString folder = retention == Pinned ? QStringLiteral("metadata/pinned") : QStringLiteral("metadata");
+    return QStringLiteral("%1/%2/%3.%4").arg(m_directory, folder, QString::fromLatin1(hash), kind);
+}
+
+QString OfflineStore::contentFileName(const QString &fileId, const QDateTime &modified, Retention retention) const
+{
+    // Entries only carry seconds.
+    const QString folder = retention == Pinned ? QStringLiteral("content/pinned") : QStringLiteral("content");
+    return QStringLiteral("%1/%2/%3.%4").arg(m_directory, folder, fileId).arg(modified.toMSecsSinceEpoch() / 1000);
+}
+
+void OfflineStore::storeListing(const QString &path, const KIO::UDSEntryList &entries, Retention retention)
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    const QString fileName = metadataFile(path, QStringLiteral("listing"), retention);
+    if (!writeRecord(fileName, entries)) {
+        return;
+    }
+    if (retention == Pinned) {
+        QFile::remove(metadataFile(path, QStringLiteral("listing")));
+    } else {
+        metadataWritten(fileName);
+    }
+}
+
+bool OfflineStore::listing(const QString &path, KIO::UDSEntryList *entries, QDateTime *storedAt) const
+{
+    return isEnabled() && readNewerRecord(metadataFile(path, QStringLiteral("listing")),
+                                          metadataFile(path, QStringLiteral("listing"), Pinned), entries, storedAt);
+}
+
+void OfflineStore::storeEntry(const QString &path, const KIO::UDSEntry &entry, Retention retention)
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    const QString fileName = metadataFile(path, QStringLiteral("entry"), retention);
+    if (!writeRecord(fileName, entry)) {
+        return;
+    }
+    if (retention == Pinned) {
+        QFile::remove(metadataFile(path, QStringLiteral("entry")));
+    } else {
+        metadataWritten(fileName);
+    }
+}
+
+void OfflineStore::metadataWritten(const QString &fileName)
+{
+    // Overwritten records are counted twice, which only trims a bit early.
+    if (m_metadataSize < 0) {
+        m_metadataSize = 0;
+        const auto files = QDir(m_directory + QStringLiteral("/metadata")).entryInfoList(QDir::Files);
+        for (const auto &file : files) {
+            if (file.suffix() != QLatin1String("hot")) {
+                m_metadataSize += file.size();
+            }
+        }
+    } else {
+        m_metadataSize += QFileInfo(fileName).size();
+    }
+    if (m_metadataSize > m_metadataBudget) {
+        trimMetadata();
+    }
+}
+
+void OfflineStore::trimMetadata()
+{
+    QDir metadata(m_directory + QStringLiteral("/metadata"));
+    // Newest first.
+    const auto files = metadata.entryInfoList(QDir::Files, QDir::Time);
+    const qint64 target = m_metadataBudget / MetadataTrimDenominator * MetadataTrimNumerator;
+    qint64 size = 0;
+    for (const auto &file : files) {
+        if (file.suffix() == QLatin1String("hot")) {
+            continue;
+        }
+        size += file.size();
+        if (size > target) {
+            size -= file.size();
+            QFile::remove(file.absoluteFilePath());
+        }
+    }
+    m_metadataSize = size;
+    qCDebug(ONEDRIVE) << "Trimmed the offline metadata to" << size << "bytes";
+}
+
+bool OfflineStore::entry(const QString &path, KIO::UDSEntry *entry, QDateTime *storedAt) const
+{
+    if (!isEnabled()) {
+        return false;
+    }
+    if (readNewerRecord(metadataFile(path, QStringLiteral("entry")), metadataFile(path, QStringLiteral("entry"), Pinned),
+                        entry, storedAt)) {
+        return true;
+    }
+
+    const QString itemPath = normalized(path);
+    const int slash = itemPath.lastIndexOf(QLatin1Char('/'));
+    const QString name = itemPath.mid(slash + 1);
+    KIO::UDSEntryList entries;
+    if (!listing(itemPath.left(slash), &entries, storedAt)) {
+        return false;
+    }
+    for (const auto &listed : qAsConst(entries)) {
+        if (listed.stringValue(KIO::UDSEntry::UDS_NAME) == name) {
+            *entry = listed;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool OfflineStore::canStore(qint64 size, Retention retention) const
+{
+    // Pinned contents are budgeted by the sync agent.
+    if (retention == Pinned) {
+        return isEnabled();
+    }
+    return isEnabled() && m_contentsStored && size <= m_contentBudget / MaxContentShare;
+}
+
+void OfflineStore::storeContent(const QString &fileId, const QDateTime &modified, const QByteArray &data,
+                                Retention retention)
+{
+    if (!canStore(data.size(), retention) || fileId.isEmpty()) {
+        return;
+    }
+
+    removeContent(fileId);
+    const QString target = contentFileName(fileId, modified, retention);
+    QSaveFile file(target);
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        qCWarning(ONEDRIVE) << "Cannot store the content of" << fileId << ":" << file.errorString();
+        return;
+    }
+    if (retention == Evictable) {
+        trimContent(target);
+    }
+}
+
+void OfflineStore::storeContentFile(const QString &fileId, const QDateTime &modified, const QString &fileName,
+                                    Retention retention)
+{
+    if (!canStore(QFileInfo(fileName).size(), retention) || fileId.isEmpty()) {
+        return;
+    }
+
+    removeContent(fileId);
+    const QString target = contentFileName(fileId, modified, retention);
+    // Copy next to the target first, so that a partial copy is never served.
+    const QString partial = target + QStringLiteral(".part");
+    QFile::remove(partial);
+    if (!QFile::copy(fileName, partial) || !QFile::rename(partial, target)) {
+        qCWarning(ONEDRIVE) << "Cannot store the content of" << fileId << "from" << fileName;
+        QFile::remove(partial);
+        return;
+    }
+    if (retention == Evictable) {
+        trimContent(target);
+    }
+}
+
+QString OfflineStore::contentFile(const QString &fileId, const QDateTime &modified) const
+{
+    if (!isEnabled() || fileId.isEmpty()) {
+        return QString();
+    }
+
+    for (auto retention : {Pinned, Evictable}) {
+        const QString fileName = contentFileName(fileId, modified, retention);
+        if (QFileInfo::exists(fileName)) {
+            return fileName;
+        }
+    }
+    return QString();
+}
+
+void OfflineStore::removeContent(const QString &fileId)
+{
+    if (!isEnabled() || fileId.isEmpty()) {
+        return;
+    }
+
+    // Older versions of the same file are useless from now on.
+    for (const auto &folder : {QStringLiteral("/content"), QStringLiteral("/content/pinned")}) {
+        QDir content(m_directory + folder);
+        const auto names = content.entryList({fileId + QStringLiteral(".*")}, QDir::Files);
+        for (const auto &name : names) {
+            content.remove(name);
+        }
+    }
+}
+
+void OfflineStore::trimContent(const QString &stored)
+{
+    QDir content(m_directory + QStringLiteral("/content"));
+    // Oldest last. Files stored within the same second are in no useful
+    // order, so the one just stored is kept explicitly.
+    const auto files = content.entryInfoList(QDir::Files, QDir::Time);
+    qint64 size = QFileInfo(stored).size();
+    for (const auto &file : files) {
+        if (file.absoluteFilePath() == QFileInfo(stored).absoluteFilePath()) {
+            continue;
+        }
+        size += file.size();
+        if (size > m_contentBudget) {
+            qCDebug(ONEDRIVE) << "Evicting" << file.fileName() << "from the offline store";
+            QFile::remove(file.absoluteFilePath());
+        }
+    }
+}
+
+qint64 OfflineStore::contentSize() const
+{
+    if (!isEnabled()) {
+        return 0;
+    }
+
+    qint64 size = 0;
+    const auto files = QDir(m_directory + QStringLiteral("/content")).entryInfoList(QDir::Files);
+    for (const auto &file : files) {
+        size += file.size();
+    }
+    return size;
+}
+
+void OfflineStore::invalidate(const QString &path)
+{
+    if (!isEnabled()) {
+        return;
+    }
+
+    const QString itemPath = normalized(path);
+    const QString parentPath = itemPath.left(itemPath.lastIndexOf(QLatin1Char('/')));
+    for (auto retention : {Evictable, Pinned}) {
+        QFile::remove(metadataFile(itemPath, QStringLiteral("entry"), retention));
+        QFile::remove(metadataFile(itemPath, QStringLiteral("listing"), retention));
+        QFile::remove(metadataFile(parentPath, QStringLiteral("listing"), retention));
+    }
+}
+
+void OfflineStore::markHotFolder(const QString &path, const QDateTime &syncedAt)
+{
+    if (isEnabled()) {
+        writeRecord(metadataFile(path, QStringLiteral("hot")), syncedAt);
+    }
+}
+
+void OfflineStore::unmarkHotFolder(const QString &path)
+{
+    if (isEnabled()) {
+        QFile::remove(metadataFile(path, QStringLiteral("hot")));
+    }
+}
+
+bool OfflineStore::hotFolder(const QString &path, QDateTime *syncedAt) const
+{
+    if (!isEnabled()) {
+        return false;
+    }
+
+    // One lookup per level, account included.
+    QString folder = normalized(path);
+    while (folder.size() > 1) {
+        QDateTime storedAt;
+        if (readRecord(metadataFile(folder, QStringLiteral("hot")), syncedAt, &storedAt)) {
+            return true;
+        }
+        folder.truncate(folder.lastIndexOf(QLatin1Char('/')));
+    }
+    return false;
+}
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef OFFLINESTORE_H
+#define OFFLINESTORE_H
+
+#include <KIO/UDSEntry>
+
+#include <QDateTime>
+#include <QString>
+
+/**
+ * Keeps on disk what the worker last saw of the drive, so that it can still
+ * answer listDir(), stat(), mimetype() and get() while offline.
+ *
+ * Metadata is stored per path: the listing of each folder, and the entry of
+ * each item that was stat'ed. The least recently written records are
+ * evicted beyond the metadata budget. Contents are stored per file ID and
+ * modification time, so an outdated copy is never served for a newer entry,
+ * and the oldest ones are evicted beyond the content budget. Nothing is
+ * encrypted, so storing the contents can be turned off.
+ *
+ * The sync agent also stores here the folders it keeps materialized: their
+ * contents and metadata are pinned, never evicted by the budgets, and the
+ * folders are marked with the time of their last sync. See HotFolderSync.
+ */
+class OfflineStore
+{
+public:
+    static const qint64 DefaultContentBudget = 512 * 1024 * 1024;
+    static const qint64 DefaultMetadataBudget = 32 * 1024 * 1024;
+
+    enum Retention {
+        Evictable,
+        Pinned
+    };
+
+    /**
+     * @param directory Where to persist the data, nothing is stored if empty.
+     */
+    explicit OfflineStore(const QString &directory, qint64 contentBudget = DefaultContentBudget);
+    ~OfflineStore();
+
+    /**
+     * @return The directory shared by the worker and the sync agent: the
+     * ONEDRIVE_OFFLINE_DIR environment variable if set, otherwise a folder
+     * of the generic cache location.
+     */
+    static QString defaultDirectory();
+
+    bool isEnabled() const;
+
+    void setContentBudget(qint64 budget);
+
+    /**
+     * Sets whether storeContent() and storeContentFile() keep evictable
+     * contents, true by default. Pinned contents are always kept.
+     */
+    void setContentsStored(bool stored);
+
+    /**
+     * Sets the size beyond which the least recently written listings and
+     * entries are evicted. Pinned ones and hot folder marks are never evicted.
+     */
+    void setMetadataBudget(qint64 budget);
+
+    /**
+     * Pinned listings and entries, those of the hot folders, are never
+     * evicted by the metadata budget.
+     */
+    void storeListing(const QString &path, const KIO::UDSEntryList &entries, Retention retention = Evictable);
+
+    /**
+     * @return Whether the listing of the folder @p path is stored. In that
+     * case, @p entries and @p storedAt are filled.
+     */
+    bool listing(const QString &path, KIO::UDSEntryList *entries, QDateTime *storedAt) const;
+
+    void storeEntry(const QString &path, const KIO::UDSEntry &entry, Retention retention = Evictable);
+
+    /**
+     * Looks @p path up among the stat'ed items, then in the listing of its parent.
+     * @return Whether the entry of @p path is stored.
+     */
+    bool entry(const QString &path, KIO::UDSEntry *entry, QDateTime *storedAt) const;
+
+    /**
+     * Stores @p data as the content of @p fileId, modified at @p modified.
+     * Contents bigger than a fraction of the budget are not stored.
+     */
+    void storeContent(const QString &fileId, const QDateTime &modified, const QByteArray &data,
+                      Retention retention = Evictable);
+
+    /**
+     * Same as storeContent(), from the local file @p fileName.
+     */
+    void storeContentFile(const QString &fileId, const QDateTime &modified, const QString &fileName,
+                          Retention retention = Evictable);
+
+    /**
+     * @return The local file holding the content of @p fileId as modified at
+     * @p modified, or an empty string.
+     */
+    QString contentFile(const QString &fileId, const QDateTime &modified) const;
+
+    /**
+     * Removes every stored version of the content of @p fileId, pinned or not.
+     */
+    void removeContent(const QString &fileId);
+
+    /**
+     * Forgets the entry and listing of @p path, and the listing of its parent,
+     * which are about to change on the server.
+     */
+    void invalidate(const QString &path);
+
+    /**
+     * @return The total size of the stored contents, pinned ones excluded.
+     */
+    qint64 contentSize() const;
+
+    /**
+     * Marks @p path as a folder kept materialized, and synced at @p syncedAt.
+     */
+    void markHotFolder(const QString &path, const QDateTime &syncedAt);
+    void unmarkHotFolder(const QString &path);
+
+    /**
+     * @return Whether @p path is a folder kept materialized, or inside one.
+     * In that case, @p syncedAt is filled with the time of its last sync.
+     */
+    bool hotFolder(const QString &path, QDateTime *syncedAt) const;
+
+private:
+    QString metadataFile(const QString &path, const QString &kind, Retention retention = Evictable) const;
+    QString contentFileName(const QString &fileId, const QDateTime &modified, Retention retention) const;
+    bool canStore(qint64 size, Retention retention) const;
+    void trimContent(const QString &stored);
+    void metadataWritten(const QString &fileName);
+    void trimMetadata();
+
+    QString m_directory;
+    qint64 m_contentBudget;
+    bool m_contentsStored = true;
+    qint64 m_metadataBudget = DefaultMetadataBudget;
+    /** Counted on the first write, then kept up to date, or -1. */
+    qint64 m_metadataSize = -1;
+};
+
+#endif // OFFLINESTORE_H
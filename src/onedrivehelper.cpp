@@ -18,11 +18,20 @@
  */
 
 #include "onedrivehelper.h"
+#include "fixturenetworkaccessmanager.h"
 
 #include <KIO/Job>
+#include <KMGraph/Account>
 #include <KMGraph/OneDrive/File>
 #include <KLocalizedString>
 
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+
+#include <sys/stat.h>
+
 using namespace KMGraph2::OneDrive;
 
 #define VND_GOOGLE_APPS_DOCUMENT        QStringLiteral("application/vnd.google-apps.document")
@@ -49,6 +58,9 @@ using namespace KMGraph2::OneDrive;
 #define VND_OPENXMLFORMATS_OFFICEDOCUMENT_SPREADSHEETML_SHEET \
             QStringLiteral("application/vnd.openxmlformats-officedocument.spreadsheetml.sheet")
 
+#define GRAPH_URL                       QStringLiteral("https://graph.microsoft.com/v1.0")
+#define GRAPH_DRIVE_PATH                QStringLiteral("/me/drive")
+
 #define IMAGE_PNG                       QStringLiteral("image/png")
 #define IMAGE_JPEG                      QStringLiteral("image/jpeg")
 #define APPLICATION_PDF                 QStringLiteral("application/pdf")
@@ -131,6 +143,146 @@ QUrl OneDriveHelper::convertFromGDocs(KMGraph2::OneDrive::FilePtr &file)
     return file->downloadUrl();
 }
 
+QUrl OneDriveHelper::graphUrl()
+{
+    static const QUrl url = qEnvironmentVariableIsSet("ONEDRIVE_GRAPH_URL")
+        ? QUrl(QString::fromLocal8Bit(qgetenv("ONEDRIVE_GRAPH_URL")))
+        : QUrl(GRAPH_URL);
+    return url;
+}
+
+QString OneDriveHelper::graphDrivePath()
+{
+    return GRAPH_DRIVE_PATH;
+}
+
+QNetworkRequest OneDriveHelper::graphRequest(const KMGraph2::AccountPtr &account, const QString &path)
+{
+    QNetworkRequest request(QUrl(graphUrl().toString() + GRAPH_DRIVE_PATH + path));
+    request.setRawHeader("Authorization", "Bearer " + account->accessToken().toUtf8());
+    request.setHeader(QNetworkRequest::ContentTypeHeader, QStringLiteral("application/json"));
+    return request;
+}
+
+QString OneDriveHelper::searchPath(const QString &folderId, const QString &term)
+{
+    // The term is a string literal of an OData function call.
+    QString literal = term;
+    literal.replace(QLatin1Char('\''), QStringLiteral("''"));
+    const QString folder = folderId.isEmpty() ? QStringLiteral("/root") : QStringLiteral("/items/%1").arg(folderId);
+    return QStringLiteral("%1/search(q='%2')").arg(folder, QString::fromLatin1(QUrl::toPercentEncoding(literal)));
+}
+
+QString OneDriveHelper::itemPath(const QJsonObject &item, const QString &accountId)
+{
+    // e.g. "/drive/root:/Documents", percent-encoded.
+    const QString parentPath = item.value(QStringLiteral("parentReference")).toObject().value(QStringLiteral("path")).toString();
+    const int rootEnd = parentPath.indexOf(QLatin1String("root:"));
+    const QString name = item.value(QStringLiteral("name")).toString();
+    if (rootEnd < 0 || name.isEmpty()) {
+        return QString();
+    }
+
+    QString path = QLatin1Char('/') + accountId + QUrl::fromPercentEncoding(parentPath.mid(rootEnd + 5).toUtf8());
+    if (!path.endsWith(QLatin1Char('/'))) {
+        path += QLatin1Char('/');
+    }
+    return path + name;
+}
+
+static QPointer<QNetworkAccessManager> s_network;
+
+QNetworkAccessManager *OneDriveHelper::networkAccessManager()
+{
+    if (s_network) {
+        return s_network;
+    }
+
+    // Owned by the application, so that a recording is saved before exiting.
+    auto parent = QCoreApplication::instance();
+    const QString recordFile = QString::fromLocal8Bit(qgetenv("ONEDRIVE_FIXTURE_RECORD"));
+    const QString replayFile = QString::fromLocal8Bit(qgetenv("ONEDRIVE_FIXTURE_REPLAY"));
+    if (!replayFile.isEmpty()) {
+        s_network = new FixtureNetworkAccessManager(FixtureNetworkAccessManager::Replay, replayFile, parent);
+    } else if (!recordFile.isEmpty()) {
+        s_network = new FixtureNetworkAccessManager(FixtureNetworkAccessManager::Record, recordFile, parent);
+    } else {
+        s_network = new QNetworkAccessManager(parent);
+    }
+    return s_network;
+}
+
+void OneDriveHelper::setNetworkAccessManager(QNetworkAccessManager *network)
+{
+    s_network = network;
+}
+
+KIO::UDSEntry OneDriveHelper::itemToUDSEntry(const QJsonObject &item, const QString &path)
+{
+    KIO::UDSEntry entry;
+    bool isFolder = false;
+
+    const FilePtr origFile = File::fromJSON(QJsonDocument(item).toJson());
+    if (!origFile) {
+        return entry;
+    }
+    FilePtr file = origFile;
+    if (OneDriveHelper::isGDocsDocument(file)) {
+        OneDriveHelper::convertFromGDocs(file);
+    }
+
+    entry.insert(KIO::UDSEntry::UDS_NAME, file->title());
+    entry.insert(KIO::UDSEntry::UDS_DISPLAY_NAME, file->title());
+    entry.insert(KIO::UDSEntry::UDS_COMMENT, file->description());
+
+    if (file->isFolder()) {
+        entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFDIR);
+        entry.insert(KIO::UDSEntry::UDS_SIZE, 0);
+        entry.insert(ContentSize, QString::number(file->fileSize()));
+        isFolder = true;
+    } else {
+        entry.insert(KIO::UDSEntry::UDS_FILE_TYPE, S_IFREG);
+        entry.insert(KIO::UDSEntry::UDS_MIME_TYPE, file->mimeType());
+        entry.insert(KIO::UDSEntry::UDS_SIZE, file->fileSize());
+        entry.insert(KIO::UDSEntry::UDS_URL, QStringLiteral("onedrive://%1/%2?id=%3").arg(path, origFile->title(), origFile->id()));
+    }
+
+    entry.insert(KIO::UDSEntry::UDS_CREATION_TIME, file->createdDate().toTime_t());
+    entry.insert(KIO::UDSEntry::UDS_MODIFICATION_TIME, file->modifiedDate().toTime_t());
+    entry.insert(KIO::UDSEntry::UDS_ACCESS_TIME, file->lastViewedByMeDate().toTime_t());
+    if (!file->ownerNames().isEmpty()) {
+        entry.insert(KIO::UDSEntry::UDS_USER, file->ownerNames().first());
+    }
+
+    if (!isFolder) {
+        if (file->editable()) {
+            entry.insert(KIO::UDSEntry::UDS_ACCESS, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
+        } else {
+            entry.insert(KIO::UDSEntry::UDS_ACCESS, S_IRUSR | S_IRGRP | S_IROTH);
+        }
+    } else {
+        entry.insert(KIO::UDSEntry::UDS_ACCESS, S_IRUSR | S_IWUSR | S_IXUSR | S_IRGRP | S_IWGRP | S_IXGRP | S_IROTH | S_IXOTH);
+    }
+
+    // Enough to tell whether two copies of a tree differ, without any
+    // content transfer. Which hashes are given depends on the drive type.
+    const QJsonObject hashes = item.value(QStringLiteral("file")).toObject().value(QStringLiteral("hashes")).toObject();
+    const QPair<ExtraField, QString> fields[] = {
+        {ETag, item.value(QStringLiteral("eTag")).toString()},
+        {CTag, item.value(QStringLiteral("cTag")).toString()},
+        {QuickXorHash, hashes.value(QStringLiteral("quickXorHash")).toString()},
+        {Sha1Hash, hashes.value(QStringLiteral("sha1Hash")).toString()},
+        {Sha256Hash, hashes.value(QStringLiteral("sha256Hash")).toString()}
+    };
+    for (const auto &field : fields) {
+        if (!field.second.isEmpty()) {
+            entry.insert(field.first, field.second);
+        }
+    }
+
+    return entry;
+}
+
 // Currently unused, see https://phabricator.kde.org/T3443
 /*
 KIO::UDSEntry OneDriveHelper::trash()
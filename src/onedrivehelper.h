@@ -23,6 +23,11 @@
 #include <KMGraph/Types>
 #include <KIO/UDSEntry>
 
+#include <QJsonObject>
+#include <QNetworkRequest>
+
+class QNetworkAccessManager;
+
 namespace OneDriveHelper
 {
     QString folderMimeType();
@@ -32,6 +37,76 @@ namespace OneDriveHelper
     QUrl convertFromGDocs(KMGraph2::OneDrive::FilePtr &file);
 
     KIO::UDSEntry trash();
+
+    /**
+     * The extra fields of the entries, in the order of the ExtraNames
+     * of onedrive.json.
+     */
+    enum ExtraField {
+        /**
+         * The total size of the content of a folder, as aggregated by the
+         * server. UDS_SIZE stays 0 for folders, since KIO::directorySize()
+         * adds it to the sizes of the content.
+         */
+        ContentSize = KIO::UDSEntry::UDS_EXTRA,
+        /** Changes with the metadata or the content. */
+        ETag,
+        /** Changes with the content only. */
+        CTag,
+        QuickXorHash,
+        Sha1Hash,
+        Sha256Hash
+    };
+
+    /**
+     * @return The entry of the drive item @p item, as received from the
+     * server, located in the folder @p path, or an empty entry if @p item is
+     * not a drive item. The extra fields are read from @p item as well.
+     */
+    KIO::UDSEntry itemToUDSEntry(const QJsonObject &item, const QString &path);
+
+    /**
+     * @return The Microsoft Graph API root, which can be overridden with the
+     * ONEDRIVE_GRAPH_URL environment variable (e.g. to run against a local test server).
+     */
+    QUrl graphUrl();
+
+    /**
+     * @return The path of the drive endpoint, relative to graphUrl().
+     */
+    QString graphDrivePath();
+
+    /**
+     * @return A request for @p path, relative to the Microsoft Graph drive
+     * endpoint of @p account, carrying its access token.
+     */
+    QNetworkRequest graphRequest(const KMGraph2::AccountPtr &account, const QString &path);
+
+    /**
+     * @return The path, relative to the drive endpoint, that searches the
+     * items below the folder @p folderId (the root if empty) for @p term.
+     */
+    QString searchPath(const QString &folderId, const QString &term);
+
+    /**
+     * @return The path of the drive item @p item, account included, as given
+     * by its parent reference, or an empty string if the server left it out.
+     */
+    QString itemPath(const QJsonObject &item, const QString &accountId);
+
+    /**
+     * @return The network access manager shared by the requests the worker
+     * sends itself. When the ONEDRIVE_FIXTURE_RECORD or ONEDRIVE_FIXTURE_REPLAY
+     * environment variable names a file, the exchanges are recorded there, or
+     * replayed from there. See FixtureNetworkAccessManager.
+     */
+    QNetworkAccessManager *networkAccessManager();
+
+    /**
+     * Replaces the shared network access manager, e.g. to replay fixtures in
+     * tests. The caller keeps ownership of @p network.
+     */
+    void setNetworkAccessManager(QNetworkAccessManager *network);
 }
 
 
@@ -20,6 +20,8 @@
 
 #include "onedriveurl.h"
 
+#include <QUrlQuery>
+
 OneDriveUrl::OneDriveUrl(const QUrl &url)
     : m_url(url)
 {
@@ -62,3 +64,18 @@ QStringList OneDriveUrl::pathComponents() const
 {
     return m_components;
 }
+
+bool OneDriveUrl::isSearch() const
+{
+    return !isRoot() && QUrlQuery(m_url).hasQueryItem(QStringLiteral("search"));
+}
+
+QString OneDriveUrl::searchTerm() const
+{
+    return QUrlQuery(m_url).queryItemValue(QStringLiteral("search"), QUrl::FullyDecoded);
+}
+
+bool OneDriveUrl::isRecursive() const
+{
+    return !isRoot() && QUrlQuery(m_url).hasQueryItem(QStringLiteral("recursive"));
+}
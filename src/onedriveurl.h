@@ -34,6 +34,19 @@ public:
     QString parentPath() const;
     QStringList pathComponents() const;
 
+    /**
+     * @return Whether the URL asks to search the folder, e.g.
+     * "onedrive:/foo@outlook.com/Documents?search=report".
+     */
+    bool isSearch() const;
+    QString searchTerm() const;
+
+    /**
+     * @return Whether the URL asks for the whole subtree of the folder, e.g.
+     * "onedrive:/foo@outlook.com/Documents?recursive".
+     */
+    bool isRecursive() const;
+
 private:
     QUrl m_url;
     QStringList m_components;
@@ -19,6 +19,7 @@
 
 #include "pathcache.h"
 #include "onedrivedebug.h"
+#include "tracer.h"
 
 #include <QDateTime>
 
@@ -41,6 +42,7 @@ void PathCache::insertPath(const QString &path, const QString &fileId)
 
 QString PathCache::idForPath(const QString &path) const
 {
+    Tracer::Span span("PathCache::idForPath");
     if (path.startsWith(QLatin1Char('/'))) {
         return m_pathIdMap[path.mid(1)];
     } else {
@@ -72,7 +74,38 @@ QStringList PathCache::descendants(const QString &path) const
 
 void PathCache::removePath(const QString &path)
 {
-    m_pathIdMap.remove(path);
+    m_pathIdMap.remove(normalized(path));
+    m_parentsCounts.remove(normalized(path));
+}
+
+void PathCache::removeSubtree(const QString &path)
+{
+    const QString root = normalized(path);
+    const QString prefix = root + QLatin1Char('/');
+
+    for (auto iter = m_pathIdMap.begin(); iter != m_pathIdMap.end();) {
+        if (iter.key() == root || iter.key().startsWith(prefix)) {
+            m_parentsCounts.remove(iter.key());
+            iter = m_pathIdMap.erase(iter);
+        } else {
+            ++iter;
+        }
+    }
+}
+
+void PathCache::setParentsCount(const QString &path, int count)
+{
+    m_parentsCounts.insert(normalized(path), count);
+}
+
+int PathCache::parentsCount(const QString &path) const
+{
+    return m_parentsCounts.value(normalized(path));
+}
+
+QString PathCache::normalized(const QString &path)
+{
+    return path.startsWith(QLatin1Char('/')) ? path.mid(1) : path;
 }
 
 
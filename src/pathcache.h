@@ -35,9 +35,24 @@ public:
     QStringList descendants(const QString &path) const;
     void removePath(const QString &path);
 
+    /**
+     * Removes @p path and everything below it.
+     */
+    void removeSubtree(const QString &path);
+
+    void setParentsCount(const QString &path, int count);
+
+    /**
+     * @return The number of parents of @p path, or 0 if unknown.
+     */
+    int parentsCount(const QString &path) const;
+
     void dump();
 private:
+    static QString normalized(const QString &path);
+
     QHash<QString /* path */, QString> m_pathIdMap;
+    QHash<QString /* path */, int> m_parentsCounts;
 };
 
 #endif // PATHCACHE_H
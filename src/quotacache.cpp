@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "quotacache.h"
+
+QuotaCache::QuotaCache(qint64 ttl)
+    : m_ttl(ttl)
+{
+}
+
+QuotaCache::~QuotaCache()
+{
+}
+
+void QuotaCache::insert(const QString &account, qint64 total, qint64 used)
+{
+    Entry entry;
+    entry.total = total;
+    entry.used = used;
+    entry.age.start();
+    m_entries.insert(account, entry);
+}
+
+bool QuotaCache::lookup(const QString &account, qint64 *total, qint64 *used) const
+{
+    const auto it = m_entries.constFind(account);
+    if (it == m_entries.constEnd() || it->age.hasExpired(m_ttl)) {
+        return false;
+    }
+
+    *total = it->total;
+    *used = it->used;
+    return true;
+}
+
+void QuotaCache::adjustUsed(const QString &account, qint64 delta)
+{
+    auto it = m_entries.find(account);
+    if (it == m_entries.end()) {
+        return;
+    }
+
+    // Keep the original age: the server is still the source of truth.
+    it->used = qMax<qint64>(0, it->used + delta);
+}
+
+void QuotaCache::invalidate(const QString &account)
+{
+    m_entries.remove(account);
+}
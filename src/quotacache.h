@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef QUOTACACHE_H
+#define QUOTACACHE_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+
+class QuotaCache
+{
+public:
+    explicit QuotaCache(qint64 ttl = 30000);
+    ~QuotaCache();
+
+    void insert(const QString &account, qint64 total, qint64 used);
+
+    /**
+     * @return Whether a fresh quota for @p account is cached.
+     * In that case @p total and @p used are filled.
+     */
+    bool lookup(const QString &account, qint64 *total, qint64 *used) const;
+
+    /**
+     * Applies a change of @p delta bytes done by ourselves, e.g. an upload.
+     */
+    void adjustUsed(const QString &account, qint64 delta);
+
+    void invalidate(const QString &account);
+
+private:
+    struct Entry {
+        qint64 total;
+        qint64 used;
+        QElapsedTimer age;
+    };
+
+    qint64 m_ttl;
+    QHash<QString /* account */, Entry> m_entries;
+};
+
+#endif // QUOTACACHE_H
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "requestscheduler.h"
+#include "onedrivedebug.h"
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QSharedMemory>
+#include <QTimer>
+
+#include <chrono>
+
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+
+namespace
+{
+// Shares of the link, by class, while classes compete.
+const int Weights[] = { 8, 2, 1 };
+const int PollInterval = 50;
+const int MaxPause = 2000;
+// Background work gets through after this long anyway.
+const int MaxPreemption = 30000;
+// A ticket this old is from a process that died without releasing it, and
+// whose pid was reused since.
+const qint64 MaxTicketAge = 6 * 3600 * 1000;
+
+struct Slot {
+    qint64 pid;
+    qint64 startedAt;
+    qint32 priority;
+    quint32 serial;
+};
+
+// Fresh segments are zeroed, so every slot starts free.
+struct Table {
+    static const int Capacity = 128;
+
+    Slot slots[Capacity];
+};
+
+quint32 s_serial = 0;
+
+qint64 now()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+QString tableKey()
+{
+    if (qEnvironmentVariableIsSet("ONEDRIVE_SCHEDULER_KEY")) {
+        return QString::fromLocal8Bit(qgetenv("ONEDRIVE_SCHEDULER_KEY"));
+    }
+    // One table per user, shared by the workers and the sync agent.
+    return QStringLiteral("kio_onedrive_scheduler_%1").arg(getuid());
+}
+
+QSharedMemory *sharedTable()
+{
+    // Detached at exit, which removes the table along with the last process.
+    static QSharedMemory memory(tableKey());
+    static const bool attached = [] {
+        if (memory.create(sizeof(Table)) || (memory.error() == QSharedMemory::AlreadyExists && memory.attach())) {
+            return true;
+        }
+        qCWarning(ONEDRIVE) << "Requests are not scheduled:" << memory.errorString();
+        return false;
+    }();
+    return attached ? &memory : nullptr;
+}
+
+bool isAlive(const Slot &slot, qint64 at)
+{
+    return slot.pid != 0 && at - slot.startedAt < MaxTicketAge
+           && (kill(pid_t(slot.pid), 0) == 0 || errno != ESRCH);
+}
+
+// The highest class with a running request, Background + 1 if none.
+int highestActive()
+{
+    QSharedMemory *memory = sharedTable();
+    if (!memory || !memory->lock()) {
+        return RequestScheduler::Background + 1;
+    }
+    const auto *table = static_cast<const Table *>(memory->constData());
+    const qint64 at = now();
+    int highest = RequestScheduler::Background + 1;
+    for (const auto &slot : table->slots) {
+        if (slot.priority < highest && isAlive(slot, at)) {
+            highest = slot.priority;
+        }
+    }
+    memory->unlock();
+    return highest;
+}
+
+void waitFor(int msecs)
+{
+    QEventLoop eventLoop;
+    QTimer::singleShot(msecs, &eventLoop, &QEventLoop::quit);
+    eventLoop.exec();
+}
+}
+
+RequestScheduler::Priority RequestScheduler::s_priority = RequestScheduler::Interactive;
+
+RequestScheduler::Scope::Scope(Priority priority)
+    : m_previous(s_priority)
+{
+    s_priority = priority;
+}
+
+RequestScheduler::Scope::~Scope()
+{
+    s_priority = m_previous;
+}
+
+RequestScheduler::Ticket::Ticket()
+    : m_slot(-1)
+    , m_serial(++s_serial)
+{
+    QSharedMemory *memory = sharedTable();
+    if (!memory) {
+        return;
+    }
+
+    if (s_priority == Background) {
+        QElapsedTimer waiting;
+        waiting.start();
+        while (highestActive() == Interactive && !waiting.hasExpired(MaxPreemption)) {
+            waitFor(PollInterval);
+        }
+    }
+
+    if (!memory->lock()) {
+        return;
+    }
+    auto *table = static_cast<Table *>(memory->data());
+    const qint64 at = now();
+    // Dead processes leave their slots behind, they are reused as free ones.
+    for (int i = 0; i < Table::Capacity; ++i) {
+        Slot &slot = table->slots[i];
+        if (!isAlive(slot, at)) {
+            slot = { qint64(getpid()), at, qint32(s_priority), m_serial };
+            m_slot = i;
+            break;
+        }
+    }
+    memory->unlock();
+}
+
+RequestScheduler::Ticket::~Ticket()
+{
+    QSharedMemory *memory = sharedTable();
+    if (m_slot < 0 || !memory->lock()) {
+        return;
+    }
+    Slot &slot = static_cast<Table *>(memory->data())->slots[m_slot];
+    if (slot.pid == getpid() && slot.serial == m_serial) {
+        slot.pid = 0;
+    }
+    memory->unlock();
+}
+
+RequestScheduler::Priority RequestScheduler::priority()
+{
+    return s_priority;
+}
+
+int RequestScheduler::holdOff(Priority priority, qint64 chunkMsecs)
+{
+    if (priority == Interactive) {
+        return 0;
+    }
+    const int active = highestActive();
+    if (active >= priority) {
+        return 0;
+    }
+    if (priority == Background && active == Interactive) {
+        return PollInterval;
+    }
+    // Pausing in proportion keeps the chunks of this class to their weighted
+    // share of the time.
+    return int(qMin<qint64>(chunkMsecs * Weights[active] / Weights[priority], MaxPause));
+}
+
+void RequestScheduler::yield(qint64 chunkMsecs)
+{
+    QElapsedTimer waiting;
+    waiting.start();
+    const Priority priority = s_priority;
+    int pause = holdOff(priority, chunkMsecs);
+    while (pause > 0 && !waiting.hasExpired(MaxPreemption)) {
+        waitFor(pause);
+        pause = holdOff(priority, 0);
+    }
+}
+
+int RequestScheduler::connectionShare(Priority priority, int connections)
+{
+    if (priority == Interactive) {
+        return connections;
+    }
+    const int active = highestActive();
+    if (active >= priority) {
+        return connections;
+    }
+    return qMax(1, connections * Weights[priority] / (Weights[priority] + Weights[active]));
+}
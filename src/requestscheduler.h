@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#pragma once
+
+#include <QtGlobal>
+
+/**
+ * Shares the network between the requests of all the workers and of the sync
+ * agent of the user, by priority class, so that browsing stays responsive
+ * while large transfers run.
+ *
+ * Each request holds a Ticket while it runs, which registers it, by class,
+ * in a table shared by the processes. Lower classes give way to the higher
+ * ones that are running:
+ *
+ * - interactive metadata requests never wait;
+ * - foreground transfers go on at a weighted share: between two chunks they
+ *   pause in proportion to the weights, and keep fewer connections;
+ * - background prefetch and sync are preempted: their requests and chunks
+ *   wait until no interactive request runs.
+ *
+ * The class is set per process with Scope, and is Interactive by default.
+ * Setting ONEDRIVE_SCHEDULER_KEY selects another table, apart from the one of
+ * the session.
+ */
+class RequestScheduler
+{
+public:
+    enum Priority {
+        Interactive = 0,
+        Transfer,
+        Background
+    };
+
+    /**
+     * Sets the class of the requests of this process until it goes out of scope.
+     */
+    class Scope
+    {
+    public:
+        explicit Scope(Priority priority);
+        ~Scope();
+
+    private:
+        Q_DISABLE_COPY(Scope)
+
+        Priority m_previous;
+    };
+
+    /**
+     * Registers a request of the current class until it goes out of scope.
+     * Background requests wait first, as long as interactive ones run.
+     */
+    class Ticket
+    {
+    public:
+        Ticket();
+        ~Ticket();
+
+    private:
+        Q_DISABLE_COPY(Ticket)
+
+        int m_slot;
+        quint32 m_serial;
+    };
+
+    static Priority priority();
+
+    /**
+     * @return How long to wait before sending the next chunk of a transfer
+     * of class @p priority, in milliseconds, given that the previous one took
+     * @p chunkMsecs. 0 means right away.
+     *
+     * Asynchronous transfers pass the class they started with, as requests of
+     * other classes may run in the meantime.
+     */
+    static int holdOff(Priority priority, qint64 chunkMsecs);
+
+    /**
+     * Waits in an event loop as long as holdOff() says, for the current class.
+     */
+    static void yield(qint64 chunkMsecs);
+
+    /**
+     * @return How many of @p connections a transfer of class @p priority
+     * may keep busy now, at least 1.
+     */
+    static int connectionShare(Priority priority, int connections);
+
+private:
+    static Priority s_priority;
+};
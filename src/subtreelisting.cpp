@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "subtreelisting.h"
+
+SubtreeListing::SubtreeListing(const QString &folderId)
+    : m_folderId(folderId)
+{
+}
+
+QList<SubtreeListing::Node> SubtreeListing::add(const QJsonObject &item)
+{
+    const QString id = item.value(QStringLiteral("id")).toString();
+    if (id.isEmpty() || item.contains(QStringLiteral("deleted"))) {
+        return {};
+    }
+
+    QList<QJsonObject> queue;
+    if (id == m_folderId || (m_folderId.isEmpty() && item.contains(QStringLiteral("root")))) {
+        m_folderId = id;
+        m_folders.insert(id, QString());
+        queue = m_pending.take(id);
+    } else {
+        queue << item;
+    }
+
+    QList<Node> nodes;
+    while (!queue.isEmpty()) {
+        const QJsonObject current = queue.takeFirst();
+        const QString parentId = current.value(QStringLiteral("parentReference")).toObject().value(QStringLiteral("id")).toString();
+        const auto parent = m_folders.constFind(parentId);
+        if (parent == m_folders.constEnd()) {
+            m_pending[parentId].append(current);
+            continue;
+        }
+
+        Node node;
+        node.id = current.value(QStringLiteral("id")).toString();
+        node.relativePath = parent->isEmpty() ? current.value(QStringLiteral("name")).toString()
+                                              : *parent + QLatin1Char('/') + current.value(QStringLiteral("name")).toString();
+        node.folder = current.contains(QStringLiteral("folder"));
+        node.item = current;
+        if (node.folder) {
+            m_folders.insert(node.id, node.relativePath);
+            queue << m_pending.take(node.id);
+        }
+        nodes << node;
+    }
+    return nodes;
+}
+
+int SubtreeListing::pendingCount() const
+{
+    int count = 0;
+    for (const auto &items : m_pending) {
+        count += items.size();
+    }
+    return count;
+}
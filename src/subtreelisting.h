@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+
+/**
+ * Turns the items of a folder's change feed, enumerated from scratch, into
+ * the entries of a recursive listing: each item with its path relative to
+ * the folder, parents before their content.
+ *
+ * The feed gives the parent of each item by ID only, in no guaranteed order,
+ * so items whose parent has not been seen yet are held back until it is.
+ */
+class SubtreeListing
+{
+public:
+    /**
+     * @param folderId The folder listed, or an empty string for the root.
+     */
+    explicit SubtreeListing(const QString &folderId);
+
+    struct Node {
+        QString id;
+        /** e.g. "Photos/2018/a.jpg" */
+        QString relativePath;
+        bool folder = false;
+        QJsonObject item;
+    };
+
+    /**
+     * @return The nodes that could be placed thanks to @p item: the item
+     * itself and any held back item below it, or nothing.
+     */
+    QList<Node> add(const QJsonObject &item);
+
+    /**
+     * @return The number of items held back, whose parent was never seen.
+     */
+    int pendingCount() const;
+
+private:
+    QString m_folderId;
+    /** Relative paths of the folders placed so far, by ID. */
+    QHash<QString, QString> m_folders;
+    /** Held back items, by parent ID. */
+    QHash<QString, QList<QJsonObject>> m_pending;
+};
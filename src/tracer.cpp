@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "tracer.h"
+#include "onedrivedebug.h"
+
+#include <QCoreApplication>
+#include <QMutex>
+#include <QSaveFile>
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+namespace
+{
+struct Event {
+    const char *name;
+    qint64 start;
+    qint64 end;
+};
+
+// Only the recording thread writes to its buffer, so recording takes no lock.
+struct Buffer {
+    static const quint64 Capacity = 1 << 16;
+
+    Event events[Capacity];
+    std::atomic<quint64> written{0};
+    int thread = 0;
+};
+
+QMutex s_buffersLock;
+std::vector<Buffer *> s_buffers;
+QString s_fileName;
+
+thread_local Buffer *t_buffer = nullptr;
+
+Buffer *threadBuffer()
+{
+    if (!t_buffer) {
+        // Kept until exit, so that the spans of finished threads are dumped too.
+        t_buffer = new Buffer;
+        QMutexLocker locker(&s_buffersLock);
+        t_buffer->thread = int(s_buffers.size()) + 1;
+        s_buffers.push_back(t_buffer);
+    }
+    return t_buffer;
+}
+}
+
+bool Tracer::s_enabled = false;
+
+void Tracer::enable(const QString &fileName)
+{
+    s_fileName = fileName;
+    s_enabled = true;
+}
+
+qint64 Tracer::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Tracer::record(const char *name, qint64 start, qint64 end)
+{
+    Buffer *buffer = threadBuffer();
+    const quint64 index = buffer->written.load(std::memory_order_relaxed);
+    buffer->events[index % Buffer::Capacity] = { name, start, end };
+    buffer->written.store(index + 1, std::memory_order_release);
+}
+
+QByteArray Tracer::toJson()
+{
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+
+    QByteArray json("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    bool first = true;
+
+    QMutexLocker locker(&s_buffersLock);
+    for (const Buffer *buffer : s_buffers) {
+        const QByteArray thread = QByteArray::number(buffer->thread);
+        const quint64 written = buffer->written.load(std::memory_order_acquire);
+        // Once the ring wrapped, only the most recent spans are left.
+        const quint64 oldest = written > Buffer::Capacity ? written - Buffer::Capacity : 0;
+        for (quint64 i = oldest; i < written; ++i) {
+            const Event &event = buffer->events[i % Buffer::Capacity];
+            if (!first) {
+                json += ',';
+            }
+            first = false;
+            // Complete events carry both ends of a span, so a wrapped ring
+            // never leaves a begin without its end.
+            json += "{\"name\":\"" + QByteArray(event.name) + "\",\"ph\":\"X\",\"pid\":" + pid
+                    + ",\"tid\":" + thread
+                    + ",\"ts\":" + QByteArray::number(event.start / 1000.0, 'f', 3)
+                    + ",\"dur\":" + QByteArray::number((event.end - event.start) / 1000.0, 'f', 3) + '}';
+        }
+    }
+
+    json += "]}";
+    return json;
+}
+
+bool Tracer::dump(const QString &fileName)
+{
+    const QString target = fileName.isEmpty() ? s_fileName : fileName;
+    if (target.isEmpty()) {
+        return false;
+    }
+
+    QSaveFile file(target);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(ONEDRIVE) << "Cannot write trace to" << target << file.errorString();
+        return false;
+    }
+    file.write(toJson());
+    return file.commit();
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QByteArray>
+#include <QString>
+
+/**
+ * Records the spans of the worker in per-thread ring buffers and writes them
+ * as Chrome trace events, to be opened in Perfetto or chrome://tracing.
+ *
+ * Span names must be string literals, or otherwise outlive the tracer: they
+ * are stored as pointers and only formatted when the trace is written. When
+ * tracing is disabled, a span costs a load and a branch.
+ */
+class Tracer
+{
+public:
+    /**
+     * Records the time until it goes out of scope, when tracing is enabled.
+     */
+    class Span
+    {
+    public:
+        explicit Span(const char *name)
+            : m_name(s_enabled ? name : nullptr)
+            , m_start(m_name ? now() : 0)
+        {
+        }
+
+        ~Span()
+        {
+            if (m_name) {
+                record(m_name, m_start, now());
+            }
+        }
+
+    private:
+        Q_DISABLE_COPY(Span)
+
+        const char *m_name;
+        qint64 m_start;
+    };
+
+    static bool isEnabled()
+    {
+        return s_enabled;
+    }
+
+    /**
+     * Starts tracing, to be written to @p fileName by dump().
+     */
+    static void enable(const QString &fileName);
+
+    /**
+     * @return The monotonic time in nanoseconds.
+     */
+    static qint64 now();
+
+    static void record(const char *name, qint64 start, qint64 end);
+
+    /**
+     * @return The recorded spans, as Chrome trace event JSON. Spans of other
+     * threads still being recorded may be missing.
+     */
+    static QByteArray toJson();
+
+    /**
+     * Writes the trace to @p fileName, or else to the one passed to enable().
+     */
+    static bool dump(const QString &fileName = QString());
+
+private:
+    static bool s_enabled;
+};
+
+#endif // TRACER_H
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "uploadjournal.h"
+#include "onedrivedebug.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+static const quint32 FormatVersion = 2;
+// Safe saves rename "name.part" right after writing it. Until then the
+// partial file is left to the worker, in seconds.
+static const int PartialGracePeriod = 60;
+
+static QString normalized(const QString &path)
+{
+    QString result = path;
+    while (result.endsWith(QLatin1Char('/'))) {
+        result.chop(1);
+    }
+    if (!result.startsWith(QLatin1Char('/'))) {
+        result.prepend(QLatin1Char('/'));
+    }
+    return result;
+}
+
+UploadJournal::UploadJournal(const QString &directory)
+    : m_directory(directory)
+{
+}
+
+UploadJournal::~UploadJournal()
+{
+}
+
+QString UploadJournal::defaultDirectory()
+{
+    if (qEnvironmentVariableIsSet("ONEDRIVE_JOURNAL_DIR")) {
+        return QString::fromLocal8Bit(qgetenv("ONEDRIVE_JOURNAL_DIR"));
+    }
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + QStringLiteral("/kio_onedrive/journal");
+}
+
+QString UploadJournal::directory() const
+{
+    return m_directory;
+}
+
+QString UploadJournal::baseName(const QString &path) const
+{
+    const QByteArray hash = QCryptographicHash::hash(normalized(path).toUtf8(), QCryptographicHash::Sha1).toHex();
+    return m_directory + QLatin1Char('/') + QString::fromLatin1(hash);
+}
+
+QString UploadJournal::contentFile(const Upload &upload) const
+{
+    // Each put() gets its own file, the previous one may still be read by the agent.
+    return QStringLiteral("%1.%2.data").arg(baseName(upload.path)).arg(upload.queuedAt.toMSecsSinceEpoch());
+}
+
+QString UploadJournal::lockFile(const QString &path) const
+{
+    return baseName(path) + QStringLiteral(".lock");
+}
+
+bool UploadJournal::add(const Upload &upload, const QString &fileName)
+{
+    if (!QDir().mkpath(m_directory)) {
+        qCWarning(ONEDRIVE) << "Cannot create the upload journal in" << m_directory;
+        return false;
+    }
+
+    Upload queued = upload;
+    queued.path = normalized(upload.path);
+    queued.attempts = 0;
+    queued.nextAttempt = QDateTime();
+    queued.lastError.clear();
+    Upload pending;
+    if (this->upload(queued.path, &pending) && queued.queuedAt <= pending.queuedAt) {
+        queued.queuedAt = pending.queuedAt.addMSecs(1);
+    }
+
+    QFile source(fileName);
+    QSaveFile target(contentFile(queued));
+    if (!source.open(QIODevice::ReadOnly) || !target.open(QIODevice::WriteOnly)) {
+        qCWarning(ONEDRIVE) << "Cannot queue" << fileName << "for upload:" << source.errorString() << target.errorString();
+        return false;
+    }
+    qint64 size = 0;
+    while (!source.atEnd()) {
+        const QByteArray chunk = source.read(1024 * 1024);
+        if (target.write(chunk) != chunk.size()) {
+            qCWarning(ONEDRIVE) << "Cannot queue" << fileName << "for upload:" << target.errorString();
+            target.cancelWriting();
+            return false;
+        }
+        size += chunk.size();
+    }
+    // Committing syncs the content to disk, before the record points to it.
+    if (!target.commit()) {
+        qCWarning(ONEDRIVE) << "Cannot queue" << fileName << "for upload:" << target.errorString();
+        return false;
+    }
+    queued.size = size;
+    // The server still holds the version the pending upload was based on.
+    // Read last, the agent may have committed the pending upload meanwhile.
+    if (this->upload(queued.path, &pending)) {
+        queued.baseCTag = pending.baseCTag;
+    }
+    if (!write(queued)) {
+        QFile::remove(contentFile(queued));
+        return false;
+    }
+
+    // Older contents of the same path are useless from now on.
+    const QString current = QFileInfo(contentFile(queued)).fileName();
+    QDir journal(m_directory);
+    const auto names = journal.entryList({QFileInfo(baseName(queued.path)).fileName() + QStringLiteral(".*.data")}, QDir::Files);
+    for (const auto &name : names) {
+        if (name != current) {
+            journal.remove(name);
+        }
+    }
+    return true;
+}
+
+bool UploadJournal::read(const QString &recordFile, Upload *upload) const
+{
+    QFile file(recordFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream stream(&file);
+    quint32 version = 0;
+    stream >> version;
+    if (version < 1 || version > FormatVersion) {
+        return false;
+    }
+    stream >> upload->path >> upload->baseCTag >> upload->queuedAt >> upload->size
+           >> upload->attempts >> upload->nextAttempt >> upload->lastError;
+    // Version 1 had no safe saves.
+    if (version >= 2) {
+        stream >> upload->deletedTarget;
+    }
+    return stream.status() == QDataStream::Ok;
+}
+
+bool UploadJournal::write(const Upload &upload) const
+{
+    const QString fileName = baseName(upload.path) + QStringLiteral(".upload");
+    QSaveFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qCWarning(ONEDRIVE) << "Cannot write" << fileName << ":" << file.errorString();
+        return false;
+    }
+    QDataStream stream(&file);
+    stream << FormatVersion << upload.path << upload.baseCTag << upload.queuedAt << upload.size
+           << upload.attempts << upload.nextAttempt << upload.lastError << upload.deletedTarget;
+    return file.commit();
+}
+
+bool UploadJournal::upload(const QString &path, Upload *upload) const
+{
+    return read(baseName(path) + QStringLiteral(".upload"), upload);
+}
+
+QList<UploadJournal::Upload> UploadJournal::uploads() const
+{
+    QList<Upload> uploads;
+    QDir journal(m_directory);
+    const auto names = journal.entryList({QStringLiteral("*.upload")}, QDir::Files);
+    for (const auto &name : names) {
+        Upload upload;
+        if (read(journal.filePath(name), &upload)) {
+            uploads << upload;
+        }
+    }
+    std::sort(uploads.begin(), uploads.end(), [](const Upload &a, const Upload &b) {
+        return a.queuedAt < b.queuedAt;
+    });
+    return uploads;
+}
+
+QList<UploadJournal::Upload> UploadJournal::uploadsIn(const QString &folderPath) const
+{
+    const QString folder = normalized(folderPath);
+    QList<Upload> uploads;
+    const auto all = this->uploads();
+    for (const auto &upload : all) {
+        if (upload.path.left(upload.path.lastIndexOf(QLatin1Char('/'))) == folder) {
+            uploads << upload;
+        }
+    }
+    return uploads;
+}
+
+QDateTime UploadJournal::readyAt(const Upload &upload)
+{
+    QDateTime ready = upload.nextAttempt;
+    if (upload.path.endsWith(QLatin1String(".part"))) {
+        const QDateTime renameDeadline = upload.queuedAt.addSecs(PartialGracePeriod);
+        if (!ready.isValid() || renameDeadline > ready) {
+            ready = renameDeadline;
+        }
+    }
+    return ready;
+}
+
+bool UploadJournal::isEmpty() const
+{
+    return QDir(m_directory).entryList({QStringLiteral("*.upload")}, QDir::Files).isEmpty();
+}
+
+void UploadJournal::update(const Upload &upload)
+{
+    Upload current;
+    if (this->upload(upload.path, &current) && current.queuedAt == upload.queuedAt) {
+        write(upload);
+    }
+}
+
+bool UploadJournal::rename(const Upload &upload, const QString &path, const QString &baseCTag)
+{
+    Upload moved = upload;
+    moved.path = path;
+    moved.baseCTag = baseCTag;
+    moved.deletedTarget.clear();
+    if (!add(moved, contentFile(upload))) {
+        return false;
+    }
+    remove(upload);
+    return true;
+}
+
+void UploadJournal::remove(const Upload &upload)
+{
+    Upload current;
+    if (this->upload(upload.path, &current) && current.queuedAt == upload.queuedAt) {
+        QFile::remove(baseName(upload.path) + QStringLiteral(".upload"));
+    }
+    QFile::remove(contentFile(upload));
+}
+
+void UploadJournal::commit(const Upload &upload, const QString &cTag)
+{
+    Upload current;
+    if (!cTag.isEmpty() && this->upload(upload.path, &current) && current.queuedAt > upload.queuedAt) {
+        current.baseCTag = cTag;
+        write(current);
+    }
+    remove(upload);
+}
+
+void UploadJournal::remove(const QString &path)
+{
+    Upload current;
+    if (upload(path, &current)) {
+        remove(current);
+    }
+}
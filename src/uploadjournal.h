@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#pragma once
+
+#include <QDateTime>
+#include <QList>
+#include <QString>
+
+/**
+ * The uploads accepted by the worker in write-back mode, and not yet sent
+ * to the server.
+ *
+ * Each upload is a copy of the content and a small record, both committed
+ * to disk before put() returns, so that they survive a crash or a logout.
+ * There is at most one upload per path: a newer put() replaces the pending
+ * one. The agent sends them in queue order, see BackgroundUploader.
+ *
+ * The journal lives in the data location rather than the cache, since it
+ * holds the only copy of the data until it is uploaded.
+ */
+class UploadJournal
+{
+public:
+    struct Upload {
+        /** Account included, e.g. "/foo@outlook.com/Documents/notes.txt". */
+        QString path;
+        /**
+         * The cTag of the item the content replaces, when known. Empty for
+         * new files.
+         */
+        QString baseCTag;
+        QDateTime queuedAt;
+        qint64 size = 0;
+        int attempts = 0;
+        /** Not to be tried again before. */
+        QDateTime nextAttempt;
+        QString lastError;
+        /**
+         * The file this upload is to replace, deleted meanwhile as a step of
+         * a safe save. It is deleted on the server along with the upload,
+         * unless the upload is renamed over it first.
+         */
+        QString deletedTarget;
+    };
+
+    explicit UploadJournal(const QString &directory);
+    ~UploadJournal();
+
+    /**
+     * @return The directory shared by the worker and the agent. It can be
+     * overridden with the ONEDRIVE_JOURNAL_DIR environment variable.
+     */
+    static QString defaultDirectory();
+
+    QString directory() const;
+
+    /**
+     * Queues the content of the local file @p fileName for @p upload,
+     * replacing any pending upload of the same path.
+     * @return Whether the upload is on disk.
+     */
+    bool add(const Upload &upload, const QString &fileName);
+
+    /**
+     * @return Whether an upload of @p path is pending, and sets @p upload to it.
+     */
+    bool upload(const QString &path, Upload *upload) const;
+
+    /**
+     * @return The local file holding the content of @p upload.
+     */
+    QString contentFile(const Upload &upload) const;
+
+    /**
+     * @return The lock file claiming the upload of @p path, held by the
+     * process sending it. See BackgroundUploader.
+     */
+    QString lockFile(const QString &path) const;
+
+    /**
+     * @return The pending uploads, oldest first.
+     */
+    QList<Upload> uploads() const;
+
+    /**
+     * @return The pending uploads of files right inside @p folderPath.
+     */
+    QList<Upload> uploadsIn(const QString &folderPath) const;
+
+    /**
+     * @return When @p upload may be sent: after its backoff, and for the
+     * partial file of a safe save, once the worker had time to rename it.
+     * Invalid if right away.
+     */
+    static QDateTime readyAt(const Upload &upload);
+
+    bool isEmpty() const;
+
+    /**
+     * Saves the attempts of @p upload, unless it was replaced meanwhile.
+     */
+    void update(const Upload &upload);
+
+    /**
+     * Moves @p upload to @p path, replacing any pending upload there, and
+     * bases it on @p baseCTag unless that one was pending already.
+     * @return Whether the moved upload is on disk.
+     */
+    bool rename(const Upload &upload, const QString &path, const QString &baseCTag);
+
+    /**
+     * Forgets @p upload and its content, unless it was replaced meanwhile
+     * by a newer put().
+     */
+    void remove(const Upload &upload);
+
+    /**
+     * Same as remove(), once @p upload is on the server as the version
+     * @p cTag. A newer put() queued meanwhile is based on that version
+     * from now on, rather than on the one @p upload replaced.
+     */
+    void commit(const Upload &upload, const QString &cTag);
+
+    /**
+     * Forgets whatever upload of @p path is pending.
+     */
+    void remove(const QString &path);
+
+private:
+    QString baseName(const QString &path) const;
+    bool read(const QString &recordFile, Upload *upload) const;
+    bool write(const Upload &upload) const;
+
+    QString m_directory;
+};
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "uploadsession.h"
+#include "onedrivehelper.h"
+#include "requestscheduler.h"
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QIODevice>
+#include <QJsonDocument>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+
+const qint64 UploadSession::SimpleUploadLimit;
+const qint64 UploadSession::ChunkSize;
+
+UploadSession::UploadSession(const KMGraph2::AccountPtr &account,
+                             const QString &itemPath,
+                             const GraphRunner &runner,
+                             QObject *parent)
+    : QObject(parent)
+    , m_account(account)
+    , m_itemPath(itemPath)
+    , m_runner(runner)
+{
+}
+
+UploadSession::~UploadSession()
+{
+}
+
+void UploadSession::setModifiedDate(const QDateTime &modified)
+{
+    m_modified = modified;
+}
+
+QJsonObject UploadSession::item() const
+{
+    return m_item;
+}
+
+int UploadSession::statusCode() const
+{
+    return m_statusCode;
+}
+
+QString UploadSession::errorString() const
+{
+    return m_errorString;
+}
+
+bool UploadSession::exec(QIODevice *content, qint64 size)
+{
+    QJsonObject item;
+    item.insert(QStringLiteral("@microsoft.graph.conflictBehavior"), QStringLiteral("replace"));
+    if (m_modified.isValid()) {
+        QJsonObject fileSystemInfo;
+        fileSystemInfo.insert(QStringLiteral("lastModifiedDateTime"), m_modified.toUTC().toString(Qt::ISODate));
+        item.insert(QStringLiteral("fileSystemInfo"), fileSystemInfo);
+    }
+    QJsonObject body;
+    body.insert(QStringLiteral("item"), item);
+
+    GraphRequest sessionRequest(OneDriveHelper::networkAccessManager(), "POST",
+                                m_itemPath + QStringLiteral("/createUploadSession"), body);
+    bool created = false;
+    if (m_runner) {
+        created = m_runner(sessionRequest);
+    } else {
+        sessionRequest.setAccount(m_account);
+        created = sessionRequest.exec();
+    }
+    if (!created) {
+        m_statusCode = sessionRequest.statusCode();
+        m_errorString = sessionRequest.errorString();
+        return false;
+    }
+    const QUrl uploadUrl(sessionRequest.response().value(QStringLiteral("uploadUrl")).toString());
+    if (!uploadUrl.isValid()) {
+        m_errorString = QStringLiteral("Invalid upload session");
+        return false;
+    }
+
+    qint64 uploaded = 0;
+    QElapsedTimer chunkTimer;
+    while (uploaded < size) {
+        if (uploaded > 0) {
+            RequestScheduler::yield(chunkTimer.elapsed());
+        }
+        const QByteArray chunk = content->read(qMin(ChunkSize, size - uploaded));
+        if (chunk.isEmpty()) {
+            m_errorString = content->errorString();
+            return false;
+        }
+
+        // The upload URL is pre-authenticated, so no Authorization header here.
+        QNetworkRequest request(uploadUrl);
+        request.setRawHeader("Content-Range", QStringLiteral("bytes %1-%2/%3").arg(uploaded).arg(uploaded + chunk.size() - 1).arg(size).toLatin1());
+        request.setHeader(QNetworkRequest::ContentLengthHeader, chunk.size());
+        RequestScheduler::Ticket ticket;
+        chunkTimer.start();
+        if (!wait(OneDriveHelper::networkAccessManager()->put(request, chunk))) {
+            return false;
+        }
+        uploaded += chunk.size();
+        Q_EMIT processed(uploaded);
+    }
+    return true;
+}
+
+bool UploadSession::wait(QNetworkReply *reply)
+{
+    QEventLoop eventLoop;
+    QObject::connect(reply, &QNetworkReply::finished, &eventLoop, &QEventLoop::quit);
+    eventLoop.exec();
+
+    const int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    const bool succeeded = statusCode >= 200 && statusCode < 300;
+    const QJsonObject response = QJsonDocument::fromJson(reply->readAll()).object();
+    if (succeeded) {
+        // The last chunk is answered with the item.
+        m_item = response;
+    } else {
+        m_statusCode = statusCode;
+        m_errorString = response.value(QStringLiteral("error")).toObject().value(QStringLiteral("message")).toString();
+        if (m_errorString.isEmpty()) {
+            m_errorString = reply->errorString();
+        }
+    }
+    reply->deleteLater();
+    return succeeded;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#pragma once
+
+#include "graphrequest.h"
+
+#include <QDateTime>
+#include <QJsonObject>
+
+#include <KMGraph/Account>
+
+class QIODevice;
+class QNetworkReply;
+
+/**
+ * Uploads a content to an item through an upload session, in chunks,
+ * replacing the item if it exists.
+ *
+ * Between two chunks, the upload gives way to the higher classes of the
+ * RequestScheduler, so that large uploads do not hold up browsing.
+ */
+class UploadSession : public QObject
+{
+    Q_OBJECT
+
+public:
+    /** Smaller contents are better sent in one request. */
+    static const qint64 SimpleUploadLimit = 4 * 1024 * 1024;
+    /** A multiple of 320 KiB, as required by upload sessions. */
+    static const qint64 ChunkSize = 10 * 1024 * 1024;
+
+    /**
+     * @param itemPath Graph path of the item, e.g. "/items/{id}" or
+     * "/items/{parent-id}:/{name}:".
+     * @param runner Sends the request that creates the session, by default
+     * once. The chunks are sent directly, the upload URL is pre-authenticated.
+     */
+    UploadSession(const KMGraph2::AccountPtr &account,
+                  const QString &itemPath,
+                  const GraphRunner &runner = GraphRunner(),
+                  QObject *parent = nullptr);
+    ~UploadSession();
+
+    void setModifiedDate(const QDateTime &modified);
+
+    /**
+     * Sends @p size bytes read from @p content and blocks until done.
+     * @return Whether the upload succeeded.
+     */
+    bool exec(QIODevice *content, qint64 size);
+
+    /**
+     * @return The uploaded item.
+     */
+    QJsonObject item() const;
+
+    /**
+     * @return The HTTP status of the request that failed, 0 if it got no
+     * answer or did not fail.
+     */
+    int statusCode() const;
+    QString errorString() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted after each chunk, with the number of bytes uploaded so far.
+     */
+    void processed(qint64 bytes);
+
+private:
+    bool wait(QNetworkReply *reply);
+
+    KMGraph2::AccountPtr m_account;
+    QString m_itemPath;
+    GraphRunner m_runner;
+    QDateTime m_modified;
+
+    QJsonObject m_item;
+    int m_statusCode = 0;
+    QString m_errorString;
+};